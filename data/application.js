@@ -196,6 +196,8 @@ function buildDynamicNavigation(fields) {
 if(DEBUGME) console.log("Trying to connect to " + "ws://" + address + "/ws");
 var ws = new ReconnectingWebSocket('ws://' + address + '/ws', ['arduino']);
 ws.debug = true;
+// the live preview frames are sent as binary messages
+ws.binaryType = "arraybuffer";
 
 ws.onopen = function(evt) {
 	if(evt.data !== null)
@@ -204,6 +206,8 @@ ws.onopen = function(evt) {
 	}
 	ws_connected = true;
 	updateWSState(true);
+	// the subscription is lost with the connection
+	if(previewActive) setPreview(true);
 }
 
 ws.onerror = function(evt) {
@@ -224,6 +228,11 @@ ws.onclose = function(evt) {
 
 ws.onmessage = function(evt) {
 
+  if(evt.data instanceof ArrayBuffer)
+  {
+    decodePreviewFrame(evt.data);
+    return;
+  }
   if(evt.data !== null)
   {
     // added exception handling fro wrong json strings
@@ -239,6 +248,12 @@ ws.onmessage = function(evt) {
 	{
 		if(DEBUGME) console.log("Received field data for field " + data.name + " with " + data.value);
 		updateFieldValue(data.name, data.value);
+	} else if (data.values != undefined) {
+		// all values at once (e.g. after a preset was recalled)
+		if(DEBUGME) console.log("Received " + data.values.length + " field values");
+		for (var i = 0; i < data.values.length; i++) {
+			updateFieldValue(data.values[i].name, data.values[i].value);
+		}
 	} else if (data.Client != undefined) {
 		if(DEBUGME) console.log("Received Client info with from ID " + data.Client + ", Status: " + data.Status);
 	} else {
@@ -249,6 +264,80 @@ ws.onmessage = function(evt) {
 }
 
 
+// live LED preview (see src/LED_strip/led_preview.h for the frame format)
+var PREVIEW_FPS = 15;
+var previewActive = false;
+var previewPixels = [];
+var previewSeq = 0;
+
+function setPreview(active)
+{
+	previewActive = active;
+	previewSeq = 0;
+	if(ws_connected) ws.send(JSON.stringify({ preview: active ? PREVIEW_FPS : 0 }));
+	if(!active) drawPreview();
+}
+
+function decodePreviewFrame(buffer)
+{
+	var d = new Uint8Array(buffer);
+	if(d.length < 6 || d[0] != 0x4C) return;
+	var delta = (d[1] & 0x01) != 0;
+	var count = d[2] | (d[3] << 8);
+	var seq = d[4] | (d[5] << 8);
+	var pos = 6;
+	if(delta)
+	{
+		// delta frames only apply to the frame received before (sequence 0 is skipped by the controller)
+		if(previewSeq == 0 || seq != (previewSeq == 0xffff ? 1 : previewSeq + 1) || previewPixels.length != count) return;
+		var i = 0;
+		while(pos + 2 <= d.length)
+		{
+			i += d[pos++];
+			var n = d[pos++];
+			for(var k = 0; k < n && pos + 3 <= d.length; k++, i++, pos += 3)
+			{
+				previewPixels[i] = [d[pos], d[pos+1], d[pos+2]];
+			}
+		}
+	}
+	else
+	{
+		previewPixels = [];
+		while(pos + 4 <= d.length)
+		{
+			var run = d[pos];
+			var c = [d[pos+1], d[pos+2], d[pos+3]];
+			for(var k = 0; k < run; k++) previewPixels.push(c);
+			pos += 4;
+		}
+	}
+	// only full resolution frames can be the base for a delta
+	previewSeq = ((d[1] >> 4) == 0) ? seq : 0;
+	drawPreview();
+}
+
+function drawPreview()
+{
+	var canvas = document.getElementById("ledPreview");
+	if(!canvas) return;
+	var ctx = canvas.getContext("2d");
+	ctx.fillStyle = "#000";
+	ctx.fillRect(0, 0, canvas.width, canvas.height);
+	if(!previewActive || previewPixels.length == 0) return;
+	var w = canvas.width / previewPixels.length;
+	for(var i = 0; i < previewPixels.length; i++)
+	{
+		var c = previewPixels[i];
+		ctx.fillStyle = "rgb(" + c[0] + "," + c[1] + "," + c[2] + ")";
+		ctx.fillRect(Math.floor(i * w), 0, Math.ceil(w), canvas.height);
+	}
+}
+
+$(document).on("click", "#ledPreview", function() {
+	setPreview(!previewActive);
+});
+
 function updateWSState(active)
 {
 	if(!active)
@@ -759,6 +848,13 @@ function setBooleanFieldValue(field, btnOn, btnOff, value) {
 }
 
 function postValue(name, value) {
+  // the web socket is the cheaper channel - acknowledged by the broadcast of the changed value
+  if(ws_connected)
+  {
+    ws.send(JSON.stringify({ name: name, value: value }));
+    updateStatus("Set " + name + ": " + value, false, 3000);
+    return;
+  }
   updateStatus("Set " + name + ": " + value + ", please wait...", true);
 
   var body = { name: name, value: value };
@@ -779,20 +875,23 @@ function postValue(name, value) {
   {
 	  updateStatus("success setting " + JSON.stringify(name.currentState), false, 3000);
   });
-  if(ws_connected)
-  {
-    ws.send("{\"" + name + "\": " + value + "}");
-  }
 }
 
 function delayPostValue(name, value) {
   clearTimeout(postValueTimer);
+  // slider changes can be streamed at ~25 Hz via web socket
   postValueTimer = setTimeout(function() {
     postValue(name, value);
-  }, 300);
+  }, ws_connected ? 40 : 300);
 }
 
 function postColor(name, value) {
+  if(ws_connected)
+  {
+    ws.send(JSON.stringify({ name: name, value: (value.r << 16) | (value.g << 8) | value.b }));
+    updateStatus("Set " + name + ": " + value.r + "," + value.g + "," + value.b, false, 3000);
+    return;
+  }
   updateStatus("Set " + name + ": " + value.r + "," + value.g + "," + value.b + ", please wait...", true);
 
   var body = { name: name, r: value.r, g: value.g, b: value.b };
@@ -808,11 +907,6 @@ function postColor(name, value) {
   {
 	  updateStatus("success setting "  + JSON.stringify(name.currentState), false, 3000);
   });
-  
-  if(ws_connected)
-  {
-    ws.send("{\"" + name + "\": " + value + "}");
-  }
 }
 
 function delayPostColor(name, value) {
@@ -75,6 +75,7 @@
 
 #define EEPROM_SAVE_INTERVAL_MS 5000
 #define WIFI_TIMEOUT            5000 // changed for issue #13 
+#define BOOT_WIFI_TIMEOUT       20000 // ms the boot waits for the stored WiFi before the WiFiManager (captive portal) takes over
 #define MAX_NUM_SEGMENTS        ((LED_COUNT / 15)>10?10:(LED_COUNT / 15))
 #define MAX_NUM_BARS_FACTOR     20                    // Segment divided by this defines the maximum number of "bars"
 #define MAX_NUM_BARS            ((LED_COUNT / MAX_NUM_BARS_FACTOR)>10?10:(LED_COUNT / MAX_NUM_BARS_FACTOR))
@@ -186,6 +187,128 @@
 #define BCKND_MIN_BRI     0
 #define BCKND_MAX_BRI     80
 
+// Command queue between the (async) web handlers and the render loop
+#ifndef LED_CMD_QUEUE_SIZE
+  #define LED_CMD_QUEUE_SIZE  32      // number of pending commands - needs to be a power of 2 (max 128)
+#endif
+#define LED_CMD_MAX_FIELDS    64      // fields beyond this index can not be queued (and coalesced)
+#define SET_BODY_MAX_SIZE     512     // max. size of a POST /set body (JSON or binary TLV)
+#define SET_JSON_DOC_SIZE     768     // size of the (static) JSON document parsing a POST /set body
+#define LED_LATENCY_SAMPLES   32      // input latency samples kept per source (for the percentiles)
+#define SET_LATENCY_MAX_WAIT  1000    // ms a /set?latency request waits for the changes being shown
+#define SET_LATENCY_REQUESTS  4       // max. number of /set?latency requests waiting
+
+// Live LED preview via web socket (opt-in per client)
+#define PREVIEW_MAX_FPS         25    // max. frame rate a client can request
+#define PREVIEW_MAX_DS_SHIFT    3     // slow clients get downsampled frames down to 1:(2^3)
+#define PREVIEW_RECOVER_FRAMES  32    // frames without back pressure to reduce the downsampling again
+#define PREVIEW_MIN_FREE_BLOCK  4096  // no frames are sent if the largest free heap block is smaller
+
+// Server-Sent Events (/events) for polling based integrations
+#define SSE_MAX_CLIENTS         4     // further clients get disconnected right away
+#define SSE_MAX_QUEUED          8     // with more pending messages per client (on average) the events get dropped till they caught up
+#define SSE_STATS_INTERVAL      10000 // ms between two "stats" events
+#define SSE_RECONNECT           2000  // ms a client should wait before reconnecting
+
+// Long-poll on /status and /allvalues (?since=<version>&wait=<ms>)
+#define LONGPOLL_MAX_REQUESTS   4     // further requests are answered immediately
+#define LONGPOLL_DEFAULT_WAIT   10000 // ms
+#define LONGPOLL_MAX_WAIT       30000 // ms
+
+// Realtime pixel data via UDP (DDP, E1.31 / sACN, Art-Net) - switches to VOID while data is received
+#define UDP_RT_DDP_PORT         4048
+#define UDP_RT_E131_PORT        5568
+#define UDP_RT_ARTNET_PORT      6454
+#ifndef UDP_RT_E131_UNIVERSE
+  #define UDP_RT_E131_UNIVERSE    1     // first E1.31 universe (170 LEDs per universe)
+#endif
+#ifndef UDP_RT_ARTNET_UNIVERSE
+  #define UDP_RT_ARTNET_UNIVERSE  0     // first Art-Net universe (15 bit port address)
+#endif
+#define UDP_RT_TIMEOUT          2500  // ms without data until the previous effect gets restored
+#define UDP_RT_HOLD_MAX         250   // ms an incomplete frame is held back at most
+#define UDP_RT_MAX_PACKETS      16    // max. packets processed per loop
+
+// Synchronization of several strips via UDP broadcast (see led_sync.h)
+#define SYNC_PORT               21330
+#define SYNC_INTERVAL           500   // ms between two packets of the leader (changes are sent right away)
+#define SYNC_MIN_INTERVAL       20    // ms between two packets sent because of changes
+#define SYNC_TIMEOUT            5000  // ms without packets until a follower runs on its own again
+#define SYNC_STEP_MS            250   // a larger clock difference (new leader) is set at once - smaller ones are slewed
+#define SYNC_SLEW_RATE          20    // while slewing the clock runs up to 1/20 faster or slower
+#ifndef DEFAULT_SYNC_ROLE
+  #define DEFAULT_SYNC_ROLE     0     // SYNC_ROLE_OFF
+#endif
+#ifndef DEFAULT_SYNC_GROUP
+  #define DEFAULT_SYNC_GROUP    0
+#endif
+
+// Persistence of the runtime settings (LittleFS snapshot + journal of the changed bytes)
+#define SETTINGS_QUIET_MS       1000  // changes get written once they did not change for this time
+#define SETTINGS_MAX_DELAY_MS   EEPROM_SAVE_INTERVAL_MS // ... or at the latest after this time (e.g. while dragging a slider)
+#define SETTINGS_MIN_INTERVAL_MS 1000 // min. ms between two writes
+#define SETTINGS_FRAME_WAIT_MS  100   // writes wait for a frame being shown at most this long
+#define SETTINGS_RECORD_BUFFER  128   // max. bytes appended at once - larger changes write a snapshot
+#define SETTINGS_LOG_COMPACT    1024  // a journal larger than this gets compacted when idle
+#define SETTINGS_LOG_MAX        4096  // a journal never grows larger than this
+#define SETTINGS_COMPACT_IDLE_MS 30000 // ms without changes until the journal gets compacted
+
+// Presets (scenes) stored on LittleFS
+#define PRESET_MAX              16    // max. number of presets
+#define PRESET_NAME_LENGTH      24    // max. characters of a preset name
+
+// Playlists stored on LittleFS (see led_playlist.h)
+#define PLAYLIST_MAX            8     // playlist ids 1 .. PLAYLIST_MAX
+#define PLAYLIST_MAX_ENTRIES    16    // entries per playlist
+#define PLAYLIST_PREPARE_MS     1000  // the next entry gets prepared within the last ms of the current one
+#define PLAYLIST_PRESET_BUFFER  256   // max. length of the values of a preset played (static buffer)
+#define EFFECT_POOL_SIZE        PLAYLIST_MAX_ENTRIES // effects kept for reuse (the distinct modes of a playlist)
+
+// Random bytes for the effects (see FastRandom.h)
+#define RANDOM_POOL_SIZE        128   // bytes generated at once (multiple of 4)
+
+// Particles shared by the particle effects (see ParticleSystem.h)
+#define PARTICLE_POOL_SIZE      256   // particles in the pool (21 bytes each, allocated while used)
+#define PARTICLE_MAX_GROUPS     8     // effects (groups of particles) using the pool at the same time
+#define PARTICLE_LEDS_PER_BAR   60    // the particle effects use numBars particles per this many LEDs
+
+// Fire2012 (see Fire2012Effect.h) - one flame per segment. The build flag FIRE2012_FLAMES
+// splits the segment into numBars flames (mirrored: every second one burns downwards)
+
+// Audio input on A0 (see AudioInput.h) - the sampling needs the build flag HAS_AUDIO_INPUT
+#define AUDIO_SAMPLE_RATE       1000  // Hz - one ADC read per ms (the most the WiFi tolerates)
+#define AUDIO_BLOCK_SIZE        32    // samples per analysis block (32 ms at 1000 Hz)
+#define AUDIO_BANDS             8     // Goertzel filters (50 .. 400 Hz)
+#define AUDIO_RING_SIZE         256   // samples buffered between two frames (power of 2)
+#define AUDIO_MIN_BEAT_MS       250   // shortest time between two beats
+
+// Effect layers on top of the effect (see LayerStack.h)
+#define LAYER_COUNT             2     // overlay layers (LED_COUNT * 3 bytes each while used)
+#define LAYER_BUDGET_US         2000  // render time per frame a layer may take before it gets slowed down
+#define LAYER_MAX_THROTTLE      3     // a slow layer renders at 1/2 .. 1/8 of its rate at most
+#define DEFAULT_LAYER_MODE      FX_MODE_SHOOTING_STAR
+#define DEFAULT_LAYER_OPACITY   0     // 0: layer off
+#define DEFAULT_LAYER_BLEND     0     // LayerStack::ADD
+
+// LED matrix (see MatrixLayout.h) - without MATRIX_WIDTH the strip is a line
+#ifdef MATRIX_WIDTH
+  #ifndef MATRIX_HEIGHT
+    #error "A matrix needs MATRIX_HEIGHT as well (build flag e.g. -DMATRIX_HEIGHT=16)"
+  #endif
+  #ifndef MATRIX_SERPENTINE
+    #define MATRIX_SERPENTINE     1     // every second row is wired backwards
+  #endif
+  #ifndef MATRIX_ROTATION
+    #define MATRIX_ROTATION       0     // quarter turns (clockwise) of the picture
+  #endif
+  #ifndef MATRIX_OFFSET
+    #define MATRIX_OFFSET         0     // first LED of the matrix in the strip
+  #endif
+  #if (MATRIX_OFFSET + MATRIX_WIDTH * MATRIX_HEIGHT) > LED_COUNT
+    #error "The matrix does not fit into LED_COUNT"
+  #endif
+#endif
+
 // KNOB CONTROL
 #ifdef HAS_KNOB_CONTROL
   #define DEFAULT_WIFI_DISABLED    (false)
@@ -0,0 +1,84 @@
+#ifndef PROFILER_h
+#define PROFILER_h
+
+/*
+ * Scoped profiling zones (build flag -DHAS_PROFILER).
+ *
+ *   PROFILE_ZONE("show");
+ *
+ * records the time from the macro till the end of the enclosing scope into
+ * a ring buffer of the last PROFILER_EVENTS events. The duration is measured
+ * with the ccount cycle counter, the start time with micros() (the cycle
+ * counter wraps after 53 s at 80 MHz). The ring can be dumped as Chrome
+ * trace_event JSON via /trace.
+ *
+ * Without HAS_PROFILER the macro expands to nothing.
+ */
+
+#ifdef HAS_PROFILER
+
+#include <Arduino.h>
+
+#ifndef PROFILER_EVENTS
+  #define PROFILER_EVENTS 128   // 12 bytes each
+#endif
+
+struct profilerEvent {
+  PGM_P    name;    // zone name (in flash)
+  uint32_t start;   // micros() at the start of the zone
+  uint32_t cycles;  // duration in CPU cycles
+};
+
+struct profilerRing {
+  profilerEvent events[PROFILER_EVENTS];
+  uint16_t      head;     // next event to be written
+  uint32_t      count;    // events recorded since boot
+  bool          frozen;   // no events are recorded while the ring is being dumped
+};
+
+// one ring for all translation units
+inline profilerRing & getProfilerRing(void)
+{
+  static profilerRing ring;
+  return ring;
+}
+
+static inline uint32_t profilerCycles(void)
+{
+  uint32_t ccount;
+  __asm__ __volatile__("rsr %0,ccount" : "=a"(ccount));
+  return ccount;
+}
+
+class ProfilerZone {
+  public:
+    explicit ProfilerZone(PGM_P name) : _name(name), _start(micros()), _cycles(profilerCycles()) {}
+    ~ProfilerZone()
+    {
+      const uint32_t cycles = profilerCycles() - _cycles;
+      profilerRing & ring = getProfilerRing();
+      if (ring.frozen) return;
+      profilerEvent & e = ring.events[ring.head];
+      e.name   = _name;
+      e.start  = _start;
+      e.cycles = cycles;
+      ring.head = (ring.head + 1) % PROFILER_EVENTS;
+      ring.count++;
+    }
+  private:
+    PGM_P    _name;
+    uint32_t _start;
+    uint32_t _cycles;
+};
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b)  PROFILER_CONCAT_(a, b)
+#define PROFILE_ZONE(name)     ProfilerZone PROFILER_CONCAT(_profilerZone, __LINE__)(PSTR(name))
+
+#else
+
+#define PROFILE_ZONE(name)
+
+#endif
+
+#endif
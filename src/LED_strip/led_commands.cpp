@@ -0,0 +1,394 @@
+#include "led_commands.h"
+#include "led_presets.h"
+#include "led_playlist.h"
+
+#if (LED_CMD_QUEUE_SIZE & (LED_CMD_QUEUE_SIZE - 1)) || (LED_CMD_QUEUE_SIZE > 128)
+#error "LED_CMD_QUEUE_SIZE needs to be a power of 2 and must not exceed 128"
+#endif
+
+// prevents the compiler from reordering the slot access and the index update
+#define CMD_QUEUE_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+// the ring buffer. _cmdHead is only written by the producer (network callbacks),
+// _cmdTail only by the consumer (render loop). uint8_t indices wrap at 256
+// which is a multiple of the (power of 2) queue size.
+static ledCommand        _cmdQueue[LED_CMD_QUEUE_SIZE];
+static volatile uint8_t  _cmdHead = 0;
+static volatile uint8_t  _cmdTail = 0;
+
+static ledCommandStats   _cmdStats = {0, 0, 0, 0, 0};
+
+// coalescing of field writes: last value per field and a bitmask of pending fields
+static uint32_t          _pendingValues[LED_CMD_MAX_FIELDS];
+static uint8_t           _pendingMask[(LED_CMD_MAX_FIELDS + 7) / 8];
+static bool              _hasPending = false;
+
+static bool              _solidColorChanged = false;
+
+// batch handling (producer side only): commands are staged behind _cmdHead
+// and only published with commitCommandBatch
+static bool              _batchActive = false;
+static bool              _batchFailed = false;
+static uint8_t           _batchHead   = 0;
+static uint8_t           _batchSource  = LED_SRC_HTTP;
+static uint32_t          _batchArrival = 0;
+
+// latency tracking (render loop only): the oldest and the newest input applied per source
+// since the last show and when the newest input of a source was shown
+static uint8_t           _appliedMask = 0;
+static uint32_t          _appliedOldest[LED_SRC_COUNT];
+static uint32_t          _appliedNewest[LED_SRC_COUNT];
+static uint32_t          _shownArrival[LED_SRC_COUNT];
+static uint32_t          _shownMicros[LED_SRC_COUNT];
+static bool              _shownValid[LED_SRC_COUNT];
+static ledLatencyStats   _latency[LED_SRC_COUNT];
+
+uint8_t getFieldIndex(const char * name)
+{
+  const Field * fields = getFields();
+  const uint8_t count  = getFieldCount();
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (strcmp(fields[i].name, name) == 0)
+    {
+      return i;
+    }
+  }
+  return count;
+}
+
+bool queueCommand(const ledCommand &cmd)
+{
+  const uint8_t head  = _batchActive ? _batchHead : _cmdHead;
+  const uint8_t depth = (uint8_t)(head - _cmdTail);
+  if (depth >= LED_CMD_QUEUE_SIZE || _batchFailed)
+  {
+    _batchFailed = _batchActive;
+    _cmdStats.dropped++;
+    return false;
+  }
+  ledCommand &slot = _cmdQueue[head & (LED_CMD_QUEUE_SIZE - 1)];
+  slot = cmd;
+  slot.source  = _batchActive ? _batchSource  : LED_SRC_HTTP;
+  slot.arrival = _batchActive ? _batchArrival : micros();
+
+  _cmdStats.queued++;
+  if (depth + 1 > _cmdStats.maxDepth)
+  {
+    _cmdStats.maxDepth = depth + 1;
+  }
+
+  if (_batchActive)
+  {
+    _batchHead = head + 1;
+    return true;
+  }
+  CMD_QUEUE_BARRIER();
+  _cmdHead = head + 1;
+  return true;
+}
+
+void beginCommandBatch(ledInputSources source)
+{
+  _batchActive  = true;
+  _batchFailed  = false;
+  _batchHead    = _cmdHead;
+  _batchSource  = source;
+  _batchArrival = micros();
+}
+
+uint32_t getCommandBatchArrival(void)
+{
+  return _batchArrival;
+}
+
+bool commitCommandBatch(void)
+{
+  if (!_batchActive) return false;
+  _batchActive = false;
+  if (_batchFailed)
+  {
+    // everything staged so far counts as dropped as well
+    const uint8_t staged = (uint8_t)(_batchHead - _cmdHead);
+    _cmdStats.dropped += staged;
+    _cmdStats.queued  -= staged;
+    _batchFailed = false;
+    return false;
+  }
+  CMD_QUEUE_BARRIER();
+  _cmdHead = _batchHead;
+  return true;
+}
+
+bool queueFieldValue(uint8_t field, uint32_t value)
+{
+  if (field >= getFieldCount() || field >= LED_CMD_MAX_FIELDS || !getFields()[field].setValue)
+  {
+    return false;
+  }
+  ledCommand cmd = { LED_CMD_SET_FIELD, field, 0, 0, 0, limitFieldValue(getFields()[field], value), 0 };
+  return queueCommand(cmd);
+}
+
+void cancelCommandBatch(void)
+{
+  if (!_batchActive) return;
+  _cmdStats.queued -= (uint8_t)(_batchHead - _cmdHead);
+  _batchActive = false;
+  _batchFailed = false;
+}
+
+// queues "value" for the field with index idx and adds the value to be applied to the answer
+static bool queueFieldAnswer(uint8_t idx, uint32_t value, JsonObject answer)
+{
+  const Field &f = getFields()[idx];
+  if (f.type == ColorFieldType)
+  {
+    ledCommand cmd = { LED_CMD_SOLID_COLOR, 0, 0, 0, 0, value & 0xffffff, 0 };
+    if (!queueCommand(cmd)) return false;
+    answer[f.name] = cmd.value;
+    return true;
+  }
+  value = limitFieldValue(f, value);
+  if (!queueFieldValue(idx, value)) return false;
+  answer[f.name] = getFieldValue(f, value);
+  return true;
+}
+
+bool queueFieldJSON(uint8_t field, JsonVariantConst value, JsonObject answer)
+{
+  if (field >= getFieldCount()) return false;
+
+  if (getFields()[field].type == ColorFieldType && value.is<const char *>())
+  {
+    return queueFieldAnswer(field, strtoul(value.as<const char *>(), NULL, 16), answer);
+  }
+  return queueFieldAnswer(field, value.as<uint32_t>(), answer);
+}
+
+uint8_t queueFieldsJSON(JsonObjectConst values, JsonObject answer)
+{
+  uint8_t queued = 0;
+  for (JsonPairConst kv : values)
+  {
+    if (queueFieldJSON(getFieldIndex(kv.key().c_str()), kv.value(), answer)) queued++;
+  }
+  return queued;
+}
+
+int16_t queueFieldsTLV(const uint8_t * data, size_t len, JsonObject answer)
+{
+  int16_t queued = 0;
+  size_t pos = 0;
+  while (pos + 2 <= len)
+  {
+    const uint8_t idx  = data[pos++];
+    const uint8_t vlen = data[pos++];
+    if (vlen > 4 || pos + vlen > len) return -1;
+
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < vlen; i++)
+    {
+      value |= (uint32_t)data[pos + i] << (8 * i);
+    }
+    pos += vlen;
+
+    if (idx >= getFieldCount()) continue;
+    if (queueFieldAnswer(idx, value, answer)) queued++;
+  }
+  return (pos == len) ? queued : -1;
+}
+
+// applies the coalesced field writes (in the order of the fields array)
+static void flushPendingFields(void)
+{
+  if (!_hasPending) return;
+
+  const Field * fields = getFields();
+  for (uint8_t i = 0; i < sizeof(_pendingMask); i++)
+  {
+    uint8_t mask = _pendingMask[i];
+    while (mask)
+    {
+      const uint8_t bit = __builtin_ctz(mask);
+      const uint8_t idx = i * 8 + bit;
+      mask &= mask - 1;
+      fields[idx].setValue(_pendingValues[idx]);
+      _cmdStats.applied++;
+    }
+    _pendingMask[i] = 0;
+  }
+  _hasPending = false;
+}
+
+static void applyCommand(const ledCommand &cmd)
+{
+  switch (cmd.type)
+  {
+    case LED_CMD_SOLID_COLOR:
+      strip->setSolidColor(cmd.value);
+      strip->setColor(cmd.value);
+      _solidColorChanged = true;
+      break;
+    case LED_CMD_RGB:
+      strip->setColor(cmd.value);
+      strip->setPower(true);
+      strip->setMode(FX_MODE_STATIC);
+      break;
+    case LED_CMD_PIXELS:
+      // set the VOID directly avoiding the call to "setTransition"
+      // which would clear the (currently written data first
+      strip->getSegment()->mode = FX_MODE_VOID;
+      strip->setPower(true);
+      for (uint16_t i = cmd.start; i <= cmd.end && i < LED_COUNT_TOT; i++)
+      {
+        strip->physicalLeds[i] = CRGB(cmd.value);
+      }
+      break;
+    case LED_CMD_FREE_PIXELS:
+      #if LED_OFFSET > 0
+      for (uint16_t i = cmd.start; i <= cmd.end && i < LED_OFFSET; i++)
+      {
+        strip->physicalLeds[i] = CRGB(cmd.value);
+      }
+      #endif
+      break;
+    case LED_CMD_PRESET:
+      presetApply((uint8_t)cmd.value);
+      break;
+    case LED_CMD_PLAYLIST:
+      playlistStart((uint8_t)cmd.value);
+      break;
+    default:
+      break;
+  }
+  _cmdStats.applied++;
+}
+
+void applyQueuedCommands(void)
+{
+  // take a snapshot of the producer index - whatever comes in meanwhile
+  // will be handled with the next frame
+  const uint8_t head = _cmdHead;
+  CMD_QUEUE_BARRIER();
+  uint8_t tail = _cmdTail;
+
+  if (tail == head) return;
+
+  while (tail != head)
+  {
+    const ledCommand &cmd = _cmdQueue[tail & (LED_CMD_QUEUE_SIZE - 1)];
+    noteInputApplied((ledInputSources)cmd.source, cmd.arrival);
+    if (cmd.type == LED_CMD_SET_FIELD)
+    {
+      const uint8_t byteIdx = cmd.field >> 3;
+      const uint8_t bitMask = 1 << (cmd.field & 0x07);
+      if (_pendingMask[byteIdx] & bitMask)
+      {
+        _cmdStats.coalesced++;
+      }
+      _pendingMask[byteIdx] |= bitMask;
+      _pendingValues[cmd.field] = cmd.value;
+      _hasPending = true;
+    }
+    else
+    {
+      // keep the order between field writes and other commands
+      flushPendingFields();
+      applyCommand(cmd);
+    }
+    tail++;
+  }
+  CMD_QUEUE_BARRIER();
+  _cmdTail = tail;
+
+  flushPendingFields();
+}
+
+void noteInputApplied(ledInputSources source, uint32_t arrival)
+{
+  if (source >= LED_SRC_COUNT) return;
+  const uint8_t bit = 1 << source;
+  if (!(_appliedMask & bit))
+  {
+    _appliedMask |= bit;
+    _appliedOldest[source] = arrival;
+    _appliedNewest[source] = arrival;
+    return;
+  }
+  if ((int32_t)(arrival - _appliedOldest[source]) < 0) _appliedOldest[source] = arrival;
+  if ((int32_t)(arrival - _appliedNewest[source]) > 0) _appliedNewest[source] = arrival;
+}
+
+void inputsShown(void)
+{
+  if (!_appliedMask) return;
+  const uint32_t now = micros();
+  for (uint8_t s = 0; s < LED_SRC_COUNT; s++)
+  {
+    if (!(_appliedMask & (1 << s))) continue;
+    // one sample per source and frame: the input waiting the longest
+    const uint32_t latency = now - _appliedOldest[s];
+    ledLatencyStats &l = _latency[s];
+    l.samples[l.next] = latency;
+    l.next = (l.next + 1) % LED_LATENCY_SAMPLES;
+    l.count++;
+    if (latency > l.max) l.max = latency;
+    _shownArrival[s] = _appliedNewest[s];
+    _shownMicros[s]  = now;
+    _shownValid[s]   = true;
+  }
+  _appliedMask = 0;
+}
+
+bool getInputShown(ledInputSources source, uint32_t arrival, uint32_t &latency)
+{
+  if (source >= LED_SRC_COUNT || !_shownValid[source]) return false;
+  if ((int32_t)(_shownArrival[source] - arrival) < 0) return false;
+  latency = _shownMicros[source] - arrival;
+  return true;
+}
+
+const ledLatencyStats * getLatencyStats(ledInputSources source)
+{
+  return &_latency[source];
+}
+
+uint32_t getLatencyPercentile(ledInputSources source, uint8_t percent)
+{
+  const ledLatencyStats &l = _latency[source];
+  const uint8_t n = min(l.count, (uint32_t)LED_LATENCY_SAMPLES);
+  if (!n) return 0;
+  // insertion sort of a copy - only done when the stats are requested
+  uint32_t sorted[LED_LATENCY_SAMPLES];
+  for (uint8_t i = 0; i < n; i++)
+  {
+    uint32_t v = l.samples[i];
+    uint8_t j = i;
+    while (j > 0 && sorted[j - 1] > v)
+    {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = v;
+  }
+  const uint8_t idx = min((uint16_t)((n * percent) / 100), (uint16_t)(n - 1));
+  return sorted[idx];
+}
+
+uint8_t getCommandQueueDepth(void)
+{
+  return (uint8_t)(_cmdHead - _cmdTail);
+}
+
+const ledCommandStats * getCommandStats(void)
+{
+  return &_cmdStats;
+}
+
+bool getSolidColorChanged(void)
+{
+  const bool ret = _solidColorChanged;
+  _solidColorChanged = false;
+  return ret;
+}
@@ -0,0 +1,125 @@
+#ifndef led_commands_h
+#define led_commands_h
+
+#include "led_strip.h"
+
+/*
+ * Command queue between the network handlers and the render loop.
+ *
+ * The async web server callbacks (producer) do not touch the strip directly.
+ * They put typed commands into a bounded single producer / single consumer
+ * ring buffer. The render loop (consumer) applies all pending commands at
+ * the start of the next frame (see WS2812FX::setCommandHandler).
+ *
+ * Repeated writes to the same field within one drain are coalesced,
+ * i.e. only the last value gets applied.
+ */
+
+enum ledCommandTypes : uint8_t {
+  LED_CMD_SET_FIELD,      // set the field with index "field" to "value"
+  LED_CMD_SOLID_COLOR,    // set the solid color (and the color palette) to "value" (0xRRGGBB)
+  LED_CMD_RGB,            // switch to the static effect with color "value" (0xRRGGBB)
+  LED_CMD_PIXELS,         // set the (physical) pixels "start" to "end" to "value" and switch to VOID
+  LED_CMD_FREE_PIXELS,    // set the pixels "start" to "end" within the LED_OFFSET area (effect untouched)
+  LED_CMD_PRESET,         // recall the preset with id "value" (see led_presets.h)
+  LED_CMD_PLAYLIST        // start the playlist with id "value" - 0 stops (see led_playlist.h)
+};
+
+// where a command (or input) came from - latency is tracked per source
+enum ledInputSources : uint8_t {
+  LED_SRC_HTTP,
+  LED_SRC_WS,
+  LED_SRC_KNOB,
+  LED_SRC_UDP,
+  LED_SRC_COUNT
+};
+
+struct ledCommand {
+  ledCommandTypes type;
+  uint8_t  field;
+  uint8_t  source;        // set by queueCommand
+  uint16_t start;
+  uint16_t end;
+  uint32_t value;
+  uint32_t arrival;       // micros() when the command was queued - set by queueCommand
+};
+
+// counters to monitor the queue (exposed via /status)
+struct ledCommandStats {
+  uint32_t queued;      // commands accepted
+  uint32_t applied;     // commands applied (field writes after coalescing)
+  uint32_t coalesced;   // field writes replaced by a later write to the same field
+  uint32_t dropped;     // commands rejected because the queue was full
+  uint8_t  maxDepth;    // high water mark of the queue
+};
+
+// latency from the arrival of an input till the first FastLED.show() after it was applied
+// (UDP: from the poll finding the packet - see led_realtime.h)
+struct ledLatencyStats {
+  uint32_t count;                         // inputs shown
+  uint32_t max;                           // us
+  uint32_t samples[LED_LATENCY_SAMPLES];  // the last latencies in us
+  uint8_t  next;
+};
+
+// returns the index of the field with the given name within the fields array
+// or getFieldCount() if there is no such field
+uint8_t getFieldIndex(const char * name);
+
+// queues a command - returns false (and counts the drop) if the queue is full
+bool queueCommand(const ledCommand &cmd);
+
+// commands queued between beginCommandBatch and commitCommandBatch are published
+// at once and therefore applied within the same frame. If one of them does not
+// fit into the queue, the complete batch gets dropped.
+// All commands of the batch carry the source and the arrival time of the batch.
+void beginCommandBatch(ledInputSources source = LED_SRC_HTTP);
+// arrival time (micros) of the last batch begun
+uint32_t getCommandBatchArrival(void);
+// returns false if the batch was dropped
+bool commitCommandBatch(void);
+// discards all commands staged since beginCommandBatch (e.g. on malformed input)
+void cancelCommandBatch(void);
+
+// queues a write of "value" to the field with index "field"
+// Number and Boolean values are limited to the field boundaries
+// returns false if the field can not be set or the queue is full
+bool queueFieldValue(uint8_t field, uint32_t value);
+
+// queues the JSON value for the field with index "field" and writes the value to be applied to "answer"
+// Color fields accept the color as number or hex string.
+// returns false if the field can not be set or the queue is full
+bool queueFieldJSON(uint8_t field, JsonVariantConst value, JsonObject answer);
+// queues all name / value pairs of the JSON object (e.g. {"power":1,"brightness":120})
+// and writes the values to be applied to "answer".
+// returns the number of queued values
+uint8_t queueFieldsJSON(JsonObjectConst values, JsonObject answer);
+// queues the values of a binary TLV sequence and writes the values to be applied to "answer"
+// each entry: [field index (uint8)][length (uint8, 0..4)][value (length bytes, little endian)]
+// returns the number of queued values or -1 if the data is malformed
+int16_t queueFieldsTLV(const uint8_t * data, size_t len, JsonObject answer);
+
+// applies all queued commands - to be called from the render loop only
+void applyQueuedCommands(void);
+
+// notes an input applied directly in the render loop (e.g. knob or UDP data)
+// to be tracked until it gets shown
+void noteInputApplied(ledInputSources source, uint32_t arrival);
+// to be called after each FastLED.show() - turns the applied inputs into latency samples
+void inputsShown(void);
+// returns true once the input of "source" with "arrival" (or a later one) was shown
+// and the latency of that show in us
+bool getInputShown(ledInputSources source, uint32_t arrival, uint32_t &latency);
+const ledLatencyStats * getLatencyStats(ledInputSources source);
+// latency (us) below which "percent" of the last samples are
+uint32_t getLatencyPercentile(ledInputSources source, uint8_t percent);
+
+// current number of queued commands
+uint8_t getCommandQueueDepth(void);
+// the queue statistics
+const ledCommandStats * getCommandStats(void);
+
+// returns true (once) if the solid color was changed by a command
+bool getSolidColorChanged(void);
+
+#endif
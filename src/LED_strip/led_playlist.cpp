@@ -0,0 +1,275 @@
+#include "led_playlist.h"
+#include "led_presets.h"
+#include "led_settings.h"
+#include "led_commands.h"
+#include "profiler.h"
+#include <LittleFS.h>
+
+#define PLAYLIST_TEMP_FILE    "/playlist.tmp"
+#define PLAYLIST_FILE_MAGIC   0x31504C4CUL  // "LLP1"
+
+struct playlistFileHeader {
+  uint32_t magic;
+  uint8_t  count;
+  uint16_t crc;         // of the entries
+} __attribute__((packed));
+
+// preparation of the next entry - one step per spare cycle
+enum playlistStages : uint8_t {
+  PLAYLIST_STAGE_IDLE,      // nothing prepared
+  PLAYLIST_STAGE_PRESET,    // the preset of the next entry is in _tlv
+  PLAYLIST_STAGE_READY      // the effect is prepared (or can not be)
+};
+
+static playlistEntry     _entries[PLAYLIST_MAX_ENTRIES];
+static uint8_t           _count    = 0;
+static uint8_t           _playing  = 0;     // id of the playlist playing
+static uint8_t           _current  = 0;     // entry shown
+static uint32_t          _switchAt = 0;     // millis() when the next entry is due
+static playlistStages    _stage    = PLAYLIST_STAGE_IDLE;
+static uint8_t           _tlv[PLAYLIST_PRESET_BUFFER];
+static size_t            _tlvLength = 0;    // 0: the next entry has no (readable) preset
+static WS2812FX::segment _scene;            // values of the next entry
+static CRGB *            _scratch  = NULL;  // drawn into by the effects prepared
+
+static inline uint16_t playlistCRC(const uint8_t * buf, size_t len)
+{
+  return (uint16_t)WS2812FX::calc_CRC16(0x5a5a, (unsigned char *)buf, len);
+}
+
+static inline void playlistPath(uint8_t id, char * path, size_t size)
+{
+  snprintf_P(path, size, PSTR("/playlist_%u.bin"), id);
+}
+
+bool playlistSave(uint8_t id, const playlistEntry * entries, uint8_t count)
+{
+  if (!id || id > PLAYLIST_MAX || !count || count > PLAYLIST_MAX_ENTRIES) return false;
+
+  const size_t len = count * sizeof(playlistEntry);
+  playlistFileHeader hdr = { PLAYLIST_FILE_MAGIC, count, playlistCRC((const uint8_t *)entries, len) };
+
+  char path[20];
+  playlistPath(id, path, sizeof(path));
+  File f = LittleFS.open(PLAYLIST_TEMP_FILE, "w");
+  bool ok = static_cast<bool>(f);
+  ok = ok && f.write((const uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr);
+  ok = ok && f.write((const uint8_t *)entries, len) == len;
+  if (f) f.close();
+  // the rename replaces the previous playlist atomically
+  if (!ok || !LittleFS.rename(PLAYLIST_TEMP_FILE, path))
+  {
+    LittleFS.remove(PLAYLIST_TEMP_FILE);
+    return false;
+  }
+  return true;
+}
+
+bool playlistDelete(uint8_t id)
+{
+  char path[20];
+  playlistPath(id, path, sizeof(path));
+  return LittleFS.remove(path);
+}
+
+uint8_t playlistRead(uint8_t id, playlistEntry * entries, uint8_t max)
+{
+  if (!id || id > PLAYLIST_MAX) return 0;
+  char path[20];
+  playlistPath(id, path, sizeof(path));
+  File f = LittleFS.open(path, "r");
+  if (!f) return 0;
+
+  playlistFileHeader hdr = { 0, 0, 0 };
+  const bool ok = f.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) && hdr.magic == PLAYLIST_FILE_MAGIC &&
+                  hdr.count && hdr.count <= max &&
+                  f.read((uint8_t *)entries, hdr.count * sizeof(playlistEntry)) == hdr.count * sizeof(playlistEntry) &&
+                  hdr.crc == playlistCRC((const uint8_t *)entries, hdr.count * sizeof(playlistEntry));
+  f.close();
+  return ok ? hdr.count : 0;
+}
+
+// one value of an entry - "keep" if empty or "-"
+static bool parseValue(const char ** p, uint32_t keep, uint32_t max, uint32_t * value)
+{
+  const char * s = *p;
+  if (*s == '-')
+  {
+    *value = keep;
+    *p = s + 1;
+    return true;
+  }
+  if (*s == ':' || *s == ',' || *s == '\0')
+  {
+    *value = keep;
+    return true;
+  }
+  if (*s < '0' || *s > '9') return false;
+  char * end;
+  *value = strtoul(s, &end, 10);
+  *p = end;
+  return *value <= max;
+}
+
+uint8_t playlistParse(const char * text, playlistEntry * entries, uint8_t max)
+{
+  uint8_t count = 0;
+  const char * p = text;
+  while (p && *p)
+  {
+    if (count >= max) return 0;
+    uint32_t v[5];
+    static const uint32_t keep[5]  = { 0, PLAYLIST_KEEP, PLAYLIST_KEEP, 0, 0 };
+    static const uint32_t limit[5] = { 255, MODE_AVAILABLE_COUNT - 1, 255, BEAT88_MAX, 0xFFFF };
+    for (uint8_t i = 0; i < 5; i++)
+    {
+      if (!parseValue(&p, keep[i], limit[i], &v[i])) return 0;
+      if (i < 4 && *p++ != ':') return 0;
+    }
+    if (!v[4] || (*p && *p++ != ',')) return 0;
+    playlistEntry &e = entries[count++];
+    e.preset   = v[0];
+    e.mode     = v[1];
+    e.palette  = v[2];
+    e.reserved = 0;
+    e.speed    = v[3];
+    e.duration = v[4];
+  }
+  return count;
+}
+
+bool queuePlaylist(uint8_t id)
+{
+  if (id)
+  {
+    char path[20];
+    playlistPath(id, path, sizeof(path));
+    if (id > PLAYLIST_MAX || !LittleFS.exists(path)) return false;
+  }
+  ledCommand cmd = { LED_CMD_PLAYLIST, 0, 0, 0, 0, id, 0 };
+  return queueCommand(cmd);
+}
+
+// the values of the entry: the current ones, the preset read (_tlv) on top and the ones of the entry on top of that
+static void buildScene(const playlistEntry &e, WS2812FX::segment * scene)
+{
+  *scene = *strip->getSegment();
+  const bool preset = _tlvLength && settingsDecode(_tlv, _tlvLength, scene);
+  if (e.mode != PLAYLIST_KEEP) scene->mode = min(e.mode, (uint8_t)(MODE_AVAILABLE_COUNT - 1));
+  // the speed the effect runs with (see WS2812FX::setMode)
+  if (e.speed)
+  {
+    scene->beat88 = constrain(e.speed, BEAT88_MIN, BEAT88_MAX);
+  }
+  else if (!preset && scene->effectSpeeds[scene->mode])
+  {
+    scene->beat88 = scene->effectSpeeds[scene->mode];
+  }
+  if (e.palette != PLAYLIST_KEEP) scene->targetPaletteNum = e.palette;
+  // the playlist chooses the effects
+  scene->autoplay = AUTO_MODE_OFF;
+}
+
+static void readPreset(const playlistEntry &e)
+{
+  // an unknown (or too large) preset leaves the values as they are
+  _tlvLength = e.preset ? presetRead(e.preset, _tlv, sizeof(_tlv)) : 0;
+}
+
+static void showEntry(uint8_t index)
+{
+  PROFILE_ZONE("playlistSwitch");
+  const playlistEntry &e = _entries[index];
+  if (_stage == PLAYLIST_STAGE_IDLE)
+  {
+    // not prepared in time - the preset is read now
+    readPreset(e);
+  }
+  // the values (built again: the ones changed meanwhile are kept)
+  buildScene(e, &_scene);
+  if (_tlvLength)
+  {
+    presetApplyScene(_scene);
+  }
+  else
+  {
+    strip->setMode(_scene.mode);
+    strip->setBeat88(_scene.beat88);
+    if (e.palette != PLAYLIST_KEEP) strip->setTargetPalette(_scene.targetPaletteNum);
+    strip->setAutoplay(AUTO_MODE_OFF);
+  }
+  _current  = index;
+  _switchAt = millis() + (uint32_t)max(e.duration, (uint16_t)1) * 1000;
+  _stage    = PLAYLIST_STAGE_IDLE;
+}
+
+bool playlistStart(uint8_t id)
+{
+  playlistStop();
+  if (!id) return true;
+
+  _count = playlistRead(id, _entries, PLAYLIST_MAX_ENTRIES);
+  if (!_count) return false;
+  // allocated once per playlist - fine if it fails, the effects are not prepared then
+  _scratch = (CRGB *)malloc(LED_COUNT * sizeof(CRGB));
+  // the effects of the entries get constructed once - reused with each switch
+  uint8_t modes[PLAYLIST_MAX_ENTRIES];
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    readPreset(_entries[i]);
+    buildScene(_entries[i], &_scene);
+    modes[i] = _scene.mode;
+  }
+  strip->poolEffects(modes, _count, _scratch);
+  _playing = id;
+  showEntry(0);
+  return true;
+}
+
+void playlistStop(void)
+{
+  if (!_playing) return;
+  strip->discardPreparedEffect();
+  strip->releaseEffectPool();
+  free(_scratch);
+  _scratch = NULL;
+  _playing = 0;
+  _count   = 0;
+  _stage   = PLAYLIST_STAGE_IDLE;
+}
+
+uint8_t getPlaylistPlaying(uint8_t * entry)
+{
+  if (entry) *entry = _current;
+  return _playing;
+}
+
+void playlistService(void)
+{
+  if (!_playing || (int32_t)(millis() - _switchAt) < 0) return;
+  showEntry((_current + 1) % _count);
+}
+
+void playlistPrepare(void)
+{
+  if (!_playing || _stage == PLAYLIST_STAGE_READY) return;
+  if ((int32_t)(millis() - (_switchAt - PLAYLIST_PREPARE_MS)) < 0) return;
+
+  PROFILE_ZONE("playlistPrepare");
+  const playlistEntry &e = _entries[(_current + 1) % _count];
+  if (_stage == PLAYLIST_STAGE_IDLE)
+  {
+    // the file system access first...
+    readPreset(e);
+    _stage = PLAYLIST_STAGE_PRESET;
+    return;
+  }
+  // ...the effect with the next spare cycle
+  buildScene(e, &_scene);
+  if (_scene.mode != strip->getMode())
+  {
+    // initialized with the time of the switch - the effect starts its phase there, not now
+    strip->prepareEffect(_scene, _scratch, GET_MILLIS() + (_switchAt - millis()));
+  }
+  _stage = PLAYLIST_STAGE_READY;
+}
@@ -0,0 +1,66 @@
+#ifndef led_playlist_h
+#define led_playlist_h
+
+#include "led_strip.h"
+
+/*
+ * Playlists (sequences of effects / presets) stored on LittleFS.
+ *
+ *   /playlist_<id>.bin:  [magic (4)][count (1)][CRC16 (2)][playlistEntry]...
+ *
+ * An entry shows a preset, an effect or an effect with the values of a
+ * preset for "duration" seconds - the playlist repeats after the last one.
+ * While a playlist plays the autoplay is off.
+ *
+ * The next entry gets prepared within the last PLAYLIST_PREPARE_MS of the
+ * current one on spare cycles (see WS2812FX::setIdleHandler), one step per
+ * call: first the preset gets read from the file system, then the effect
+ * gets initialized (see WS2812FX::prepareEffect) with the timebase of the
+ * switch. The switch (at the start of a frame) only applies the values - the
+ * prepared effect is taken over with the next render.
+ *
+ * Memory: the entries, the preset data and the values of the next entry are
+ * static. The scratch buffer for the effects being initialized ahead and the
+ * effects of the entries (see WS2812FX::poolEffects, with the buffers of their
+ * init(), e.g. Fire2012 or TwinkleMap) get allocated when a playlist starts
+ * and freed when it stops. While it plays a switch initializes the pooled
+ * effect again - nothing gets constructed, freed or allocated.
+ */
+
+#define PLAYLIST_KEEP 0xFF        // mode / palette of an entry: the one of the preset (or the current one)
+
+struct playlistEntry {
+  uint8_t  preset;                // preset to be recalled (0: none)
+  uint8_t  mode;                  // effect or PLAYLIST_KEEP
+  uint8_t  palette;               // palette or PLAYLIST_KEEP
+  uint8_t  reserved;
+  uint16_t speed;                 // beat88 (0: the speed of the preset or the one stored for the effect)
+  uint16_t duration;              // s
+};
+
+// stores the playlist "id" (1..PLAYLIST_MAX) - returns false if writing failed
+bool playlistSave(uint8_t id, const playlistEntry * entries, uint8_t count);
+// removes the playlist "id" - returns false if there is no such playlist
+// (playing it goes on until it gets stopped - the entries are in RAM)
+bool playlistDelete(uint8_t id);
+// reads the entries of playlist "id" - returns their number (0: no such playlist)
+uint8_t playlistRead(uint8_t id, playlistEntry * entries, uint8_t max);
+
+// parses entries given as text: "<preset>:<mode>:<palette>:<speed>:<duration>,..."
+// (empty or "-" values: 0 / PLAYLIST_KEEP) - returns their number (0: malformed)
+uint8_t playlistParse(const char * text, playlistEntry * entries, uint8_t max);
+
+// queues the start of the playlist "id" (0: stop) - returns false for an unknown playlist or a full queue
+bool queuePlaylist(uint8_t id);
+// starts playing the playlist "id" with its first entry (0 stops) - to be called from the render loop only
+bool playlistStart(uint8_t id);
+void playlistStop(void);
+// the playlist playing (0: none) and the index of the entry shown
+uint8_t getPlaylistPlaying(uint8_t * entry);
+
+// switches to the next entry when due - at the start of each frame
+void playlistService(void);
+// prepares the next entry - on spare cycles
+void playlistPrepare(void);
+
+#endif
@@ -0,0 +1,265 @@
+#include "led_presets.h"
+#include "led_settings.h"
+#include "led_commands.h"
+#include "profiler.h"
+#include <LittleFS.h>
+
+#define PRESET_INDEX_FILE     "/presets.idx"
+#define PRESET_TEMP_FILE      "/presets.tmp"
+#define PRESET_INDEX_MAGIC    0x3149504CUL  // "LPI1"
+#define PRESET_FILE_MAGIC     0x3150534CUL  // "LSP1"
+#define PRESET_MAX_LENGTH     1024          // sanity limit of the values of a preset
+
+struct presetFileHeader {
+  uint32_t magic;
+  uint16_t length;      // of the values
+  uint16_t crc;         // of the values
+};
+
+static presetEntry _presets[PRESET_MAX];
+static uint8_t     _presetCount   = 0;
+static bool        _presetApplied = false;
+
+// the save / delete queued by the web server (see presetService)
+static volatile uint8_t _pendingId     = 0;
+static bool             _pendingDelete = false;
+static char             _pendingName[PRESET_NAME_LENGTH + 1];
+
+static inline uint16_t presetCRC(const uint8_t * buf, size_t len)
+{
+  return (uint16_t)WS2812FX::calc_CRC16(0x5a5a, (unsigned char *)buf, len);
+}
+
+static inline void presetPath(uint8_t id, char * path, size_t size)
+{
+  snprintf_P(path, size, PSTR("/preset_%u.bin"), id);
+}
+
+static int16_t findPreset(uint8_t id)
+{
+  for (uint8_t i = 0; i < _presetCount; i++)
+  {
+    if (_presets[i].id == id) return i;
+  }
+  return -1;
+}
+
+static bool writeIndex(void)
+{
+  const uint32_t magic = PRESET_INDEX_MAGIC;
+  File f = LittleFS.open(PRESET_TEMP_FILE, "w");
+  bool ok = static_cast<bool>(f);
+  ok = ok && f.write((const uint8_t *)&magic, sizeof(magic)) == sizeof(magic);
+  ok = ok && f.write(&_presetCount, 1) == 1;
+  ok = ok && f.write((const uint8_t *)_presets, _presetCount * sizeof(presetEntry)) == _presetCount * sizeof(presetEntry);
+  if (f) f.close();
+  // the rename replaces the previous index atomically
+  if (!ok || !LittleFS.rename(PRESET_TEMP_FILE, PRESET_INDEX_FILE))
+  {
+    LittleFS.remove(PRESET_TEMP_FILE);
+    return false;
+  }
+  return true;
+}
+
+void presetsBegin(void)
+{
+  _presetCount = 0;
+  File f = LittleFS.open(PRESET_INDEX_FILE, "r");
+  if (!f) return;
+
+  uint32_t magic = 0;
+  uint8_t  count = 0;
+  if (f.read((uint8_t *)&magic, sizeof(magic)) == sizeof(magic) && magic == PRESET_INDEX_MAGIC &&
+      f.read(&count, 1) == 1 && count <= PRESET_MAX &&
+      f.read((uint8_t *)_presets, count * sizeof(presetEntry)) == count * sizeof(presetEntry))
+  {
+    _presetCount = count;
+    for (uint8_t i = 0; i < _presetCount; i++)
+    {
+      _presets[i].name[PRESET_NAME_LENGTH] = '\0';
+    }
+  }
+  f.close();
+}
+
+bool presetSave(uint8_t id, const char * name)
+{
+  if (!id) return false;
+  int16_t idx = findPreset(id);
+  if (idx < 0 && _presetCount >= PRESET_MAX) return false;
+
+  const size_t size = settingsEncodedSize(SETTINGS_FLAG_DEVICE);
+  uint8_t * tlv = (uint8_t *)malloc(size);
+  if (!tlv) return false;
+
+  const size_t len = settingsEncode(strip->getSegment(), SETTINGS_FLAG_DEVICE, tlv, size);
+  presetFileHeader hdr = { PRESET_FILE_MAGIC, (uint16_t)len, presetCRC(tlv, len) };
+
+  char path[20];
+  presetPath(id, path, sizeof(path));
+  File f = LittleFS.open(path, "w");
+  bool ok = static_cast<bool>(f) && len;
+  ok = ok && f.write((const uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr);
+  ok = ok && f.write(tlv, len) == len;
+  if (f) f.close();
+  free(tlv);
+  if (!ok)
+  {
+    LittleFS.remove(path);
+    return false;
+  }
+
+  if (idx < 0)
+  {
+    // keep the index ordered by id
+    idx = _presetCount;
+    while (idx > 0 && _presets[idx - 1].id > id)
+    {
+      _presets[idx] = _presets[idx - 1];
+      idx--;
+    }
+    _presetCount++;
+  }
+  _presets[idx].id = id;
+  strncpy(_presets[idx].name, name ? name : "", PRESET_NAME_LENGTH);
+  _presets[idx].name[PRESET_NAME_LENGTH] = '\0';
+  return writeIndex();
+}
+
+bool presetDelete(uint8_t id)
+{
+  const int16_t idx = findPreset(id);
+  if (idx < 0) return false;
+
+  for (uint8_t i = idx; i + 1 < _presetCount; i++)
+  {
+    _presets[i] = _presets[i + 1];
+  }
+  _presetCount--;
+
+  char path[20];
+  presetPath(id, path, sizeof(path));
+  LittleFS.remove(path);
+  return writeIndex();
+}
+
+bool queuePresetSave(uint8_t id, const char * name)
+{
+  if (!id || _pendingId) return false;
+  if (findPreset(id) < 0 && _presetCount >= PRESET_MAX) return false;
+  strncpy(_pendingName, name ? name : "", PRESET_NAME_LENGTH);
+  _pendingName[PRESET_NAME_LENGTH] = '\0';
+  _pendingDelete = false;
+  _pendingId     = id;
+  return true;
+}
+
+bool queuePresetDelete(uint8_t id)
+{
+  if (_pendingId || findPreset(id) < 0) return false;
+  _pendingDelete = true;
+  _pendingId     = id;
+  return true;
+}
+
+void presetService(void)
+{
+  if (!_pendingId) return;
+  PROFILE_ZONE("presetService");
+  if (_pendingDelete)
+  {
+    presetDelete(_pendingId);
+  }
+  else
+  {
+    presetSave(_pendingId, _pendingName);
+  }
+  _pendingId = 0;
+}
+
+bool queuePresetRecall(uint8_t id)
+{
+  if (findPreset(id) < 0) return false;
+  ledCommand cmd = { LED_CMD_PRESET, 0, 0, 0, 0, id, 0 };
+  return queueCommand(cmd);
+}
+
+size_t presetRead(uint8_t id, uint8_t * buf, size_t size)
+{
+  PROFILE_ZONE("presetRead");
+  char path[20];
+  presetPath(id, path, sizeof(path));
+  File f = LittleFS.open(path, "r");
+  if (!f) return 0;
+
+  presetFileHeader hdr = { 0, 0, 0 };
+  bool ok = f.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) && hdr.magic == PRESET_FILE_MAGIC &&
+            hdr.length && hdr.length <= PRESET_MAX_LENGTH;
+  // without a buffer only the length is asked for
+  if (ok && buf)
+  {
+    ok = hdr.length <= size &&
+         f.read(buf, hdr.length) == hdr.length &&
+         hdr.crc == presetCRC(buf, hdr.length);
+  }
+  f.close();
+  return ok ? hdr.length : 0;
+}
+
+void presetApplyScene(WS2812FX::segment &scene)
+{
+  WS2812FX::segment * s = strip->getSegment();
+
+  // setMode keeps the speed of the current effect and takes care of the VOID mode
+  strip->setMode(scene.mode);
+  // the preset does not hold the speeds per effect (the ones just updated are kept)
+  memcpy(scene.effectSpeeds, s->effectSpeeds, sizeof(scene.effectSpeeds));
+  *s = scene;
+
+  // the values with side effects (derived state, timers)
+  strip->setBeat88(s->beat88);
+  strip->setTargetPalette(s->targetPaletteNum);
+  strip->setBlur(s->blur);
+  strip->setHuetime(s->hueTime);
+  strip->setAutoplayDuration(s->autoplayDuration);
+  strip->setAutopalDuration(s->autoPalDuration);
+  strip->setSegments(s->segments);
+  strip->setNumBars(s->numBars);
+  // one transition for all of it
+  strip->setTransition();
+
+  _presetApplied = true;
+}
+
+bool presetApply(uint8_t id)
+{
+  PROFILE_ZONE("presetApply");
+  const size_t len = presetRead(id, NULL, 0);
+  uint8_t * tlv = len ? (uint8_t *)malloc(len) : NULL;
+  WS2812FX::segment scene = *strip->getSegment();
+  const bool ok = tlv && presetRead(id, tlv, len) == len && settingsDecode(tlv, len, &scene);
+  free(tlv);
+  if (!ok) return false;
+  presetApplyScene(scene);
+  return true;
+}
+
+bool getPresetApplied(void)
+{
+  const bool applied = _presetApplied;
+  _presetApplied = false;
+  return applied;
+}
+
+const presetEntry * getPresets(uint8_t * count)
+{
+  *count = _presetCount;
+  return _presets;
+}
+
+const presetEntry * getPreset(uint8_t id)
+{
+  const int16_t idx = findPreset(id);
+  return idx < 0 ? NULL : &_presets[idx];
+}
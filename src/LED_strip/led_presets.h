@@ -0,0 +1,59 @@
+#ifndef led_presets_h
+#define led_presets_h
+
+#include "led_strip.h"
+
+/*
+ * Presets (scenes) stored on LittleFS.
+ *
+ *   PRESET_INDEX_FILE:  [magic (4)][count (1)][presetEntry]...    (kept in RAM)
+ *   /preset_<id>.bin:   [magic (4)][length (2)][CRC16 (2)][value]...
+ *
+ * A preset holds all values of the segment except the ones belonging to the
+ * device (SETTINGS_FLAG_DEVICE, e.g. the current limit) encoded like the
+ * settings (see settingsEncode). Presets stored by an older firmware
+ * therefore keep working - missing values keep their current value.
+ *
+ * A recall is queued as a single command (LED_CMD_PRESET) and applied at once
+ * at the start of a frame with a single transition (see presetApply).
+ * A save or delete is queued as well (one at a time) and written by
+ * presetService - the values saved are the ones of the frame shown then.
+ */
+
+struct presetEntry {
+  uint8_t id;                             // 1..255
+  char    name[PRESET_NAME_LENGTH + 1];
+};
+
+// reads the index of the stored presets - LittleFS needs to be mounted
+void presetsBegin(void);
+// stores the current values of the strip as preset "id" (replacing an existing one)
+// returns false if all PRESET_MAX presets are in use or writing failed - to be called from the loop only
+bool presetSave(uint8_t id, const char * name);
+// removes the preset "id" - returns false if there is no such preset - to be called from the loop only
+bool presetDelete(uint8_t id);
+// queue the save / delete for presetService (the web server does not write the file system)
+// return false if a save / delete is still pending, all presets are in use or there is no such preset
+bool queuePresetSave(uint8_t id, const char * name);
+bool queuePresetDelete(uint8_t id);
+// writes the save / delete queued (if any) - from the loop after a frame was shown (like settingsService)
+void presetService(void);
+// queues the recall of the preset "id" - returns false for an unknown preset or a full queue
+bool queuePresetRecall(uint8_t id);
+// reads and applies the preset "id" - to be called from the render loop only
+bool presetApply(uint8_t id);
+// reads the encoded values of the preset "id" into "buf" (see settingsDecode)
+// returns their length - 0 for an unknown preset or if they exceed "size"
+// (with buf == NULL only the length gets returned)
+size_t presetRead(uint8_t id, uint8_t * buf, size_t size);
+// applies "scene" (e.g. the segment with a preset decoded) at once - to be called from the render loop only
+void presetApplyScene(WS2812FX::segment &scene);
+// returns true (once) if a preset was applied
+bool getPresetApplied(void);
+
+// the stored presets (ordered by id)
+const presetEntry * getPresets(uint8_t * count);
+// the preset "id" or NULL
+const presetEntry * getPreset(uint8_t id);
+
+#endif
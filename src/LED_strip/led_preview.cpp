@@ -0,0 +1,90 @@
+#include "led_preview.h"
+
+static inline void writePreviewHeader(uint8_t * out, uint8_t flags, uint16_t count, uint16_t seq)
+{
+  out[0] = PREVIEW_MAGIC;
+  out[1] = flags;
+  out[2] = count & 0xff;
+  out[3] = count >> 8;
+  out[4] = seq & 0xff;
+  out[5] = seq >> 8;
+}
+
+// returns the average color of the "1 << dsShift" pixels starting at "leds[index << dsShift]"
+static inline CRGB getPreviewPixel(const CRGB * leds, uint16_t total, uint16_t index, uint8_t dsShift)
+{
+  if (!dsShift) return leds[index];
+
+  const uint16_t first = index << dsShift;
+  const uint16_t last  = min((uint16_t)(first + (1 << dsShift)), total);
+  uint16_t r = 0, g = 0, b = 0;
+  for (uint16_t i = first; i < last; i++)
+  {
+    r += leds[i].r;
+    g += leds[i].g;
+    b += leds[i].b;
+  }
+  const uint8_t n = last - first;
+  return CRGB(r / n, g / n, b / n);
+}
+
+size_t encodePreviewKeyFrame(const CRGB * leds, uint16_t count, uint8_t dsShift, uint16_t seq, uint8_t * out, size_t outSize)
+{
+  const uint16_t num = (count + (1 << dsShift) - 1) >> dsShift;
+  if (outSize < PREVIEW_HEADER_SIZE) return 0;
+  writePreviewHeader(out, dsShift << 4, num, seq);
+
+  size_t pos = PREVIEW_HEADER_SIZE;
+  uint16_t i = 0;
+  while (i < num)
+  {
+    const CRGB c = getPreviewPixel(leds, count, i, dsShift);
+    uint8_t run = 1;
+    while ((i + run) < num && run < 255 && getPreviewPixel(leds, count, i + run, dsShift) == c)
+    {
+      run++;
+    }
+    if (pos + 4 > outSize) return 0;
+    out[pos++] = run;
+    out[pos++] = c.r;
+    out[pos++] = c.g;
+    out[pos++] = c.b;
+    i += run;
+  }
+  return pos;
+}
+
+size_t encodePreviewDeltaFrame(const CRGB * leds, const CRGB * prev, uint16_t count, uint16_t seq, uint8_t * out, size_t outSize)
+{
+  if (outSize < PREVIEW_HEADER_SIZE) return 0;
+  writePreviewHeader(out, PREVIEW_FLAG_DELTA, count, seq);
+
+  size_t pos = PREVIEW_HEADER_SIZE;
+  uint16_t i = 0;
+  while (i < count)
+  {
+    uint8_t skip = 0;
+    while (i < count && skip < 255 && leds[i] == prev[i])
+    {
+      skip++;
+      i++;
+    }
+    if (i == count) break; // unchanged till the end
+
+    uint8_t changed = 0;
+    while ((i + changed) < count && changed < 255 && leds[i + changed] != prev[i + changed])
+    {
+      changed++;
+    }
+    if (pos + 2 + 3 * changed > outSize) return 0;
+    out[pos++] = skip;
+    out[pos++] = changed;
+    for (uint8_t k = 0; k < changed; k++, i++)
+    {
+      out[pos++] = leds[i].r;
+      out[pos++] = leds[i].g;
+      out[pos++] = leds[i].b;
+    }
+  }
+  return pos;
+}
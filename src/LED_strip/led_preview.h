@@ -0,0 +1,37 @@
+#ifndef led_preview_h
+#define led_preview_h
+
+#include "../WS2812FX/WS2812FX_FastLed.h"
+
+/*
+ * Encoding of the live LED preview frames sent as binary web socket messages.
+ *
+ * header (6 bytes):
+ *   byte 0    : PREVIEW_MAGIC ('L')
+ *   byte 1    : flags - bit 0: delta frame, bits 4..7: log2 of the downsampling factor
+ *   byte 2..3 : number of (downsampled) pixels, little endian
+ *   byte 4..5 : frame sequence number, little endian
+ *
+ * key frame payload:  runs of [count (1..255)][r][g][b]
+ * delta frame payload: entries of [skip (0..255)][count (0..255)][count x r g b]
+ *   "skip" pixels are unchanged compared to the previous frame (sequence - 1),
+ *   the following "count" pixels carry their new color. Unchanged pixels at the
+ *   end are not encoded.
+ */
+
+#define PREVIEW_MAGIC           0x4C
+#define PREVIEW_HEADER_SIZE     6
+#define PREVIEW_FLAG_DELTA      0x01
+
+// worst case size of an encoded frame with "count" pixels (either type)
+#define PREVIEW_MAX_FRAME_SIZE(count) (PREVIEW_HEADER_SIZE + 4 * (count) + 2)
+
+// encodes "count" pixels (downsampled by 2^dsShift by averaging neighbours) run length encoded.
+// returns the number of bytes written to "out" or 0 if "outSize" was not sufficient
+size_t encodePreviewKeyFrame(const CRGB * leds, uint16_t count, uint8_t dsShift, uint16_t seq, uint8_t * out, size_t outSize);
+
+// encodes the pixels changed between "prev" and "leds" (full resolution).
+// returns the number of bytes written to "out" or 0 if "outSize" was not sufficient
+size_t encodePreviewDeltaFrame(const CRGB * leds, const CRGB * prev, uint16_t count, uint16_t seq, uint8_t * out, size_t outSize);
+
+#endif
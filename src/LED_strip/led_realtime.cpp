@@ -0,0 +1,419 @@
+#include "led_realtime.h"
+#include "led_commands.h"
+#include <WiFiUdp.h>
+
+#define RT_CHANNELS             (LED_COUNT * 3)
+#define RT_CHANNELS_PER_UNIVERSE 510
+#define RT_UNIVERSES            ((RT_CHANNELS + RT_CHANNELS_PER_UNIVERSE - 1) / RT_CHANNELS_PER_UNIVERSE)
+
+#if RT_UNIVERSES > 32
+#error "The realtime UDP receiver supports up to 32 universes"
+#endif
+#define RT_ALL_UNIVERSES        ((uint32_t)(0xffffffffULL >> (32 - RT_UNIVERSES)))
+
+// DDP (http://www.3waylabs.com/ddp/)
+#define DDP_HEADER_SIZE         10
+#define DDP_TIMECODE_SIZE       4
+#define DDP_FLAG_VERSION_MASK   0xC0
+#define DDP_FLAG_VERSION_1      0x40
+#define DDP_FLAG_TIMECODE       0x10
+#define DDP_FLAG_STORAGE        0x08
+#define DDP_FLAG_REPLY          0x04
+#define DDP_FLAG_QUERY          0x02
+#define DDP_FLAG_PUSH           0x01
+#define DDP_TYPE_UNDEFINED      0x00
+#define DDP_TYPE_RGB8           0x0B
+#define DDP_ID_DISPLAY          1
+#define DDP_ID_ALL              255
+
+// E1.31 (ANSI E1.31-2018)
+#define E131_DATA_HEADER_SIZE   126
+#define E131_SYNC_PACKET_SIZE   49
+#define E131_ROOT_LAYER_SIZE    38
+#define E131_VECTOR_ROOT_DATA   0x00000004
+#define E131_VECTOR_ROOT_EXT    0x00000008
+#define E131_VECTOR_DATA_PACKET 0x00000002
+#define E131_VECTOR_EXT_SYNC    0x00000001
+#define E131_VECTOR_DMP_SET     0x02
+#define E131_OPT_PREVIEW        0x80
+#define E131_OPT_TERMINATED     0x40
+
+// Art-Net 4
+#define ARTNET_HEADER_SIZE      18
+#define ARTNET_OP_DMX           0x5000
+#define ARTNET_OP_SYNC          0x5200
+#define ARTNET_SYNC_TIMEOUT     4000  // ArtSync mode ends if no ArtSync was received for 4 seconds
+
+static const uint8_t E131_ACN_ID[12]  PROGMEM = {'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0};
+static const uint8_t ARTNET_ID[8]     PROGMEM = {'A', 'r', 't', '-', 'N', 'e', 't', 0};
+
+static WiFiUDP        _ddpUdp;
+static WiFiUDP        _e131Udp;
+static WiFiUDP        _artnetUdp;
+
+// the only "packet buffer": the header gets read here, the payload goes to the LEDs directly
+static uint8_t        _hdr[E131_DATA_HEADER_SIZE];
+
+static realtimeStats  _rtStats = {0, 0, 0, 0, 0};
+// micros() when the current packet was found (for the latency). WiFiUDP has no receive callback:
+// the packet waited in the lwIP queue since the previous realtimeService - the UDP latency
+// misses that time (up to one pass of the loop, e.g. a frame being calculated and shown).
+static uint32_t       _packetArrival = 0;
+
+static bool           _active      = false;
+static bool           _overridden  = false;
+static uint32_t       _lastPacket  = 0;
+static uint8_t        _prevMode    = 0;
+static bool           _prevPower   = false;
+
+static bool           _holding     = false;
+static uint32_t       _holdSince   = 0;
+
+static uint8_t        _ddpSeq      = 0;
+static uint8_t        _e131Seq[RT_UNIVERSES];
+static uint8_t        _artnetSeq[RT_UNIVERSES];
+static uint32_t       _e131SeqValid   = 0;
+static uint32_t       _e131Received   = 0;
+static uint32_t       _artnetReceived = 0;
+static uint16_t       _e131SyncAddr   = 0;
+static uint32_t       _artnetSyncTime = 0;
+static bool           _artnetSynced   = false;
+
+static inline uint16_t readBE16(const uint8_t * p) { return ((uint16_t)p[0] << 8) | p[1]; }
+static inline uint32_t readBE32(const uint8_t * p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]; }
+
+// returns true if an 8 bit sequence number is a duplicate or older than the last one (E1.31 6.7.2)
+static inline bool isStaleSequence(uint8_t seq, uint8_t last)
+{
+  const int8_t diff = (int8_t)(seq - last);
+  return (diff <= 0 && diff > -20);
+}
+
+static void releaseFrame(void)
+{
+  if (_holding)
+  {
+    _holding = false;
+    strip->setVoidHold(false);
+  }
+  _rtStats.frames++;
+}
+
+static void holdFrame(uint32_t now)
+{
+  if (!_holding)
+  {
+    _holding   = true;
+    _holdSince = now;
+    strip->setVoidHold(true);
+  }
+}
+
+static void exitRealtime(void)
+{
+  if (_holding)
+  {
+    _holding = false;
+    strip->setVoidHold(false);
+  }
+  if (_active && strip->getMode() == FX_MODE_VOID)
+  {
+    strip->setMode(_prevMode);
+    strip->setPower(_prevPower);
+  }
+  _active = false;
+  _e131Received   = 0;
+  _artnetReceived = 0;
+}
+
+// returns true if the received data can be applied to the LEDs
+static bool enterRealtime(uint32_t now)
+{
+  _lastPacket = now;
+  if (_overridden)
+  {
+    _rtStats.ignored++;
+    return false;
+  }
+  if (!_active)
+  {
+    _prevMode  = strip->getMode();
+    _prevPower = strip->getPower();
+    strip->setPower(true);
+    strip->setMode(FX_MODE_VOID);
+    _active = true;
+    _ddpSeq = 0;
+    _e131SeqValid = 0;
+    memset(_artnetSeq, 0, sizeof(_artnetSeq));
+  }
+  return true;
+}
+
+// reads "len" bytes of the packet payload directly into the LED data starting with "channel"
+static void readChannels(WiFiUDP &udp, uint32_t channel, uint16_t len)
+{
+  if (channel >= RT_CHANNELS) return;
+  if (len > RT_CHANNELS - channel) len = RT_CHANNELS - channel;
+  udp.read((uint8_t *)strip->_bleds + channel, len);
+  _rtStats.packets++;
+  noteInputApplied(LED_SRC_UDP, _packetArrival);
+}
+
+// frame handling for the universe based protocols: a frame is complete once all universes
+// have been received - unless the sender uses synchronization packets
+static void universeReceived(uint32_t &received, uint8_t idx, bool synced, uint32_t now)
+{
+  if (synced)
+  {
+    holdFrame(now);
+    return;
+  }
+  const uint32_t bit = (uint32_t)1 << idx;
+  if (received & bit)
+  {
+    // the sender started a new frame without completing the previous one
+    releaseFrame();
+    received = 0;
+  }
+  received |= bit;
+  if (received == RT_ALL_UNIVERSES)
+  {
+    received = 0;
+    releaseFrame();
+  }
+  else
+  {
+    holdFrame(now);
+  }
+}
+
+static void handleDDP(uint32_t now)
+{
+  if (_ddpUdp.read(_hdr, DDP_HEADER_SIZE) != DDP_HEADER_SIZE || (_hdr[0] & DDP_FLAG_VERSION_MASK) != DDP_FLAG_VERSION_1)
+  {
+    _rtStats.invalid++;
+    return;
+  }
+  const uint8_t flags = _hdr[0];
+  if (flags & DDP_FLAG_TIMECODE)
+  {
+    // timecode is not used - but it needs to be skipped
+    if (_ddpUdp.read(&_hdr[DDP_HEADER_SIZE], DDP_TIMECODE_SIZE) != DDP_TIMECODE_SIZE)
+    {
+      _rtStats.invalid++;
+      return;
+    }
+  }
+  if ((flags & (DDP_FLAG_QUERY | DDP_FLAG_REPLY | DDP_FLAG_STORAGE)) ||
+      (_hdr[3] != DDP_ID_DISPLAY && _hdr[3] != DDP_ID_ALL) ||
+      (_hdr[2] != DDP_TYPE_UNDEFINED && _hdr[2] != DDP_TYPE_RGB8))
+  {
+    // queries, config / status and other data types are not supported
+    _rtStats.ignored++;
+    return;
+  }
+  // 4 bit sequence (0 = not used). Packets of the same frame may share a number,
+  // so only packets older than the last one are dropped
+  const uint8_t seq = _hdr[1] & 0x0F;
+  if (seq && _ddpSeq && ((seq - _ddpSeq) & 0x0F) > 8)
+  {
+    _rtStats.outOfSequence++;
+    return;
+  }
+  if (!enterRealtime(now)) return;
+  if (seq) _ddpSeq = seq;
+
+  const uint32_t offset = readBE32(&_hdr[4]);
+  const uint16_t len    = readBE16(&_hdr[8]);
+  readChannels(_ddpUdp, offset, len);
+
+  if ((flags & DDP_FLAG_PUSH) || (offset + len >= RT_CHANNELS))
+  {
+    releaseFrame();
+  }
+  else
+  {
+    holdFrame(now);
+  }
+}
+
+static void handleE131(uint32_t now)
+{
+  const int len = _e131Udp.read(_hdr, E131_DATA_HEADER_SIZE);
+  if (len < E131_ROOT_LAYER_SIZE + 6 || memcmp_P(&_hdr[4], E131_ACN_ID, sizeof(E131_ACN_ID)))
+  {
+    _rtStats.invalid++;
+    return;
+  }
+  const uint32_t rootVector = readBE32(&_hdr[18]);
+  if (rootVector == E131_VECTOR_ROOT_EXT)
+  {
+    // synchronization packet: shows the frame of all universes waiting for this sync address
+    if (len >= E131_SYNC_PACKET_SIZE && readBE32(&_hdr[40]) == E131_VECTOR_EXT_SYNC)
+    {
+      if (_active && _e131SyncAddr && readBE16(&_hdr[45]) == _e131SyncAddr)
+      {
+        _lastPacket = now;
+        releaseFrame();
+      }
+    }
+    else
+    {
+      _rtStats.ignored++; // e.g. universe discovery
+    }
+    return;
+  }
+  if (rootVector != E131_VECTOR_ROOT_DATA || len < E131_DATA_HEADER_SIZE ||
+      readBE32(&_hdr[40]) != E131_VECTOR_DATA_PACKET || _hdr[117] != E131_VECTOR_DMP_SET)
+  {
+    _rtStats.invalid++;
+    return;
+  }
+  const uint8_t options = _hdr[112];
+  if (options & E131_OPT_TERMINATED)
+  {
+    exitRealtime();
+    return;
+  }
+  const uint16_t universe = readBE16(&_hdr[113]);
+  // start code 0 (dimmer data) only, preview data is not meant to be shown
+  if ((options & E131_OPT_PREVIEW) || _hdr[125] != 0 ||
+      universe < UDP_RT_E131_UNIVERSE || universe - UDP_RT_E131_UNIVERSE >= RT_UNIVERSES)
+  {
+    _rtStats.ignored++;
+    return;
+  }
+  const uint8_t idx = universe - UDP_RT_E131_UNIVERSE;
+  const uint8_t seq = _hdr[111];
+  if (_active && (_e131SeqValid & ((uint32_t)1 << idx)) && isStaleSequence(seq, _e131Seq[idx]))
+  {
+    _rtStats.outOfSequence++;
+    return;
+  }
+  if (!enterRealtime(now)) return;
+  _e131Seq[idx] = seq;
+  _e131SeqValid |= (uint32_t)1 << idx;
+  _e131SyncAddr = readBE16(&_hdr[109]);
+
+  // property value count includes the start code
+  const uint16_t slots = readBE16(&_hdr[123]);
+  if (slots > 1)
+  {
+    readChannels(_e131Udp, (uint32_t)idx * RT_CHANNELS_PER_UNIVERSE, min((uint16_t)(slots - 1), (uint16_t)RT_CHANNELS_PER_UNIVERSE));
+  }
+  universeReceived(_e131Received, idx, _e131SyncAddr != 0, now);
+}
+
+static void handleArtnet(uint32_t now)
+{
+  const int len = _artnetUdp.read(_hdr, ARTNET_HEADER_SIZE);
+  if (len < 10 || memcmp_P(_hdr, ARTNET_ID, sizeof(ARTNET_ID)))
+  {
+    _rtStats.invalid++;
+    return;
+  }
+  const uint16_t opCode = _hdr[8] | ((uint16_t)_hdr[9] << 8);
+  if (opCode == ARTNET_OP_SYNC)
+  {
+    _artnetSyncTime = now;
+    _artnetSynced   = true;
+    if (_active)
+    {
+      _lastPacket = now;
+      releaseFrame();
+    }
+    return;
+  }
+  if (opCode != ARTNET_OP_DMX)
+  {
+    _rtStats.ignored++; // ArtPoll etc. are not supported
+    return;
+  }
+  if (len < ARTNET_HEADER_SIZE)
+  {
+    _rtStats.invalid++;
+    return;
+  }
+  const uint16_t universe = _hdr[14] | ((uint16_t)(_hdr[15] & 0x7F) << 8);
+  if (universe < UDP_RT_ARTNET_UNIVERSE || universe - UDP_RT_ARTNET_UNIVERSE >= RT_UNIVERSES)
+  {
+    _rtStats.ignored++;
+    return;
+  }
+  const uint8_t idx = universe - UDP_RT_ARTNET_UNIVERSE;
+  // sequence 0 disables the sequence check
+  const uint8_t seq = _hdr[12];
+  if (_active && seq && _artnetSeq[idx] && isStaleSequence(seq, _artnetSeq[idx]))
+  {
+    _rtStats.outOfSequence++;
+    return;
+  }
+  if (!enterRealtime(now)) return;
+  _artnetSeq[idx] = seq;
+
+  if (_artnetSynced && (now - _artnetSyncTime) > ARTNET_SYNC_TIMEOUT)
+  {
+    _artnetSynced = false;
+  }
+  readChannels(_artnetUdp, (uint32_t)idx * RT_CHANNELS_PER_UNIVERSE, min(readBE16(&_hdr[16]), (uint16_t)RT_CHANNELS_PER_UNIVERSE));
+  universeReceived(_artnetReceived, idx, _artnetSynced, now);
+}
+
+void realtimeBegin(void)
+{
+  _ddpUdp.begin(UDP_RT_DDP_PORT);
+  _e131Udp.begin(UDP_RT_E131_PORT);
+  _artnetUdp.begin(UDP_RT_ARTNET_PORT);
+}
+
+void realtimeService(uint32_t now)
+{
+  // a frame is usually split into several packets - process what is there
+  for (uint8_t n = 0; n < UDP_RT_MAX_PACKETS; n++)
+  {
+    bool received = false;
+    _packetArrival = micros();
+    if (_ddpUdp.parsePacket() > 0)    { handleDDP(now);    received = true; }
+    if (_e131Udp.parsePacket() > 0)   { handleE131(now);   received = true; }
+    if (_artnetUdp.parsePacket() > 0) { handleArtnet(now); received = true; }
+    if (!received) break;
+  }
+
+  if (_holding && (now - _holdSince) > UDP_RT_HOLD_MAX)
+  {
+    // parts of the frame got lost (or were never sent) - show what we have
+    _e131Received   = 0;
+    _artnetReceived = 0;
+    releaseFrame();
+  }
+
+  if (_active)
+  {
+    if (strip->getMode() != FX_MODE_VOID)
+    {
+      // the effect was changed (e.g. via web) - this wins over the received data
+      _active = false;
+      _overridden = true;
+      _holding = false;
+      strip->setVoidHold(false);
+    }
+    else if ((now - _lastPacket) > UDP_RT_TIMEOUT)
+    {
+      exitRealtime();
+    }
+  }
+  else if (_overridden && (now - _lastPacket) > UDP_RT_TIMEOUT)
+  {
+    _overridden = false;
+  }
+}
+
+bool realtimeIsActive(void)
+{
+  return _active;
+}
+
+const realtimeStats * getRealtimeStats(void)
+{
+  return &_rtStats;
+}
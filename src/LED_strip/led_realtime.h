@@ -0,0 +1,45 @@
+#ifndef led_realtime_h
+#define led_realtime_h
+
+#include "led_strip.h"
+
+/*
+ * Realtime pixel data received via UDP.
+ *
+ * Supported protocols (unicast):
+ *   DDP          port UDP_RT_DDP_PORT,    offset 0 = first LED (LED_OFFSET), push flag ends a frame
+ *   E1.31 / sACN port UDP_RT_E131_PORT,   170 LEDs per universe starting with UDP_RT_E131_UNIVERSE,
+ *                                         universe synchronization (sync packets) supported
+ *   Art-Net      port UDP_RT_ARTNET_PORT, 170 LEDs per universe starting with UDP_RT_ARTNET_UNIVERSE,
+ *                                         ArtSync supported
+ *
+ * The first valid data packet switches the strip to VOID and the payload is read
+ * from the socket directly into the LED data (no additional buffer). Incomplete
+ * frames are held back (see WS2812FX::setVoidHold) until the frame is complete,
+ * pushed or synced. After UDP_RT_TIMEOUT ms without data the previous effect
+ * (and power state) is restored. If the effect gets changed while receiving,
+ * the received data is ignored until the sender stopped for UDP_RT_TIMEOUT ms.
+ *
+ * The latency of the UDP input (LED_SRC_UDP) starts when realtimeService finds
+ * the packet, not when it was received - it is low by the time the packet
+ * waited for the loop (up to one pass).
+ */
+
+struct realtimeStats {
+  uint32_t packets;       // data packets applied
+  uint32_t frames;        // frames completed (pushed, synced or all universes received)
+  uint32_t outOfSequence; // packets dropped because of their sequence number
+  uint32_t invalid;       // malformed packets
+  uint32_t ignored;       // valid packets not being applied (e.g. other universe, effect changed)
+};
+
+// binds the UDP listeners
+void realtimeBegin(void);
+// processes the received packets and handles the timeout - to be called from the render loop only
+void realtimeService(uint32_t now);
+
+// true while the LEDs are driven by UDP data
+bool realtimeIsActive(void);
+const realtimeStats * getRealtimeStats(void);
+
+#endif
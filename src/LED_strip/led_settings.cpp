@@ -0,0 +1,706 @@
+#include "led_settings.h"
+#include <LittleFS.h>
+#include <stddef.h>
+
+#define SETTINGS_SNAPSHOT_FILE    "/settings.bin"
+#define SETTINGS_TEMP_FILE        "/settings.tmp"
+#define SETTINGS_LOG_FILE         "/settings.log"
+
+#define SETTINGS_SNAPSHOT_MAGIC   0x3253534CUL  // "LSS2"
+#define SETTINGS_LOG_MAGIC        0x324A534CUL  // "LSJ2"
+// to be increased when values are added or change their meaning (the snapshot gets rewritten once)
+#define SETTINGS_SCHEMA           2
+#define SETTINGS_MAX_LENGTH       1024          // sanity limit of the TLV data of a snapshot
+#define SETTINGS_RECORD_MAGIC     0xA5
+#define SETTINGS_RECORD_HEADER    2             // magic, length
+#define SETTINGS_RECORD_OVERHEAD  (SETTINGS_RECORD_HEADER + 2)
+#define SETTINGS_TLV_HEADER       2             // id, length
+#define SETTINGS_SIZE             sizeof(WS2812FX::segment)
+
+#if SETTINGS_RECORD_BUFFER > 255 + SETTINGS_RECORD_OVERHEAD
+#error "SETTINGS_RECORD_BUFFER exceeds the max. record length"
+#endif
+
+struct settingsSnapshotHeader {
+  uint32_t magic;
+  uint32_t generation;
+  uint16_t schema;      // SETTINGS_SCHEMA of the firmware writing the snapshot
+  uint16_t tags;        // number of values
+  uint16_t length;      // of the TLV data
+  uint16_t crc;         // of the TLV data
+};
+
+struct settingsLogHeader {
+  uint32_t magic;
+  uint32_t generation;
+};
+
+// a value of the segment being stored as [id][length][value]
+// arrays are stored as [id][length][index of the first element][elements],
+// keyed arrays (SETTINGS_FLAG_KEYED) as [id][length][index][element][index][element]...
+struct settingsTag {
+  uint8_t  id;          // stored - never change or reuse an id
+  uint8_t  size;        // size of the value (or of one element)
+  uint8_t  count;       // number of elements (arrays) or 0
+  uint8_t  flags;       // SETTINGS_FLAG_...
+  uint16_t offset;      // within the segment
+};
+
+#define SEGMENT_MEMBER(member)      (((WS2812FX::segment *)0)->member)
+#define SETTINGS_VALUE(id, member)  { id, sizeof(SEGMENT_MEMBER(member)),    0, 0, offsetof(WS2812FX::segment, member) }
+#define SETTINGS_DEVICE(id, member) { id, sizeof(SEGMENT_MEMBER(member)),    0, SETTINGS_FLAG_DEVICE, offsetof(WS2812FX::segment, member) }
+#define SETTINGS_ARRAY(id, member, flags) { id, sizeof(SEGMENT_MEMBER(member)[0]), sizeof(SEGMENT_MEMBER(member)) / sizeof(SEGMENT_MEMBER(member)[0]), flags, offsetof(WS2812FX::segment, member) }
+
+static_assert(sizeof(SEGMENT_MEMBER(effectSpeeds)) + MODE_COUNT < 255, "effectSpeeds exceed the max. length of a value");
+
+// ids are the index + 1 (for the lookup) - the names are the ones of the fields[] table (if any).
+// SETTINGS_DEVICE values belong to the device (or are runtime values) and are not part of presets.
+static const settingsTag settingsTags[] PROGMEM = {
+  SETTINGS_VALUE( 1, beat88),               // "speed"
+  // id 2: the speeds per effect stored by position (retired)
+  SETTINGS_ARRAY(48, effectSpeeds, SETTINGS_FLAG_DEVICE | SETTINGS_FLAG_KEYED), // speed per effect (keyed by the mode id)
+  SETTINGS_VALUE( 3, solidColor),           // "solidColor"
+  SETTINGS_VALUE( 4, colorTemp),            // "colorTemperature"
+  SETTINGS_VALUE( 5, hueTime),              // "hueTime"
+  SETTINGS_DEVICE( 6, milliamps),           // "currentLimit"
+  SETTINGS_VALUE( 7, autoplayDuration),     // "autoPlayInterval"
+  SETTINGS_VALUE( 8, autoPalDuration),      // "autoPalInterval"
+  SETTINGS_VALUE( 9, segments),             // "segments"
+  SETTINGS_VALUE(10, cooling),              // "cooling"
+  SETTINGS_VALUE(11, sparking),             // "sparking"
+  SETTINGS_VALUE(12, twinkleSpeed),         // "twinkleSpeed"
+  SETTINGS_VALUE(13, twinkleDensity),       // "twinkleDensity"
+  SETTINGS_VALUE(14, numBars),              // "numEffectBars"
+  SETTINGS_VALUE(15, mode),                 // "effect"
+  SETTINGS_DEVICE(16, fps),                 // "fps"
+  SETTINGS_VALUE(17, deltaHue),             // "deltaHue"
+  SETTINGS_VALUE(18, blur),                 // "ledBlur"
+  SETTINGS_VALUE(19, damping),              // "damping"
+  SETTINGS_DEVICE(20, dithering),           // "dithering"
+  SETTINGS_VALUE(21, sunrisetime),          // "sunriseset"
+  SETTINGS_VALUE(22, targetBrightness),     // "brightness"
+  SETTINGS_DEVICE(23, brightness),
+  SETTINGS_VALUE(24, targetPaletteNum),     // "colorPalette"
+  SETTINGS_DEVICE(25, currentPaletteNum),
+  SETTINGS_VALUE(26, paletteDistribution),  // "paletteDistribution"
+  SETTINGS_VALUE(27, backgroundHue),        // "backgroundHue"
+  SETTINGS_VALUE(28, backgroundSat),        // "backgroundSat"
+  SETTINGS_VALUE(29, backgroundBri),        // "backgroundBri"
+  SETTINGS_DEVICE(30, colCor),              // "colorCorrection"
+  SETTINGS_VALUE(31, power),                // "power"
+  SETTINGS_VALUE(32, isRunning),            // "running"
+  SETTINGS_VALUE(33, reverse),              // "reversed"
+  SETTINGS_VALUE(34, mirror),               // "mirrored"
+  SETTINGS_VALUE(35, addGlitter),           // "addGlitter"
+  SETTINGS_VALUE(36, whiteGlitter),         // "whiteGlitter"
+  SETTINGS_VALUE(37, onBlackOnly),          // "onBlackOnly"
+  SETTINGS_VALUE(38, synchronous),          // "syncGlitter"
+  SETTINGS_VALUE(39, blendType),            // "blendType"
+  SETTINGS_VALUE(40, autoplay),             // "autoPlay"
+  SETTINGS_VALUE(41, autoPal),              // "autoPalette"
+  #ifdef HAS_KNOB_CONTROL
+  SETTINGS_DEVICE(42, wifiDisabled),        // "wifiDisabled"
+  #endif
+  SETTINGS_ARRAY(43, layerMode, 0),         // "layer<n>Effect"
+  SETTINGS_ARRAY(44, layerOpacity, 0),      // "layer<n>Opacity"
+  SETTINGS_ARRAY(45, layerBlend, 0),        // "layer<n>Blend"
+  SETTINGS_DEVICE(46, syncRole),            // "syncRole"
+  SETTINGS_DEVICE(47, syncGroup),           // "syncGroup"
+};
+
+#define SETTINGS_TAG_COUNT (sizeof(settingsTags) / sizeof(settingsTags[0]))
+
+static WS2812FX::segment _persisted;        // the segment as it is stored
+static uint32_t          _generation   = 0;
+static bool              _haveSnapshot = false;
+static bool              _removeLog    = false;  // the journal is obsolete after a compaction
+static bool              _dirty        = false;
+static uint32_t          _firstChange  = 0;
+static uint32_t          _lastChange   = 0;
+static uint32_t          _lastWrite    = 0;
+static uint32_t          _lastFrames   = 0;
+static uint32_t          _lastFrameMillis = 0;
+static uint8_t           _records[SETTINGS_RECORD_BUFFER];
+static settingsStats     _stats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+static inline uint16_t settingsCRC(const uint8_t * buf, size_t len)
+{
+  return (uint16_t)WS2812FX::calc_CRC16(0x5a5a, (unsigned char *)buf, len);
+}
+
+static inline void noteStall(uint32_t start)
+{
+  _stats.lastStallMicros = micros() - start;
+  _stats.stallMicros += _stats.lastStallMicros;
+  if (_stats.lastStallMicros > _stats.stallMaxMicros) _stats.stallMaxMicros = _stats.lastStallMicros;
+}
+
+static inline void readTag(uint8_t index, settingsTag * t)
+{
+  memcpy_P(t, &settingsTags[index], sizeof(settingsTag));
+}
+
+static bool findTag(uint8_t id, settingsTag * t)
+{
+  // ids are the index + 1 - unless a (build flag dependent) tag is missing
+  if (id && id <= SETTINGS_TAG_COUNT)
+  {
+    readTag(id - 1, t);
+    if (t->id == id) return true;
+  }
+  for (uint8_t i = 0; i < SETTINGS_TAG_COUNT; i++)
+  {
+    readTag(i, t);
+    if (t->id == id) return true;
+  }
+  return false;
+}
+
+// writes [id][length]([first])[value] of the elements first .. first + n - 1 (values: 0, 1).
+// returns the number of bytes written (0 if "outSize" was not sufficient)
+static size_t encodeTag(const settingsTag & t, const uint8_t * data, uint8_t first, uint8_t n, uint8_t * out, size_t outSize)
+{
+  const size_t len = (t.count ? 1 : 0) + n * t.size;
+  if (SETTINGS_TLV_HEADER + len > outSize) return 0;
+
+  out[0] = t.id;
+  out[1] = len;
+  uint8_t * v = &out[SETTINGS_TLV_HEADER];
+  if (t.count) *v++ = first;
+  memcpy(v, data + t.offset + first * t.size, n * t.size);
+  return SETTINGS_TLV_HEADER + len;
+}
+
+// writes [id][length][index][element]... of the elements of a keyed array - all of them or (with "old")
+// the ones differing from "old". returns the number of bytes written (0 if "outSize" was not sufficient)
+static size_t encodeKeyed(const settingsTag & t, const uint8_t * data, const uint8_t * old, uint8_t * out, size_t outSize)
+{
+  const uint8_t * a = data + t.offset;
+  size_t len = SETTINGS_TLV_HEADER;
+  for (uint8_t e = 0; e < t.count; e++)
+  {
+    if (old && !memcmp(a + e * t.size, old + t.offset + e * t.size, t.size)) continue;
+    if (len + 1 + t.size > outSize) return 0;
+    out[len] = e;
+    memcpy(&out[len + 1], a + e * t.size, t.size);
+    len += 1 + t.size;
+  }
+  out[0] = t.id;
+  out[1] = len - SETTINGS_TLV_HEADER;
+  return len;
+}
+
+// applies the TLV encoded values to "data" in one pass. Unknown ids (of a newer version) are skipped,
+// values not contained keep their current (default) value. returns false if the data is malformed.
+static bool decodeTags(const uint8_t * p, size_t len, uint8_t * data)
+{
+  const uint8_t * end = p + len;
+  while (p < end)
+  {
+    if (end - p < SETTINGS_TLV_HEADER || end - p < SETTINGS_TLV_HEADER + p[1]) return false;
+
+    const uint8_t   id = p[0];
+    const uint8_t   n  = p[1];
+    const uint8_t * v  = &p[SETTINGS_TLV_HEADER];
+    p += SETTINGS_TLV_HEADER + n;
+
+    settingsTag t;
+    if (!findTag(id, &t)) continue;
+
+    uint8_t * m = data + t.offset;
+    if (t.flags & SETTINGS_FLAG_KEYED)
+    {
+      // elements of unknown indices (e.g. of removed effects) are skipped
+      for (uint8_t k = 0; k + 1 + t.size <= n; k += 1 + t.size)
+      {
+        if (v[k] < t.count) memcpy(m + v[k] * t.size, &v[k + 1], t.size);
+      }
+    }
+    else if (!t.count)
+    {
+      // the size changed (e.g. uint8_t -> uint16_t): little endian, so cut or extended with zeros
+      const uint8_t c = n < t.size ? n : t.size;
+      memcpy(m, v, c);
+      memset(m + c, 0, t.size - c);
+    }
+    else if (n)
+    {
+      // the number of elements changed (e.g. effects added): the others keep their default
+      const uint8_t first = v[0];
+      uint16_t elements = (n - 1) / t.size;
+      if (first >= t.count) continue;
+      if (first + elements > t.count) elements = t.count - first;
+      memcpy(m + first * t.size, &v[1], elements * t.size);
+    }
+  }
+  return true;
+}
+
+// number of stored bytes of "data" differing from the persisted segment
+static uint16_t countChanges(const uint8_t * data)
+{
+  const uint8_t * old = (const uint8_t *)&_persisted;
+  uint16_t count = 0;
+  settingsTag t;
+  for (uint8_t i = 0; i < SETTINGS_TAG_COUNT; i++)
+  {
+    readTag(i, &t);
+    const uint16_t end = t.offset + t.size * (t.count ? t.count : 1);
+    for (uint16_t b = t.offset; b < end; b++)
+    {
+      if (data[b] != old[b]) count++;
+    }
+  }
+  return count;
+}
+
+// encodes the values of "data" differing from the persisted segment as one journal record.
+// returns the size of the record in "_records" (0 if there was not enough space)
+static size_t buildRecord(const uint8_t * data)
+{
+  const uint8_t * old = (const uint8_t *)&_persisted;
+  size_t len = SETTINGS_RECORD_HEADER;
+  const size_t space = sizeof(_records) - 2;  // CRC
+  settingsTag t;
+
+  for (uint8_t i = 0; i < SETTINGS_TAG_COUNT; i++)
+  {
+    readTag(i, &t);
+    const uint8_t * a = data + t.offset;
+    const uint8_t * b = old + t.offset;
+    size_t n = 0;
+    if (t.flags & SETTINGS_FLAG_KEYED)
+    {
+      if (!memcmp(a, b, t.size * t.count)) continue;
+      n = encodeKeyed(t, data, old, &_records[len], space - len);
+    }
+    else if (!t.count)
+    {
+      if (!memcmp(a, b, t.size)) continue;
+      n = encodeTag(t, data, 0, 1, &_records[len], space - len);
+    }
+    else
+    {
+      // only the range of changed elements
+      int16_t first = -1, last = -1;
+      for (uint8_t e = 0; e < t.count; e++)
+      {
+        if (memcmp(a + e * t.size, b + e * t.size, t.size))
+        {
+          if (first < 0) first = e;
+          last = e;
+        }
+      }
+      if (first < 0) continue;
+      n = encodeTag(t, data, first, last - first + 1, &_records[len], space - len);
+    }
+    if (!n) return 0;
+    len += n;
+  }
+
+  _records[0] = SETTINGS_RECORD_MAGIC;
+  _records[1] = len - SETTINGS_RECORD_HEADER;
+  const uint16_t crc = settingsCRC(&_records[1], len - 1);
+  _records[len]     = crc & 0xff;
+  _records[len + 1] = crc >> 8;
+  return len + 2;
+}
+
+// writes "data" as snapshot with the next generation
+static bool writeSnapshot(const WS2812FX::segment * data)
+{
+  const uint8_t * d = (const uint8_t *)data;
+  const size_t size = settingsEncodedSize(0);
+  uint8_t * tlv = (uint8_t *)malloc(size);
+  if (!tlv) return false;
+
+  const size_t len = settingsEncode(data, 0, tlv, size);
+  settingsSnapshotHeader hdr = {
+    SETTINGS_SNAPSHOT_MAGIC,
+    _generation + 1,
+    SETTINGS_SCHEMA,
+    SETTINGS_TAG_COUNT,
+    (uint16_t)len,
+    settingsCRC(tlv, len)
+  };
+
+  File f = LittleFS.open(SETTINGS_TEMP_FILE, "w");
+  bool ok = static_cast<bool>(f);
+  ok = ok && f.write((const uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr);
+  ok = ok && f.write(tlv, len) == len;
+  if (f) f.close();
+  free(tlv);
+  // the rename replaces the previous snapshot atomically
+  if (!ok || !LittleFS.rename(SETTINGS_TEMP_FILE, SETTINGS_SNAPSHOT_FILE))
+  {
+    LittleFS.remove(SETTINGS_TEMP_FILE);
+    return false;
+  }
+
+  _generation++;
+  _haveSnapshot = true;
+  _removeLog = _stats.logBytes > 0;
+  _stats.logBytes = 0;
+  _stats.compactions++;
+  _stats.bytesChanged += countChanges(d);
+  _stats.bytesWritten += sizeof(hdr) + len;
+  if (data != &_persisted) memcpy(&_persisted, data, SETTINGS_SIZE);
+  return true;
+}
+
+// appends the changes of "data" to the journal (or writes a snapshot if required)
+static bool writeChanges(const WS2812FX::segment * data)
+{
+  const uint8_t * d = (const uint8_t *)data;
+  const uint16_t changed = countChanges(d);
+  if (_haveSnapshot && !changed) return true;
+
+  const size_t len = _haveSnapshot ? buildRecord(d) : 0;
+  if (!len || _stats.logBytes + len > SETTINGS_LOG_MAX) return writeSnapshot(data);
+
+  // a new journal replaces the obsolete one
+  const bool newLog = !_stats.logBytes;
+  File f = LittleFS.open(SETTINGS_LOG_FILE, newLog ? "w" : "a");
+  if (!f) return false;
+  bool ok = true;
+  size_t written = len;
+  if (newLog)
+  {
+    settingsLogHeader hdr = { SETTINGS_LOG_MAGIC, _generation };
+    ok = f.write((const uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr);
+    written += sizeof(hdr);
+  }
+  ok = ok && f.write(_records, len) == len;
+  f.close();
+  if (!ok)
+  {
+    // the journal may end with an incomplete record now - start with a new snapshot
+    _haveSnapshot = false;
+    return false;
+  }
+
+  _removeLog = false;
+  _stats.logBytes += written;
+  _stats.bytesChanged += changed;
+  _stats.bytesWritten += written;
+  decodeTags(&_records[SETTINGS_RECORD_HEADER], _records[1], (uint8_t *)&_persisted);
+  return true;
+}
+
+// applies the journal records of the current generation.
+// returns false if the journal ends with an invalid record
+static bool replayLog(void)
+{
+  File f = LittleFS.open(SETTINGS_LOG_FILE, "r");
+  if (!f) return true;
+
+  settingsLogHeader hdr;
+  if (f.read((uint8_t *)&hdr, sizeof(hdr)) != sizeof(hdr) || hdr.magic != SETTINGS_LOG_MAGIC || hdr.generation != _generation)
+  {
+    // journal of a previous snapshot (the compaction was interrupted)
+    f.close();
+    _removeLog = true;
+    return true;
+  }
+
+  size_t valid = sizeof(hdr);
+  bool complete = true;
+  uint8_t * r = _records;
+  while (f.available())
+  {
+    if (f.read(r, SETTINGS_RECORD_HEADER) != SETTINGS_RECORD_HEADER || r[0] != SETTINGS_RECORD_MAGIC ||
+        (size_t)(SETTINGS_RECORD_OVERHEAD + r[1]) > sizeof(_records) ||
+        f.read(&r[SETTINGS_RECORD_HEADER], r[1] + 2) != (size_t)(r[1] + 2) ||
+        settingsCRC(&r[1], r[1] + 1) != (r[SETTINGS_RECORD_HEADER + r[1]] | (r[SETTINGS_RECORD_HEADER + r[1] + 1] << 8)) ||
+        !decodeTags(&r[SETTINGS_RECORD_HEADER], r[1], (uint8_t *)&_persisted))
+    {
+      complete = false;
+      break;
+    }
+    valid += SETTINGS_RECORD_OVERHEAD + r[1];
+    _stats.replayed++;
+  }
+  f.close();
+  _stats.logBytes = valid;
+  return complete;
+}
+
+size_t settingsEncodedSize(uint8_t exclude)
+{
+  settingsTag t;
+  size_t size = 0;
+  for (uint8_t i = 0; i < SETTINGS_TAG_COUNT; i++)
+  {
+    readTag(i, &t);
+    if (t.flags & exclude) continue;
+    if (t.flags & SETTINGS_FLAG_KEYED) size += SETTINGS_TLV_HEADER + t.count * (1 + t.size);
+    else size += SETTINGS_TLV_HEADER + (t.count ? 1 + t.count * t.size : t.size);
+  }
+  return size;
+}
+
+size_t settingsEncode(const WS2812FX::segment * data, uint8_t exclude, uint8_t * out, size_t outSize)
+{
+  settingsTag t;
+  size_t len = 0;
+  for (uint8_t i = 0; i < SETTINGS_TAG_COUNT; i++)
+  {
+    readTag(i, &t);
+    if (t.flags & exclude) continue;
+    const size_t n = (t.flags & SETTINGS_FLAG_KEYED) ? encodeKeyed(t, (const uint8_t *)data, NULL, &out[len], outSize - len) :
+                     encodeTag(t, (const uint8_t *)data, 0, t.count ? t.count : 1, &out[len], outSize - len);
+    if (!n) return 0;
+    len += n;
+  }
+  return len;
+}
+
+bool settingsDecode(const uint8_t * tlv, size_t len, WS2812FX::segment * data)
+{
+  return decodeTags(tlv, len, (uint8_t *)data);
+}
+
+// the segment as the versions before stored it in the EEPROM (raw) - frozen, never change it.
+// The enums were 32 bit, CRGB 3 bytes (the padding is part of the CRC as it was stored).
+#define SETTINGS_LEGACY_MODES 54    // their MODE_COUNT (the mode ids did not change)
+
+struct settingsLegacySegment {
+  uint16_t CRC;                     // over the bytes behind it
+  uint16_t beat88;
+  uint16_t effectSpeeds[SETTINGS_LEGACY_MODES];
+  uint8_t  solidColor[3];
+  uint32_t colorTemp;
+  uint16_t hueTime;
+  uint16_t milliamps;
+  uint16_t autoplayDuration;
+  uint16_t autoPalDuration;
+  uint8_t  segments;
+  uint8_t  cooling;
+  uint8_t  sparking;
+  uint8_t  twinkleSpeed;
+  uint8_t  twinkleDensity;
+  uint8_t  numBars;
+  uint8_t  mode;
+  uint8_t  fps;
+  uint8_t  deltaHue;
+  uint8_t  blur;
+  uint8_t  damping;
+  uint8_t  dithering;
+  uint8_t  sunrisetime;
+  uint8_t  targetBrightness;
+  uint8_t  brightness;
+  uint8_t  targetPaletteNum;
+  uint8_t  currentPaletteNum;
+  uint8_t  paletteDistribution;
+  uint8_t  backgroundHue;
+  uint8_t  backgroundSat;
+  uint8_t  backgroundBri;
+  uint32_t colCor;
+  uint8_t  power;
+  uint8_t  isRunning;
+  uint8_t  reverse;
+  uint8_t  mirror;
+  uint8_t  addGlitter;
+  uint8_t  whiteGlitter;
+  uint8_t  onBlackOnly;
+  uint8_t  synchronous;
+  #ifdef HAS_KNOB_CONTROL
+  uint8_t  wifiDisabled;
+  #endif
+  uint32_t blendType;
+  uint32_t autoplay;
+  uint32_t autoPal;
+};
+
+#ifdef HAS_KNOB_CONTROL
+static_assert(sizeof(settingsLegacySegment) == 180, "the layout of the EEPROM settings is frozen");
+#else
+static_assert(sizeof(settingsLegacySegment) == 176, "the layout of the EEPROM settings is frozen");
+#endif
+
+size_t settingsLegacySize(void)
+{
+  return sizeof(settingsLegacySegment);
+}
+
+bool settingsDecodeLegacy(const uint8_t * blob, size_t len, WS2812FX::segment * data)
+{
+  settingsLegacySegment l;
+  if (len < sizeof(l)) return false;
+  memcpy(&l, blob, sizeof(l));
+  if (l.CRC != settingsCRC(blob + sizeof(l.CRC), sizeof(l) - sizeof(l.CRC))) return false;
+
+  data->beat88 = l.beat88;
+  for (uint8_t m = 0; m < SETTINGS_LEGACY_MODES && m < MODE_COUNT; m++)
+  {
+    data->effectSpeeds[m] = l.effectSpeeds[m];
+  }
+  data->solidColor          = CRGB(l.solidColor[0], l.solidColor[1], l.solidColor[2]);
+  data->colorTemp           = (ColorTemperature)l.colorTemp;
+  data->hueTime             = l.hueTime;
+  data->milliamps           = l.milliamps;
+  data->autoplayDuration    = l.autoplayDuration;
+  data->autoPalDuration     = l.autoPalDuration;
+  data->segments            = l.segments;
+  data->cooling             = l.cooling;
+  data->sparking            = l.sparking;
+  data->twinkleSpeed        = l.twinkleSpeed;
+  data->twinkleDensity      = l.twinkleDensity;
+  data->numBars             = l.numBars;
+  data->mode                = l.mode;
+  data->fps                 = l.fps;
+  data->deltaHue            = l.deltaHue;
+  data->blur                = l.blur;
+  data->damping             = l.damping;
+  data->dithering           = l.dithering;
+  data->sunrisetime         = l.sunrisetime;
+  data->targetBrightness    = l.targetBrightness;
+  data->brightness          = l.brightness;
+  data->targetPaletteNum    = l.targetPaletteNum;
+  data->currentPaletteNum   = l.currentPaletteNum;
+  data->paletteDistribution = l.paletteDistribution;
+  data->backgroundHue       = l.backgroundHue;
+  data->backgroundSat       = l.backgroundSat;
+  data->backgroundBri       = l.backgroundBri;
+  data->colCor              = (COLORCORRECTIONS)l.colCor;
+  data->power               = l.power;
+  data->isRunning           = l.isRunning;
+  data->reverse             = l.reverse;
+  data->mirror              = l.mirror;
+  data->addGlitter          = l.addGlitter;
+  data->whiteGlitter        = l.whiteGlitter;
+  data->onBlackOnly         = l.onBlackOnly;
+  data->synchronous         = l.synchronous;
+  #ifdef HAS_KNOB_CONTROL
+  data->wifiDisabled        = l.wifiDisabled;
+  #endif
+  data->blendType           = (TBlendType)l.blendType;
+  data->autoplay            = (AUTOPLAYMODES)l.autoplay;
+  data->autoPal             = (AUTOPLAYMODES)l.autoPal;
+  return true;
+}
+
+settingsLoadResult settingsLoad(WS2812FX::segment * data)
+{
+  const uint32_t start = micros();
+  // everything not being stored keeps its default
+  memcpy(&_persisted, data, SETTINGS_SIZE);
+  _haveSnapshot = false;
+  _stats.logBytes = 0;
+
+  File f = LittleFS.open(SETTINGS_SNAPSHOT_FILE, "r");
+  if (!f) return SETTINGS_NONE;
+
+  settingsSnapshotHeader hdr = {0, 0, 0, 0, 0, 0};
+  if (f.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) && hdr.magic != SETTINGS_SNAPSHOT_MAGIC)
+  {
+    // not in this format (yet) - the settings will be taken from the EEPROM (again)
+    f.close();
+    return SETTINGS_NONE;
+  }
+  uint8_t * tlv = NULL;
+  bool ok = hdr.magic == SETTINGS_SNAPSHOT_MAGIC &&
+            hdr.length && hdr.length <= SETTINGS_MAX_LENGTH &&
+            (tlv = (uint8_t *)malloc(hdr.length)) != NULL &&
+            f.read(tlv, hdr.length) == hdr.length;
+  f.close();
+  ok = ok && hdr.crc == settingsCRC(tlv, hdr.length) && decodeTags(tlv, hdr.length, (uint8_t *)&_persisted);
+  free(tlv);
+  if (!ok)
+  {
+    memcpy(&_persisted, data, SETTINGS_SIZE);
+    return SETTINGS_INVALID;
+  }
+  _generation   = hdr.generation;
+  _haveSnapshot = true;
+
+  // an incomplete journal: records appended now would not be replayed
+  // another schema: the snapshot gets written in the current one
+  if (!replayLog() || hdr.schema != SETTINGS_SCHEMA)
+  {
+    writeSnapshot(&_persisted);
+  }
+
+  memcpy(data, &_persisted, SETTINGS_SIZE);
+  _stats.loadMicros = micros() - start;
+  return SETTINGS_LOADED;
+}
+
+void settingsChanged(uint32_t now)
+{
+  if (!_dirty) _firstChange = now;
+  _lastChange = now;
+  _dirty = true;
+}
+
+void settingsService(const WS2812FX::segment * data, uint32_t now)
+{
+  // the time directly after a frame was shown is the best to block the loop
+  const uint32_t frames = strip->getFrameStats()->frames;
+  const bool frameShown = frames != _lastFrames;
+  _lastFrames = frames;
+  if (frameShown) _lastFrameMillis = now;
+
+  const bool idle = !_dirty && now - _lastChange > SETTINGS_COMPACT_IDLE_MS;
+  const bool compact = _haveSnapshot && idle && _stats.logBytes > SETTINGS_LOG_COMPACT;
+  if (!_dirty && !_removeLog && !compact) return;
+  if (!frameShown && now - _lastFrameMillis < SETTINGS_FRAME_WAIT_MS) return;
+
+  const uint32_t start = micros();
+  if (_removeLog)
+  {
+    // one file operation per frame - the changes (if any) follow with the next one
+    LittleFS.remove(SETTINGS_LOG_FILE);
+    _removeLog = false;
+    noteStall(start);
+    return;
+  }
+
+  if (now - _lastWrite < SETTINGS_MIN_INTERVAL_MS) return;
+  if (_dirty && now - _lastChange < SETTINGS_QUIET_MS && now - _firstChange < SETTINGS_MAX_DELAY_MS) return;
+
+  const bool ok = _dirty ? writeChanges(data) : writeSnapshot(&_persisted);
+  _lastWrite = now;
+  noteStall(start);
+  if (ok)
+  {
+    _stats.writes++;
+    _dirty = false;
+  }
+  else
+  {
+    _stats.failures++;
+  }
+}
+
+void settingsFlush(const WS2812FX::segment * data)
+{
+  const uint32_t start = micros();
+  if (writeChanges(data))
+  {
+    _stats.writes++;
+    _dirty = false;
+  }
+  else
+  {
+    _stats.failures++;
+  }
+  noteStall(start);
+}
+
+void settingsClear(void)
+{
+  LittleFS.remove(SETTINGS_SNAPSHOT_FILE);
+  LittleFS.remove(SETTINGS_TEMP_FILE);
+  LittleFS.remove(SETTINGS_LOG_FILE);
+  memset(&_persisted, 0, SETTINGS_SIZE);
+  _haveSnapshot = false;
+  _removeLog = false;
+  _dirty = false;
+  _stats.logBytes = 0;
+}
+
+const settingsStats * getSettingsStats(void)
+{
+  return &_stats;
+}
@@ -0,0 +1,83 @@
+#ifndef led_settings_h
+#define led_settings_h
+
+#include "led_strip.h"
+
+/*
+ * Persistence of the runtime settings (the segment) on LittleFS.
+ *
+ *   SETTINGS_SNAPSHOT_FILE: [header (16 bytes)][value]...
+ *   SETTINGS_LOG_FILE:      [magic (4)][generation (4)][record]...
+ *     record:               [SETTINGS_RECORD_MAGIC][length][value]...[CRC16 (2, LE)]
+ *     value:                [id][length][data (LE)] - arrays: [id][length][first index][elements]
+ *                                                   keyed arrays: [id][length]([index][element])...
+ *
+ * The values are identified by stable ids (see settingsTags), not by their position
+ * within the segment. Changing the segment layout (adding values, changing their size
+ * or the number of effects) keeps the stored settings - values of unknown ids are
+ * skipped, values not being stored keep their default. The speeds per effect are
+ * stored with the mode id of each effect.
+ *
+ * Changes are appended as records holding only the changed values to a journal.
+ * The journal belongs to the snapshot with the same generation. Compacting writes a new
+ * snapshot (to a temporary file being renamed) with the next generation - the old journal
+ * then is obsolete and gets removed with the next call. On boot the journal gets replayed
+ * up to the first invalid (e.g. incompletely written) record.
+ *
+ * Writes are debounced and only done directly after a frame was shown
+ * (unless the strip did not show a frame for SETTINGS_FRAME_WAIT_MS).
+ */
+
+// values belonging to the device (e.g. the current limit) or to the runtime (see settingsTags)
+#define SETTINGS_FLAG_DEVICE  0x01
+// arrays stored as index / element pairs (e.g. values per mode id)
+#define SETTINGS_FLAG_KEYED   0x02
+
+enum settingsLoadResult {
+  SETTINGS_LOADED,    // snapshot (and journal) read
+  SETTINGS_NONE,      // nothing stored in this format (e.g. settings still in the EEPROM of an older firmware)
+  SETTINGS_INVALID    // snapshot corrupt
+};
+
+struct settingsStats {
+  uint32_t writes;          // journal appends and snapshots written
+  uint32_t compactions;     // snapshots written
+  uint32_t failures;        // writes which failed (and get retried)
+  uint32_t replayed;        // journal records applied on boot
+  uint32_t bytesChanged;    // segment bytes which actually changed
+  uint32_t bytesWritten;    // bytes written to the files (write amplification = bytesWritten / bytesChanged)
+  uint32_t stallMicros;     // sum of the time spent writing
+  uint32_t stallMaxMicros;
+  uint32_t lastStallMicros;
+  uint32_t logBytes;        // current size of the journal
+  uint32_t loadMicros;      // time to read and decode the settings on boot
+};
+
+// applies the stored values to "data" (holding the defaults) - LittleFS needs to be mounted
+settingsLoadResult settingsLoad(WS2812FX::segment * data);
+// marks the settings to be changed - they get written once they are stable for SETTINGS_QUIET_MS
+void settingsChanged(uint32_t now);
+// writes the changes of "data" when due - to be called from the loop after the strip service
+void settingsService(const WS2812FX::segment * data, uint32_t now);
+// writes the changes of "data" right away (e.g. before a restart)
+void settingsFlush(const WS2812FX::segment * data);
+// removes the stored settings
+void settingsClear(void);
+
+// encodes the values of "data" as [id][length][value]... without the ones flagged with "exclude"
+// returns the number of bytes written to "out" (0 if "outSize" was not sufficient)
+size_t settingsEncode(const WS2812FX::segment * data, uint8_t exclude, uint8_t * out, size_t outSize);
+// max. number of bytes written by settingsEncode
+size_t settingsEncodedSize(uint8_t exclude);
+// applies the encoded values to "data" (values of unknown ids are skipped)
+// returns false if the data is malformed
+bool settingsDecode(const uint8_t * tlv, size_t len, WS2812FX::segment * data);
+
+// size of the settings stored in the EEPROM by the versions before
+size_t settingsLegacySize(void);
+// applies those (field by field) to "data" - returns false if their CRC does not match
+bool settingsDecodeLegacy(const uint8_t * blob, size_t len, WS2812FX::segment * data);
+
+const settingsStats * getSettingsStats(void);
+
+#endif
@@ -46,6 +46,8 @@
 #ifndef led_strip_h
 #include "led_strip.h"
 #endif
+#include "led_commands.h"
+#include "led_playlist.h"
 
 WS2812FX *strip;
 
@@ -159,6 +161,16 @@ inline uint32_t getFPSValue(void) {
 inline uint32_t getDithering(void) {
   return (uint32_t)(strip->getDithering());
 }
+// layer "L" (the fields of the layers only differ by the index)
+template <uint8_t L> uint32_t getLayerMode(void) {
+  return (uint32_t)(strip->getLayerMode(L));
+}
+template <uint8_t L> uint32_t getLayerOpacity(void) {
+  return (uint32_t)(strip->getLayerOpacity(L));
+}
+template <uint8_t L> uint32_t getLayerBlend(void) {
+  return (uint32_t)(strip->getLayerBlend(L));
+}
 inline uint32_t getResetDefaults(void) {
   return (uint32_t)(0);
 }
@@ -171,6 +183,12 @@ inline uint32_t getBckndSat() {
 inline uint32_t getBckndBri() {
   return (uint32_t)(strip->getBckndBri());
 }
+inline uint32_t getSyncRole() {
+  return (uint32_t)(strip->getSyncRole());
+}
+inline uint32_t getSyncGroup() {
+  return (uint32_t)(strip->getSyncGroup());
+}
 inline uint32_t getColCor() {
   return (uint32_t)(strip->getColorCorrectionEnum());
 }
@@ -214,6 +232,19 @@ void getBlendTypes(JsonArray jArr)
   jArr.add(F("NoBlend"));
   jArr.add(F("LinearBlend"));
 }
+void getSyncRoles(JsonArray jArr)
+{
+  jArr.add(F("Off"));
+  jArr.add(F("Leader"));
+  jArr.add(F("Follower"));
+}
+void getLayerBlends(JsonArray jArr)
+{
+  for (uint8_t i = 0; i < LayerStack::BLEND_COUNT; i++)
+  {
+    jArr.add(LayerStack::getBlendName(i));
+  }
+}
 void getColorTemps(JsonArray jArr)
 {
   const uint8_t count = 10;
@@ -267,6 +298,19 @@ String getBlendTypeAtIndex(uint32_t index) {
   }
 }
 
+String getSyncRoleAtIndex(uint32_t index) {
+  switch(index) {
+    case SYNC_ROLE_OFF:      return String("Off");
+    case SYNC_ROLE_LEADER:   return String("Leader");
+    case SYNC_ROLE_FOLLOWER: return String("Follower");
+    default: return String("");
+  }
+}
+
+String getLayerBlendAtIndex(uint32_t index) {
+  return String(LayerStack::getBlendName(index));
+}
+
 String getColorTempAtIndex(uint32_t index) {
   if (index < 10) {
     return String(strip->getColorTempName(index));
@@ -392,6 +436,15 @@ void setFPSValue(uint32_t val) {
 void setDithering(uint32_t val) {
   strip->setDithering(val);
 }
+template <uint8_t L> void setLayerMode(uint32_t val) {
+  strip->setLayerMode(L, val);
+}
+template <uint8_t L> void setLayerOpacity(uint32_t val) {
+  strip->setLayerOpacity(L, val);
+}
+template <uint8_t L> void setLayerBlend(uint32_t val) {
+  strip->setLayerBlend(L, val);
+}
 void setResetDefaults(uint32_t val) {
   if(val)
   {
@@ -407,6 +460,12 @@ void setBckndSat(uint32_t val) {
 void setBckndBri(uint32_t val) {
   strip->setBckndBri(val);
 }
+void setSyncRole(uint32_t val) {
+  strip->setSyncRole(val);
+}
+void setSyncGroup(uint32_t val) {
+  strip->setSyncGroup(val);
+}
 void setColCor(uint32_t val) {
   strip->setColCor((COLORCORRECTIONS)val);
 }
@@ -447,6 +506,11 @@ String getResetAtIndex(uint32_t index) {
 }
 #endif
 
+// the fields table has the layers 1 and 2
+#if LAYER_COUNT > 2
+#error "There are fields for two layers only (LAYER_COUNT)"
+#endif
+
 const Field fields [] = {
   {"title",             LED_NAME,                       TitleFieldType,     0,                                   0,                                             nullptr,               nullptr,           nullptr,        nullptr          },
   {"s_powerSection",    "Power / Effects",              SectionFieldType,   0,                                   0,                                             nullptr,               nullptr,           nullptr,        nullptr          },
@@ -482,6 +546,18 @@ const Field fields [] = {
   {"whiteGlitter",      "White Glitter",                BooleanFieldType,   (uint16_t)0,                            (uint16_t)1,                                      getWhiteOnly,       nullptr,           nullptr,        setWhiteOnly                  },
   {"onBlackOnly",       "On Black",                     BooleanFieldType,   (uint16_t)0,                            (uint16_t)1,                                      getOnBlackOnly,     nullptr,           nullptr,        setOnBlackOnly                },
   {"syncGlitter",       "Sync Segments",                BooleanFieldType,   (uint16_t)0,                            (uint16_t)1,                                      getSynched,         nullptr,           nullptr,        setSynched             },
+  {"s_layers",          "Layers",                       SectionFieldType,   0,                                   0,                                             nullptr,               nullptr,           nullptr,        nullptr                          },
+  {"layer1Effect",      "Layer 1 effect",               SelectFieldType,    (uint16_t)0,                            (uint16_t)strip->getModeCount(),                  getLayerMode<0>,    getPatterns,       getPatternAtIndex, setLayerMode<0>             },
+  {"layer1Opacity",     "Layer 1 opacity (0: off)",     NumberFieldType,    (uint16_t)0,                            (uint16_t)255,                                    getLayerOpacity<0>, nullptr,           nullptr,        setLayerOpacity<0>            },
+  {"layer1Blend",       "Layer 1 blend",                SelectFieldType,    (uint16_t)0,                            (uint16_t)(LayerStack::BLEND_COUNT-1),            getLayerBlend<0>,   getLayerBlends,    getLayerBlendAtIndex, setLayerBlend<0>         },
+  #if LAYER_COUNT > 1
+  {"layer2Effect",      "Layer 2 effect",               SelectFieldType,    (uint16_t)0,                            (uint16_t)strip->getModeCount(),                  getLayerMode<1>,    getPatterns,       getPatternAtIndex, setLayerMode<1>             },
+  {"layer2Opacity",     "Layer 2 opacity (0: off)",     NumberFieldType,    (uint16_t)0,                            (uint16_t)255,                                    getLayerOpacity<1>, nullptr,           nullptr,        setLayerOpacity<1>            },
+  {"layer2Blend",       "Layer 2 blend",                SelectFieldType,    (uint16_t)0,                            (uint16_t)(LayerStack::BLEND_COUNT-1),            getLayerBlend<1>,   getLayerBlends,    getLayerBlendAtIndex, setLayerBlend<1>         },
+  #endif
+  {"s_sync",            "Sync (with other strips)",     SectionFieldType,   0,                                   0,                                             nullptr,               nullptr,           nullptr,        nullptr                          },
+  {"syncRole",          "Sync role",                    SelectFieldType,    (uint16_t)SYNC_ROLE_OFF,                (uint16_t)(SYNC_ROLE_COUNT-1),                    getSyncRole,        getSyncRoles,      getSyncRoleAtIndex, setSyncRole                 },
+  {"syncGroup",         "Sync group",                   NumberFieldType,    (uint16_t)0,                            (uint16_t)255,                                    getSyncGroup,       nullptr,           nullptr,        setSyncGroup                  },
   {"s_basicHue",        "Hue Change",                   SectionFieldType,   0,                                   0,                                             nullptr,               nullptr,           nullptr,        nullptr                          },
   {"hueTime",           "Hue interval (ms)",            NumberFieldType,    (uint16_t)0,                            (uint16_t)5000,                                   getHueTime,         nullptr,           nullptr,        setHueTime                    },
   {"deltaHue",          "Hue Offset",                   NumberFieldType,    (uint16_t)0,                            (uint16_t)255,                                    getDeltaHue,        nullptr,           nullptr,        setDeltaHue                   },    
@@ -515,6 +591,9 @@ const Field fields [] = {
 #define ARRAY_SIZE(A) (sizeof(A) / sizeof((A)[0]))
 #endif
 
+// the commands address the fields by index - the ones beyond could not be set (see led_commands.cpp)
+static_assert(ARRAY_SIZE(fields) <= LED_CMD_MAX_FIELDS, "more fields than LED_CMD_MAX_FIELDS");
+
 uint8_t fieldCount = ARRAY_SIZE(fields);
 
 bool getAllValuesJSONArray(JsonArray arr)
@@ -603,41 +682,59 @@ String getFieldValue(const char * name)
   Field field = getField(name);
   if (field.getValue)
   {
-    switch (field.type)
+    return getFieldValue(field, field.getValue());
+  }
+  return String();
+}
+
+String getFieldValue(const Field &field, uint32_t value)
+{
+  switch (field.type)
+  {
+  case NumberFieldType:
+  case ColorFieldType:
+    return String(value);
+    break;
+  case BooleanFieldType:
+    if(value)
+    {
+      return "on";
+    }
+    return "off";
+    break;
+  case SelectFieldType:
+    // Use memory-efficient single option getter if available
+    if (field.getOptionAtIndex)
     {
-    case NumberFieldType:
-    case ColorFieldType:
-      return String(field.getValue());
-      break;
-    case BooleanFieldType:
-      if(field.getValue())
-      {
-        return "on";
-      }
-      return "off";
-      break;
-    case SelectFieldType:
-      // Use memory-efficient single option getter if available
-      if (field.getOptionAtIndex)
-      {
-        return field.getOptionAtIndex(field.getValue());
-      }
-      else if (field.getOptions)
-      {
-        // Fallback to original method if single option getter not available
-        // Buffer size: Single field value as uint32_t + JSON overhead = 1024 bytes - standard to be safe
-        DynamicJsonDocument doc(1024);
-        JsonArray a = doc.to<JsonArray>();
-        field.getOptions(a);
-        return a[field.getValue()].as<const char*>(); 
-      }
-      break;
-    default:
-      break;
+      return field.getOptionAtIndex(value);
     }
-    return String(field.getValue());
+    else if (field.getOptions)
+    {
+      // Fallback to original method if single option getter not available
+      // Buffer size: Single field value as uint32_t + JSON overhead = 1024 bytes - standard to be safe
+      DynamicJsonDocument doc(1024);
+      JsonArray a = doc.to<JsonArray>();
+      field.getOptions(a);
+      return a[value].as<const char*>(); 
+    }
+    break;
+  default:
+    break;
+  }
+  return String(value);
+}
+
+uint32_t limitFieldValue(const Field &field, uint32_t value)
+{
+  switch (field.type)
+  {
+  case NumberFieldType:
+    return constrain(value, (uint32_t)field.min, (uint32_t)field.max);
+  case BooleanFieldType:
+    return value ? 1 : 0;
+  default:
+    return value;
   }
-  return String();
 }
 
 void setFieldValue(const char * name, uint32_t value)
@@ -662,9 +759,21 @@ uint8_t getFieldCount(void)
 
   
 
+// at the start of each frame: the changes from the web server, then the playlist
+static void frameStart(void)
+{
+  applyQueuedCommands();
+  playlistService();
+}
+
 void stripe_setup(CRGB * pleds, CRGB* eleds)
 {
   strip = new WS2812FX(pleds, eleds);
+  // changes from the web server are applied at the start of each frame
+  strip->setCommandHandler(frameStart);
+  strip->setShowHandler(inputsShown);
+  // the next entry of a playlist gets prepared while waiting for the next frame
+  strip->setIdleHandler(playlistPrepare);
   strip->init();
   strip->start();
   strip->show();
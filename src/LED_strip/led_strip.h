@@ -140,6 +140,10 @@ struct Field {
 
 Field getField(const char * name);
 String getFieldValue(const char * name);
+// returns the given value of the field as it would be returned by getFieldValue
+String getFieldValue(const Field &field, uint32_t value);
+// limits the value to the boundaries of Number and Boolean fields
+uint32_t limitFieldValue(const Field &field, uint32_t value);
 void setFieldValue(const char * name, uint32_t value);
 bool isField(const char * name);
 const Field * getFields(void);
@@ -0,0 +1,211 @@
+#include "led_sync.h"
+#include "led_playlist.h"
+#include "profiler.h"
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+
+#ifndef USE_GET_MILLISECOND_TIMER
+#error "The synchronization needs USE_GET_MILLISECOND_TIMER (the beat generators follow syncMillis)"
+#endif
+
+#define SYNC_MAGIC        0x31594E53UL  // "SNY1"
+#define SYNC_MAX_PACKETS  4             // max. packets processed per loop
+
+struct syncPacket {
+  uint32_t magic;
+  uint32_t leader;        // chip id
+  uint32_t clock;         // syncMillis() of the leader when sent
+  uint32_t timebase;      // effect timebase of the leader
+  uint16_t beat88;
+  uint8_t  group;
+  uint8_t  seq;
+  uint8_t  mode;
+  uint8_t  palette;
+  uint8_t  reserved[2];
+} __attribute__((packed));
+
+static WiFiUDP    _udp;
+static syncStats  _stats = {0, 0, 0, 0, 0, 0, 0, 0};
+
+static int32_t    _offset       = 0;  // syncMillis() - millis()
+static int32_t    _target       = 0;  // the offset being slewed towards
+static uint32_t   _slewTime     = 0;  // millis() of the last slew step
+static uint32_t   _leader       = 0;  // chip id followed (0: none)
+static uint32_t   _lastReceived = 0;
+static uint32_t   _lastSent     = 0;
+static syncPacket _sent;              // last packet sent (leader)
+
+uint32_t syncMillis(void)
+{
+  return millis() + _offset;
+}
+
+// the clock of the FastLED beat generators (beat88, beatsin88, ...)
+uint32_t get_millisecond_timer(void)
+{
+  return syncMillis();
+}
+
+bool syncIsFollowing(void)
+{
+  return _leader != 0;
+}
+
+const syncStats * getSyncStats(void)
+{
+  _stats.leader = _leader;
+  _stats.offset = _offset;
+  _stats.error  = _target - _offset;
+  return &_stats;
+}
+
+// moves the offset towards the target - 1 ms per SYNC_SLEW_RATE ms at most
+static void slew(uint32_t now)
+{
+  const int32_t error = _target - _offset;
+  if (!error)
+  {
+    _slewTime = now;
+    return;
+  }
+  const uint32_t steps = (now - _slewTime) / SYNC_SLEW_RATE;
+  if (!steps) return;
+  _slewTime += steps * SYNC_SLEW_RATE;
+  const int32_t step = min((uint32_t)abs(error), steps);
+  _offset += error > 0 ? step : -step;
+}
+
+static void unfollow(void)
+{
+  if (!_leader) return;
+  _leader = 0;
+  // the effect keeps running - it just gets its own timebase with the next restart
+  strip->releaseEffectTimebase();
+}
+
+static void follow(const syncPacket &p)
+{
+  // the leader decides what is shown
+  if (getPlaylistPlaying(NULL)) playlistStop();
+  if (strip->getAutoplay() != AUTO_MODE_OFF) strip->setAutoplay(AUTO_MODE_OFF);
+  if (strip->getAutopal()  != AUTO_MODE_OFF) strip->setAutopal(AUTO_MODE_OFF);
+
+  // the VOID mode (realtime data of the leader) and the ones controlling the strip stay local
+  if (p.mode < FX_MODE_VOID && p.mode != strip->getMode())
+  {
+    strip->setMode(p.mode);
+  }
+  if (p.beat88 != strip->getBeat88())
+  {
+    strip->setBeat88(p.beat88);
+  }
+  if (p.palette < NUM_PALETTES && p.palette != strip->getTargetPaletteNumber())
+  {
+    strip->setTargetPalette(p.palette);
+  }
+  if (p.mode == strip->getMode() && p.timebase != strip->getEffectTimebase())
+  {
+    // (re)starts the effect in phase with the one of the leader
+    strip->setEffectTimebase(p.timebase);
+  }
+}
+
+static void receive(uint32_t now)
+{
+  syncPacket p;
+  if (_udp.read((uint8_t *)&p, sizeof(p)) != sizeof(p) || p.magic != SYNC_MAGIC)
+  {
+    _stats.invalid++;
+    return;
+  }
+  if (strip->getSyncRole() != SYNC_ROLE_FOLLOWER || p.group != strip->getSyncGroup() || p.leader == ESP.getChipId() ||
+      (_leader && p.leader != _leader))
+  {
+    // another group or a second leader of the group (the first one heard is followed)
+    _stats.ignored++;
+    return;
+  }
+  _stats.received++;
+
+  // the clock of the leader when the packet arrived - minus the transmission delay
+  const int32_t sample = (int32_t)(p.clock - now);
+  if (p.leader != _leader || abs(sample - _target) > SYNC_STEP_MS)
+  {
+    // new leader (or it restarted) - the effect restarts with its timebase anyway
+    _offset   = _target = sample;
+    _slewTime = now;
+    _leader   = p.leader;
+    _stats.steps++;
+  }
+  else if (sample > _target)
+  {
+    // the packets delayed least tell the offset best
+    _target += (sample - _target + 1) / 2;
+  }
+  else
+  {
+    _target -= (_target - sample + 15) / 16;
+  }
+  _lastReceived = now;
+  follow(p);
+}
+
+static void send(uint32_t now)
+{
+  _sent.magic    = SYNC_MAGIC;
+  _sent.leader   = ESP.getChipId();
+  _sent.clock    = syncMillis();
+  _sent.timebase = strip->getEffectTimebase();
+  _sent.beat88   = strip->getBeat88();
+  _sent.group    = strip->getSyncGroup();
+  _sent.seq++;
+  _sent.mode     = strip->getMode();
+  _sent.palette  = strip->getTargetPaletteNumber();
+
+  // the broadcast address of the network
+  const IPAddress broadcast((uint32_t)WiFi.localIP() | ~(uint32_t)WiFi.subnetMask());
+  _udp.beginPacket(broadcast, SYNC_PORT);
+  _udp.write((const uint8_t *)&_sent, sizeof(_sent));
+  if (_udp.endPacket()) _stats.sent++;
+  _lastSent = now;
+}
+
+static bool leaderChanged(void)
+{
+  return _sent.mode     != strip->getMode() ||
+         _sent.beat88   != strip->getBeat88() ||
+         _sent.palette  != strip->getTargetPaletteNumber() ||
+         _sent.timebase != strip->getEffectTimebase() ||
+         _sent.group    != strip->getSyncGroup();
+}
+
+void syncBegin(void)
+{
+  _udp.begin(SYNC_PORT);
+}
+
+void syncService(uint32_t now)
+{
+  // the packets are read in any role (they would queue up otherwise)
+  for (uint8_t n = 0; n < SYNC_MAX_PACKETS && _udp.parsePacket() > 0; n++)
+  {
+    receive(now);
+  }
+
+  const uint8_t role = strip->getSyncRole();
+  if (role != SYNC_ROLE_FOLLOWER || (_leader && (now - _lastReceived) > SYNC_TIMEOUT))
+  {
+    unfollow();
+  }
+  slew(now);
+
+  if (role == SYNC_ROLE_LEADER)
+  {
+    const uint32_t since = now - _lastSent;
+    if (since >= SYNC_INTERVAL || (since >= SYNC_MIN_INTERVAL && leaderChanged()))
+    {
+      PROFILE_ZONE("syncSend");
+      send(now);
+    }
+  }
+}
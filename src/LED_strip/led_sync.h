@@ -0,0 +1,54 @@
+#ifndef led_sync_h
+#define led_sync_h
+
+#include "led_strip.h"
+
+/*
+ * Synchronization of several strips (lamps) via UDP broadcast on SYNC_PORT.
+ *
+ * The strips of a sync group either lead (one) or follow (see the "syncRole" and
+ * "syncGroup" fields). The leader broadcasts every SYNC_INTERVAL ms (and right
+ * after a change) its clock, effect, palette, speed and the timebase its effect
+ * was started with:
+ *
+ *   [magic (4)][leader chip id (4)][clock (4)][timebase (4)][beat88 (2)]
+ *   [group (1)][sequence (1)][mode (1)][palette (1)][reserved (2)]    (little endian)
+ *
+ * The clock is syncMillis() - millis() plus an offset. It drives the beat
+ * generators of FastLED (get_millisecond_timer, USE_GET_MILLISECOND_TIMER) and
+ * the effect timebase (WS2812FX::getEffectTimebase). A follower estimates the
+ * offset to the clock of its leader (favouring the packets delayed least) and
+ * slews its own offset towards it - the clock never runs more than 1/SYNC_SLEW_RATE
+ * faster or slower and never jumps. Only a new leader (or a difference larger than
+ * SYNC_STEP_MS) sets the clock at once - together with the effect restarting with
+ * the timebase of the leader.
+ *
+ * A follower takes over the effect (the VOID mode and the ones behind excluded),
+ * palette and speed and runs its effect with the timebase of the leader - the
+ * same effects stay in phase. Its autoplay and playlist are stopped meanwhile.
+ * Without packets for SYNC_TIMEOUT ms it runs on its own again (keeping its clock).
+ */
+
+struct syncStats {
+  uint32_t sent;          // packets sent (leader)
+  uint32_t received;      // packets of the leader followed
+  uint32_t ignored;       // valid packets of other groups or other leaders
+  uint32_t invalid;       // malformed packets
+  uint32_t steps;         // clock set at once (new leader)
+  uint32_t leader;        // chip id of the leader followed (0: none)
+  int32_t  offset;        // ms syncMillis() is ahead of millis()
+  int32_t  error;         // ms still to be slewed
+};
+
+// binds the UDP socket
+void syncBegin(void);
+// sends / receives and slews the clock - to be called from the render loop only
+void syncService(uint32_t now);
+
+// the synchronized clock (ms)
+uint32_t syncMillis(void);
+// true while following a leader
+bool syncIsFollowing(void);
+const syncStats * getSyncStats(void);
+
+#endif
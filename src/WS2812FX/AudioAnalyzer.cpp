@@ -0,0 +1,181 @@
+#include "AudioAnalyzer.h"
+#include <math.h>
+#include <string.h>
+
+#if AUDIO_BANDS != 8
+  #error "AudioAnalyzer has band frequencies for 8 bands"
+#endif
+#if AUDIO_SAMPLE_RATE < 1000
+  #error "AUDIO_SAMPLE_RATE needs to be 1000 Hz or more (the highest band is 400 Hz)"
+#endif
+
+// centre frequencies of the bands (Hz)
+static const uint16_t bandFrequency[AUDIO_BANDS] = { 50, 70, 100, 140, 190, 250, 320, 400 };
+
+// beat and tempo limits in blocks
+static const uint16_t MIN_BEAT_BLOCKS    = (uint32_t)AUDIO_MIN_BEAT_MS * AUDIO_SAMPLE_RATE / (1000UL * AUDIO_BLOCK_SIZE);
+static const uint16_t MIN_INTERVAL       = 300UL  * AUDIO_SAMPLE_RATE / (1000UL * AUDIO_BLOCK_SIZE);  // 200 bpm
+static const uint16_t MAX_INTERVAL       = 1500UL * AUDIO_SAMPLE_RATE / (1000UL * AUDIO_BLOCK_SIZE);  //  40 bpm
+static const uint8_t  MIN_RANGE          = 24;   // between floor and peak (3 octaves of energy ~ 9 dB)
+static const uint16_t MIN_FLUX           = 24;   // rise of the energy to count as an onset
+static const uint8_t  NOISE_GATE         = 96;   // 8 * log2 of the energy of ~ 2 LSB noise
+static const uint8_t  ONSET_BANDS        = 2;    // the bands up to 70 Hz (kick drum)
+
+AudioAnalyzer::AudioAnalyzer()
+{
+  for (uint8_t b = 0; b < AUDIO_BANDS; b++)
+  {
+    const long q = lroundf(32768.0f * cosf(2.0f * (float)M_PI * bandFrequency[b] / AUDIO_SAMPLE_RATE));
+    _coeff[b] = q > 32767 ? 32767 : q;
+  }
+  reset();
+}
+
+void AudioAnalyzer::reset()
+{
+  memset(_s1, 0, sizeof(_s1));
+  memset(_s2, 0, sizeof(_s2));
+  memset(_energy, 0, sizeof(_energy));
+  memset(&_frame, 0, sizeof(_frame));
+  for (uint8_t b = 0; b < AUDIO_BANDS; b++)
+  {
+    _floor[b] = 0xFF00;  // drops to the first block
+    _peak[b]  = 0;
+  }
+  _dc        = 512L << 8;  // the middle of the ADC range (no settling at the start)
+  _count     = 0;
+  _fluxAvg   = 0;
+  _sinceBeat = 0xFFFF;
+  _interval  = 0;
+  _misses    = 0;
+  _beatLatch = false;
+  _blocks    = 0;
+  _beats     = 0;
+}
+
+uint8_t AudioAnalyzer::log2x8(uint32_t v)
+{
+  if (!v) return 0;
+  uint8_t msb = 31;
+  while (!(v & 0x80000000UL))
+  {
+    v <<= 1;
+    msb--;
+  }
+  // the three bits below the leading one are the fraction
+  return (msb << 3) | ((v >> 28) & 0x07);
+}
+
+bool AudioAnalyzer::addSample(uint16_t sample)
+{
+  // remove the DC offset (one pole high pass, ~256 samples)
+  const int32_t x256 = (int32_t)sample << 8;
+  _dc += (x256 - _dc) >> 8;
+  const int32_t x = (x256 - _dc) >> 8;
+
+  for (uint8_t b = 0; b < AUDIO_BANDS; b++)
+  {
+    const int32_t s0 = x + ((_coeff[b] * _s1[b]) >> 14) - _s2[b];
+    _s2[b] = _s1[b];
+    _s1[b] = s0;
+  }
+
+  if (++_count < AUDIO_BLOCK_SIZE) return false;
+  analyzeBlock();
+  _count = 0;
+  return true;
+}
+
+void AudioAnalyzer::analyzeBlock()
+{
+  uint16_t flux = 0;
+  uint16_t sum  = 0;
+
+  for (uint8_t b = 0; b < AUDIO_BANDS; b++)
+  {
+    // energy of the band: s1^2 + s2^2 - coeff * s1 * s2
+    const int64_t s1 = _s1[b];
+    const int64_t s2 = _s2[b];
+    int64_t p = s1 * s1 + s2 * s2 - ((_coeff[b] * s1) >> 14) * s2;
+    _s1[b] = _s2[b] = 0;
+    if (p < 0) p = 0;
+    if (p > 0xFFFFFFFFLL) p = 0xFFFFFFFFLL;
+    // below the gate it is the noise of the ADC
+    uint8_t e = log2x8((uint32_t)p);
+    if (e < NOISE_GATE) e = NOISE_GATE;
+
+    // rise against the last block - the onsets are taken from the lower bands
+    if (b < ONSET_BANDS && e > _energy[b]) flux += e - _energy[b];
+    _energy[b] = e;
+
+    // automatic gain: the floor follows the minimum (fast down, slow up),
+    // the peak the maximum (fast up, slow down)
+    const uint16_t e88 = (uint16_t)e << 8;
+    if (e88 < _floor[b]) _floor[b] = e88;
+    else                 _floor[b] += (e88 - _floor[b]) >> 9;
+    if (e88 > _peak[b])  _peak[b] = e88;
+    else                 _peak[b] -= (_peak[b] - e88) >> 7;
+
+    const uint16_t lo = _floor[b] >> 8;
+    uint16_t hi = _peak[b] >> 8;
+    if (hi < lo + MIN_RANGE) hi = lo + MIN_RANGE;
+    const uint16_t v = e <= lo ? 0 : ((uint32_t)(e - lo) * 255) / (hi - lo);
+    const uint8_t level = v > 255 ? 255 : v;
+
+    // rises at once, falls by a quarter per block (no flicker on the LEDs)
+    uint8_t &shown = _frame.bands[b];
+    shown = level >= shown ? level : shown - ((shown - level + 3) >> 2);
+    sum += shown;
+  }
+
+  _frame.level = sum / AUDIO_BANDS;
+  _frame.bass  = ((uint16_t)_frame.bands[0] + _frame.bands[1]) >> 1;
+
+  // onset: the rise is well above its running average (8.4 fixed point)
+  // (the first block has nothing to rise from)
+  if (!_blocks) flux = 0;
+  if (_sinceBeat < 0xFFFF) _sinceBeat++;
+  const uint32_t flux16 = (uint32_t)flux << 4;
+  const bool beat = flux16 > (uint32_t)_fluxAvg + (_fluxAvg >> 1) + (MIN_FLUX << 4) && _sinceBeat >= MIN_BEAT_BLOCKS;
+  _fluxAvg += ((int32_t)flux16 - (int32_t)_fluxAvg) >> 4;
+
+  if (beat)
+  {
+    // tempo: average the intervals close to the current one, switch after
+    // several others in a row
+    if (_sinceBeat >= MIN_INTERVAL && _sinceBeat <= MAX_INTERVAL)
+    {
+      const int32_t iv = (int32_t)_sinceBeat << 4;
+      const int32_t diff = iv - _interval;
+      if (!_interval)
+      {
+        _interval = iv;
+      }
+      else if (diff <= (int32_t)_interval / 5 && -diff <= (int32_t)_interval / 5)
+      {
+        _interval += diff / 4;
+        _misses = 0;
+      }
+      else if (++_misses >= 4)
+      {
+        _interval = iv;
+        _misses = 0;
+      }
+    }
+    _sinceBeat = 0;
+    _beats++;
+    _beatLatch = true;
+  }
+  else if (_sinceBeat > 4 * MAX_INTERVAL)
+  {
+    // no beats anymore - forget the tempo
+    _interval = 0;
+  }
+
+  _frame.beat = beat;
+  _frame.bpm = _interval ? (60UL * AUDIO_SAMPLE_RATE * 16) / ((uint32_t)_interval * AUDIO_BLOCK_SIZE) : 0;
+  const uint32_t age = (uint32_t)_sinceBeat * AUDIO_BLOCK_SIZE * 1000 / AUDIO_SAMPLE_RATE;
+  _frame.beatAge = age > 0xFFFF ? 0xFFFF : age;
+  _frame.active = true;
+  _blocks++;
+}
@@ -0,0 +1,92 @@
+#ifndef AUDIO_ANALYZER_H
+#define AUDIO_ANALYZER_H
+
+#include <stdint.h>
+#include "../../include/defaults.h"
+
+/**
+ * @brief What the effects get to see of the audio - refreshed once per frame
+ */
+struct AudioFrame {
+    uint8_t  bands[AUDIO_BANDS];  ///< loudness per band (0..255 relative to its recent range), low to high
+    uint8_t  level;               ///< loudness of all bands
+    uint8_t  bass;                ///< loudness of the two lowest bands
+    bool     beat;                ///< an onset (beat) was detected since the last frame
+    uint16_t bpm;                 ///< tempo from the beat intervals (0: not known yet)
+    uint16_t beatAge;             ///< ms since the last beat (saturates at 0xFFFF)
+    bool     active;              ///< audio is being sampled (false: all values are 0)
+};
+
+/**
+ * @brief Goertzel filter bank with beat (onset) and tempo detection
+ *
+ * Works on the raw 10 bit ADC samples in fixed point and has no platform
+ * dependencies - the same code runs on the host (e.g. fed from a WAV file).
+ *
+ * The samples are analyzed in blocks of AUDIO_BLOCK_SIZE: the DC offset gets
+ * removed and every band is a Goertzel filter (one multiply per sample and
+ * band) at a fixed frequency between 50 and 400 Hz. Per block the band
+ * energies are taken as 8 * log2 and scaled between a slow noise floor and a
+ * decaying peak (automatic gain) - energies below a fixed gate count as the
+ * ADC noise. A beat is a rise of the energy of the two lowest bands (kick
+ * drum) well above its running average - at most one per AUDIO_MIN_BEAT_MS.
+ * The tempo follows the beat intervals between 40 and 200 bpm.
+ */
+class AudioAnalyzer {
+public:
+    AudioAnalyzer();
+
+    /**
+     * @brief Forget everything (gain, beats, tempo)
+     */
+    void reset();
+
+    /**
+     * @brief Feed one ADC sample (0..1023)
+     * @return true when a block got completed (and analyzed)
+     */
+    bool addSample(uint16_t sample);
+
+    /**
+     * @brief The result of the last block (beat is set when this block had a beat)
+     */
+    inline const AudioFrame& result() const { return _frame; }
+
+    /**
+     * @brief Get and clear the "beat since the last call" flag
+     */
+    inline bool takeBeat() { const bool b = _beatLatch; _beatLatch = false; return b; }
+
+    inline uint32_t getBlocks() const { return _blocks; }
+    inline uint32_t getBeats()  const { return _beats; }
+
+    /**
+     * @brief 8 * log2(v) with 3 fractional bits (0 for v == 0)
+     */
+    static uint8_t log2x8(uint32_t v);
+
+private:
+    void analyzeBlock();
+
+    int16_t  _coeff[AUDIO_BANDS];     ///< 2 * cos(2 pi f / fs) in Q14
+    int32_t  _s1[AUDIO_BANDS];        ///< Goertzel state
+    int32_t  _s2[AUDIO_BANDS];
+    int32_t  _dc;                     ///< DC offset of the input in 1/256
+    uint16_t _count;                  ///< samples in the current block
+
+    uint16_t _floor[AUDIO_BANDS];     ///< noise floor per band (log scale, 8.8)
+    uint16_t _peak[AUDIO_BANDS];      ///< recent peak per band (log scale, 8.8)
+    uint8_t  _energy[AUDIO_BANDS];    ///< log energy of the last block
+    uint16_t _fluxAvg;                ///< running average of the energy rise (8.4)
+    uint16_t _sinceBeat;              ///< blocks since the last beat
+    uint16_t _interval;               ///< beat interval in blocks (12.4, 0: unknown)
+    uint8_t  _misses;                 ///< intervals in a row not matching the tempo
+    bool     _beatLatch;
+
+    uint32_t _blocks;
+    uint32_t _beats;
+
+    AudioFrame _frame;
+};
+
+#endif
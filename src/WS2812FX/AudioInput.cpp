@@ -0,0 +1,99 @@
+#include "AudioInput.h"
+#include "profiler.h"
+
+#if AUDIO_RING_SIZE & (AUDIO_RING_SIZE - 1)
+  #error "AUDIO_RING_SIZE needs to be a power of 2"
+#endif
+
+#if AUDIO_SAMPLE_RATE > 1000
+  #error "AUDIO_SAMPLE_RATE above 1 kHz disturbs the WiFi (see AudioInput.h)"
+#endif
+
+#define AUDIO_SAMPLE_PERIOD_US (1000000UL / AUDIO_SAMPLE_RATE)
+
+AudioAnalyzer AudioInput::_analyzer;
+AudioFrame    AudioInput::_frame;
+uint16_t      AudioInput::_ring[AUDIO_RING_SIZE];
+uint16_t      AudioInput::_head       = 0;
+uint16_t      AudioInput::_tail       = 0;
+uint32_t      AudioInput::_nextSample = 0;
+uint16_t      AudioInput::_lastSample = 0;
+bool          AudioInput::_running    = false;
+uint32_t      AudioInput::_samples    = 0;
+uint32_t      AudioInput::_held       = 0;
+uint32_t      AudioInput::_overruns   = 0;
+
+void AudioInput::begin(void)
+{
+#ifdef HAS_AUDIO_INPUT
+  pinMode(A0, INPUT);
+  _analyzer.reset();
+  _head = _tail = 0;
+  _lastSample = analogRead(A0);
+  _nextSample = micros() + AUDIO_SAMPLE_PERIOD_US;
+  _running = true;
+#endif
+}
+
+void AudioInput::end(void)
+{
+  _running = false;
+  memset(&_frame, 0, sizeof(_frame));
+}
+
+void AudioInput::push(uint16_t sample)
+{
+  _ring[_head & (AUDIO_RING_SIZE - 1)] = sample;
+  _head++;
+  if ((uint16_t)(_head - _tail) > AUDIO_RING_SIZE)
+  {
+    // not analyzed in time (no frame rendered) - the oldest sample is lost
+    _tail = _head - AUDIO_RING_SIZE;
+    _overruns++;
+  }
+}
+
+void AudioInput::poll(void)
+{
+  if (!_running) return;
+
+  const uint32_t now = micros();
+  if ((int32_t)(now - _nextSample) < 0) return;
+
+  uint32_t slots = (now - _nextSample) / AUDIO_SAMPLE_PERIOD_US + 1;
+  if (slots > AUDIO_RING_SIZE)
+  {
+    // a long gap (e.g. a blocking flash write) - start over instead of holding
+    _nextSample = now;
+    slots = 1;
+  }
+  _nextSample += slots * AUDIO_SAMPLE_PERIOD_US;
+
+  const uint16_t sample = analogRead(A0);
+  // the slots missed while the loop was busy (show()) are interpolated - holding
+  // the last sample would add a step (energy in all bands) to every gap
+  const int32_t step = ((int32_t)sample - _lastSample) * 256 / (int32_t)slots;
+  for (uint32_t i = 1; i < slots; i++)
+  {
+    push(_lastSample + ((step * (int32_t)i) >> 8));
+    _held++;
+  }
+  _lastSample = sample;
+  push(sample);
+  _samples++;
+}
+
+void AudioInput::update(void)
+{
+  if (!_running) return;
+  PROFILE_ZONE("audio");
+
+  while (_tail != _head)
+  {
+    _analyzer.addSample(_ring[_tail & (AUDIO_RING_SIZE - 1)]);
+    _tail++;
+  }
+  _frame = _analyzer.result();
+  // a beat in any of the blocks since the last frame
+  _frame.beat = _analyzer.takeBeat();
+}
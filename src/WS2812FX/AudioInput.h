@@ -0,0 +1,70 @@
+#ifndef AUDIO_INPUT_H
+#define AUDIO_INPUT_H
+
+#include <Arduino.h>
+#include "AudioAnalyzer.h"
+
+/**
+ * @brief Audio from a microphone (amplifier) on A0 for the audio reactive effects
+ *
+ * Build flag HAS_AUDIO_INPUT - without it nothing is sampled and the frame
+ * stays inactive (all 0).
+ *
+ * poll() is called from the loop as often as possible and reads A0 each
+ * 1/AUDIO_SAMPLE_RATE s (paced by micros()) into a ring of AUDIO_RING_SIZE
+ * samples. Limits of the ESP8266:
+ * - A timer interrupt can not sample: the SDK ADC read is not in IRAM (it
+ *   must not run while the flash is accessed) and takes longer than FastLED
+ *   tolerates between two pixels (show() would restart on every sample).
+ * - The ADC shares the RF part - reading it more often than once per ms
+ *   disturbs the WiFi (AUDIO_SAMPLE_RATE is limited to 1 kHz).
+ * - Nothing is sampled while the loop is busy, mainly during show() (about
+ *   30 us per LED). The slots missed are interpolated between the samples
+ *   around the gap (counted as "held"). Longer gaps (more than
+ *   AUDIO_RING_SIZE slots) start over. With many LEDs the share of held
+ *   samples grows - it is exposed in /metrics and the higher bands get
+ *   less reliable, the beat (bass) detection is affected least.
+ *
+ * update() is called by the strip once per frame: it runs the buffered
+ * samples through the AudioAnalyzer and publishes the result as the frame
+ * the effects read via frame() during this render.
+ */
+class AudioInput {
+public:
+    static void begin(void);
+    static void end(void);
+
+    /**
+     * @brief Take the samples due (cheap when none is due)
+     */
+    static void poll(void);
+
+    /**
+     * @brief Analyze the buffered samples and refresh frame()
+     */
+    static void update(void);
+
+    static inline const AudioFrame& frame(void) { return _frame; }
+    static inline uint16_t lastSample(void)      { return _lastSample; }
+    static inline uint32_t getSamples(void)      { return _samples; }
+    static inline uint32_t getHeld(void)         { return _held; }
+    static inline uint32_t getOverruns(void)     { return _overruns; }
+    static inline uint32_t getBeats(void)        { return _analyzer.getBeats(); }
+
+private:
+    static void push(uint16_t sample);
+
+    static AudioAnalyzer _analyzer;
+    static AudioFrame    _frame;
+    static uint16_t      _ring[AUDIO_RING_SIZE];
+    static uint16_t      _head;       ///< next sample to be written
+    static uint16_t      _tail;       ///< next sample to be analyzed
+    static uint32_t      _nextSample; ///< micros() of the next sample slot
+    static uint16_t      _lastSample;
+    static bool          _running;
+    static uint32_t      _samples;
+    static uint32_t      _held;
+    static uint32_t      _overruns;
+};
+
+#endif
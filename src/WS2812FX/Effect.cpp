@@ -35,6 +35,15 @@ Effect* EffectFactory::createEffect(uint8_t modeId) {
     return nullptr;
 }
 
+bool EffectFactory::hasEffect(uint8_t modeId) {
+    for (uint8_t i = 0; i < numRegistered; i++) {
+        if (registeredModes[i] == modeId) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void EffectFactory::registerEffect(uint8_t modeId, EffectCreator creator) {
     if (numRegistered < MAX_EFFECTS) {
         registeredModes[numRegistered] = modeId;
@@ -24,6 +24,10 @@ public:
 
     /**
      * @brief Initialize the effect when it first becomes active
+     *
+     * A pooled instance (see WS2812FX::poolEffects) gets initialized again with each
+     * switch to it - the effect restarts and keeps the buffers it already has.
+     *
      * @param strip Pointer to the WS2812FX instance
      * @return true if initialization was successful
      */
@@ -56,6 +60,12 @@ public:
      */
     virtual void cleanup() {}
 
+    /**
+     * @brief Called instead of cleanup() when a pooled instance is switched away from
+     * Keeps the buffers - gives back what other effects would miss (e.g. particles)
+     */
+    virtual void suspend() {}
+
     /**
      * @brief Check if this effect supports smooth transitions
      * @return true if effect can blend smoothly with others
@@ -97,6 +107,13 @@ public:
      */
     static Effect* createEffect(uint8_t modeId);
 
+    /**
+     * @brief Check if there is an effect class for a mode (without creating it)
+     * @param modeId Mode ID from MODES enum
+     * @return true if createEffect would return an instance
+     */
+    static bool hasEffect(uint8_t modeId);
+
     /**
      * @brief Register an effect creator function
      * @param modeId Mode ID from MODES enum
@@ -1,5 +1,6 @@
 #include "EffectHelper.h"
 #include "WS2812FX_FastLed.h"
+#include "FastRandom.h"
 
 // ===== INITIALIZATION HELPERS =====
 
@@ -12,8 +13,8 @@ bool EffectHelper::standardInit(WS2812FX* strip, uint32_t& timebase, bool& initi
         return true; // Already initialized
     }
     
-    // Set timebase for consistent animation timing
-    timebase = millis();
+    // Set timebase for consistent animation timing (the one of the strip - see WS2812FX::setEffectTimebase)
+    timebase = strip->getEffectTimebase();
     
     // Get runtime data and mark as initialized
     auto runtime = strip->getSegmentRuntime();
@@ -240,7 +241,7 @@ void EffectHelper::safeFreeArray(void*& array, size_t& size) {
 
 uint8_t EffectHelper::get_random_wheel_index(uint8_t pos, uint8_t dist) {
     dist = dist < 85 ? dist : 85; // dist shouldn't be too high (not higher than 85 actually)
-    return (pos + random8(dist, 255 - (dist))); 
+    return (pos + RandomPool::random8(dist, 255 - (dist))); 
 }
 
 uint16_t EffectHelper::triwave16(uint16_t in) {
@@ -25,7 +25,7 @@ public:
     /**
      * @brief Standard effect initialization pattern
      * @param strip Pointer to WS2812FX instance
-     * @param timebase Reference to effect's timebase variable (will be set to millis())
+     * @param timebase Reference to effect's timebase variable (will be set to strip->getEffectTimebase())
      * @param initialized Reference to effect's initialized flag (will be set to true)
      * @return true if initialization succeeded
      */
@@ -0,0 +1,52 @@
+#include "FastRandom.h"
+#include "FastLED.h"
+#include "profiler.h"
+
+#if RANDOM_POOL_SIZE & 3
+  #error "RANDOM_POOL_SIZE needs to be a multiple of 4"
+#endif
+
+FastRandom RandomPool::_generator;
+uint8_t    RandomPool::_pool[RANDOM_POOL_SIZE];
+uint16_t   RandomPool::_next    = RANDOM_POOL_SIZE;  // empty - filled on first use
+uint32_t   RandomPool::_refills = 0;
+bool       RandomPool::_seeded  = false;
+
+void FastRandom::fill(uint8_t* buf, size_t len)
+{
+    for (; len >= 4; len -= 4, buf += 4) {
+        const uint32_t r = next();
+        buf[0] = r;
+        buf[1] = r >> 8;
+        buf[2] = r >> 16;
+        buf[3] = r >> 24;
+    }
+    if (len) {
+        uint32_t r = next();
+        for (; len; len--, buf++, r >>= 8) *buf = r;
+    }
+}
+
+void RandomPool::seed(uint32_t seed)
+{
+    _generator.setSeed(seed);
+    _seeded = true;
+    _next = RANDOM_POOL_SIZE;
+}
+
+uint32_t RandomPool::effectSeed(uint8_t modeId)
+{
+    return (((uint32_t)random16() << 16) | random16()) ^ ((uint32_t)modeId * 0x9E3779B9UL);
+}
+
+void RandomPool::refill()
+{
+    PROFILE_ZONE("randomRefill");
+    if (!_seeded) {
+        // random16 got its entropy during setup (addEntropy)
+        seed(((uint32_t)::random16() << 16) | ::random16());
+    }
+    _generator.fill(_pool, RANDOM_POOL_SIZE);
+    _next = 0;
+    _refills++;
+}
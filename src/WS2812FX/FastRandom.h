@@ -0,0 +1,85 @@
+#ifndef FAST_RANDOM_H
+#define FAST_RANDOM_H
+
+#include <Arduino.h>
+#include "../../include/defaults.h"
+
+/**
+ * @brief xorshift32 generator producing four random bytes per step
+ *
+ * Each instance has its own state - seeded with the same value it
+ * reproduces the same sequence (e.g. per effect or in host tests).
+ */
+class FastRandom {
+public:
+    explicit FastRandom(uint32_t seed = 1) { setSeed(seed); }
+
+    /**
+     * @brief Restart the sequence (0 is replaced as xorshift would stay at zero)
+     */
+    inline void setSeed(uint32_t seed) { _state = seed ? seed : 0x9E3779B9UL; }
+
+    /**
+     * @brief The next 32 random bits
+     */
+    inline uint32_t next() {
+        _state ^= _state << 13;
+        _state ^= _state >> 17;
+        _state ^= _state << 5;
+        return _state;
+    }
+
+    /**
+     * @brief Fill "len" bytes with random values (one step per four bytes)
+     */
+    void fill(uint8_t* buf, size_t len);
+
+private:
+    uint32_t _state;
+};
+
+/**
+ * @brief Random bytes shared by the effects and the strip
+ *
+ * The bytes are generated as a block of RANDOM_POOL_SIZE bytes and handed
+ * out one by one - the functions match the lib8tion ones (random8(lim) is
+ * (random byte * lim) >> 8 etc.) but cost an index increment per call.
+ * The pool gets seeded from random16() on first use (see addEntropy) or
+ * explicitly with seed() for a reproducible sequence.
+ */
+class RandomPool {
+public:
+    static void seed(uint32_t seed);
+
+    /**
+     * @brief A seed for the generator of an effect (taken from the pool)
+     */
+    static uint32_t effectSeed(uint8_t modeId);
+
+    static inline uint8_t random8() {
+        if (_next >= RANDOM_POOL_SIZE) refill();
+        return _pool[_next++];
+    }
+    static inline uint8_t random8(uint8_t lim) { return (random8() * lim) >> 8; }
+    static inline uint8_t random8(uint8_t min, uint8_t lim) { return min + random8(lim - min); }
+
+    static inline uint16_t random16() { return (random8() << 8) | random8(); }
+    static inline uint16_t random16(uint16_t lim) { return ((uint32_t)random16() * lim) >> 16; }
+    static inline uint16_t random16(uint16_t min, uint16_t lim) { return min + random16(lim - min); }
+
+    /**
+     * @brief Number of blocks generated (the PRNG cost is one block per RANDOM_POOL_SIZE bytes used)
+     */
+    static inline uint32_t getRefills() { return _refills; }
+
+private:
+    static void refill();
+
+    static FastRandom _generator;
+    static uint8_t    _pool[RANDOM_POOL_SIZE];
+    static uint16_t   _next;
+    static uint32_t   _refills;
+    static bool       _seeded;
+};
+
+#endif
@@ -0,0 +1,244 @@
+#include "LayerStack.h"
+#include "WS2812FX_FastLed.h"
+#include "Effect.h"
+#include "profiler.h"
+#include <stdlib.h>
+
+static_assert(LAYER_COUNT >= 1 && LAYER_COUNT <= 8, "LAYER_COUNT needs to be 1 .. 8 (one bit per layer)");
+
+LayerStack::Layer LayerStack::_layers[LAYER_COUNT];
+CRGB*             LayerStack::_pool[LAYER_COUNT];
+uint8_t           LayerStack::_poolUsed = 0;
+uint8_t           LayerStack::_active   = 0;
+
+// VOID shows data from the network, ring, sunrise and sunset control
+// brightness and power of the strip
+static const uint8_t _notLayerable[] = {
+  FX_MODE_VOID,
+  FX_MODE_RING_RING,
+  FX_MODE_SUNRISE,
+  FX_MODE_SUNSET,
+};
+
+bool LayerStack::isLayerable(uint8_t mode)
+{
+  if (mode >= MODE_AVAILABLE_COUNT) return false;
+  for (uint8_t i = 0; i < sizeof(_notLayerable); i++)
+  {
+    if (_notLayerable[i] == mode) return false;
+  }
+  return true;
+}
+
+const __FlashStringHelper* LayerStack::getBlendName(uint8_t blend)
+{
+  switch (blend)
+  {
+    case ADD:      return F("Add");
+    case SCREEN:   return F("Screen");
+    case MULTIPLY: return F("Multiply");
+    case ALPHA:    return F("Alpha");
+    default:       return F("");
+  }
+}
+
+CRGB* LayerStack::acquireBuffer(void)
+{
+  for (uint8_t i = 0; i < LAYER_COUNT; i++)
+  {
+    if (_poolUsed & (1 << i)) continue;
+    if (!_pool[i])
+    {
+      _pool[i] = (CRGB *)malloc(LED_COUNT * sizeof(CRGB));
+      if (!_pool[i]) return nullptr;
+    }
+    _poolUsed |= (1 << i);
+    memset(_pool[i], 0, LED_COUNT * sizeof(CRGB));
+    return _pool[i];
+  }
+  return nullptr;
+}
+
+void LayerStack::releaseBuffer(CRGB* buffer)
+{
+  for (uint8_t i = 0; i < LAYER_COUNT; i++)
+  {
+    if (_pool[i] == buffer) _poolUsed &= ~(1 << i);
+  }
+}
+
+void LayerStack::trimPool(void)
+{
+  // switching a layer to another effect keeps its buffer - the memory is given back with the last layer
+  if (_poolUsed) return;
+  for (uint8_t i = 0; i < LAYER_COUNT; i++)
+  {
+    free(_pool[i]);
+    _pool[i] = nullptr;
+  }
+}
+
+void LayerStack::stop(Layer &layer)
+{
+  if (layer.effect)
+  {
+    layer.effect->cleanup();
+    delete layer.effect;
+    layer.effect = nullptr;
+  }
+  if (layer.buffer)
+  {
+    releaseBuffer(layer.buffer);
+    layer.buffer = nullptr;
+  }
+  _active &= ~(1 << (&layer - _layers));
+}
+
+void LayerStack::end(void)
+{
+  for (uint8_t i = 0; i < LAYER_COUNT; i++)
+  {
+    stop(_layers[i]);
+  }
+  trimPool();
+}
+
+void LayerStack::restart(void)
+{
+  for (uint8_t i = 0; i < LAYER_COUNT; i++)
+  {
+    Layer &layer = _layers[i];
+    if (layer.effect) layer.effect->setInitialized(false);
+    if (layer.buffer) memset(layer.buffer, 0, LED_COUNT * sizeof(CRGB));
+    // rendered again with the next call (not after the delay of its last frame)
+    layer.nextTime = millis();
+  }
+}
+
+void LayerStack::render(WS2812FX* strip, uint32_t now)
+{
+  const WS2812FX::segment * seg = strip->getSegment();
+  for (uint8_t i = 0; i < LAYER_COUNT; i++)
+  {
+    Layer &layer = _layers[i];
+    const uint8_t mode = seg->layerMode[i];
+    if (!seg->layerOpacity[i] || !isLayerable(mode))
+    {
+      stop(layer);
+      continue;
+    }
+    if (layer.effect && layer.effect->getModeId() != mode)
+    {
+      // keeps the buffer
+      layer.effect->cleanup();
+      delete layer.effect;
+      layer.effect = nullptr;
+    }
+    if (!layer.buffer)
+    {
+      layer.buffer = acquireBuffer();
+      if (!layer.buffer) continue; // out of memory - try again with the next frame
+    }
+    if (!layer.effect)
+    {
+      layer.effect = EffectFactory::createEffect(mode);
+      if (!layer.effect)
+      {
+        stop(layer);
+        continue;
+      }
+      memset(&layer.stats, 0, sizeof(layer.stats));
+      layer.nextTime = now;
+    }
+    layer.opacity = seg->layerOpacity[i];
+    layer.blend   = seg->layerBlend[i] < BLEND_COUNT ? seg->layerBlend[i] : ADD;
+    _active |= (1 << i);
+
+    if ((int32_t)(now - layer.nextTime) < 0) continue;
+
+    PROFILE_ZONE("layer");
+    // the effect draws into strip->leds - which is the buffer of the layer meanwhile
+    CRGB * const leds = strip->leds;
+    strip->leds = layer.buffer;
+    const uint32_t start = micros();
+    if (!layer.effect->isInitialized()) layer.effect->init(strip);
+    const uint16_t delay = layer.effect->update(strip);
+    const uint32_t elapsed = micros() - start;
+    const uint16_t took = elapsed > 0xFFFF ? 0xFFFF : (uint16_t)elapsed;
+    strip->leds = leds;
+
+    Stats &stats = layer.stats;
+    stats.renders++;
+    stats.avgMicros = stats.renders == 1 ? took : (uint16_t)(((uint32_t)stats.avgMicros * 7 + took) / 8);
+    const uint16_t budget = layer.budget ? layer.budget : LAYER_BUDGET_US;
+    if (stats.avgMicros > budget)
+    {
+      stats.throttled++;
+      if (stats.throttle < LAYER_MAX_THROTTLE) stats.throttle++;
+      // slows down further as long as the renders stay over the budget
+      stats.avgMicros = budget;
+    }
+    else if (stats.throttle && stats.avgMicros < budget / 2)
+    {
+      stats.throttle--;
+    }
+    // on the grid of the layer (independent of the effect of the strip and of
+    // the calls being late) - unless a full interval got lost
+    const uint32_t interval = (uint32_t)delay << stats.throttle;
+    layer.nextTime += interval;
+    if ((int32_t)(now - layer.nextTime) >= 0) layer.nextTime = now + interval;
+  }
+  trimPool();
+}
+
+// pixel "c" with the layer pixel "l" on top
+static inline void blendPixel(CRGB &c, const CRGB &l, uint8_t blend, uint8_t opacity)
+{
+  switch (blend)
+  {
+    case LayerStack::ADD:
+      c.r = qadd8(c.r, scale8(l.r, opacity));
+      c.g = qadd8(c.g, scale8(l.g, opacity));
+      c.b = qadd8(c.b, scale8(l.b, opacity));
+      break;
+    case LayerStack::SCREEN:
+      // 1 - (1 - c) * (1 - l) = c + l * (1 - c) - never exceeds 255
+      c.r += scale8(255 - c.r, scale8(l.r, opacity));
+      c.g += scale8(255 - c.g, scale8(l.g, opacity));
+      c.b += scale8(255 - c.b, scale8(l.b, opacity));
+      break;
+    case LayerStack::MULTIPLY:
+      // c * (1 - o + l * o) - the opacity fades between c and c * l
+      c.r = scale8(c.r, 255 - opacity + scale8(l.r, opacity));
+      c.g = scale8(c.g, 255 - opacity + scale8(l.g, opacity));
+      c.b = scale8(c.b, 255 - opacity + scale8(l.b, opacity));
+      break;
+    default:
+      // ALPHA - the coverage follows the brightest channel (black is transparent)
+      nblend(c, l, scale8(max(l.r, max(l.g, l.b)), opacity));
+      break;
+  }
+}
+
+void LayerStack::compose(CRGB* dst, const CRGB* base, uint16_t count, uint16_t last, bool reversed, fract8 amount)
+{
+  PROFILE_ZONE("layerCompose");
+  // the layers on (in order) - the base is blended with all of them per pixel
+  const Layer * on[LAYER_COUNT];
+  uint8_t n = 0;
+  for (uint8_t k = 0; k < LAYER_COUNT; k++)
+  {
+    if (_active & (1 << k)) on[n++] = &_layers[k];
+  }
+
+  for (uint16_t i = 0; i < count; i++)
+  {
+    const uint16_t src = reversed ? last - i : i;
+    CRGB c = base[src];
+    for (uint8_t k = 0; k < n; k++)
+    {
+      blendPixel(c, on[k]->buffer[src], on[k]->blend, on[k]->opacity);
+    }
+    nblend(dst[i], c, amount);
+  }
+}
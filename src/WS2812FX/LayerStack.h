@@ -0,0 +1,117 @@
+#ifndef LAYER_STACK_H
+#define LAYER_STACK_H
+
+#include "FastLED.h"
+#include "../../include/defaults.h"
+
+class WS2812FX;
+class Effect;
+
+/**
+ * @brief Up to LAYER_COUNT effects rendered on top of the effect of the strip
+ *
+ * A layer is configured by the segment (layerMode, layerOpacity, layerBlend)
+ * and is off with opacity 0. While on, it owns an instance of its Effect and
+ * a buffer of LED_COUNT pixels from the pool. The effect renders into that
+ * buffer (strip->leds points to it during the update) at its own rate.
+ *
+ * The layers are combined with the effect of the strip in one pass while
+ * the frame gets composed (see compose()) - the effect buffer itself stays
+ * untouched (the effects fading their last frame do not see the layers).
+ *
+ * Blend modes (b: base pixel, l: layer pixel scaled by the opacity):
+ * - ADD:      b + l (saturating)
+ * - SCREEN:   b + l * (1 - b) - brightens without clipping
+ * - MULTIPLY: b * l - the layer is a mask (at full opacity)
+ * - ALPHA:    the layer covers the base - black layer pixels are transparent
+ *
+ * Each layer renders on its own timer (the delay its effect returns) - the
+ * service of the strip calls render() with every loop, not only when the effect
+ * of the strip is due. The layers pause together with the strip (not running).
+ *
+ * Render budget: a layer taking more than its budget (average render time)
+ * gets its frame interval doubled (up to LAYER_MAX_THROTTLE times) and
+ * speeds up again once it takes less than half of the budget.
+ */
+class LayerStack {
+public:
+    enum Blend : uint8_t {
+        ADD,
+        SCREEN,
+        MULTIPLY,
+        ALPHA,
+        BLEND_COUNT
+    };
+
+    struct Stats {
+        uint32_t renders;     ///< frames rendered
+        uint32_t throttled;   ///< renders over budget (each slows the layer down)
+        uint16_t avgMicros;   ///< average render time
+        uint8_t  throttle;    ///< the interval is multiplied by 2^throttle
+    };
+
+    /**
+     * @brief The mode can run as a layer (available and not VOID, ring, sunrise or sunset)
+     */
+    static bool isLayerable(uint8_t mode);
+
+    static const __FlashStringHelper* getBlendName(uint8_t blend);
+
+    /**
+     * @brief Follow the configuration of the segment and render the layers due
+     */
+    static void render(WS2812FX* strip, uint32_t now);
+
+    /**
+     * @brief At least one layer has a buffer to be composed
+     */
+    static inline bool active(void) { return _active != 0; }
+
+    /**
+     * @brief dst[i] = nblend(dst[i], base[i] with all layers on top, amount)
+     *
+     * With "reversed" the pixel i of dst takes base[last - i] (and the same
+     * pixel of the layers).
+     */
+    static void compose(CRGB* dst, const CRGB* base, uint16_t count, uint16_t last, bool reversed, fract8 amount);
+
+    /**
+     * @brief Initialize the layer effects again and clear their buffers (e.g. new segments)
+     */
+    static void restart(void);
+
+    /**
+     * @brief Stop all layers and free their buffers
+     */
+    static void end(void);
+
+    // render time budget of a layer in us (0: LAYER_BUDGET_US)
+    static inline void     setBudget(uint8_t layer, uint16_t micros) { if (layer < LAYER_COUNT) _layers[layer].budget = micros; }
+    static inline uint16_t getBudget(uint8_t layer)                  { return layer < LAYER_COUNT ? _layers[layer].budget : 0; }
+    static inline const Stats& getStats(uint8_t layer)               { return _layers[layer < LAYER_COUNT ? layer : 0].stats; }
+
+private:
+    struct Layer {
+        Effect*  effect;
+        CRGB*    buffer;
+        uint32_t nextTime;    ///< millis() of the next render
+        uint16_t budget;      ///< us per render (0: LAYER_BUDGET_US)
+        uint8_t  opacity;
+        uint8_t  blend;
+        Stats    stats;
+    };
+
+    static void stop(Layer &layer);
+
+    // buffer pool - a buffer is allocated on first use and kept while any layer is on
+    static CRGB* acquireBuffer(void);
+    static void  releaseBuffer(CRGB* buffer);
+    static void  trimPool(void);
+
+    static Layer   _layers[LAYER_COUNT];
+    static CRGB*   _pool[LAYER_COUNT];
+    static uint8_t _poolUsed;   ///< bit per pool entry
+    static uint8_t _active;     ///< bit per layer with a buffer
+};
+
+#endif
@@ -0,0 +1,52 @@
+#include "MatrixLayout.h"
+#include <stdlib.h>
+
+uint16_t* MatrixLayout::_map    = nullptr;
+uint8_t   MatrixLayout::_width  = 0;
+uint8_t   MatrixLayout::_height = 0;
+uint16_t  MatrixLayout::_offset = 0;
+
+bool MatrixLayout::begin(uint8_t width, uint8_t height, bool serpentine, uint8_t rotation, uint16_t offset)
+{
+  end();
+  if (!width || !height) return false;
+
+  _map = (uint16_t *)malloc((uint16_t)width * height * sizeof(uint16_t));
+  if (!_map) return false;
+
+  rotation &= 0x03;
+  _width  = (rotation & 0x01) ? height : width;
+  _height = (rotation & 0x01) ? width  : height;
+  _offset = offset;
+
+  uint16_t *idx = _map;
+  for (uint8_t y = 0; y < _height; y++)
+  {
+    for (uint8_t x = 0; x < _width; x++)
+    {
+      // logical -> physical (as wired) position
+      uint8_t px, py;
+      switch (rotation)
+      {
+        case 0:  px = x;                  py = y;                   break;
+        case 1:  px = y;                  py = height - 1 - x;      break;
+        case 2:  px = width - 1 - x;      py = height - 1 - y;      break;
+        default: px = width - 1 - y;      py = x;                   break;
+      }
+      if (serpentine && (py & 0x01))
+      {
+        px = width - 1 - px;
+      }
+      *idx++ = offset + (uint16_t)py * width + px;
+    }
+  }
+  return true;
+}
+
+void MatrixLayout::end(void)
+{
+  free(_map);
+  _map = nullptr;
+  _width = _height = 0;
+  _offset = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef MATRIX_LAYOUT_H
+#define MATRIX_LAYOUT_H
+
+#include <stdint.h>
+#include "../../include/defaults.h"
+
+/**
+ * @brief Position of the LEDs of a matrix (panel) in the strip - XY to index
+ *
+ * The panel is described as wired: "width" LEDs per row starting at the LED
+ * "offset" of the strip, "height" rows, every second row running backwards
+ * when serpentine. The effects see it turned by "rotation" quarter turns
+ * (clockwise) - for odd rotations the logical width is the panel height.
+ * Logical (0, 0) is the top left corner, y grows downwards.
+ *
+ * begin() builds a lookup table (row major, one uint16_t per LED) once, the
+ * effects read the index with XY() or walk the table with map() instead of
+ * doing the wiring maths per pixel.
+ *
+ * Build flags (see defaults.h): MATRIX_WIDTH, MATRIX_HEIGHT, MATRIX_SERPENTINE,
+ * MATRIX_ROTATION, MATRIX_OFFSET - without MATRIX_WIDTH the strip is a line.
+ */
+class MatrixLayout {
+public:
+    static const uint16_t NONE = 0xFFFF;
+
+    /**
+     * @brief Build the table - false when out of memory (the strip stays 1D)
+     */
+    static bool begin(uint8_t width, uint8_t height, bool serpentine, uint8_t rotation, uint16_t offset);
+    static void end(void);
+
+    static inline bool    is2D(void)   { return _map != nullptr; }
+    static inline uint8_t width(void)  { return _width; }   ///< logical width (after the rotation)
+    static inline uint8_t height(void) { return _height; }  ///< logical height (after the rotation)
+    static inline uint16_t count(void) { return (uint16_t)_width * _height; }
+
+    /**
+     * @brief Index in leds[] of the logical pixel (x, y) - no range check
+     */
+    static inline uint16_t XY(uint8_t x, uint8_t y) { return _map[(uint16_t)y * _width + x]; }
+
+    /**
+     * @brief Index in leds[] or NONE for pixels outside of the matrix
+     */
+    static inline uint16_t XYsafe(int16_t x, int16_t y) {
+        return (_map && x >= 0 && y >= 0 && x < _width && y < _height) ? XY(x, y) : NONE;
+    }
+
+    /**
+     * @brief The table - the indices of all pixels, row by row
+     */
+    static inline const uint16_t* map(void) { return _map; }
+
+    /**
+     * @brief The matrix lies completely within leds[start .. start + length - 1]
+     */
+    static inline bool within(uint16_t start, uint16_t length) {
+        return _map && _offset >= start && _offset + count() <= (uint32_t)start + length;
+    }
+
+private:
+    static uint16_t* _map;
+    static uint8_t   _width;
+    static uint8_t   _height;
+    static uint16_t  _offset;
+};
+
+#endif
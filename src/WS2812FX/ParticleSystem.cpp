@@ -0,0 +1,248 @@
+#include "ParticleSystem.h"
+#include "SpanRaster.h"
+#include "WS2812FX_FastLed.h"
+#include "profiler.h"
+
+int32_t  *ParticleSystem::pos    = nullptr;
+int32_t  *ParticleSystem::vel    = nullptr;
+uint16_t *ParticleSystem::life   = nullptr;
+uint16_t *ParticleSystem::size   = nullptr;
+int16_t  *ParticleSystem::trail  = nullptr;
+uint8_t  *ParticleSystem::color  = nullptr;
+uint8_t  *ParticleSystem::bright = nullptr;
+uint8_t  *ParticleSystem::flags  = nullptr;
+
+void     *ParticleSystem::_pool = nullptr;
+uint16_t *ParticleSystem::_next = nullptr;
+uint16_t *ParticleSystem::_prev = nullptr;
+uint16_t  ParticleSystem::_free = ParticleSystem::NONE;
+uint16_t  ParticleSystem::_used = 0;
+uint16_t  ParticleSystem::_head[PARTICLE_MAX_GROUPS];
+uint16_t  ParticleSystem::_count[PARTICLE_MAX_GROUPS];
+bool      ParticleSystem::_inUse[PARTICLE_MAX_GROUPS];
+
+bool ParticleSystem::allocate(void)
+{
+  if (_pool) return true;
+
+  // one block, the wider types first to keep all arrays aligned
+  const size_t n = PARTICLE_POOL_SIZE;
+  uint8_t *p = (uint8_t *)malloc(n * (2 * sizeof(int32_t) + 5 * sizeof(uint16_t) + 3 * sizeof(uint8_t)));
+  if (!p) return false;
+  _pool = p;
+  pos    = (int32_t  *)p; p += n * sizeof(int32_t);
+  vel    = (int32_t  *)p; p += n * sizeof(int32_t);
+  life   = (uint16_t *)p; p += n * sizeof(uint16_t);
+  size   = (uint16_t *)p; p += n * sizeof(uint16_t);
+  trail  = (int16_t  *)p; p += n * sizeof(int16_t);
+  _next  = (uint16_t *)p; p += n * sizeof(uint16_t);
+  _prev  = (uint16_t *)p; p += n * sizeof(uint16_t);
+  color  = p;             p += n;
+  bright = p;             p += n;
+  flags  = p;
+
+  for (uint16_t i = 0; i < n; i++)
+  {
+    _next[i] = i + 1;
+  }
+  _next[n - 1] = NONE;
+  _free = 0;
+  _used = 0;
+  for (uint8_t g = 0; g < PARTICLE_MAX_GROUPS; g++)
+  {
+    _head[g]  = NONE;
+    _count[g] = 0;
+    _inUse[g] = false;
+  }
+  return true;
+}
+
+bool ParticleSystem::acquire(uint8_t &group)
+{
+  if (group < PARTICLE_MAX_GROUPS && _pool && _inUse[group])
+  {
+    killAll(group);
+    return true;
+  }
+  group = NO_GROUP;
+  if (!allocate()) return false;
+  for (uint8_t g = 0; g < PARTICLE_MAX_GROUPS; g++)
+  {
+    if (!_inUse[g])
+    {
+      _inUse[g] = true;
+      group = g;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ParticleSystem::release(uint8_t &group)
+{
+  if (group >= PARTICLE_MAX_GROUPS || !_pool)
+  {
+    group = NO_GROUP;
+    return;
+  }
+  killAll(group);
+  _inUse[group] = false;
+  group = NO_GROUP;
+
+  for (uint8_t g = 0; g < PARTICLE_MAX_GROUPS; g++)
+  {
+    if (_inUse[g]) return;
+  }
+  // nobody uses particles anymore - give the memory back
+  free(_pool);
+  _pool = nullptr;
+  pos = vel = nullptr;
+  life = size = _next = _prev = nullptr;
+  trail = nullptr;
+  color = bright = flags = nullptr;
+  _free = NONE;
+}
+
+uint16_t ParticleSystem::spawn(uint8_t group)
+{
+  if (group >= PARTICLE_MAX_GROUPS || !_pool || _free == NONE) return NONE;
+
+  const uint16_t i = _free;
+  _free = _next[i];
+
+  _prev[i] = NONE;
+  _next[i] = _head[group];
+  if (_head[group] != NONE) _prev[_head[group]] = i;
+  _head[group] = i;
+  _count[group]++;
+  _used++;
+
+  pos[i] = vel[i] = 0;
+  life[i] = size[i] = 0;
+  trail[i] = 0;
+  color[i] = bright[i] = flags[i] = 0;
+  return i;
+}
+
+void ParticleSystem::unlink(uint8_t group, uint16_t i)
+{
+  if (_prev[i] != NONE) _next[_prev[i]] = _next[i];
+  else                  _head[group]    = _next[i];
+  if (_next[i] != NONE) _prev[_next[i]] = _prev[i];
+  _count[group]--;
+  _used--;
+}
+
+void ParticleSystem::kill(uint8_t group, uint16_t i)
+{
+  if (group >= PARTICLE_MAX_GROUPS || !_pool || i >= PARTICLE_POOL_SIZE) return;
+  unlink(group, i);
+  _next[i] = _free;
+  _free = i;
+}
+
+void ParticleSystem::killAll(uint8_t group)
+{
+  if (group >= PARTICLE_MAX_GROUPS || !_pool) return;
+  while (_head[group] != NONE)
+  {
+    kill(group, _head[group]);
+  }
+}
+
+void ParticleSystem::step(uint8_t group, uint16_t dt, const Physics &physics)
+{
+  PROFILE_ZONE("particleStep");
+  if (group >= PARTICLE_MAX_GROUPS || !_pool) return;
+
+  const int32_t dv = (physics.gravity * dt) >> 10;
+
+  for (uint16_t i = _head[group], n; i != NONE; i = n)
+  {
+    n = _next[i];
+
+    if (life[i])
+    {
+      if (life[i] <= dt)
+      {
+        kill(group, i);
+        continue;
+      }
+      life[i] -= dt;
+    }
+
+    int32_t v = vel[i] + dv;
+    if (physics.drag)
+    {
+      v -= ((v >> 8) * physics.drag * dt) >> 10;
+    }
+    const int32_t moved = (v * dt) >> 10;
+    int32_t p = pos[i] + moved;
+    uint8_t f = flags[i] & ~FLAG_LANDED;
+
+    if (p < physics.lower || p > physics.upper)
+    {
+      if (!(f & FLAG_BOUNCE))
+      {
+        kill(group, i);
+        continue;
+      }
+      if (p < physics.lower)
+      {
+        p = physics.lower;
+        v = (-v * physics.bounce) >> 8;
+        f |= FLAG_LANDED;
+      }
+      else
+      {
+        p = physics.upper;
+        if (v > 0) v = 0;
+      }
+    }
+
+    trail[i] = constrain(moved, -32767, 32767);
+    pos[i]   = p;
+    vel[i]   = v;
+    flags[i] = f;
+  }
+}
+
+void ParticleSystem::render(uint8_t group, WS2812FX *strip, const CRGBPalette16 &pal, uint8_t hueOffset, bool additive)
+{
+  PROFILE_ZONE("particleRender");
+  if (group >= PARTICLE_MAX_GROUPS || !_pool) return;
+
+  auto seg = strip->getSegment();
+  auto runtime = strip->getSegmentRuntime();
+  CRGB *leds = &strip->leds[runtime->start];
+
+  for (uint16_t i = _head[group]; i != NONE; i = _next[i])
+  {
+    uint8_t b = bright[i];
+    if ((flags[i] & FLAG_FADE) && life[i] && life[i] < 256)
+    {
+      b = scale8(b, life[i]);
+    }
+    if (!b) continue;
+
+    CRGB c;
+    if (flags[i] & FLAG_WHITE)
+    {
+      c = CRGB(b, b, b);
+    }
+    else
+    {
+      c = strip->ColorFromPaletteWithDistribution(pal, color[i] + hueOffset, b, seg->blendType);
+    }
+
+    int32_t from = pos[i];
+    int32_t to   = pos[i];
+    if (flags[i] & FLAG_TRAIL)
+    {
+      if (trail[i] > 0) from -= trail[i];
+      else              to   -= trail[i];
+    }
+    to += size[i] ? size[i] : 256;
+    SpanRaster::fillSolid(leds, runtime->length, from, to, c, additive ? SpanRaster::ADD : SpanRaster::MAX);
+  }
+}
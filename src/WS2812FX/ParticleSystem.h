@@ -0,0 +1,117 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include "FastLED.h"
+#include "../../include/defaults.h"
+
+class WS2812FX;
+
+/**
+ * @brief Particle storage, physics and rendering shared by the particle effects
+ *
+ * The particles live in one pool of PARTICLE_POOL_SIZE entries stored as
+ * structure of arrays - the integrators only touch the arrays they need.
+ * The pool gets allocated (one block) with the first group and freed with
+ * the last one. An effect acquires a group in init() and releases it in
+ * cleanup(); its particles are a linked list within the pool, unused
+ * particles are kept in a free-list (spawn and kill are O(1)).
+ *
+ * Fixed point units (positions are relative to the segment start):
+ * - pos:     1/256 LED
+ * - vel:     1/256 LED per 1024 ms (~ per second)
+ * - gravity: 1/256 LED per (1024 ms)^2
+ * - life:    ms until the particle dies (0 = no limit)
+ * - size:    length of the lit span in 1/256 LED
+ *
+ * Iterating a group (killing the current particle is fine):
+ *   for (uint16_t i = ParticleSystem::first(g), n; i != ParticleSystem::NONE; i = n) {
+ *     n = ParticleSystem::next(i);
+ *     ...
+ *   }
+ */
+class ParticleSystem {
+public:
+    static const uint16_t NONE     = 0xFFFF;
+    static const uint8_t  NO_GROUP = 0xFF;
+
+    // particle flags
+    static const uint8_t FLAG_BOUNCE = 0x01;   ///< bounces at the lower bound instead of dying
+    static const uint8_t FLAG_TRAIL  = 0x02;   ///< the span covers the distance moved in the last step
+    static const uint8_t FLAG_FADE   = 0x04;   ///< fades out within the last 256 ms of its life
+    static const uint8_t FLAG_WHITE  = 0x08;   ///< rendered white instead of a palette color
+    static const uint8_t FLAG_LANDED = 0x80;   ///< set by step() when it bounced (cleared with the next step)
+
+    /**
+     * @brief Forces applied to all particles of a group by step()
+     */
+    struct Physics {
+        int32_t  gravity;   ///< acceleration (negative towards the segment start)
+        uint8_t  drag;      ///< velocity lost per 1024 ms (of 256)
+        uint16_t bounce;    ///< velocity kept on a bounce (of 256)
+        int32_t  lower;     ///< particles below die (or bounce with FLAG_BOUNCE)
+        int32_t  upper;     ///< particles above die (or stop with FLAG_BOUNCE)
+    };
+
+    /**
+     * @brief Get a group (or empty the one given) - returns false when no group is left
+     */
+    static bool acquire(uint8_t &group);
+
+    /**
+     * @brief Kill the particles of the group and give the group back
+     */
+    static void release(uint8_t &group);
+
+    /**
+     * @brief A new particle of the group (all fields 0) or NONE if the pool is exhausted
+     */
+    static uint16_t spawn(uint8_t group);
+    static void     kill(uint8_t group, uint16_t i);
+    static void     killAll(uint8_t group);
+
+    static inline uint16_t first(uint8_t group) { return (_pool && group < PARTICLE_MAX_GROUPS) ? _head[group] : NONE; }
+    static inline uint16_t next(uint16_t i)     { return _next[i]; }
+    static inline uint16_t count(uint8_t group) { return (_pool && group < PARTICLE_MAX_GROUPS) ? _count[group] : 0; }
+    static inline uint16_t available(void)      { return _pool ? PARTICLE_POOL_SIZE - _used : 0; }
+
+    /**
+     * @brief Integrate the group for "dt" ms (semi-implicit Euler)
+     *
+     * Applies gravity and drag, moves the particles, bounces or kills
+     * them at the bounds and counts down their life.
+     */
+    static void step(uint8_t group, uint16_t dt, const Physics &physics);
+
+    /**
+     * @brief Draw the particles of the group into the current segment
+     *
+     * @param pal Palette for the colors (color[i] + hueOffset)
+     * @param additive Add the colors (true) or keep the max. per channel
+     */
+    static void render(uint8_t group, WS2812FX *strip, const CRGBPalette16 &pal, uint8_t hueOffset = 0, bool additive = false);
+
+    // particle data (index from spawn() / first() / next())
+    static int32_t  *pos;
+    static int32_t  *vel;
+    static uint16_t *life;
+    static uint16_t *size;
+    static int16_t  *trail;     ///< distance moved in the last step
+    static uint8_t  *color;     ///< palette index
+    static uint8_t  *bright;
+    static uint8_t  *flags;
+
+private:
+    static bool allocate(void);
+    static void unlink(uint8_t group, uint16_t i);
+
+    static void     *_pool;
+    static uint16_t *_next;
+    static uint16_t *_prev;
+    static uint16_t  _free;
+    static uint16_t  _used;
+    static uint16_t  _head[PARTICLE_MAX_GROUPS];
+    static uint16_t  _count[PARTICLE_MAX_GROUPS];
+    static bool      _inUse[PARTICLE_MAX_GROUPS];
+};
+
+#endif
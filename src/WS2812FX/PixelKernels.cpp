@@ -0,0 +1,141 @@
+#include "PixelKernels.h"
+
+// word access to the byte buffers (CRGB) without breaking the aliasing rules
+typedef uint32_t __attribute__((__may_alias__)) swar_word;
+
+#define SWAR_EVEN 0x00FF00FFUL    // bytes 0 and 2 as 16-bit lanes
+#define SWAR_ODD  0xFF00FF00UL
+#define SWAR_MSB  0x80808080UL
+
+// the lanes of the multiplications never carry into each other:
+// 255 * 256 + 255 * 1 (blend) is the max. of a 16-bit lane
+struct ScaleOp {
+    uint16_t scale;     // 1..256
+
+    inline uint8_t byte(uint8_t a) const { return (a * scale) >> 8; }
+    inline uint32_t word(uint32_t a) const {
+        const uint32_t even = ((a & SWAR_EVEN) * scale) >> 8;
+        const uint32_t odd  = ((a >> 8) & SWAR_EVEN) * scale;
+        return (even & SWAR_EVEN) | (odd & SWAR_ODD);
+    }
+};
+
+// blend8: (a * (255 - amount) + a + b * amount + b) >> 8
+struct BlendOp {
+    uint16_t keep;      // 256 - amount
+    uint16_t take;      // amount + 1
+
+    inline uint8_t byte(uint8_t a, uint8_t b) const { return (a * keep + b * take) >> 8; }
+    inline uint32_t word(uint32_t a, uint32_t b) const {
+        const uint32_t even = ((a & SWAR_EVEN) * keep + (b & SWAR_EVEN) * take) >> 8;
+        const uint32_t odd  = ((a >> 8) & SWAR_EVEN) * keep + ((b >> 8) & SWAR_EVEN) * take;
+        return (even & SWAR_EVEN) | (odd & SWAR_ODD);
+    }
+};
+
+// qadd8: the sum of the lower 7 bits plus the top bits, saturated by the carry out of each byte
+struct AddOp {
+    inline uint8_t byte(uint8_t a, uint8_t b) const { const uint16_t t = a + b; return t > 255 ? 255 : t; }
+    inline uint32_t word(uint32_t a, uint32_t b) const {
+        const uint32_t low   = (a & ~SWAR_MSB) + (b & ~SWAR_MSB);
+        const uint32_t sum   = low ^ ((a ^ b) & SWAR_MSB);
+        const uint32_t carry = ((a & b) | ((a | b) & ~sum)) & SWAR_MSB;
+        return sum | ((carry >> 7) * 0xFF);
+    }
+};
+
+// CRGB::operator|=: the max. per channel (a >= b per byte from the top bits and a borrow free subtraction)
+struct MaxOp {
+    inline uint8_t byte(uint8_t a, uint8_t b) const { return a > b ? a : b; }
+    inline uint32_t word(uint32_t a, uint32_t b) const {
+        const uint32_t low  = ((a | SWAR_MSB) - (b & ~SWAR_MSB)) & SWAR_MSB;
+        const uint32_t ge   = ((a & ~b) | (~(a ^ b) & low)) & SWAR_MSB;
+        const uint32_t mask = (ge >> 7) * 0xFF;
+        return (a & mask) | (b & ~mask);
+    }
+};
+
+template <class Op>
+static inline void unaryKernel(uint8_t * p, size_t n, const Op &op)
+{
+    for (; n && ((uintptr_t)p & 3); n--, p++) *p = op.byte(*p);
+
+    swar_word * w = (swar_word *)p;
+    for (size_t i = n >> 2; i; i--, w++) *w = op.word(*w);
+
+    p = (uint8_t *)w;
+    for (n &= 3; n; n--, p++) *p = op.byte(*p);
+}
+
+template <class Op>
+static inline void binaryKernel(uint8_t * d, const uint8_t * s, size_t n, const Op &op)
+{
+    for (; n && ((uintptr_t)d & 3); n--, d++, s++) *d = op.byte(*d, *s);
+
+    swar_word * dw = (swar_word *)d;
+    size_t words = n >> 2;
+    const uint8_t skip = (uintptr_t)s & 3;
+    if (!skip)
+    {
+        const swar_word * sw = (const swar_word *)s;
+        for (size_t i = words; i; i--, dw++, sw++) *dw = op.word(*dw, *sw);
+    }
+    else
+    {
+        // little endian: the source word starts within "lo" and ends within "hi" (aligned reads).
+        // The aligned words around the source hold bytes before its start and beyond its end:
+        // the first "lo" gets built from the bytes of the source, and the last word whose "hi"
+        // would reach beyond the end is left to the bytes below.
+        if ((n & 3) + skip < 4 && words) words--;
+        const uint8_t shift = skip * 8;
+        const swar_word * sw = (const swar_word *)(s - skip) + 1;
+        uint32_t lo = 0;
+        for (uint8_t b = 0; words && b < 4 - skip; b++) lo |= (uint32_t)s[b] << (shift + b * 8);
+        for (size_t i = words; i; i--, dw++)
+        {
+            const uint32_t hi = *sw++;
+            *dw = op.word(*dw, (lo >> shift) | (hi << (32 - shift)));
+            lo = hi;
+        }
+    }
+
+    d = (uint8_t *)dw;
+    s += words << 2;
+    for (n -= words << 2; n; n--, d++, s++) *d = op.byte(*d, *s);
+}
+
+void PixelKernels::nscale8(CRGB * leds, uint16_t count, uint8_t scale)
+{
+    if (scale == 255) return;
+    const ScaleOp op = { (uint16_t)(scale + 1) };
+    unaryKernel((uint8_t *)leds, count * sizeof(CRGB), op);
+}
+
+void PixelKernels::fadeToBlackBy(CRGB * leds, uint16_t count, uint8_t fadeBy)
+{
+    nscale8(leds, count, 255 - fadeBy);
+}
+
+void PixelKernels::nblend(CRGB * existing, const CRGB * overlay, uint16_t count, fract8 amountOfOverlay)
+{
+    if (amountOfOverlay == 0) return;
+    if (amountOfOverlay == 255)
+    {
+        memmove(existing, overlay, count * sizeof(CRGB));
+        return;
+    }
+    const BlendOp op = { (uint16_t)(256 - amountOfOverlay), (uint16_t)(amountOfOverlay + 1) };
+    binaryKernel((uint8_t *)existing, (const uint8_t *)overlay, count * sizeof(CRGB), op);
+}
+
+void PixelKernels::add(CRGB * dst, const CRGB * src, uint16_t count)
+{
+    AddOp op;
+    binaryKernel((uint8_t *)dst, (const uint8_t *)src, count * sizeof(CRGB), op);
+}
+
+void PixelKernels::maximize(CRGB * dst, const CRGB * src, uint16_t count)
+{
+    MaxOp op;
+    binaryKernel((uint8_t *)dst, (const uint8_t *)src, count * sizeof(CRGB), op);
+}
@@ -0,0 +1,47 @@
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+#include "FastLED.h"
+
+/**
+ * @brief Kernels for the common operations on complete CRGB buffers
+ *
+ * The buffers are processed as a stream of channel bytes, four of them packed
+ * into one 32-bit word (SIMD within a register). The results are bit-exact to
+ * the lib8tion functions named in the comments (FASTLED_SCALE8_FIXED == 1).
+ *
+ * Alignment: the words are read and written on 4 byte boundaries only (the
+ * ESP8266 faults on unaligned word accesses). The bytes in front of the first
+ * boundary of the destination and behind the last one are done one by one.
+ * A source not sharing the alignment of the destination is read as aligned
+ * words being shifted together.
+ */
+class PixelKernels {
+public:
+    /**
+     * @brief leds[i].nscale8(scale) for "count" pixels - nscale8(leds, count, scale)
+     */
+    static void nscale8(CRGB * leds, uint16_t count, uint8_t scale);
+
+    /**
+     * @brief fadeToBlackBy(leds, count, fadeBy)
+     */
+    static void fadeToBlackBy(CRGB * leds, uint16_t count, uint8_t fadeBy);
+
+    /**
+     * @brief nblend(existing, overlay, count, amountOfOverlay)
+     */
+    static void nblend(CRGB * existing, const CRGB * overlay, uint16_t count, fract8 amountOfOverlay);
+
+    /**
+     * @brief dst[i] += src[i] (saturating, qadd8 per channel)
+     */
+    static void add(CRGB * dst, const CRGB * src, uint16_t count);
+
+    /**
+     * @brief dst[i] |= src[i] (the max. per channel)
+     */
+    static void maximize(CRGB * dst, const CRGB * src, uint16_t count);
+};
+
+#endif
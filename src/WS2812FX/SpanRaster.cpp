@@ -0,0 +1,114 @@
+#include "SpanRaster.h"
+
+static inline void plot(CRGB &led, const CRGB &color, SpanRaster::Mode mode)
+{
+  switch (mode)
+  {
+    case SpanRaster::REPLACE: led = color;  break;
+    case SpanRaster::MAX:     led |= color; break;
+    case SpanRaster::ADD:     led += color; break;
+  }
+}
+
+// the edge pixels must not cut into what is there (they are only partially lit)
+static inline SpanRaster::Mode edgeMode(SpanRaster::Mode mode)
+{
+  return mode == SpanRaster::REPLACE ? SpanRaster::MAX : mode;
+}
+
+void SpanRaster::fillSolid(CRGB * leds, uint16_t count, int32_t from, int32_t to, const CRGB &color, Mode mode)
+{
+  if (from < 0) from = 0;
+  if (to > (int32_t)count << 8) to = (int32_t)count << 8;
+  if (from >= to) return;
+
+  uint16_t first = from >> 8;
+  const uint16_t last = (to - 1) >> 8;
+
+  if (first == last)
+  {
+    CRGB c = color;
+    c.nscale8_video(min(to - from, (int32_t)255));
+    plot(leds[first], c, edgeMode(mode));
+    return;
+  }
+
+  if (from & 0xFF)
+  {
+    CRGB c = color;
+    c.nscale8_video(256 - (from & 0xFF));
+    plot(leds[first++], c, edgeMode(mode));
+  }
+
+  const uint16_t end = (to & 0xFF) ? last : last + 1;
+  switch (mode)
+  {
+    case REPLACE: for (uint16_t k = first; k < end; k++) leds[k] = color;  break;
+    case MAX:     for (uint16_t k = first; k < end; k++) leds[k] |= color; break;
+    case ADD:     for (uint16_t k = first; k < end; k++) leds[k] += color; break;
+  }
+
+  if (to & 0xFF)
+  {
+    CRGB c = color;
+    c.nscale8_video(to & 0xFF);
+    plot(leds[last], c, edgeMode(mode));
+  }
+}
+
+void SpanRaster::fillPalette(CRGB * leds, uint16_t count, int32_t from, int32_t to,
+                             const CRGBPalette16 &pal, uint8_t index, int32_t step,
+                             uint8_t bright, TBlendType blendType, Mode mode)
+{
+  // the palette position (8.8) of the first pixel - the gradient stays attached to "from"
+  int32_t from0 = from;
+  if (from < 0) from = 0;
+  if (to > (int32_t)count << 8) to = (int32_t)count << 8;
+  if (from >= to) return;
+
+  uint16_t first = from >> 8;
+  const uint16_t last = (to - 1) >> 8;
+  // (split into whole and fractional pixels to stay within 32 bit)
+  const int32_t skipped = ((int32_t)first << 8) - from0;
+  uint16_t pos = ((uint16_t)index << 8) + (skipped >> 8) * step + (((skipped & 0xFF) * step) >> 8);
+
+  if (first == last)
+  {
+    const uint8_t cover = min(to - from, (int32_t)255);
+    plot(leds[first], ColorFromPalette(pal, pos >> 8, scale8(cover, bright), blendType), edgeMode(mode));
+    return;
+  }
+
+  if (from & 0xFF)
+  {
+    const uint8_t cover = 256 - (from & 0xFF);
+    plot(leds[first++], ColorFromPalette(pal, pos >> 8, scale8(cover, bright), blendType), edgeMode(mode));
+    pos += step;
+  }
+
+  const uint16_t end = (to & 0xFF) ? last : last + 1;
+  if (!step)
+  {
+    // one color - a single palette lookup for all of the covered pixels
+    const CRGB color = ColorFromPalette(pal, pos >> 8, bright, blendType);
+    switch (mode)
+    {
+      case REPLACE: for (uint16_t k = first; k < end; k++) leds[k] = color;  break;
+      case MAX:     for (uint16_t k = first; k < end; k++) leds[k] |= color; break;
+      case ADD:     for (uint16_t k = first; k < end; k++) leds[k] += color; break;
+    }
+  }
+  else
+  {
+    for (uint16_t k = first; k < end; k++, pos += step)
+    {
+      plot(leds[k], ColorFromPalette(pal, pos >> 8, bright, blendType), mode);
+    }
+  }
+
+  if (to & 0xFF)
+  {
+    const uint8_t cover = to & 0xFF;
+    plot(leds[last], ColorFromPalette(pal, pos >> 8, scale8(cover, bright), blendType), edgeMode(mode));
+  }
+}
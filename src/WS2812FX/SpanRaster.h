@@ -0,0 +1,39 @@
+#ifndef SPAN_RASTER_H
+#define SPAN_RASTER_H
+
+#include "FastLED.h"
+
+/**
+ * @brief Anti-aliased drawing of spans (bars) with 1/256 pixel precision
+ *
+ * A span [from, to) is given in 1/256 of a pixel relative to leds[0]. It gets
+ * clipped to the buffer once; the pixels covered completely get the full
+ * color, the partially covered pixels at both ends are scaled by their coverage.
+ * A span shorter than a pixel within one pixel lights it by its length.
+ */
+class SpanRaster {
+public:
+    enum Mode {
+        REPLACE,    ///< the covered pixels get the color (the partially covered edges keep the max.)
+        MAX,        ///< the max. of the existing and the new color per channel (CRGB |=)
+        ADD         ///< the colors get added (saturating, CRGB +=)
+    };
+
+    /**
+     * @brief Fill the span with one color
+     */
+    static void fillSolid(CRGB * leds, uint16_t count, int32_t from, int32_t to, const CRGB &color, Mode mode);
+
+    /**
+     * @brief Fill the span with a gradient from a palette
+     *
+     * @param index palette index at "from"
+     * @param step  change of the palette index per pixel in 1/256 (0: one color, 256: next index per pixel)
+     * @param bright brightness of the covered pixels (the edges are scaled down from it)
+     */
+    static void fillPalette(CRGB * leds, uint16_t count, int32_t from, int32_t to,
+                            const CRGBPalette16 &pal, uint8_t index, int32_t step,
+                            uint8_t bright, TBlendType blendType, Mode mode);
+};
+
+#endif
@@ -36,7 +36,13 @@
 // TODO: May something like https://gist.github.com/kriegsman/626dca2f9d2189bd82ca ??
 
 #include "WS2812FX_FastLed.h"
+#include "profiler.h"
 #include "EffectHelper.h"
+#include "PixelKernels.h"
+#include "SpanRaster.h"
+#include "FastRandom.h"
+#include "AudioInput.h"
+#include "MatrixLayout.h"
 #include "Effect.h"
 #include "effects/StaticEffect.h"
 #include "effects/EaseEffect.h"
@@ -238,6 +244,11 @@ void WS2812FX::init()
   SEG_RT.stop = LED_COUNT - 1;
   SEG_RT.length = LED_COUNT;
 
+  #ifdef MATRIX_WIDTH
+  // the XY table is built once - the 2D effects fall back to 1D without it
+  MatrixLayout::begin(MATRIX_WIDTH, MATRIX_HEIGHT, MATRIX_SERPENTINE, MATRIX_ROTATION, MATRIX_OFFSET);
+  #endif
+
   _brightness = 255;
 
   bool isRunning = SEG.isRunning;
@@ -345,6 +356,14 @@ void WS2812FX::resetDefaults(void)
   setOnBlackOnly            (DEFAULT_GLITTER_ONBLACK);
   setSynchronous            (DEFAULT_GLITTER_SYNC);
   setColCor                 (COR_UncorrectedColor);
+  for (uint8_t l = 0; l < LAYER_COUNT; l++)
+  {
+    setLayerMode            (l, DEFAULT_LAYER_MODE);
+    setLayerOpacity         (l, DEFAULT_LAYER_OPACITY);
+    setLayerBlend           (l, DEFAULT_LAYER_BLEND);
+  }
+  setSyncRole               (DEFAULT_SYNC_ROLE);
+  setSyncGroup              (DEFAULT_SYNC_GROUP);
   #ifdef HAS_KNOB_CONTROL
   setWiFiDisabled           (DEFAULT_WIFI_DISABLED);
   #endif
@@ -360,22 +379,47 @@ void WS2812FX::resetDefaults(void)
 }
 
 
+// CRC-16 (reflected polynomial 0xA001) - one table lookup per byte instead of 8 shifts
+static const uint16_t crc16Table[256] PROGMEM = {
+  0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+  0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+  0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+  0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+  0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+  0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+  0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+  0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+  0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+  0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+  0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+  0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+  0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+  0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+  0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+  0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+  0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+  0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+  0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+  0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+  0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+  0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+  0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+  0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+  0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+  0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+  0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+  0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+  0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+  0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+  0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+  0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+
 unsigned int WS2812FX::calc_CRC16(unsigned int crc, unsigned char *buf, int len)
 {
   for (int pos = 0; pos < len; pos++)
   {
-    crc ^= (unsigned int)buf[pos]; // XOR byte into least sig. byte of crc
-
-    for (int i = 8; i != 0; i--)
-    { // Loop over each bit
-      if ((crc & 0x0001) != 0)
-      {            // If the LSB is set
-        crc >>= 1; // Shift right and XOR 0xA001
-        crc ^= 0xA001;
-      }
-      else         // Else LSB is not set
-        crc >>= 1; // Just shift right
-    }
+    crc = (crc >> 8) ^ pgm_read_word(&crc16Table[(crc ^ buf[pos]) & 0xff]);
   }
   return crc;
 }
@@ -407,6 +451,12 @@ template <typename T> T WS2812FX::map(T x, T x1, T x2, T y1, T y2)
  */
 void WS2812FX::service()
 {
+  // apply everything queued since the last call so it becomes visible with this frame
+  if (_commandHandler)
+  {
+    _commandHandler();
+  }
+
   unsigned long now = millis(); // Be aware, millis() rolls over every 49 days
   static uint32_t last_show = 0;
 
@@ -439,6 +489,8 @@ void WS2812FX::service()
   {
     fill_solid(leds, LED_COUNT, CRGB::Black);
     setTransition();
+    LayerStack::restart();
+    if (!_timebaseHeld) _effectTimebase = GET_MILLIS();
     // reset the modeinit flag
     SEG_RT.modeinit = false;
   }
@@ -450,28 +502,46 @@ void WS2812FX::service()
 
       if (now > SEG_RT.next_time || _triggered)
       {
+        // the audio of this frame (the same for all segments)
+        AudioInput::update();
+
+        PROFILE_ZONE("effect");
         uint16_t delay;
+        const uint32_t renderStart = micros();
         
-        // Check if a class-based effect is available for this mode
-        Effect* classEffect = EffectFactory::createEffect(SEG.mode);
-        bool useClassBasedForThisMode = (classEffect != nullptr) || _useClassBasedEffects;
-        
-        if (classEffect) {
-          delete classEffect; // We just needed to check if it exists
-        }
+        // Check if a class-based effect is available for this mode (the running one is)
+        const bool useClassBasedForThisMode = (_currentEffect && _currentEffect->getModeId() == SEG.mode) ||
+                                              _useClassBasedEffects || EffectFactory::hasEffect(SEG.mode);
         
         if (useClassBasedForThisMode) {
           // Use new effect system
           if (!_currentEffect || _currentEffect->getModeId() != SEG.mode) {
             // Switch to new effect
             if (_currentEffect) {
-              _currentEffect->cleanup();
-              delete _currentEffect;
+              dropEffect(_currentEffect);
             }
             
-            _currentEffect = EffectFactory::createEffect(SEG.mode);
-            if (_currentEffect) {
-              _currentEffect->init(this);
+            // prepared ahead for this time (see prepareEffect) - nothing to construct or initialize now
+            const uint32_t timebase = _timebaseHeld ? _effectTimebase : GET_MILLIS();
+            if (hasPreparedEffect(SEG.mode) && timebase - _nextTimebase > PREPARED_EFFECT_MAX_LATE) {
+              // too early or too late - its phase would be off
+              discardPreparedEffect();
+            }
+            if (hasPreparedEffect(SEG.mode)) {
+              _currentEffect = _nextEffect;
+              _nextEffect = nullptr;
+              if (!_timebaseHeld) _effectTimebase = _nextTimebase;
+            } else {
+              // pooled: started again on the buffers it has
+              _currentEffect = pooledEffect(SEG.mode);
+              if (_currentEffect) {
+                _currentEffect->setInitialized(false);
+              } else {
+                _currentEffect = EffectFactory::createEffect(SEG.mode);
+              }
+              if (_currentEffect) {
+                _currentEffect->init(this);
+              }
             }
           }
           
@@ -487,7 +557,16 @@ void WS2812FX::service()
         }
         
         SEG_RT.next_time = now + delay; 
+
+        const uint32_t renderTime = micros() - renderStart;
+        _frameStats.renders++;
+        _frameStats.renderMicros += renderTime;
+        _frameStats.lastRenderMicros = renderTime;
+        _frameStats.avgRenderMicros = _frameStats.renders == 1 ? renderTime : (_frameStats.avgRenderMicros * 15 + renderTime) / 16;
+        if (renderTime > _frameStats.renderMaxMicros) _frameStats.renderMaxMicros = renderTime;
       }
+      // the layers keep their own pace
+      LayerStack::render(this, now);
       // reset trigger...
       _triggered = false;
     }
@@ -514,11 +593,11 @@ void WS2812FX::service()
         resCol|=_bleds[i];
       }
       if(resCol != CRGB(CRGB::Black)) {
-          fadeToBlackBy(_bleds, LED_COUNT, 16);
-          fadeToBlackBy(  leds, LED_COUNT, 16);
+          PixelKernels::fadeToBlackBy(_bleds, LED_COUNT, 16);
+          PixelKernels::fadeToBlackBy(  leds, LED_COUNT, 16);
           
       }
-      FastLED.show();
+      showLeds();
       /* could be activated to finally fix #35 (if I need to reopen the ticket)
       else // to be sure for #35 - don't know if this will fix as the root cause was not 
       {
@@ -577,6 +656,11 @@ if(micros() < (last_show + STRIP_DELAY_MICROSEC - FRAME_CALC_WAIT_MICROINTERVAL)
 {
   // we have the time for another calc cycle and do nothing.
   LEDupdate = false;
+  // (or something else not due with this frame)
+  if (_idleHandler)
+  {
+    _idleHandler();
+  }
 }
 else
 {
@@ -586,16 +670,24 @@ else
   } // just wait until time is "synced"
   
   // for FPS calculation
-  _service_Interval_microseconds = (micros() - last_show);
+  const uint32_t interval = micros() - last_show;
+  _service_Interval_microseconds = interval;
+  _frameStats.frames++;
+  if (last_show && interval > (STRIP_DELAY_MICROSEC + STRIP_DELAY_MICROSEC / 4))
+  {
+    _frameStats.missed++;
+  }
   last_show = micros();
   LEDupdate = true;
 }
 
 // When VOID is active, we do nothing. 
 // All data in _bleds just gets written to the LEDS
+// (unless the data is currently incomplete - see setVoidHold)
 if(LEDupdate && SEG.mode == FX_MODE_VOID)
 {
-  FastLED.show();
+  PROFILE_ZONE("show");
+  if(!_voidHold) showLeds();
   return;
 }
 
@@ -606,36 +698,30 @@ if(LEDupdate && SEG.mode == FX_MODE_VOID)
 // as the combination of "mirror" and "reverse" is a bit redundant, this could maybe be simplified as well (later)
 if(LEDupdate)
 {
+  PROFILE_ZONE("compose");
   // try to generally fade a bit to slowly remove any artefacts remaining
   // this should not affect the effect running as long the the l_blend value is 255
-  fadeToBlackBy(_bleds, LED_COUNT, 1);
+  PixelKernels::fadeToBlackBy(_bleds, LED_COUNT, 1);
   for (uint16_t j = 0; j < SEG.segments; j++)
   {
+    CRGB * segLeds = &_bleds[j * SEG_RT.length];
+    // mirrored segments are the reversed ones (or the not reversed ones when the strip is reversed)
+    const bool reversed = SEG.reverse != (SEG.mirror && (j & 0x01));
+    if(LayerStack::active())
+    {
+      // the layers on top of the effect - within the same pass
+      LayerStack::compose(segLeds, leds, SEG_RT.length, SEG_RT.stop, reversed, l_blend);
+      continue;
+    }
+    if(!reversed)
+    {
+      // same order: all channel bytes at once
+      PixelKernels::nblend(segLeds, leds, SEG_RT.length, l_blend);
+      continue;
+    }
     for (uint16_t i = 0; i < SEG_RT.length; i++)
     {
-      if (SEG.mirror && (j & 0x01))
-      {
-        if(SEG.reverse)
-        {
-          nblend(_bleds[j * SEG_RT.length + i], leds[i], l_blend);
-        }
-        else
-        {
-          nblend(_bleds[j * SEG_RT.length + i], leds[SEG_RT.stop - i], l_blend);
-        }
-      }
-      else
-      {
-        if(SEG.reverse)
-        {
-          nblend(_bleds[j * SEG_RT.length + i], leds[SEG_RT.stop - i], l_blend);
-        }
-        else
-        {
-          nblend(_bleds[j * SEG_RT.length + i], leds[i], l_blend);
-        }
-        
-      }
+      nblend(segLeds[i], leds[SEG_RT.stop - i], l_blend);
     }
   }
 }
@@ -708,8 +794,9 @@ EVERY_N_MILLISECONDS(20)
   // Write the data
   if(LEDupdate) 
   {
-    nscale8(_bleds, LED_COUNT,SEG.brightness);
-    FastLED.show();
+    PROFILE_ZONE("show");
+    PixelKernels::nscale8(_bleds, LED_COUNT,SEG.brightness);
+    showLeds();
   }
 
   // every "hueTime" we set either the deltaHue (fixed offset)
@@ -734,6 +821,7 @@ EVERY_N_MILLISECONDS(20)
     { // Blend towards the target palette
       
       _currentPalette = getRandomPalette();
+      _paletteVersion++;
       /*
       static uint8_t current_distance = 0;
       if(current_distance >= 32)
@@ -756,7 +844,11 @@ EVERY_N_MILLISECONDS(20)
     EVERY_N_MILLISECONDS(12)
     { // Blend towards the target palette
 
-      nblendPaletteTowardPalette(_currentPalette, _targetPalette, 8);
+      if (_currentPalette != _targetPalette)
+      {
+        nblendPaletteTowardPalette(_currentPalette, _targetPalette, 8);
+        _paletteVersion++;
+      }
     
       if (_currentPalette == _targetPalette)
       {
@@ -808,8 +900,8 @@ void WS2812FX::trigger()
 
 void WS2812FX::show()
 {
-  nblend(_bleds, leds, LED_COUNT, SEG.blur);
-  nscale8(_bleds, LED_COUNT,SEG.targetBrightness);
+  PixelKernels::nblend(_bleds, leds, LED_COUNT, SEG.blur);
+  PixelKernels::nscale8(_bleds, LED_COUNT,SEG.targetBrightness);
   FastLED.show();
 }
 
@@ -1071,88 +1163,30 @@ void WS2812FX::pacifica_deepen_colors()
    * sixteenths of a pixel from the start of the strip.  Fractional positions are
    * rendered using 'anti-aliasing' of pixel brightness.
    * The bar width is specified in whole pixels.
-   * Arguably, this is the interesting code. 
+   *
+   *                       57.9 . . . . . . . . . . . . . . . . . 61.9
+   *                        v                                      v
+   *  ---+---56----+---57----+---58----+---59----+---60----+---61----+---62---->
+   *     |         |        X|XXXXXXXXX|XXXXXXXXX|XXXXXXXXX|XXXXXXXX |
+   *  ---+---------+---------+---------+---------+---------+---------+--------->
+   *                   10%       100%      100%      100%      90%
+   *
+   * The rasterising (clipping to the segment, coverage of the edge pixels and
+   * the palette gradient with 'incIndex' per pixel) is done by SpanRaster.
    */
 void WS2812FX::drawFractionalBar(int pos16, int width, const CRGBPalette16 &pal, const uint8_t cindex, const uint8_t max_bright = 255, const bool mixColors = true, const uint8_t incIndex = 0)
 {
+  PROFILE_ZONE("drawFractionalBar");
+  // 1/16 pixel (absolute) -> 1/256 pixel relative to the segment start
+  const int32_t from = (int32_t)pos16 * 16 - (int32_t)SEG_RT.start * 256;
+  const int32_t to   = from + (int32_t)width * 256;
 
-  int i = pos16 / 16; // convert from pos to raw pixel number
-
-  uint8_t frac = pos16 & 0x0F; // extract the 'factional' part of the position
-
-  // brightness of the first pixel in the bar is 1.0 - (fractional part of position)
-  // e.g., if the light bar starts drawing at pixel "57.9", then
-  // pixel #57 should only be lit at 10% brightness, because only 1/10th of it
-  // is "in" the light bar:
-  //
-  //                       57.9 . . . . . . . . . . . . . . . . . 61.9
-  //                        v                                      v
-  //  ---+---56----+---57----+---58----+---59----+---60----+---61----+---62---->
-  //     |         |        X|XXXXXXXXX|XXXXXXXXX|XXXXXXXXX|XXXXXXXX |
-  //  ---+---------+---------+---------+---------+---------+---------+--------->
-  //                   10%       100%      100%      100%      90%
-  //
-  // the fraction we get is in 64ths. We subtract from 255 because we want a high
-  // fraction (e.g. 0.9) to turn into a low brightness (e.g. 0.1)
-  uint8_t firstpixelbrightness = scale8((255 - (frac * 16)), max_bright); //map8(15 - (frac), 0, max_bright);
-
-  // if the bar is of integer length, the last pixel's brightness is the
-  // reverse of the first pixel's; see illustration above.
-  uint8_t lastpixelbrightness = scale8((255 - firstpixelbrightness), max_bright); //map8(15 - firstpixelbrightness, 0, max_bright);
-
-  // For a bar of width "N", the code has to consider "N+1" pixel positions,
-  // which is why the "<= width" below instead of "< width".
-  uint8_t bright;
-  bool mix = true;
-  CRGB newColor = CRGB::Black;
+  // the palette distribution is applied once to the start and the gradient (instead of per pixel)
+  const uint8_t index = ((uint16_t)cindex * SEG.paletteDistribution) / 100;
+  const int32_t step  = ((int32_t)incIndex * 256 * SEG.paletteDistribution) / 100;
 
-  for (int n = 0; n <= width; n++)
-  {
-    if (n == 0)
-    {
-      // first pixel in the bar
-      bright = firstpixelbrightness;
-      newColor = WS2812FX::ColorFromPaletteWithDistribution(pal, cindex + (uint8_t)(n * incIndex), bright, SEG.blendType);
-    }
-    else if (n == width)
-    {
-      // last pixel in the bar
-      bright = lastpixelbrightness;
-      newColor = WS2812FX::ColorFromPaletteWithDistribution(pal, cindex + (uint8_t)(n * incIndex), bright, SEG.blendType);
-    }
-    else
-    {
-      // middle pixels
-      bright = max_bright;
-      mix = false;
-      newColor = WS2812FX::ColorFromPaletteWithDistribution(pal, cindex + (uint8_t)(n * incIndex), bright, SEG.blendType);
-      if(incIndex)
-      { 
-        if(SEG.blendType == LINEARBLEND)
-        {
-          CRGB prev_col = WS2812FX::ColorFromPaletteWithDistribution(pal, cindex + (uint8_t)((n-1) * incIndex), bright, SEG.blendType);
-          CRGB next_col = WS2812FX::ColorFromPaletteWithDistribution(pal, cindex + (uint8_t)((n+1) * incIndex), bright, SEG.blendType);
-          newColor = nblend(newColor, nblend(prev_col, next_col, firstpixelbrightness), 128);
-        }
-      }
-    }
-
-    if (i <= SEG_RT.stop && i >= SEG_RT.start)
-    {
-      if (mixColors || mix)
-      {
-        leds[i] |= newColor;
-        //newColor = leds[i] | newColor;//ColorFromPalette(pal, cindex, bright, SEG.blendType);
-        // we blend based on the "baseBeat"
-        //nblend(leds[i], newColor, qadd8(SEG.beat88 >> 8, 24));
-      }
-      else
-      {
-        leds[i] = newColor;
-      }
-    }
-    i++;
-  }
+  SpanRaster::fillPalette(&leds[SEG_RT.start], SEG_RT.length, from, to, pal, index, step, max_bright,
+                          SEG.blendType, mixColors ? SpanRaster::MAX : SpanRaster::REPLACE);
 }
 
 /*
@@ -1231,7 +1265,7 @@ void WS2812FX::addSparks(const uint8_t prob = 5, const bool onBlackOnly = true,
       }
     }
   }
-  if(active > activeMax || random8(DEFAULT_TWINKLE_NUM_MAX) > probability)
+  if(active > activeMax || RandomPool::random8(DEFAULT_TWINKLE_NUM_MAX) > probability)
     return;
 
   EVERY_N_MILLIS_I(timerObj, 10)
@@ -1242,21 +1276,21 @@ void WS2812FX::addSparks(const uint8_t prob = 5, const bool onBlackOnly = true,
       if(!sparks[i])
       {
         if(synchronous) { 
-          pos[i] = random16(SEG_RT.start, SEG_RT.stop);
+          pos[i] = RandomPool::random16(SEG_RT.start, SEG_RT.stop);
         } else {
-          pos[i] = random16(0, LED_COUNT);
+          pos[i] = RandomPool::random16(0, LED_COUNT);
         }
         if (onBlackOnly && _bleds[pos[i]])
           return;
         
-        uint8_t br = random8(192, 255);
+        uint8_t br = RandomPool::random8(192, 255);
         if(white)
         {
           sparks[i] = CRGB(br,br,br);
         }
         else
         {
-          sparks[i] = ColorFromPaletteWithDistribution(_currentPalette, random8(), br, SEG.blendType);
+          sparks[i] = ColorFromPaletteWithDistribution(_currentPalette, RandomPool::random8(), br, SEG.blendType);
         }
         return;
       }
@@ -1385,7 +1419,7 @@ void WS2812FX::coolLikeIncandescent(CRGB &c, uint8_t phase)
  */
 void WS2812FX::fade_out(uint8_t fadeB = 32)
 {
-  fadeToBlackBy(&leds[SEG_RT.start], SEG_RT.length, fadeB);
+  PixelKernels::fadeToBlackBy(&leds[SEG_RT.start], SEG_RT.length, fadeB);
 }
 
 /* 
@@ -1420,6 +1454,7 @@ void WS2812FX::toggleBlendType(void)
 void WS2812FX::setCurrentPalette(CRGBPalette16 p, String Name = "Custom")
 {
   _currentPalette = p;
+  _paletteVersion++;
   //_currentPaletteName = Name;
   SEG.currentPaletteNum = NUM_PALETTES;
 }
@@ -1432,6 +1467,7 @@ void WS2812FX::setCurrentPalette(CRGBPalette16 p, String Name = "Custom")
 void WS2812FX::setCurrentPalette(uint8_t n = 0)
 {
   _currentPalette = *(_palettes[n % NUM_PALETTES]);
+  _paletteVersion++;
   //_currentPaletteName = _pal_name[n % NUM_PALETTES];
   SEG.currentPaletteNum = n % NUM_PALETTES;
 }
@@ -1497,7 +1533,7 @@ void WS2812FX::setMode(uint8_t m)
     return; // not really a new mode...
 
   // make sure its a valid mode
-  m = constrain(m, 0, MODE_COUNT - 1);
+  m = constrain(m, 0, MODE_AVAILABLE_COUNT - 1);
 
   if (SEG.mode == FX_MODE_VOID && m != FX_MODE_VOID)
   {
@@ -1723,7 +1759,7 @@ uint32_t WS2812FX::getCurrentPower(void)
 
 uint8_t WS2812FX::getModeCount(void)
 {
-  return MODE_COUNT;
+  return MODE_AVAILABLE_COUNT;
 }
 
 uint8_t WS2812FX::getPalCount(void)
@@ -2513,6 +2549,161 @@ uint16_t WS2812FX::mode_twinkle_map()
 }
 */
 
+bool WS2812FX::prepareEffect(const segment &scene, CRGB * scratch, uint32_t activation)
+{
+  PROFILE_ZONE("prepareEffect");
+  discardPreparedEffect();
+  // the VOID mode and the ones behind change the strip itself when initialized,
+  // another number of segments changes the length the effect was initialized for
+  if (scene.mode >= FX_MODE_VOID || scene.segments != SEG.segments || !scratch)
+  {
+    return false;
+  }
+  Effect * effect = pooledEffect(scene.mode);
+  if (effect && effect == _currentEffect)
+  {
+    return false;
+  }
+  if (effect)
+  {
+    effect->setInitialized(false);
+  }
+  else
+  {
+    effect = EffectFactory::createEffect(scene.mode);
+  }
+  if (!effect)
+  {
+    return false;
+  }
+  if (!initEffectAhead(effect, scene, scratch, activation, _nextTimebase))
+  {
+    dropEffect(effect);
+    return false;
+  }
+  _nextEffect = effect;
+  return true;
+}
+
+// initializes "effect" with the values it will run with (as if "scene" was the segment),
+// drawing into "scratch" - the segment, its runtime and the effect running are left as they are
+bool WS2812FX::initEffectAhead(Effect * effect, const segment &scene, CRGB * scratch, uint32_t activation, uint32_t &timebase)
+{
+  const segment current = SEG;
+  const segment_runtime runtime = SEG_RT;
+  const uint32_t running = _effectTimebase;
+  CRGB * const l = leds;
+  SEG = scene;
+  leds = scratch;
+  if (!_timebaseHeld) _effectTimebase = activation;
+  const bool ok = effect->init(this);
+  timebase = _effectTimebase;
+  _effectTimebase = running;
+  leds = l;
+  // (e.g. the modeinit flag of a setMode earlier within this pass)
+  SEG_RT = runtime;
+  SEG = current;
+  return ok;
+}
+
+void WS2812FX::discardPreparedEffect(void)
+{
+  if (_nextEffect)
+  {
+    dropEffect(_nextEffect);
+    _nextEffect = nullptr;
+  }
+}
+
+uint8_t WS2812FX::poolEffects(const uint8_t * modes, uint8_t count, CRGB * scratch)
+{
+  PROFILE_ZONE("poolEffects");
+  releaseEffectPool();
+  discardPreparedEffect();
+  if (!scratch)
+  {
+    return 0;
+  }
+  for (uint8_t i = 0; i < count && _effectPoolCount < EFFECT_POOL_SIZE; i++)
+  {
+    const uint8_t mode = modes[i];
+    if (mode >= FX_MODE_VOID || pooledEffect(mode))
+    {
+      continue;
+    }
+    // the one running is taken over as it is
+    Effect * effect = (_currentEffect && _currentEffect->getModeId() == mode) ? _currentEffect : nullptr;
+    if (!effect)
+    {
+      uint32_t timebase;
+      effect = EffectFactory::createEffect(mode);
+      // the buffers of its init() get allocated now
+      if (!effect || !initEffectAhead(effect, SEG, scratch, GET_MILLIS(), timebase))
+      {
+        dropEffect(effect);
+        continue;
+      }
+      effect->suspend();
+    }
+    _effectPool[_effectPoolCount++] = effect;
+  }
+  return _effectPoolCount;
+}
+
+void WS2812FX::releaseEffectPool(void)
+{
+  const uint8_t count = _effectPoolCount;
+  _effectPoolCount = 0;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    Effect * effect = _effectPool[i];
+    _effectPool[i] = nullptr;
+    if (effect == _nextEffect)
+    {
+      _nextEffect = nullptr;
+    }
+    // the one running belongs to the strip again
+    if (effect != _currentEffect)
+    {
+      dropEffect(effect);
+    }
+  }
+}
+
+Effect * WS2812FX::pooledEffect(uint8_t mode) const
+{
+  for (uint8_t i = 0; i < _effectPoolCount; i++)
+  {
+    if (_effectPool[i]->getModeId() == mode) return _effectPool[i];
+  }
+  return nullptr;
+}
+
+bool WS2812FX::isPooled(const Effect * effect) const
+{
+  for (uint8_t i = 0; i < _effectPoolCount; i++)
+  {
+    if (_effectPool[i] == effect) return true;
+  }
+  return false;
+}
+
+// an effect switched away from: a pooled one is kept (suspended), any other one freed
+void WS2812FX::dropEffect(Effect * effect)
+{
+  if (!effect)
+  {
+    return;
+  }
+  if (isPooled(effect))
+  {
+    effect->suspend();
+    return;
+  }
+  effect->cleanup();
+  delete effect;
+}
+
 // Fallback function for effects that have been converted to class-based implementation
 uint16_t WS2812FX::mode_class_based_fallback(void) {
     // This should not be called if the effect selection logic works correctly
@@ -2525,8 +2716,7 @@ void WS2812FX::enableClassBasedEffects(bool enable) {
     if (_useClassBasedEffects != enable) {
         // Clean up current effect if switching away from class-based
         if (!enable && _currentEffect) {
-            _currentEffect->cleanup();
-            delete _currentEffect;
+            dropEffect(_currentEffect);
             _currentEffect = nullptr;
         }
         
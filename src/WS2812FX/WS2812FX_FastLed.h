@@ -51,12 +51,15 @@
 
 #define STRIP_MIN_DELAY max((uint32_t)((1000000 - FRAME_CALC_WAIT_MICROINTERVAL) / (SEG.fps * 1000)), (uint32_t)((MIN_LED_WRITE_CYCLE-FRAME_CALC_WAIT_MICROINTERVAL) / 1000))
 #define STRIP_DELAY_MICROSEC  ((uint32_t)max((uint32_t)(1000000 / (SEG.fps)), (uint32_t)(MIN_LED_WRITE_CYCLE)))
+// ms a prepared effect may start after the time it was prepared for (constructed anew otherwise)
+#define PREPARED_EFFECT_MAX_LATE  (2 * STRIP_DELAY_MICROSEC / 1000)
 
 #define FASTLED_INTERNAL
 #include "FastLED.h"
 FASTLED_USING_NAMESPACE
 
 #include "Effect.h" // Ensure Effect class is defined before use
+#include "LayerStack.h"
 
 /* </FastLED implementation> */
 
@@ -144,15 +147,28 @@ enum MODES
  
   FX_MODE_VOID,
   
-  // make sure these are the last ones...
+  // make sure these are behind VOID...
   FX_MODE_RING_RING,
   FX_MODE_SUNRISE,
   FX_MODE_SUNSET,
 
+  // audio reactive (need HAS_AUDIO_INPUT) - behind VOID so autoplay skips them.
+  // the ids are stored (settings, presets, playlists) - new modes are appended only
+  FX_MODE_AUDIO_SPECTRUM,
+  FX_MODE_AUDIO_VU,
+  FX_MODE_AUDIO_BEAT,
+
   // has to be the final entry!
   MODE_COUNT
 };
 
+// the modes being listed and selectable - the audio reactive ones need HAS_AUDIO_INPUT
+#ifdef HAS_AUDIO_INPUT
+#define MODE_AVAILABLE_COUNT MODE_COUNT
+#else
+#define MODE_AVAILABLE_COUNT FX_MODE_AUDIO_SPECTRUM
+#endif
+
 extern const TProgmemRGBPalette16
     Ice_Colors_p,
     Ice_p,
@@ -208,6 +224,14 @@ enum AUTOPLAYMODES
   AUTO_MODE_RANDOM
 };
 
+enum SYNCROLES
+{
+  SYNC_ROLE_OFF,
+  SYNC_ROLE_LEADER,
+  SYNC_ROLE_FOLLOWER,
+  SYNC_ROLE_COUNT
+};
+
 enum COLORCORRECTIONS
 {
   COR_TypicalLEDStrip,
@@ -275,6 +299,11 @@ public:
     TBlendType blendType;
     AUTOPLAYMODES autoplay;
     AUTOPLAYMODES autoPal;
+    uint8_t layerMode[LAYER_COUNT];     // effects on top of the effect (see LayerStack.h)
+    uint8_t layerOpacity[LAYER_COUNT];  // 0: layer off
+    uint8_t layerBlend[LAYER_COUNT];    // LayerStack::Blend
+    uint8_t syncRole;                   // SYNCROLES - with other strips via UDP (see led_sync.h)
+    uint8_t syncGroup;                  // only strips of the same group follow each other
   } segment;
 
   // segment runtime parameters
@@ -439,6 +468,18 @@ public:
     mode_variables modevars;
   } segment_runtime;
 
+  // timing of the frames (e.g. for /metrics)
+  typedef struct frame_stats
+  {
+    uint32_t frames;          // frames written to the LEDs
+    uint32_t missed;          // frames written more than 25% later than their interval
+    uint32_t renders;         // effect calculations
+    uint32_t renderMicros;    // sum of the effect calculation times
+    uint32_t renderMaxMicros; // longest effect calculation
+    uint32_t lastRenderMicros;
+    uint32_t avgRenderMicros; // effect calculation time of the recent frames (moving average, 1/16)
+  } frame_stats;
+
 public:
   WS2812FX(CRGB * pleds, CRGB* eleds)
   {
@@ -500,6 +541,9 @@ public:
     _mode[FX_MODE_COLOR_WAVES]            = &WS2812FX::mode_class_based_fallback; // Now implemented as ColorWavesEffect class
     _mode[FX_MODE_TWINKLE_MAP]            = &WS2812FX::mode_class_based_fallback; // Now implemented as TwinkleMapEffect class
     _mode[FX_MODE_VOID]                   = &WS2812FX::mode_class_based_fallback; // Now implemented as VoidEffect class
+    _mode[FX_MODE_AUDIO_SPECTRUM]         = &WS2812FX::mode_class_based_fallback; // Now implemented as AudioSpectrumEffect class
+    _mode[FX_MODE_AUDIO_VU]               = &WS2812FX::mode_class_based_fallback; // Now implemented as AudioVUEffect class
+    _mode[FX_MODE_AUDIO_BEAT]             = &WS2812FX::mode_class_based_fallback; // Now implemented as AudioBeatEffect class
     _mode[FX_MODE_SUNRISE]                = &WS2812FX::mode_class_based_fallback; // Now implemented as SunriseEffect class
     _mode[FX_MODE_SUNSET]                 = &WS2812FX::mode_class_based_fallback; // Now implemented as SunsetEffect class
 
@@ -559,6 +603,9 @@ public:
     // _name[FX_MODE_COLOR_WAVES] - provided by ColorWavesEffect class
     // _name[FX_MODE_TWINKLE_MAP] - provided by TwinkleMapEffect class
     // _name[FX_MODE_VOID] - provided by VoidEffect class
+    // _name[FX_MODE_AUDIO_SPECTRUM] - provided by AudioSpectrumEffect class
+    // _name[FX_MODE_AUDIO_VU] - provided by AudioVUEffect class
+    // _name[FX_MODE_AUDIO_BEAT] - provided by AudioBeatEffect class
     // _name[FX_MODE_SUNRISE] - provided by SunriseEffect class
     // _name[FX_MODE_SUNSET] - provided by SunsetEffect class
 
@@ -590,6 +637,8 @@ public:
 
     // Initialize effect system
     _currentEffect = nullptr;
+    _nextEffect = nullptr;
+    _nextTimebase = 0;
     _useClassBasedEffects = false;
 
     FastLED.setBrightness(255);  // DEFAULT_BRIGHTNESS);
@@ -599,12 +648,16 @@ public:
 
   ~WS2812FX()
   {
+    // the pool leaves the effect running to the strip
+    releaseEffectPool();
     // Clean up current effect
     if (_currentEffect) {
       _currentEffect->cleanup();
       delete _currentEffect;
       _currentEffect = nullptr;
     }
+    discardPreparedEffect();
+    LayerStack::end();
   }
 
   CRGB *leds;
@@ -690,6 +743,11 @@ public:
   inline void setBckndBri             (uint8_t b)       { SEG.backgroundBri = constrain(b, BCKND_MIN_BRI, BCKND_MAX_BRI); }
   inline void setColCor               (COLORCORRECTIONS c) { SEG.colCor = (COLORCORRECTIONS)constrain(c, 0, COR_NUMCORRECTIONS-1); FastLED.setCorrection(colorCorrectionValues[SEG.colCor]);}
   inline void setSolidColor           (uint32_t c)      { SEG.solidColor = CRGB(c); }
+  inline void setLayerMode            (uint8_t l, uint8_t m) { if (l < LAYER_COUNT) SEG.layerMode[l] = m < MODE_AVAILABLE_COUNT ? m : DEFAULT_LAYER_MODE; }
+  inline void setLayerOpacity         (uint8_t l, uint8_t o) { if (l < LAYER_COUNT) SEG.layerOpacity[l] = o; }
+  inline void setLayerBlend           (uint8_t l, uint8_t b) { if (l < LAYER_COUNT) SEG.layerBlend[l] = b < LayerStack::BLEND_COUNT ? b : DEFAULT_LAYER_BLEND; }
+  inline void setSyncRole             (uint8_t r)       { SEG.syncRole = r < SYNC_ROLE_COUNT ? r : SYNC_ROLE_OFF; }
+  inline void setSyncGroup            (uint8_t g)       { SEG.syncGroup = g; }
 
   inline void setTransition           (void)            { 
     _transition = true; 
@@ -713,6 +771,11 @@ public:
   inline bool           getWhiteGlitter(void)         { return SEG.whiteGlitter; }
   inline bool           getOnBlackOnly(void)          { return SEG.onBlackOnly; }
   inline bool           getSynchronous(void)          { return SEG.synchronous; }
+  inline uint8_t        getLayerMode(uint8_t l)       { return l < LAYER_COUNT ? SEG.layerMode[l] : 0; }
+  inline uint8_t        getLayerOpacity(uint8_t l)    { return l < LAYER_COUNT ? SEG.layerOpacity[l] : 0; }
+  inline uint8_t        getLayerBlend(uint8_t l)      { return l < LAYER_COUNT ? SEG.layerBlend[l] : 0; }
+  inline uint8_t        getSyncRole(void)             { return SEG.syncRole; }
+  inline uint8_t        getSyncGroup(void)            { return SEG.syncGroup; }
   #ifdef HAS_KNOB_CONTROL
   inline bool           getWiFiDisabled(void)         { return SEG.wifiDisabled; }
   #endif
@@ -808,6 +871,8 @@ public:
 
   CRGBPalette16* getCurrentPalette(void) { return &_currentPalette; };
   CRGBPalette16* getTargetPalette (void) { return &_targetPalette; };
+  // changes whenever the colors of the current palette change (for caches built from it)
+  inline uint16_t getPaletteVersion(void) { return _paletteVersion; }
 
   // Helper function for palette distribution-aware color selection
   CRGB ColorFromPaletteWithDistribution(const CRGBPalette16 &pal, uint8_t index, uint8_t brightness, TBlendType blendType);
@@ -819,6 +884,47 @@ public:
   bool isUsingClassBasedEffects() const { return _useClassBasedEffects; }
   Effect* getCurrentEffect() const { return _currentEffect; }
 
+  // Handler called at the start of each service() call before anything gets rendered.
+  // Used to apply state changes queued by other contexts (e.g. the web server) with the next frame.
+  inline void setCommandHandler(void (*handler)(void)) { _commandHandler = handler; }
+  // While set, the VOID mode does not show the LED data (e.g. while a frame received via network is incomplete).
+  inline void setVoidHold(bool hold) { _voidHold = hold; }
+
+  inline const frame_stats * getFrameStats(void) { return &_frameStats; }
+
+  // Handler called after each FastLED.show() within service() (e.g. to measure the input latency).
+  inline void setShowHandler(void (*handler)(void)) { _showHandler = handler; }
+  // Handler called when service() has time left until the next frame is due (spare cycles).
+  inline void setIdleHandler(void (*handler)(void)) { _idleHandler = handler; }
+
+  // Constructs and initializes the effect of scene.mode ahead of time (as if "scene" was the segment).
+  // The switch to that mode at "activation" (GET_MILLIS) takes it over instead of constructing and
+  // initializing it with that frame - the effect starts its phase there (unless the timebase is held).
+  // A switch earlier or more than PREPARED_EFFECT_MAX_LATE later constructs the effect anew.
+  // Effects drawing when being initialized draw into "scratch" (LED_COUNT pixels).
+  // Returns false for the modes not being prepared: VOID and behind, and scenes with another
+  // number of segments than the current one (the effect would be initialized for another length).
+  // A pooled effect (see poolEffects) is initialized again, any other one gets constructed here.
+  bool prepareEffect(const segment &scene, CRGB * scratch, uint32_t activation);
+  void discardPreparedEffect(void);
+  inline bool hasPreparedEffect(uint8_t mode) const { return _nextEffect && _nextEffect->getModeId() == mode; }
+
+  // Constructs and initializes the effects of "modes" (up to EFFECT_POOL_SIZE, e.g. the ones of a
+  // playlist) to be reused: a switch to one of them initializes it again (keeping the buffers of
+  // its init()) and a switch away suspends it - neither constructs, frees nor allocates.
+  // Returns the number of effects pooled (the others are constructed with each switch as usual).
+  uint8_t poolEffects(const uint8_t * modes, uint8_t count, CRGB * scratch);
+  // Frees the pooled effects - the one running stays until the next switch.
+  void releaseEffectPool(void);
+
+  // The time (GET_MILLIS, the clock of the beat generators) the effect was started with - the
+  // effects derive their phase from it (see EffectHelper::standardInit).
+  inline uint32_t getEffectTimebase(void) const { return _effectTimebase; }
+  // Restarts the effect with the timebase "t" and keeps it for all restarts until released
+  // (e.g. to run in phase with another strip).
+  inline void setEffectTimebase(uint32_t t) { _effectTimebase = t; _timebaseHeld = true; setTransition(); }
+  inline void releaseEffectTimebase(void) { _timebaseHeld = false; }
+
   // Make internal methods accessible to effects
   void fade_out(uint8_t fadeB);
   void drawFractionalBar(int pos16, int width, const CRGBPalette16 &pal, uint8_t cindex, uint8_t max_bright, bool mixColor, uint8_t incindex);
@@ -855,6 +961,12 @@ private:
 
   uint8_t attackDecayWave8(uint8_t i);
 
+  // the effect system (see prepareEffect and poolEffects)
+  bool initEffectAhead(Effect * effect, const segment &scene, CRGB * scratch, uint32_t activation, uint32_t &timebase);
+  Effect * pooledEffect(uint8_t mode) const;
+  bool isPooled(const Effect * effect) const;
+  void dropEffect(Effect * effect);
+
   CRGB colorCorrectionValues[3] = {TypicalLEDStrip, TypicalPixelString, UncorrectedColor };
 
   uint16_t
@@ -933,6 +1045,7 @@ private:
 
   CRGBPalette16 _currentPalette;
   CRGBPalette16 _targetPalette;
+  uint16_t      _paletteVersion = 0;
 
   CRGBPalette16 getRandomPalette(void);
 
@@ -989,8 +1102,24 @@ private:
 
   // New effect system
   Effect* _currentEffect;
+  Effect* _nextEffect;     // prepared ahead (see prepareEffect)
+  uint32_t _nextTimebase;  // the timebase the prepared effect was initialized with (its activation)
+  Effect* _effectPool[EFFECT_POOL_SIZE];  // kept for reuse (see poolEffects)
+  uint8_t _effectPoolCount = 0;
+  uint32_t _effectTimebase = 0;
+  bool _timebaseHeld = false;
   bool _useClassBasedEffects;
 
+  void (*_commandHandler)(void) = nullptr;
+  bool _voidHold = false;
+  void (*_showHandler)(void) = nullptr;
+  void (*_idleHandler)(void) = nullptr;
+
+  // writes the LED data and informs the show handler
+  inline void showLeds(void) { FastLED.show(); if (_showHandler) _showHandler(); }
+
+  frame_stats _frameStats = {0, 0, 0, 0, 0, 0, 0};
+
   segment _segment;
 
   segment_runtime _segment_runtime; // SRAM footprint: 14 bytes per element
@@ -0,0 +1,75 @@
+#include "AudioBeatEffect.h"
+#include "../WS2812FX_FastLed.h"
+#include "../EffectHelper.h"
+#include "../AudioInput.h"
+#include "../SpanRaster.h"
+
+bool AudioBeatEffect::init(WS2812FX* strip) {
+    // Call base class standard initialization first
+    if (!standardInit(strip)) {
+        return false;
+    }
+    colorIndex = 0;
+    pulseMs = DEFAULT_PULSE_MS;
+    return true;
+}
+
+uint16_t AudioBeatEffect::update(WS2812FX* strip) {
+    // Check if effect needs initialization
+    if (!isInitialized()) {
+        if (!init(strip)) {
+            return 1000; // Return reasonable delay if initialization fails
+        }
+    }
+    
+    // Validate strip pointer using helper
+    if (!EffectHelper::validateStripPointer(strip)) {
+        return 1000; // Return reasonable delay if strip is invalid
+    }
+    
+    auto seg = strip->getSegment();
+    auto runtime = strip->getSegmentRuntime();
+    const AudioFrame& audio = AudioInput::frame();
+    
+    EffectHelper::applyFadeEffect(strip, FADE_AMOUNT);
+    
+    if (audio.beat) {
+        // A new pulse - in a different color, lasting one beat
+        colorIndex = EffectHelper::get_random_wheel_index(colorIndex, 42);
+        pulseMs = audio.bpm ? 60000U / audio.bpm : DEFAULT_PULSE_MS;
+    }
+    
+    CRGB* leds = &strip->leds[runtime->start];
+    const CRGBPalette16& pal = *strip->getCurrentPalette();
+    const int32_t middle = (int32_t)runtime->length << 7;
+    
+    // The pulse: two short spans moving from the middle to the ends
+    if (audio.active && audio.beatAge < pulseMs) {
+        const int32_t radius = (int32_t)audio.beatAge * middle / pulseMs;
+        const uint8_t bright = 255 - (uint32_t)audio.beatAge * 255 / pulseMs;
+        const int32_t width = 512 + ((int32_t)audio.bass << 2);
+        const CRGB color = strip->ColorFromPaletteWithDistribution(pal, colorIndex + runtime->baseHue, bright, seg->blendType);
+        SpanRaster::fillSolid(leds, runtime->length, middle - radius - width, middle - radius, color, SpanRaster::MAX);
+        SpanRaster::fillSolid(leds, runtime->length, middle + radius, middle + radius + width, color, SpanRaster::MAX);
+    }
+    
+    // The middle glows with the bass (up to half of the segment)
+    const int32_t glow = ((int32_t)audio.bass * middle) >> 9;
+    if (glow) {
+        const CRGB color = strip->ColorFromPaletteWithDistribution(pal, colorIndex + runtime->baseHue + 128, audio.bass, seg->blendType);
+        SpanRaster::fillSolid(leds, runtime->length, middle - glow, middle + glow, color, SpanRaster::MAX);
+    }
+    
+    return strip->getStripMinDelay();
+}
+
+const __FlashStringHelper* AudioBeatEffect::getName() const {
+    return F("Audio Beat");
+}
+
+uint8_t AudioBeatEffect::getModeId() const {
+    return FX_MODE_AUDIO_BEAT;
+}
+
+// Register this effect with the factory
+REGISTER_EFFECT(FX_MODE_AUDIO_BEAT, AudioBeatEffect)
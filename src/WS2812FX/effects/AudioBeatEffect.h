@@ -0,0 +1,33 @@
+#ifndef AUDIO_BEAT_EFFECT_H
+#define AUDIO_BEAT_EFFECT_H
+
+#include "../Effect.h"
+
+/**
+ * @brief Audio Beat effect - a pulse running outwards from the middle on each beat
+ *
+ * Every detected beat starts a pulse in a new palette color at the middle of
+ * the segment. It reaches the segment ends within one beat interval (from
+ * the tempo, DEFAULT_PULSE_MS until the tempo is known) and fades on its way.
+ * The middle glows with the loudness of the bass.
+ * Needs the audio input (HAS_AUDIO_INPUT) - the segment stays dark without it.
+ */
+class AudioBeatEffect : public Effect {
+public:
+    AudioBeatEffect() = default;
+    virtual ~AudioBeatEffect() = default;
+
+    bool init(WS2812FX* strip) override;
+    uint16_t update(WS2812FX* strip) override;
+    const __FlashStringHelper* getName() const override;
+    uint8_t getModeId() const override;
+
+private:
+    uint8_t  colorIndex = 0;    ///< Palette index of the current pulse
+    uint16_t pulseMs = 0;       ///< Duration of the current pulse
+
+    static const uint16_t DEFAULT_PULSE_MS = 400;  ///< Pulse duration without a tempo
+    static const uint8_t  FADE_AMOUNT = 48;        ///< Background fade per frame
+};
+
+#endif // AUDIO_BEAT_EFFECT_H
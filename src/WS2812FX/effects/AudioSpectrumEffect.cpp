@@ -0,0 +1,50 @@
+#include "AudioSpectrumEffect.h"
+#include "../WS2812FX_FastLed.h"
+#include "../EffectHelper.h"
+#include "../AudioInput.h"
+#include "../SpanRaster.h"
+
+uint16_t AudioSpectrumEffect::update(WS2812FX* strip) {
+    // Check if effect needs initialization
+    if (!isInitialized()) {
+        if (!init(strip)) {
+            return 1000; // Return reasonable delay if initialization fails
+        }
+    }
+    
+    // Validate strip pointer using helper
+    if (!EffectHelper::validateStripPointer(strip)) {
+        return 1000; // Return reasonable delay if strip is invalid
+    }
+    
+    auto seg = strip->getSegment();
+    auto runtime = strip->getSegmentRuntime();
+    const AudioFrame& audio = AudioInput::frame();
+    
+    CRGB* leds = &strip->leds[runtime->start];
+    fill_solid(leds, runtime->length, CRGB::Black);
+    
+    // The palette runs once along the segment - each zone is lit by its band
+    const int32_t segLength = (int32_t)runtime->length << 8;
+    const int32_t step = (256L * 256) / max(runtime->length, (uint16_t)1);
+    for (uint8_t b = 0; b < AUDIO_BANDS; b++) {
+        const int32_t from = segLength * b / AUDIO_BANDS;
+        const int32_t to   = segLength * (b + 1) / AUDIO_BANDS;
+        const uint8_t index = runtime->baseHue + (uint8_t)(b * (256 / AUDIO_BANDS));
+        SpanRaster::fillPalette(leds, runtime->length, from, to, *strip->getCurrentPalette(),
+                                index, step, audio.bands[b], seg->blendType, SpanRaster::MAX);
+    }
+    
+    return strip->getStripMinDelay();
+}
+
+const __FlashStringHelper* AudioSpectrumEffect::getName() const {
+    return F("Audio Spectrum");
+}
+
+uint8_t AudioSpectrumEffect::getModeId() const {
+    return FX_MODE_AUDIO_SPECTRUM;
+}
+
+// Register this effect with the factory
+REGISTER_EFFECT(FX_MODE_AUDIO_SPECTRUM, AudioSpectrumEffect)
@@ -0,0 +1,23 @@
+#ifndef AUDIO_SPECTRUM_EFFECT_H
+#define AUDIO_SPECTRUM_EFFECT_H
+
+#include "../Effect.h"
+
+/**
+ * @brief Audio Spectrum effect - the loudness of the audio bands side by side
+ *
+ * The segment is split into AUDIO_BANDS zones (bass at the segment start).
+ * Each zone shows its part of the palette at the brightness of its band.
+ * Needs the audio input (HAS_AUDIO_INPUT) - the segment stays dark without it.
+ */
+class AudioSpectrumEffect : public Effect {
+public:
+    AudioSpectrumEffect() = default;
+    virtual ~AudioSpectrumEffect() = default;
+
+    uint16_t update(WS2812FX* strip) override;
+    const __FlashStringHelper* getName() const override;
+    uint8_t getModeId() const override;
+};
+
+#endif // AUDIO_SPECTRUM_EFFECT_H
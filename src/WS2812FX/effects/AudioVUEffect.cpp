@@ -0,0 +1,72 @@
+#include "AudioVUEffect.h"
+#include "../WS2812FX_FastLed.h"
+#include "../EffectHelper.h"
+#include "../AudioInput.h"
+#include "../SpanRaster.h"
+
+bool AudioVUEffect::init(WS2812FX* strip) {
+    // Call base class standard initialization first
+    if (!standardInit(strip)) {
+        return false;
+    }
+    peak = 0;
+    peakTime = millis();
+    lastTime = millis();
+    return true;
+}
+
+uint16_t AudioVUEffect::update(WS2812FX* strip) {
+    // Check if effect needs initialization
+    if (!isInitialized()) {
+        if (!init(strip)) {
+            return 1000; // Return reasonable delay if initialization fails
+        }
+    }
+    
+    // Validate strip pointer using helper
+    if (!EffectHelper::validateStripPointer(strip)) {
+        return 1000; // Return reasonable delay if strip is invalid
+    }
+    
+    auto seg = strip->getSegment();
+    auto runtime = strip->getSegmentRuntime();
+    const AudioFrame& audio = AudioInput::frame();
+    const uint32_t now = millis();
+    
+    CRGB* leds = &strip->leds[runtime->start];
+    fill_solid(leds, runtime->length, CRGB::Black);
+    
+    // The bar: level 255 covers the complete segment (1/256 pixel)
+    const int32_t segLength = (int32_t)runtime->length << 8;
+    const int32_t bar = ((int32_t)audio.level * segLength) / 255;
+    const int32_t step = (256L * 256) / max(runtime->length, (uint16_t)1);
+    SpanRaster::fillPalette(leds, runtime->length, 0, bar, *strip->getCurrentPalette(),
+                            runtime->baseHue, step, 255, seg->blendType, SpanRaster::REPLACE);
+    
+    // The peak is pushed up by the bar, held and then falls
+    if (bar >= peak) {
+        peak = bar;
+        peakTime = now;
+    } else if (now - peakTime > PEAK_HOLD_MS) {
+        peak -= (int32_t)((now - lastTime) * segLength / PEAK_FALL_MS);
+        if (peak < bar) peak = bar;
+    }
+    lastTime = now;
+    
+    if (peak > 0) {
+        SpanRaster::fillSolid(leds, runtime->length, peak - 256, peak, CRGB::White, SpanRaster::MAX);
+    }
+    
+    return strip->getStripMinDelay();
+}
+
+const __FlashStringHelper* AudioVUEffect::getName() const {
+    return F("Audio VU Meter");
+}
+
+uint8_t AudioVUEffect::getModeId() const {
+    return FX_MODE_AUDIO_VU;
+}
+
+// Register this effect with the factory
+REGISTER_EFFECT(FX_MODE_AUDIO_VU, AudioVUEffect)
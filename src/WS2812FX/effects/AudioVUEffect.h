@@ -0,0 +1,33 @@
+#ifndef AUDIO_VU_EFFECT_H
+#define AUDIO_VU_EFFECT_H
+
+#include "../Effect.h"
+
+/**
+ * @brief Audio VU Meter effect - a bar following the loudness with a falling peak
+ *
+ * The bar grows from the segment start with the overall audio level and
+ * shows the palette along its length. The highest level is marked by a white
+ * dot which is held for PEAK_HOLD_MS and then falls back to the bar.
+ * Needs the audio input (HAS_AUDIO_INPUT) - the segment stays dark without it.
+ */
+class AudioVUEffect : public Effect {
+public:
+    AudioVUEffect() = default;
+    virtual ~AudioVUEffect() = default;
+
+    bool init(WS2812FX* strip) override;
+    uint16_t update(WS2812FX* strip) override;
+    const __FlashStringHelper* getName() const override;
+    uint8_t getModeId() const override;
+
+private:
+    int32_t  peak = 0;          ///< Position of the peak dot (1/256 pixel)
+    uint32_t peakTime = 0;      ///< When the peak was reached (ms)
+    uint32_t lastTime = 0;      ///< Timestamp of the last frame (for the fall)
+
+    static const uint16_t PEAK_HOLD_MS = 500;   ///< The peak stays this long
+    static const uint16_t PEAK_FALL_MS = 1500;  ///< Time for falling the full segment
+};
+
+#endif // AUDIO_VU_EFFECT_H
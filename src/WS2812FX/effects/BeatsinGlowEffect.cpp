@@ -90,7 +90,7 @@ void BeatsinGlowEffect::initializeGlowElements(WS2812FX* strip) {
         }
         
         // Initialize timing with random offset for each element
-        times[i] = millis() + random8();
+        times[i] = strip->getEffectTimebase() + random8();
         
         // Initialize state tracking variables
         prev[i] = 0;
@@ -164,7 +164,7 @@ void BeatsinGlowEffect::updateElementParameters(WS2812FX* strip, uint8_t element
     cinds[elementIndex] = cinds[elementIndex] + (rand_delta / 2) - random8(rand_delta);
     
     // Update time offset to create complex timing relationships
-    times[elementIndex] = millis() - theta[elementIndex];
+    times[elementIndex] = GET_MILLIS() - theta[elementIndex];  // the clock of beat88()
 }
 
 void BeatsinGlowEffect::applyBackgroundFade(WS2812FX* strip) {
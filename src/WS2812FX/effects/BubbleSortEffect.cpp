@@ -8,21 +8,19 @@ bool BubbleSortEffect::init(WS2812FX* strip) {
         return false;
     }
     
-    // Clean up any existing memory first
-    cleanupMemory();
-    
     // Initialize state variables
     movedown = false;
     ci = co = cd = 0;
     
     // Get current strip length and allocate memory for hue array using EffectHelper
+    // (initialized again the array of the same length is kept)
     auto runtime = strip->getSegmentRuntime();
+    size_t currentSize = hues ? strip_length : 0;
     strip_length = runtime->length;
     
     if (strip_length > 0) {
         // Use EffectHelper for safe memory allocation
-        size_t currentSize = 0;
-        hues = (uint8_t*)EffectHelper::safeAllocateArray(nullptr, currentSize, strip_length, sizeof(uint8_t));
+        hues = (uint8_t*)EffectHelper::safeAllocateArray(hues, currentSize, strip_length, sizeof(uint8_t));
         if (hues != nullptr) {
             initializeHues(strip);
             return true;
@@ -151,7 +149,7 @@ uint8_t BubbleSortEffect::getModeId() const {
 }
 
 void BubbleSortEffect::initializeHues(WS2812FX* strip) {
-    if (!initialized || hues == nullptr) {
+    if (!isInitialized() || hues == nullptr) {
         return;
     }
     
@@ -176,7 +174,7 @@ void BubbleSortEffect::cleanupMemory() {
         EffectHelper::safeFreeArray((void*&)hues, arraySize);
         hues = nullptr;
     }
-    initialized = false;
+    setInitialized(false);
 }
 
 uint16_t BubbleSortEffect::calculateFrameDelay(WS2812FX* strip) const {
@@ -191,7 +189,7 @@ uint16_t BubbleSortEffect::calculateFrameDelay(WS2812FX* strip) const {
 }
 
 void BubbleSortEffect::updateLEDDisplay(WS2812FX* strip) {
-    if (!initialized || hues == nullptr) {
+    if (!isInitialized() || hues == nullptr) {
         return;
     }
     
@@ -37,12 +37,12 @@ public:
 
 private:
     // Effect state variables - encapsulated within the class
-    uint8_t* hues;           ///< Array of hue values for each LED position (dynamically allocated)
+    uint8_t* hues = nullptr; ///< Array of hue values for each LED position (dynamically allocated)
     bool movedown;           ///< Direction flag for movement animation
     uint16_t ci;             ///< Inner loop counter (comparison index)
     uint16_t co;             ///< Outer loop counter (current position)
     uint16_t cd;             ///< Movement animation counter (countdown)
-    uint16_t strip_length;   ///< Current strip length for memory management
+    uint16_t strip_length = 0; ///< Current strip length for memory management
 
     /**
      * @brief Initialize the hue array with random values
@@ -1,6 +1,7 @@
 #include "ColorWavesEffect.h"
 #include "../WS2812FX_FastLed.h"
 #include "../EffectHelper.h"
+#include "../MatrixLayout.h"
 
 bool ColorWavesEffect::init(WS2812FX* strip) {
     // Call base class standard initialization first
@@ -68,6 +69,11 @@ uint16_t ColorWavesEffect::update(WS2812FX* strip) {
     state.pseudotime += deltaMillis * msMultiplier;
     state.hue16 += deltaMillis * beatsin88(max((seg->beat88 * 4) / 10, 8), 5, 9);
     
+    if (MatrixLayout::within(runtime->start, runtime->length)) {
+        render2D(strip, brightThetaInc, brightDepth, hueInc);
+        return strip->getStripMinDelay();
+    }
+    
     // Initialize brightness theta for this frame
     uint16_t brightnessTheta = state.pseudotime;
     
@@ -107,6 +113,25 @@ uint16_t ColorWavesEffect::update(WS2812FX* strip) {
     return strip->getStripMinDelay();
 }
 
+void ColorWavesEffect::render2D(WS2812FX* strip, uint16_t brightThetaInc, uint8_t brightDepth, uint16_t hueInc) {
+    auto seg = strip->getSegment();
+    const CRGBPalette16& pal = *strip->getCurrentPalette();
+    const uint16_t* index = MatrixLayout::map();
+    
+    for (uint8_t y = 0; y < MatrixLayout::height(); y++) {
+        // Each row starts half a pixel step further along the waves (diagonal fronts)
+        uint16_t brightnessTheta = state.pseudotime + y * (brightThetaInc / 2);
+        uint16_t pixelHue16 = state.hue16 + y * (hueInc / 2);
+        for (uint8_t x = 0; x < MatrixLayout::width(); x++) {
+            uint8_t paletteIndex = scale8(shapeHue(pixelHue16), 240);
+            uint8_t brightness = calculateBrightness(brightnessTheta, brightDepth);
+            nblend(strip->leds[*index++], strip->ColorFromPaletteWithDistribution(pal, paletteIndex, brightness, seg->blendType), 128);
+            pixelHue16 += hueInc;
+            brightnessTheta += brightThetaInc;
+        }
+    }
+}
+
 void ColorWavesEffect::calculateWaveParameters(uint16_t speed, 
                                                uint8_t& brightDepth,
                                                uint16_t& brightThetaInc,
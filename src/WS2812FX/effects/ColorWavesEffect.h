@@ -27,6 +27,7 @@
  * 
  * The implementation uses precise sine wave mathematics to ensure smooth,
  * organic-looking wave motion without jarring transitions.
+ * On a matrix (MatrixLayout) the waves run along the rows with diagonal fronts.
  */
 class ColorWavesEffect : public Effect {
 public:
@@ -56,6 +57,11 @@ private:
         uint8_t multiplier;       ///< Time multiplier for animation speed
     } state;
 
+    /**
+     * @brief Render the waves on the matrix - along the rows, each row shifted by half a pixel step
+     */
+    void render2D(WS2812FX* strip, uint16_t brightThetaInc, uint8_t brightDepth, uint16_t hueInc);
+
     /**
      * @brief Calculate wave parameters based on speed setting
      * @param speed Speed parameter from segment configuration (beat88)
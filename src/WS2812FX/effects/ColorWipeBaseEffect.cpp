@@ -124,8 +124,8 @@ uint16_t ColorWipeBaseEffect::update(WS2812FX* strip) {
     
     // Calculate wipe position using subclass-specific method
     // This returns a value in range 0-65535
-    // Use millis() as timebase for consistent timing
-    uint16_t wavePosition = calculateWipePosition(strip, millis());
+    // Use the timebase of the strip (in phase with the strips in sync)
+    uint16_t wavePosition = calculateWipePosition(strip, strip->getEffectTimebase());
     
     // Check if direction actually changed 
     if (((wavePosition > previousWavePosition) && !isMovingUp) || 
@@ -8,10 +8,10 @@ bool DotBeatEffect::init(WS2812FX* strip) {
         return false;
     }
     
-    // Initialize effect-specific state
+    // Initialize effect-specific state - the bars start with the next update
+    // (an instance initialized again keeps its array)
     lastBeat88 = 0;
     numBars = 0;
-    barStates = nullptr;
     
     return true;
 }
@@ -20,25 +20,26 @@ void DotBeatEffect::initializeBars(WS2812FX* strip) {
     auto seg = strip->getSegment();
     if (!seg) return;
     
-    // Clean up existing allocation
-    if (barStates) {
+    // Set number of bars from segment setting, default to 3
+    const uint8_t bars = seg->numBars ? seg->numBars : 3;
+    
+    // Allocate memory for bar states (again only for another number of bars)
+    if (barStates && allocatedBars != bars) {
         delete[] barStates;
         barStates = nullptr;
     }
-    
-    // Set number of bars from segment setting, default to 3
-    numBars = seg->numBars;
-    if (numBars == 0) numBars = 3;
-    
-    // Allocate memory for bar states  
-    barStates = new BarState[numBars];
+    if (!barStates) {
+        barStates = new BarState[bars];
+        allocatedBars = barStates ? bars : 0;
+    }
     if (!barStates) {
         numBars = 0;
         return;
     }
+    numBars = bars;
     
     // Initialize each bar with random parameters
-    uint32_t currentTime = millis();
+    uint32_t currentTime = strip->getEffectTimebase();
     for (uint8_t i = 0; i < numBars; i++) {
         // Create varied speeds by dividing and multiplying beat88
         uint8_t divisor = random8(MIN_BEAT, MAX_BEAT_MULTIPLIER + 1);
@@ -106,7 +107,7 @@ void DotBeatEffect::updateBarColor(uint8_t barIndex, uint16_t position, WS2812FX
     if (position == runtime->start * 16) {
         // Reset timebase if needed
         if (barStates[barIndex].newBase) {
-            barStates[barIndex].timebase = millis();
+            barStates[barIndex].timebase = GET_MILLIS();  // the clock of beat88()
             barStates[barIndex].newBase = false;
         }
         
@@ -152,7 +153,7 @@ uint16_t DotBeatEffect::update(WS2812FX* strip) {
     }
     
     // Initialize bars on first run or if numBars changed
-    if (!barStates || numBars != seg->numBars) {
+    if (!barStates || !numBars || numBars != (seg->numBars ? seg->numBars : 3)) {
         initializeBars(strip);
     }
     
@@ -202,6 +203,7 @@ void DotBeatEffect::cleanup() {
         delete[] barStates;
         barStates = nullptr;
     }
+    allocatedBars = 0;
     numBars = 0;
 }
 
@@ -32,6 +32,7 @@ private:
     uint16_t lastBeat88 = 0;     ///< Last beat88 value for change detection
     BarState* barStates = nullptr; ///< Dynamic array of bar states
     uint8_t numBars = 0;         ///< Number of active bars
+    uint8_t allocatedBars = 0;   ///< Number of bar states allocated
     
     // Constants - no fading for color wipe effect
     static const uint8_t FADE_AMOUNT = 0;     ///< No background fade 
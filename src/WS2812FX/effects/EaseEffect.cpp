@@ -16,7 +16,7 @@ bool EaseEffect::init(WS2812FX* strip) {
     beat = seg->beat88;
     oldbeat = seg->beat88;
     p_lerp = 0;
-    timebase = millis();
+    timebase = strip->getEffectTimebase();
     
     return true;
 }
@@ -62,7 +62,7 @@ uint16_t EaseEffect::update(WS2812FX* strip) {
             
             // Reset trigger and timebase for smooth animation
             trigger = false;
-            timebase = millis();
+            timebase = GET_MILLIS();  // the clock of beat88()
             
             // Randomly adjust beat speed
             if (beat < 255) {
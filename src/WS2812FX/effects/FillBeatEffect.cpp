@@ -24,21 +24,22 @@ uint16_t FillBeatEffect::update(WS2812FX* strip) {
     
     // Calculate base parameters for the effect
     uint8_t reducedBeat = seg->beat88 >> 8; // Reduce beat for slower color changes
+    const uint32_t timebase = strip->getEffectTimebase();
     
     // Process each LED in the segment
     for (uint16_t k = runtime->start; k < runtime->stop; k++) {
         // Calculate position-dependent brightness using beatsin88
         // Each LED has a phase offset (k * 2) to create a wave across the strip
         uint8_t brightness = beatsin88(seg->beat88, MIN_BRIGHTNESS, MAX_BRIGHTNESS, 
-                                     millis(), (k - runtime->start) * 2);
+                                     timebase, (k - runtime->start) * 2);
         
         // Calculate complex color index using multiple wave components:
         
         // 1. Base triangular wave from beat timing
-        uint8_t baseTriWave = triwave8(beat8(reducedBeat));
+        uint8_t baseTriWave = triwave8(beat8(reducedBeat, timebase));
         
         // 2. Additional oscillation with beatsin8 for variation
-        uint8_t oscillation = beatsin8(reducedBeat, 0, 20);
+        uint8_t oscillation = beatsin8(reducedBeat, 0, 20, timebase);
         
         // 3. Position-dependent component mapped to LED position
         uint8_t positionComponent = map((uint16_t)k, 
@@ -1,6 +1,7 @@
 #include "Fire2012Effect.h"
 #include "../WS2812FX_FastLed.h"
 #include "../EffectHelper.h"
+#include "../MatrixLayout.h"
 
 bool Fire2012Effect::init(WS2812FX* strip) {
     // Call base class standard initialization first
@@ -11,6 +12,32 @@ bool Fire2012Effect::init(WS2812FX* strip) {
         
     // Clear heat array to start with a cold fire
     memset(heatArray, 0, heatArraySize * sizeof(byte));
+
+    // Without the table the colors get calculated per pixel
+    buildHeatColors();
+
+    auto runtime = strip->getSegmentRuntime();
+    onMatrix = MatrixLayout::within(runtime->start, runtime->length);
+    if (onMatrix) {
+        // One flame per column (the cells behind the matrix are not shown)
+        numFlames = MatrixLayout::width();
+        flameLength = MatrixLayout::height();
+    } else {
+#ifdef FIRE2012_FLAMES
+        // Split the segment into independent flames - each one needs a few cells to look like a flame
+        const uint8_t maxFlames = max(heatArraySize / 8, 1);
+        numFlames = constrain(strip->getSegment()->numBars, 1, max(MAX_NUM_BARS, 1));
+        if (numFlames > maxFlames) {
+            numFlames = maxFlames;
+        }
+#else
+        // One flame along the segment (as always)
+        numFlames = 1;
+#endif
+        flameLength = heatArraySize / numFlames;
+    }
+
+    rng.setSeed(RandomPool::effectSeed(getModeId()));
     
     return true;
 }
@@ -93,68 +120,114 @@ void Fire2012Effect::freeHeatArray() {
     size_t currentSize = heatArraySize; // Convert to size_t for helper function
     EffectHelper::safeFreeArray((void*&)heatArray, currentSize);
     heatArraySize = (uint16_t)currentSize; // Update the class member (should be 0)
+
+    size_t colorsSize = heatColors ? 256 : 0;
+    EffectHelper::safeFreeArray((void*&)heatColors, colorsSize);
+}
+
+bool Fire2012Effect::buildHeatColors() {
+    if (heatColors != nullptr) {
+        return true; // the palette is constant - computed once
+    }
+    heatColors = (CRGB*)malloc(256 * sizeof(CRGB));
+    if (heatColors == nullptr) {
+        return false;
+    }
+    // Scale heat value from 0-255 down to 0-240
+    // This provides the best color range in most heat palettes
+    for (uint16_t h = 0; h < 256; h++) {
+        heatColors[h] = ColorFromPalette(HeatColors_p, scale8(h, 240));
+    }
+    return true;
 }
 
 void Fire2012Effect::performCooling(WS2812FX* strip) {
     auto seg = strip->getSegment();
-    auto runtime = strip->getSegmentRuntime();
     
     // Cool down every heat cell by a random amount
-    // The cooling rate is based on the cooling parameter and strip length
-    for (uint16_t i = 0; i < runtime->length; i++) {
-        // Calculate cooling amount: random value based on cooling setting
-        // Longer strips have proportionally less cooling to maintain fire density
-        uint8_t coolingAmount = random8(0, ((seg->cooling * 10) / runtime->length) + 2);
-        
-        // Apply cooling with qsub8 to prevent underflow
-        heatArray[i] = qsub8(heatArray[i], coolingAmount);
+    // The cooling rate is based on the cooling parameter and the flame length:
+    // longer flames have proportionally less cooling to maintain fire density
+    for (uint8_t f = 0; f < numFlames; f++) {
+        byte* heat = &heatArray[flameStart(f)];
+        uint16_t cells = flameCells(f);
+        uint16_t limit = (seg->cooling * 10) / cells + 2;
+        if (limit > 256) {
+            limit = 256;
+        }
+        // random8(0, limit) is (random byte * limit) >> 8 - four cells per PRNG call
+        while (cells) {
+            uint32_t r = rng.next();
+            for (uint8_t b = 0; b < 4 && cells; b++, cells--, heat++, r >>= 8) {
+                // Apply cooling with qsub8 to prevent underflow
+                *heat = qsub8(*heat, ((r & 0xFF) * limit) >> 8);
+            }
+        }
     }
 }
 
 void Fire2012Effect::performHeatDiffusion(WS2812FX* strip) {
-    auto runtime = strip->getSegmentRuntime();
+    (void)strip;
     
     // Heat diffusion: each cell is influenced by the cells below it
     // Working from top to bottom to avoid affecting calculations
-    for (int k = runtime->length - 1; k >= 2; k--) {
-        // Each cell gets heat from the two cells below it, averaged
-        // This creates a natural upward heat flow pattern
-        heatArray[k] = (heatArray[k - 1] + heatArray[k - 2] + heatArray[k - 2]) / 3;
+    for (uint8_t f = 0; f < numFlames; f++) {
+        byte* heat = &heatArray[flameStart(f)];
+        for (int k = flameCells(f) - 1; k >= 2; k--) {
+            // Each cell gets heat from the two cells below it, averaged.
+            // x / 3 == (x * 683) >> 11 for all x <= 765 (3 * 255)
+            heat[k] = ((uint32_t)(heat[k - 1] + heat[k - 2] + heat[k - 2]) * 683) >> 11;
+        }
     }
 }
 
 void Fire2012Effect::performSparking(WS2812FX* strip) {
     auto seg = strip->getSegment();
     
-    // Randomly ignite new sparks near the bottom of the fire
+    // Randomly ignite new sparks near the bottom of each flame
     // Sparking parameter controls how often new heat sources appear
-    if (random8() < seg->sparking) {
-        // Choose a random position near the bottom (first 7 LEDs)
-        int sparkPosition = random8(7);
-        
-        // Add a random amount of heat to create the spark
-        // Heat value is high (160-255) to create bright, hot sparks
-        uint8_t sparkHeat = random8(160, 255);
-        heatArray[sparkPosition] = qadd8(heatArray[sparkPosition], sparkHeat);
+    for (uint8_t f = 0; f < numFlames; f++) {
+        if (RandomPool::random8() < seg->sparking) {
+            // Choose a random position near the bottom (first 7 cells)
+            const uint16_t cells = flameCells(f);
+            const uint16_t sparkPosition = flameStart(f) + RandomPool::random8(cells < 7 ? cells : 7);
+            
+            // Add a random amount of heat to create the spark
+            // Heat value is high (160-255) to create bright, hot sparks
+            uint8_t sparkHeat = RandomPool::random8(160, 255);
+            heatArray[sparkPosition] = qadd8(heatArray[sparkPosition], sparkHeat);
+        }
     }
 }
 
 void Fire2012Effect::mapHeatToColors(WS2812FX* strip) {
+    auto seg = strip->getSegment();
     auto runtime = strip->getSegmentRuntime();
+    CRGB* leds = &strip->leds[runtime->start];
     
     // Convert heat values to LED colors using heat palette
-    for (uint16_t j = 0; j < runtime->length; j++) {
-        // Scale heat value from 0-255 down to 0-240
-        // This provides the best color range in most heat palettes
-        byte colorIndex = scale8(heatArray[j], 240);
-        
-        // Get color from the heat palette
-        // Using HEAT_PAL (heat-based color palette) for realistic fire colors
-        // Heat palettes typically go from black -> red -> orange -> yellow -> white
-        CRGB color = ColorFromPalette(HeatColors_p, colorIndex);
-        
-        // Set the LED color
-        strip->leds[j + runtime->start] = color;
+    // Heat palettes typically go from black -> red -> orange -> yellow -> white
+    if (onMatrix) {
+        // The base of each flame is the bottom row of its column
+        const uint8_t bottom = MatrixLayout::height() - 1;
+        for (uint8_t f = 0; f < numFlames; f++) {
+            const byte* heat = &heatArray[flameStart(f)];
+            for (uint8_t j = 0; j <= bottom; j++) {
+                strip->leds[MatrixLayout::XY(f, bottom - j)] = heatColors ? heatColors[heat[j]] : ColorFromPalette(HeatColors_p, scale8(heat[j], 240));
+            }
+        }
+        return;
+    }
+    
+    for (uint8_t f = 0; f < numFlames; f++) {
+        const byte* heat = &heatArray[flameStart(f)];
+        const uint16_t cells = flameCells(f);
+        CRGB* out = &leds[flameStart(f)];
+        // mirrored: every second flame burns downwards (a single flame never)
+        const bool mirrored = seg->mirror && (f & 0x01);
+        for (uint16_t j = 0; j < cells; j++) {
+            const CRGB color = heatColors ? heatColors[heat[j]] : ColorFromPalette(HeatColors_p, scale8(heat[j], 240));
+            out[mirrored ? cells - 1 - j : j] = color;
+        }
     }
 }
 
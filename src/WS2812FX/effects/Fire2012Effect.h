@@ -2,6 +2,7 @@
 #define FIRE2012_EFFECT_H
 
 #include "../Effect.h"
+#include "../FastRandom.h"
 
 /**
  * @brief Fire 2012 effect - realistic fire simulation with heat diffusion
@@ -22,6 +23,15 @@
  * 
  * This implementation maintains its own heat array rather than using
  * shared segment runtime memory, minimizing external resource dependencies.
+ *
+ * The segment holds one flame. Built with FIRE2012_FLAMES it holds "numBars"
+ * independent flames instead - with "mirrored" every second flame burns
+ * downwards (the flames meet at their base / tip).
+ * On a matrix (MatrixLayout) every column is a flame burning upwards.
+ *
+ * Fast path: the cooling takes four random bytes per PRNG call, the diffusion
+ * divides by a multiply-shift and the colors come from a 256 entry heat table
+ * being computed once (on init) from the heat palette.
  */
 class Fire2012Effect : public Effect {
 public:
@@ -48,6 +58,25 @@ private:
      */
     uint16_t heatArraySize = 0;
     
+    /**
+     * @brief Colors of all heat values (ColorFromPalette(HeatColors_p, scale8(heat, 240)))
+     * Allocated while the effect is active (768 bytes)
+     */
+    CRGB* heatColors = nullptr;
+
+    /**
+     * @brief Number of independent flames and the cells per flame
+     * The last flame also takes the remaining cells (not on a matrix)
+     */
+    uint8_t numFlames = 1;
+    uint16_t flameLength = 0;
+    bool onMatrix = false;      ///< one flame per column of the matrix
+
+    /**
+     * @brief Generator for the cooling (seeded per activation)
+     */
+    FastRandom rng;
+
     /**
      * @brief Flag to track initialization state
      * Ensures heat array is properly allocated and cleared on first activation
@@ -67,10 +96,22 @@ private:
     bool allocateHeatArray(WS2812FX* strip);
     
     /**
-     * @brief Free the allocated heat array
+     * @brief Free the allocated heat array (and the heat colors)
      * Called during cleanup to prevent memory leaks
      */
     void freeHeatArray();
+
+    /**
+     * @brief Compute the heat color table (once)
+     * @return true if the table is available
+     */
+    bool buildHeatColors();
+
+    /**
+     * @brief First cell and number of cells of flame "f"
+     */
+    inline uint16_t flameStart(uint8_t f) const { return f * flameLength; }
+    inline uint16_t flameCells(uint8_t f) const { return (f + 1 == numFlames && !onMatrix) ? heatArraySize - f * flameLength : flameLength; }
     
     /**
      * @brief Perform cooling step of fire simulation
@@ -1,6 +1,7 @@
 #include "FireworkEffect.h"
 #include "../WS2812FX_FastLed.h"
 #include "../EffectHelper.h"
+#include "../FastRandom.h"
 
 bool FireworkEffect::init(WS2812FX* strip) {
     // Call base class standard initialization first
@@ -8,10 +9,11 @@ bool FireworkEffect::init(WS2812FX* strip) {
         return false;
     }
     
-    // Initialize all firework state arrays to empty/inactive state
-    memset(fireworkPositions, 0, sizeof(fireworkPositions));
-    memset(colorIndices, 0, sizeof(colorIndices));
-    memset(burnTimeRemaining, 0, sizeof(burnTimeRemaining));
+    // (Re-)initialization starts without burning fireworks
+    if (!ParticleSystem::acquire(group)) {
+        return false;
+    }
+    lastStep = millis();
     
     // Clear the entire LED strip using EffectHelper
     EffectHelper::clearSegment(strip);
@@ -36,52 +38,36 @@ uint16_t FireworkEffect::update(WS2812FX* strip) {
     uint8_t blurAmount = EffectHelper::safeMapuint16_t(seg->beat88 >> 8, 0, 255, 32, 172);
     blur1d(&strip->leds[runtime->start], runtime->length, blurAmount);
     
-    // Update existing fireworks - decrease burn time and render
-    for (uint8_t i = 0; i < MAX_FIREWORKS; i++) {
-        if (burnTimeRemaining[i] > 0) {
-            // Decrease burn time (firework fades over time)
-            burnTimeRemaining[i]--;
-            
-            // Render the firework with palette color and blending
-            CRGB fireworkColor = strip->ColorFromPaletteWithDistribution(
-                *strip->getCurrentPalette(), 
-                colorIndices[i], 
-                255,                    // Full brightness
-                seg->blendType
-            );
-            
-            // Set firework pixel with additive blending for bright explosion effect
-            if (fireworkPositions[i] < runtime->length) {
-                strip->leds[runtime->start + fireworkPositions[i]] += fireworkColor;
-            }
-        }
-    }
-    
-    // Launch new fireworks based on probability calculated from speed setting
-    auto runtime_spawn = strip->getSegmentRuntime();
-    
-    // Calculate spawn probability using EffectHelper
-    uint8_t spawnProbability = max(6, runtime_spawn->length / 7);
-    uint8_t spawnThreshold = max(3, runtime_spawn->length / 14);
-    
-    if (random8(spawnProbability) <= spawnThreshold) {
+    // Burn down the fireworks - they do not move, their life is the remaining burn time
+    ParticleSystem::Physics physics;
+    physics.gravity = 0;
+    physics.drag = 0;
+    physics.bounce = 0;
+    physics.lower = 0;
+    physics.upper = (int32_t)runtime->length * 256;
+    const uint32_t now = millis();
+    const uint16_t dt = min(now - lastStep, (uint32_t)64);
+    lastStep = now;
+    ParticleSystem::step(group, dt, physics);
+    
+    // Render the fireworks with additive blending for bright explosion effect
+    ParticleSystem::render(group, strip, *strip->getCurrentPalette(), 0, true);
+    
+    // Calculate spawn probability from the segment length
+    uint8_t spawnProbability = max(6, runtime->length / 7);
+    uint8_t spawnThreshold = max(3, runtime->length / 14);
+    
+    if (RandomPool::random8(spawnProbability) <= spawnThreshold) {
         // Calculate minimum distance between fireworks to prevent clustering
         uint8_t minDistance = calculateMinDistance(strip);
         
-        // Try to find a good position for a new firework
-        uint16_t candidatePosition = random16(
-            minDistance + runtime_spawn->start, 
-            runtime_spawn->stop - minDistance
-        );
-        
-        // Check if the candidate position is clear
-        if (isPositionClear(candidatePosition, minDistance, strip)) {
-            // Find an available slot for the new firework
-            uint8_t availableSlot = findAvailableSlot();
+        // Try to find a good position for a new firework (within the segment)
+        if (runtime->length > 2 * minDistance) {
+            uint16_t candidatePosition = RandomPool::random16(minDistance, runtime->length - minDistance);
             
-            if (availableSlot != 0xff) {
-                // Spawn the new firework
-                spawnFirework(candidatePosition, availableSlot, strip);
+            // Spawn the new firework if the candidate position is clear
+            if (isPositionClear(candidatePosition, minDistance, strip)) {
+                spawnFirework(candidatePosition, strip);
             }
         }
     }
@@ -97,6 +83,15 @@ uint8_t FireworkEffect::getModeId() const {
     return FX_MODE_FIREWORK;
 }
 
+void FireworkEffect::cleanup() {
+    ParticleSystem::release(group);
+}
+
+// pooled and switched away from: the burning fireworks go, the group stays for the next init()
+void FireworkEffect::suspend() {
+    ParticleSystem::killAll(group);
+}
+
 uint8_t FireworkEffect::calculateMinDistance(WS2812FX* strip) const {
     auto runtime = strip->getSegmentRuntime();
     
@@ -110,13 +105,13 @@ bool FireworkEffect::isPositionClear(uint16_t position, uint8_t minDistance, WS2
     auto runtime = strip->getSegmentRuntime();
     
     // Check a range around the candidate position for existing light
-    for (int8_t offset = -minDistance; offset <= minDistance; offset++) {
-        uint16_t checkPosition = position + offset;
+    for (int16_t offset = -minDistance; offset <= minDistance; offset++) {
+        int16_t checkPosition = position + offset;
         
-        // Ensure position is within strip bounds
-        if (checkPosition >= runtime->start && checkPosition < runtime->stop) {
+        // Ensure position is within the segment
+        if (checkPosition >= 0 && checkPosition < runtime->length) {
             // If any LED in the range is already lit, position is not clear
-            if (!(strip->leds[checkPosition] == CRGB(0x0))) {
+            if (!(strip->leds[runtime->start + checkPosition] == CRGB(0x0))) {
                 return false;
             }
         }
@@ -125,41 +120,32 @@ bool FireworkEffect::isPositionClear(uint16_t position, uint8_t minDistance, WS2
     return true;
 }
 
-uint8_t FireworkEffect::findAvailableSlot() const {
-    // Look for a slot where the firework has finished burning
-    for (uint8_t i = 0; i < MAX_FIREWORKS; i++) {
-        if (burnTimeRemaining[i] == 0) {
-            return i;
-        }
+void FireworkEffect::spawnFirework(uint16_t position, WS2812FX* strip) {
+    const uint16_t i = ParticleSystem::spawn(group);
+    if (i == ParticleSystem::NONE) {
+        return; // all particles are burning
     }
-    
-    // No available slots - all fireworks still burning
-    return 0xff;
-}
-
-void FireworkEffect::spawnFirework(uint16_t position, uint8_t slotIndex, WS2812FX* strip) {
     auto seg = strip->getSegment();
     
-    // Store firework position
-    fireworkPositions[slotIndex] = position;
-    
     // Select a random color from the palette, avoiding too similar colors
     // get_random_wheel_index helps distribute colors across the palette
-    colorIndices[slotIndex] = EffectHelper::get_random_wheel_index(colorIndices[slotIndex], 64);
+    lastColor = EffectHelper::get_random_wheel_index(lastColor, 64);
     
-    // Set random burn time - fireworks last different amounts of time
-    // Shorter burns create quick flashes, longer burns create sustained sparkles
-    burnTimeRemaining[slotIndex] = random8(10, 30);
+    // The firework lights its LED
+    ParticleSystem::pos[i] = (int32_t)position * 256;
+    ParticleSystem::color[i] = lastColor;
+    ParticleSystem::bright[i] = 255;
+    
+    // Set random burn time - 10 to 30 frames (shorter burns create quick flashes)
+    ParticleSystem::life[i] = RandomPool::random8(10, 30) * strip->getStripMinDelay();
     
     // Immediately light up the LED with the firework color
-    CRGB fireworkColor = strip->ColorFromPaletteWithDistribution(
+    strip->leds[strip->getSegmentRuntime()->start + position] = strip->ColorFromPaletteWithDistribution(
         *strip->getCurrentPalette(),
-        colorIndices[slotIndex],
-        random8(192, 255),  // Random brightness for variety
+        lastColor,
+        RandomPool::random8(192, 255),  // Random brightness for variety
         seg->blendType
     );
-    
-    strip->leds[position] = fireworkColor;
 }
 
 // Register this effect with the factory
@@ -2,6 +2,7 @@
 #define FIREWORK_EFFECT_H
 
 #include "../Effect.h"
+#include "../ParticleSystem.h"
 
 /**
  * @brief Firework effect - simulates random firework explosions with fading trails
@@ -14,48 +15,37 @@
  * - Preventing fireworks from spawning too close to existing ones
  * - Using palette colors for varied firework colors
  * 
- * The effect maintains its own state for:
- * - Active firework positions and colors
- * - Burning duration for each firework
- * - Color indices for palette-based coloring
- * 
- * This implementation uses minimal external shared resources by managing
- * all firework state internally rather than using global runtime unions.
+ * The fireworks are particles of the shared ParticleSystem (position, color
+ * index and the remaining burn time as their life). Their number is only
+ * limited by the free space on the strip and the particle pool.
  */
 class FireworkEffect : public Effect {
 public:
     FireworkEffect() = default;
-    virtual ~FireworkEffect() = default;
+    virtual ~FireworkEffect() { cleanup(); }
 
     bool init(WS2812FX* strip) override;
     uint16_t update(WS2812FX* strip) override;
     const __FlashStringHelper* getName() const override;
     uint8_t getModeId() const override;
+    void cleanup() override;
+    void suspend() override;
 
 private:
     /**
-     * @brief Maximum number of simultaneous fireworks
-     * Limits memory usage while allowing for rich visual effects
-     */
-    static const uint8_t MAX_FIREWORKS = 8; // Using smaller value than MAX_NUM_BARS for memory efficiency
-    
-    /**
-     * @brief Array storing LED positions of active fireworks
-     * Each element contains the LED index where a firework is currently burning
+     * @brief Particle group holding the burning fireworks
      */
-    uint16_t fireworkPositions[MAX_FIREWORKS];
-    
+    uint8_t group = ParticleSystem::NO_GROUP;
+
     /**
-     * @brief Array storing color indices for each firework
-     * Used to select colors from the current palette for each firework
+     * @brief Color index of the last firework (the next one differs from it)
      */
-    uint8_t colorIndices[MAX_FIREWORKS];
-    
+    uint8_t lastColor = 0;
+
     /**
-     * @brief Array storing remaining burn time for each firework
-     * Counts down from initial value to 0, determining how long firework stays lit
+     * @brief Timestamp of the last physics step
      */
-    uint8_t burnTimeRemaining[MAX_FIREWORKS];
+    uint32_t lastStep = 0;
     
     /**
      * @brief Calculate minimum distance between fireworks
@@ -73,19 +63,12 @@ private:
      */
     bool isPositionClear(uint16_t position, uint8_t minDistance, WS2812FX* strip) const;
     
-    /**
-     * @brief Find an available slot for a new firework
-     * @return Index of available slot, or 0xff if all slots are occupied
-     */
-    uint8_t findAvailableSlot() const;
-    
     /**
      * @brief Spawn a new firework at the specified position
-     * @param position LED position for the new firework
-     * @param slotIndex Array index to store the firework data
+     * @param position LED position (within the segment) for the new firework
      * @param strip Pointer to WS2812FX instance for accessing helper functions
      */
-    void spawnFirework(uint16_t position, uint8_t slotIndex, WS2812FX* strip);
+    void spawnFirework(uint16_t position, WS2812FX* strip);
 };
 
 #endif // FIREWORK_EFFECT_H
\ No newline at end of file
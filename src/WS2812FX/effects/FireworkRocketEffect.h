@@ -2,6 +2,7 @@
 #define FIREWORK_ROCKET_EFFECT_H
 
 #include "../Effect.h"
+#include "../ParticleSystem.h"
 
 /**
  * @brief Firework Rocket effect - simulates rockets launching and exploding with realistic physics
@@ -16,120 +17,66 @@
  * - Supporting configurable explosion timing and brightness
  * 
  * The effect has three distinct phases for each rocket:
- * 1. Launch phase: Rocket accelerates upward with bright trail
- * 2. Explosion phase: Bright burst with expanding blur effect
- * 3. Fade phase: Gradual dimming and disappearance
+ * 1. Launch phase: Rocket decelerates upward under gravity with a glowing trail
+ * 2. Explosion phase: The rocket bursts into sparks flying apart (plus a white flash)
+ * 3. Fade phase: The sparks slow down, sink and fade out at the end of their life
  * 
- * The effect maintains its own state for:
- * - Individual rocket physics (position, velocity, explosion timing)
- * - Color indices for palette-based coloring
- * - Brightness and explosion state tracking
- * - Previous positions for motion trail effects
- * 
- * Physics simulation includes:
- * - Gravitational deceleration during ascent
+ * Rockets and sparks are particles of the shared ParticleSystem (two groups):
+ * - numBars rockets per PARTICLE_LEDS_PER_BAR LEDs
+ * - The explosion is timed by the life of the rocket (its fuse) - the rocket
+ *   explodes when it slowed down to a random fraction of its launch velocity
+ * - The number of sparks per explosion grows with the segment length
  * - Variable launch velocities for visual variety
- * - Explosion trigger based on velocity thresholds
- * - Realistic ballistic trajectories
- * 
- * This implementation uses minimal external shared resources by managing
- * all rocket state internally rather than using global runtime unions.
  */
 class FireworkRocketEffect : public Effect {
 public:
     FireworkRocketEffect() = default;
-    virtual ~FireworkRocketEffect() = default;
+    virtual ~FireworkRocketEffect() { cleanup(); }
 
     bool init(WS2812FX* strip) override;
     uint16_t update(WS2812FX* strip) override;
     const __FlashStringHelper* getName() const override;
     uint8_t getModeId() const override;
+    void cleanup() override;
+    void suspend() override;
 
 private:
     /**
-     * @brief Structure to hold complete state for each firework rocket
-     * Contains all physics, timing, and visual data needed to simulate one rocket
-     */
-    struct RocketData {
-        uint32_t timebase;         ///< Time reference for physics calculations (milliseconds)
-        double pos;                ///< Current position in millimeters from strip start
-        double v0;                 ///< Initial launch velocity (mm/ms)
-        double v;                  ///< Current velocity (mm/ms)
-        double v_explode;          ///< Velocity threshold for triggering explosion
-        uint16_t prev_pos;         ///< Previous LED position for motion effects
-        uint16_t explodeTime;      ///< Remaining explosion duration (decrements each frame)
-        uint8_t color_index;       ///< Index into current palette for rocket color
-        uint8_t brightness;        ///< Current brightness level (0-255)
-    };
-    
-    /**
-     * @brief Array storing physics and visual data for each active rocket
-     * Each element manages the complete lifecycle of one rocket
+     * @brief Particle groups of the rising rockets and of the sparks of the explosions
      */
-    RocketData rockets[32];  // Using reasonable limit based on MAX_NUM_BARS
+    uint8_t rocketGroup = ParticleSystem::NO_GROUP;
+    uint8_t sparkGroup = ParticleSystem::NO_GROUP;
     
     /**
-     * @brief Number of active rockets currently being simulated
-     * Determined by strip configuration (SEG.numBars)
+     * @brief Number of rockets in the air at most
+     * Determined by strip configuration (SEG.numBars) and length
      */
-    uint8_t numRockets;
-    
+    uint16_t numRockets = 0;
+
     /**
-     * @brief Flag to track initialization state
-     * Ensures rocket arrays are properly initialized on first activation
+     * @brief Color index of the last explosion (the next one differs)
      */
-    bool initialized;
-    
+    uint8_t lastColor = 0;
+
     /**
-     * @brief Calculate maximum launch velocity for rockets
-     * @param strip Pointer to WS2812FX instance for accessing strip parameters
-     * @param gravity Gravitational acceleration in mm/ms²
-     * @param segmentLength Physical length of LED segment in millimeters
-     * @return Maximum initial velocity in mm/ms
+     * @brief Timestamp of the last physics step
      */
-    double calculateMaxVelocity(WS2812FX* strip, double gravity, double segmentLength) const;
+    uint32_t lastStep = 0;
     
     /**
      * @brief Get gravitational acceleration based on effect parameters
      * @param strip Pointer to WS2812FX instance for accessing beat88 parameter
-     * @return Gravity value in mm/ms² (negative for downward acceleration)
-     */
-    double getGravity(WS2812FX* strip) const;
-    
-    /**
-     * @brief Calculate physical segment length in millimeters
-     * @param strip Pointer to WS2812FX instance for accessing segment data
-     * @return Segment length in millimeters
-     */
-    double calculateSegmentLength(WS2812FX* strip) const;
-    
-    /**
-     * @brief Update rocket physics and handle phase transitions
-     * @param rocketIndex Index of rocket to update
-     * @param strip Pointer to WS2812FX instance for accessing parameters
-     * @param currentTime Current time in milliseconds
-     * @param gravity Current gravitational acceleration
-     * @param segmentLength Physical segment length
-     * @param maxVelocity Maximum velocity for re-launch
+     * @return Gravity in particle units (negative for downward acceleration)
      */
-    void updateRocketPhysics(uint8_t rocketIndex, WS2812FX* strip, uint32_t currentTime, 
-                           double gravity, double segmentLength, double maxVelocity);
+    int32_t getGravity(WS2812FX* strip) const;
     
     /**
-     * @brief Render rocket in launch phase with motion trail
-     * @param rocketIndex Index of rocket to render
-     * @param strip Pointer to WS2812FX instance for rendering functions
-     * @param segmentLength Physical segment length for position mapping
-     */
-    void renderLaunchPhase(uint8_t rocketIndex, WS2812FX* strip, double segmentLength);
-    
-    /**
-     * @brief Render rocket in explosion phase with blur effects
-     * @param rocketIndex Index of rocket to render
-     * @param strip Pointer to WS2812FX instance for rendering functions
-     * @param maxBlendWidth Maximum width for blur effects
+     * @brief Calculate maximum launch velocity for rockets
+     * @param strip Pointer to WS2812FX instance for accessing strip parameters
+     * @param gravity Gravitational acceleration in particle units
+     * @return Maximum initial velocity in particle units
      */
-    void renderExplosionPhase(uint8_t rocketIndex, WS2812FX* strip, uint16_t maxBlendWidth);
+    int32_t calculateMaxVelocity(WS2812FX* strip, int32_t gravity) const;
     
     /**
      * @brief Apply global fading to create trail effects
@@ -138,29 +85,18 @@ private:
     void applyGlobalFade(WS2812FX* strip);
     
     /**
-     * @brief Check if rocket should be re-launched
-     * @param rocketIndex Index of rocket to check
-     * @return true if rocket should start new launch cycle
-     */
-    bool shouldRelaunch(uint8_t rocketIndex) const;
-    
-    /**
-     * @brief Initialize rocket for new launch cycle
-     * @param rocketIndex Index of rocket to initialize
-     * @param strip Pointer to WS2812FX instance for accessing parameters
-     * @param currentTime Current time in milliseconds
+     * @brief Launch a new rocket from the start of the segment
+     * @param gravity Current gravitational acceleration
      * @param maxVelocity Maximum velocity for launch
      */
-    void initializeRocketLaunch(uint8_t rocketIndex, WS2812FX* strip, uint32_t currentTime, double maxVelocity);
+    void launchRocket(int32_t gravity, int32_t maxVelocity);
     
     /**
-     * @brief Add sparkling effects around explosion for visual enhancement
-     * @param rocketIndex Index of the exploding rocket
-     * @param strip Pointer to WS2812FX instance for rendering functions
-     * @param explosionPos Position of the explosion in 16ths of pixels
-     * @param sparkRadius Maximum radius for spark placement
+     * @brief Replace the rocket by a burst of sparks
+     * @param rocketIndex Particle index of the exploding rocket
+     * @param strip Pointer to WS2812FX instance for accessing parameters
      */
-    void addExplosionSparks(uint8_t rocketIndex, WS2812FX* strip, uint16_t explosionPos, uint16_t sparkRadius);
+    void explodeRocket(uint16_t rocketIndex, WS2812FX* strip);
 };
 
 #endif // FIREWORK_ROCKET_EFFECT_H
\ No newline at end of file
@@ -9,8 +9,9 @@ bool JugglePalEffect::init(WS2812FX* strip) {
     }
     
     // Initialize effect-specific state
+    timebase = strip->getEffectTimebase();
     currentHue = 0;
-    lastHueChange = millis();
+    lastHueChange = timebase;
     
     return true;
 }
@@ -36,10 +37,10 @@ uint16_t JugglePalEffect::update(WS2812FX* strip) {
     }
     
     // Calculate bar width based on segment length, with minimum width
-    uint8_t barWidth = max((uint8_t)(runtime->length / 15), MIN_BAR_WIDTH);
+    uint8_t barWidth = max((uint8_t)(runtime->length / 15), (uint8_t)MIN_BAR_WIDTH);
     
     // Handle periodic hue changes for color variation
-    uint32_t currentTime = millis();
+    uint32_t currentTime = GET_MILLIS();
     if (currentTime - lastHueChange >= HUE_CHANGE_INTERVAL) {
         // Create subtle random variation in hue
         uint8_t previousHue = currentHue;
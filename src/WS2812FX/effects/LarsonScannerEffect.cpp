@@ -28,7 +28,7 @@ uint16_t LarsonScannerEffect::update(WS2812FX* strip) {
     EffectHelper::applyFadeEffect(strip, EffectHelper::MEDIUM_FADE);
     
     // Generate smooth bouncing motion using helper with increased speed
-    uint16_t triangularPosition = EffectHelper::calculateTrianglePosition(strip, millis(), EffectHelper::FAST_SPEED);
+    uint16_t triangularPosition = EffectHelper::calculateTrianglePosition(strip, strip->getEffectTimebase(), EffectHelper::FAST_SPEED);
     
     // Map the triangular wave to the strip position using helper
     uint16_t pos = EffectHelper::mapPositionToStrip(strip, triangularPosition);
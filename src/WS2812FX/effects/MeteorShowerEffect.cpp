@@ -1,6 +1,7 @@
 #include "MeteorShowerEffect.h"
 #include "../WS2812FX_FastLed.h"
 #include "../EffectHelper.h"
+#include "../FastRandom.h"
 
 bool MeteorShowerEffect::init(WS2812FX* strip) {
     // Call base class standard initialization first
@@ -8,25 +9,20 @@ bool MeteorShowerEffect::init(WS2812FX* strip) {
         return false;
     }
     
-    auto seg = strip->getSegment();
-    
-    // Initialize all meteor state arrays
-    // Clear all timebase, active status, and color indices
-    for (uint8_t i = 0; i < 10; i++) {  // MAX_NUM_BARS is typically 10
-        state.timebase[i] = 0;
-        state.actives[i] = false;
-        state.cind[i] = random8();  // Random color offset for each slot
+    // (Re-)initialization starts without meteors
+    if (!ParticleSystem::acquire(group)) {
+        return false;
     }
     
     // Initialize timing variables
     lastFadeTime = millis();
     lastSpawnTime = millis();
+    lastStep = millis();
+    lastColor = RandomPool::random8();
     
     // Start with first meteor active
-    if (seg->numBars > 0) {
-        state.timebase[0] = millis();
-        state.actives[0] = true;
-        state.cind[0] = random8();
+    if (strip->getSegment()->numBars > 0) {
+        spawnMeteor(strip);
     }
     
     setInitialized(true);
@@ -60,71 +56,70 @@ uint16_t MeteorShowerEffect::update(WS2812FX* strip) {
         lastFadeTime = currentTime;
     }
     
-    // Update and draw all active meteors
-    for (uint8_t i = 0; i < seg->numBars && i < 10; i++) {
-        if (state.actives[i]) {
-            // Calculate meteor position using beat88 function for smooth movement
-            // Position moves from top (stop) to bottom (start) of segment
-            uint16_t beatPos = EffectHelper::calculateBeatPosition(strip, state.timebase[i], EffectHelper::FAST_SPEED);
-            uint16_t pos16 = EffectHelper::safeMapuint16_t(beatPos, 0, 65535, 
-                                                 runtime->stop * 16, runtime->start * 16);
-            
-            // Draw the meteor at current position using helper
-            drawMeteor(strip, pos16, state.cind[i]);
-            
-            // Deactivate meteor when it reaches the bottom
-            if (!(pos16 / 16)) {
-                state.actives[i] = false;
-            }
-        }
-    }
+    // Move the meteors - they vanish when they reach the bottom
+    ParticleSystem::Physics physics;
+    physics.gravity = 0;
+    physics.drag = 0;
+    physics.bounce = 0;
+    physics.lower = 0;
+    physics.upper = (int32_t)runtime->length * 256;
+    const uint16_t dt = min(currentTime - lastStep, (uint32_t)64);
+    lastStep = currentTime;
+    ParticleSystem::step(group, dt, physics);
     
     // Spawn new meteors at regular intervals
     if (currentTime - lastSpawnTime >= SPAWN_INTERVAL) {
         // Check if spawn area is clear (minimum distance from bottom) using helper
         uint16_t minDistance = EffectHelper::calculateProportionalWidth(strip, 12, 1);
         
-        if (isSpawnAreaClear(strip, minDistance)) {
-            // Try to spawn a new meteor in an available slot
-            uint8_t availableSlot = findAvailableSlot(seg->numBars);
-            
-            // Random chance to spawn (1 in 4 chance) and available slot exists
-            if (availableSlot < 10 && !random8(4)) {
-                state.actives[availableSlot] = true;
-                state.timebase[availableSlot] = currentTime;
-                state.cind[availableSlot] = EffectHelper::get_random_wheel_index(state.cind[availableSlot], 42);
-                
-                // Draw initial meteor position using helper
-                uint16_t beatPos = EffectHelper::calculateBeatPosition(strip, state.timebase[availableSlot], EffectHelper::FAST_SPEED);
-                uint16_t initialPos = EffectHelper::safeMapuint16_t(beatPos, 0, 65535,
-                                                          runtime->stop * 16, runtime->start * 16);
-                drawMeteor(strip, initialPos, state.cind[availableSlot]);
-            }
+        // Up to numBars meteors per PARTICLE_LEDS_PER_BAR LEDs
+        const uint16_t metres = max((runtime->length + PARTICLE_LEDS_PER_BAR / 2) / PARTICLE_LEDS_PER_BAR, 1);
+        const uint16_t maxMeteors = seg->numBars * metres;
+        
+        // Random chance to spawn (1 in 4 chance) if the area is clear
+        if (ParticleSystem::count(group) < maxMeteors && isSpawnAreaClear(strip, minDistance) && !RandomPool::random8(4)) {
+            spawnMeteor(strip);
         }
         lastSpawnTime = currentTime;
     }
     
+    // Draw the meteors as short bars with fractional edges
+    ParticleSystem::render(group, strip, *strip->getCurrentPalette(), runtime->baseHue);
+    
     // Return minimum delay for smooth animation
     return strip->getStripMinDelay();
 }
 
-void MeteorShowerEffect::drawMeteor(WS2812FX* strip, uint16_t pos16, uint8_t colorIndex) {
-    // Draw meteor using fractional bar drawing for smooth movement
-    // The meteor appears as a short bright bar with the specified color offset
-    auto seg = strip->getSegment();
-    auto runtime = strip->getSegmentRuntime();
-    
-    CRGB meteorColor = strip->ColorFromPaletteWithDistribution(
-        *strip->getCurrentPalette(), 
-        runtime->baseHue + colorIndex,  // Add color variation
-        255,                           // Full brightness for meteor
-        seg->blendType
-    );
-    
-    // Use the strip's fractional bar drawing function for smooth positioning
-    // This draws a bar at fractional pixel positions for fluid movement
-    strip->drawFractionalBar(pos16, METEOR_WIDTH, *strip->getCurrentPalette(), 
-                           runtime->baseHue + colorIndex, 255, true, 0);
+void MeteorShowerEffect::cleanup() {
+    ParticleSystem::release(group);
+}
+
+// pooled and switched away from: the meteors go, the group stays
+void MeteorShowerEffect::suspend() {
+    ParticleSystem::killAll(group);
+}
+
+int32_t MeteorShowerEffect::meteorVelocity(WS2812FX* strip) const {
+    // beat88(beat88 * FAST_SPEED) sweeps once per 60000 * 256 / (beat88 * FAST_SPEED) ms
+    const uint64_t length = strip->getSegmentRuntime()->length;
+    const uint64_t bpm88 = (uint64_t)strip->getSegment()->beat88 * EffectHelper::FAST_SPEED;
+    return -(int32_t)((length * 256 * 1024 * bpm88) / (60000ULL * 256));
+}
+
+bool MeteorShowerEffect::spawnMeteor(WS2812FX* strip) {
+    const uint16_t i = ParticleSystem::spawn(group);
+    if (i == ParticleSystem::NONE) {
+        return false;
+    }
+    // Start at the end of the segment, moving towards its start
+    ParticleSystem::pos[i] = (int32_t)(strip->getSegmentRuntime()->length - 1) * 256;
+    ParticleSystem::vel[i] = meteorVelocity(strip);
+    ParticleSystem::size[i] = METEOR_WIDTH * 256;
+    ParticleSystem::bright[i] = 255;
+    // Random color offset - different from the last meteor
+    lastColor = EffectHelper::get_random_wheel_index(lastColor, 42);
+    ParticleSystem::color[i] = lastColor;
+    return true;
 }
 
 bool MeteorShowerEffect::isSpawnAreaClear(WS2812FX* strip, uint16_t minDistance) {
@@ -142,16 +137,6 @@ bool MeteorShowerEffect::isSpawnAreaClear(WS2812FX* strip, uint16_t minDistance)
     return true;  // Area is clear for spawning
 }
 
-uint8_t MeteorShowerEffect::findAvailableSlot(uint8_t maxMeteors) {
-    // Find first inactive meteor slot for spawning new meteor
-    for (uint8_t i = 0; i < maxMeteors && i < 10; i++) {
-        if (!state.actives[i]) {
-            return i;  // Found available slot
-        }
-    }
-    return 255;  // No available slots
-}
-
 const __FlashStringHelper* MeteorShowerEffect::getName() const {
     return F("Meteor Shower");
 }
@@ -161,4 +146,4 @@ uint8_t MeteorShowerEffect::getModeId() const {
 }
 
 // Register this effect with the factory
-REGISTER_EFFECT(FX_MODE_RAIN, MeteorShowerEffect)
\ No newline at end of file
+REGISTER_EFFECT(FX_MODE_RAIN, MeteorShowerEffect)
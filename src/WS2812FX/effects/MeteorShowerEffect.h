@@ -2,6 +2,7 @@
 #define METEOR_SHOWER_EFFECT_H
 
 #include "../Effect.h"
+#include "../ParticleSystem.h"
 
 /**
  * @brief Meteor Shower effect - creates falling meteor-like streaks across the LED strip
@@ -14,39 +15,43 @@
  * - Speed setting controls both fade rate and meteor spawn frequency
  * - Number of simultaneous meteors is configurable via numBars setting
  * 
- * The meteors are drawn as short bars that move down the strip using fractional positioning
- * for smooth movement. Each meteor has a random color offset from the base hue to create
- * visual variety in the shower.
+ * The meteors are particles of the shared ParticleSystem falling with a constant
+ * speed - up to numBars meteors per PARTICLE_LEDS_PER_BAR LEDs. They are drawn as short
+ * spans with fractional (sub-pixel) edges. Each meteor has a random color offset from
+ * the base hue to create visual variety in the shower.
  */
 class MeteorShowerEffect : public Effect {
 public:
     MeteorShowerEffect() = default;
-    virtual ~MeteorShowerEffect() = default;
+    virtual ~MeteorShowerEffect() { cleanup(); }
 
     bool init(WS2812FX* strip) override;
     uint16_t update(WS2812FX* strip) override;
     const __FlashStringHelper* getName() const override;
     uint8_t getModeId() const override;
+    void cleanup() override;
+    void suspend() override;
 
 private:
-    // Internal state variables - moved from segment runtime union
-    // Arrays sized for maximum possible meteors (MAX_NUM_BARS)
-    struct {
-        uint32_t timebase[10];    ///< Individual start times for each meteor (MAX_NUM_BARS limit)
-        uint8_t actives[10];      ///< Active status for each meteor slot (boolean array)
-        uint8_t cind[10];         ///< Color index offset for each meteor (for color variation)
-    } state;
-    
+    uint8_t group = ParticleSystem::NO_GROUP;   ///< Particle group holding the meteors
+    uint8_t lastColor = 0;        ///< Color index of the last meteor (the next one differs)
     uint32_t lastFadeTime;        ///< Timestamp for fade timing control
     uint32_t lastSpawnTime;       ///< Timestamp for meteor spawn timing control
+    uint32_t lastStep;            ///< Timestamp of the last physics step
     
     /**
-     * @brief Draw a meteor at the specified position with fractional positioning
+     * @brief Falling speed of the meteors (one sweep of the segment per beat88 * FAST_SPEED beat)
+     * @param strip Pointer to the WS2812FX instance
+     * @return Velocity in particle units (negative - towards the segment start)
+     */
+    int32_t meteorVelocity(WS2812FX* strip) const;
+
+    /**
+     * @brief Start a new meteor at the end of the segment
      * @param strip Pointer to the WS2812FX instance
-     * @param pos16 Position in 16-bit fractional format (position * 16)
-     * @param colorIndex Color index offset for this meteor
+     * @return true if a particle was available
      */
-    void drawMeteor(WS2812FX* strip, uint16_t pos16, uint8_t colorIndex);
+    bool spawnMeteor(WS2812FX* strip);
     
     /**
      * @brief Check if there's sufficient distance from the end for a new meteor
@@ -55,13 +60,6 @@ private:
      * @return true if area is clear for new meteor
      */
     bool isSpawnAreaClear(WS2812FX* strip, uint16_t minDistance);
-    
-    /**
-     * @brief Find an inactive meteor slot for spawning a new meteor
-     * @param maxMeteors Maximum number of meteors to check
-     * @return Index of available slot, or 255 if none available
-     */
-    uint8_t findAvailableSlot(uint8_t maxMeteors);
 
     // Timing constants
     static const uint32_t FADE_INTERVAL = 20;    ///< Milliseconds between fade operations
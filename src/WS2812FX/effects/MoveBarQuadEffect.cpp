@@ -37,7 +37,7 @@ uint16_t MoveBarQuadEffect::update(WS2812FX* strip) {
 
 uint16_t MoveBarQuadEffect::calculateQuadPosition(WS2812FX* strip, uint16_t speed, uint16_t width) {
     // Use triangle wave for smooth movement with quadratic easing
-    uint16_t beatPosition = EffectHelper::calculateBeatPosition(strip, millis(), speed / 32768);
+    uint16_t beatPosition = beat88(speed / 2, strip->getEffectTimebase());
     uint16_t triangleWave = EffectHelper::generateTriangleWave(beatPosition, 0, 255);
     
     // Apply quadratic easing for dramatic acceleration/deceleration
@@ -27,7 +27,7 @@ uint16_t MoveBarSawtoothEffect::update(WS2812FX* strip) {
     EffectHelper::applyFadeEffect(strip, fadeAmount);
     
     // Calculate triangle position for sawtooth movement using EffectHelper
-    uint16_t beatPosition = EffectHelper::calculateBeatPosition(strip, millis(), speed / 32768);
+    uint16_t beatPosition = beat88(speed / 2, strip->getEffectTimebase());
     uint16_t trianglePosition = EffectHelper::generateTriangleWave(beatPosition, 0, width * 16);
     
     // Draw the moving bar using EffectHelper
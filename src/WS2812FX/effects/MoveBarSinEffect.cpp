@@ -30,7 +30,7 @@ uint16_t MoveBarSinEffect::update(WS2812FX* strip) {
     EffectHelper::applyFadeEffect(strip, fadeAmount);
     
     // Calculate the sine wave position for smooth movement
-    uint16_t position = calculateSinePosition(speed, width);
+    uint16_t position = calculateSinePosition(speed, width, strip->getEffectTimebase());
     
     // Draw the moving bar at the calculated position
     drawMovingBar(strip, position, width);
@@ -38,10 +38,10 @@ uint16_t MoveBarSinEffect::update(WS2812FX* strip) {
     return strip->getStripMinDelay();
 }
 
-uint16_t MoveBarSinEffect::calculateSinePosition(uint16_t speed, uint16_t width) {
+uint16_t MoveBarSinEffect::calculateSinePosition(uint16_t speed, uint16_t width, uint32_t timebase) {
     // Use beatsin16 for smooth sine wave movement
     // The bar oscillates from position 0 to (width * 16) for fractional positioning
-    return beatsin16(speed / 2, 0, width * 16, millis());
+    return beatsin16(speed / 2, 0, width * 16, timebase);
 }
 
 void MoveBarSinEffect::applyBackgroundFade(WS2812FX* strip, uint16_t speed) {
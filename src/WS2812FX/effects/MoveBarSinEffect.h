@@ -31,9 +31,20 @@ private:
      * @brief Calculate the sine wave position for the moving bar
      * @param speed The calculated speed value for the animation
      * @param width The width of the bar (half strip length)
+     * @param timebase The timebase of the strip (see WS2812FX::getEffectTimebase)
      * @return 16-bit fractional position for smooth movement
      */
-    uint16_t calculateSinePosition(uint16_t speed, uint16_t width);
+    uint16_t calculateSinePosition(uint16_t speed, uint16_t width, uint32_t timebase);
+
+    /**
+     * @brief Draw the bar at the fractional position
+     */
+    void drawMovingBar(WS2812FX* strip, uint16_t position, uint16_t width);
+
+    /**
+     * @brief Unused - the fade is done in update()
+     */
+    void applyBackgroundFade(WS2812FX* strip, uint16_t speed);
 };
 
 #endif // MOVE_BAR_SIN_EFFECT_H
\ No newline at end of file
@@ -9,7 +9,7 @@ bool MultiDynamicEffect::init(WS2812FX* strip) {
     }
     
     // Initialize private state variables
-    nextUpdate = 0;         // Reset timer to trigger immediate update
+    nextUpdate = strip->getEffectTimebase();  // immediate update (at the start of the effect)
     lastColorIndex = 0;     // Start with first palette index
     
     return true;
@@ -27,11 +27,11 @@ uint16_t MultiDynamicEffect::update(WS2812FX* strip) {
     auto seg = strip->getSegment();
     auto runtime = strip->getSegmentRuntime();
     
-    // Get current system time
-    uint32_t currentTime = millis();
+    // Get the time of the strip (the clock of the strips in sync)
+    uint32_t currentTime = GET_MILLIS();
     
     // Check if it's time to update colors based on speed setting
-    if (currentTime > nextUpdate) {
+    if ((int32_t)(currentTime - nextUpdate) >= 0) {
         
         // Update all LEDs in the segment with new random colors
         for (uint16_t i = runtime->start; i <= runtime->stop; i++) {
@@ -52,7 +52,9 @@ uint16_t MultiDynamicEffect::update(WS2812FX* strip) {
         
         // Calculate next update time using EffectHelper safe mapping
         uint32_t interval = EffectHelper::safeMapuint16_t(seg->beat88, 0, BEAT88_MAX, 255, 4) << 4;
-        nextUpdate = currentTime + interval;
+        // (on the grid of the timebase - the strips in sync change at the same time)
+        nextUpdate += interval;
+        if ((int32_t)(currentTime - nextUpdate) >= 0) nextUpdate = currentTime + interval;
     }
     
     return strip->getStripMinDelay();
@@ -1,6 +1,7 @@
 #include "NoiseMoverEffect.h"
 #include "../WS2812FX_FastLed.h"
 #include "../EffectHelper.h"
+#include "../MatrixLayout.h"
 
 bool NoiseMoverEffect::init(WS2812FX* strip) {
     // Call base class standard initialization first
@@ -34,6 +35,13 @@ uint16_t NoiseMoverEffect::update(WS2812FX* strip) {
         return strip->getStripMinDelay();
     }
     
+    if (MatrixLayout::within(runtime->start, runtime->length)) {
+        EffectHelper::applyFadeEffect(strip, FADE_AMOUNT);
+        render2D(strip);
+        noiseDist += beatsin88(seg->beat88, 1, 12, timebase);
+        return strip->getStripMinDelay();
+    }
+    
     // Calculate noise-based position
     // Use segment length as X-scale for noise to create position-dependent variation
     uint16_t xScale = runtime->length;
@@ -78,6 +86,38 @@ uint16_t NoiseMoverEffect::update(WS2812FX* strip) {
     return strip->getStripMinDelay();
 }
 
+void NoiseMoverEffect::render2D(WS2812FX* strip) {
+    auto runtime = strip->getSegmentRuntime();
+    const uint8_t width = MatrixLayout::width();
+    const uint8_t height = MatrixLayout::height();
+    
+    // Position of the spot (1/16 pixel) - x and y from independent noise
+    const int16_t cx = ((uint16_t)inoise8(runtime->length, noiseDist) * (width - 1) * 16) / 255;
+    const int16_t cy = ((uint16_t)inoise8(noiseDist + NOISE_Y_SCALE, runtime->length) * (height - 1) * 16) / 255;
+    const uint8_t colorIndex = runtime->baseHue + (uint8_t)(cx + cy) / 4;
+    const CRGBPalette16& pal = *strip->getCurrentPalette();
+    
+    // The pixels around the centre get lit by their distance (anti-aliased edge)
+    const int16_t r16 = SPOT_RADIUS * 16;
+    const int32_t r2 = (int32_t)r16 * r16;
+    for (int16_t y = (cy - r16) / 16; y <= (cy + r16) / 16 + 1; y++) {
+        for (int16_t x = (cx - r16) / 16; x <= (cx + r16) / 16 + 1; x++) {
+            const uint16_t i = MatrixLayout::XYsafe(x, y);
+            if (i == MatrixLayout::NONE) {
+                continue;
+            }
+            const int32_t dx = x * 16 - cx;
+            const int32_t dy = y * 16 - cy;
+            const int32_t d2 = dx * dx + dy * dy;
+            if (d2 >= r2) {
+                continue;
+            }
+            const uint8_t brightness = 255 - (d2 * 255) / r2;
+            strip->leds[i] |= strip->ColorFromPaletteWithDistribution(pal, colorIndex, brightness, strip->getSegment()->blendType);
+        }
+    }
+}
+
 const __FlashStringHelper* NoiseMoverEffect::getName() const {
     return F("iNoise8");
 }
@@ -10,6 +10,7 @@
  * The position is determined by Perlin noise (inoise8), which creates smooth,
  * organic movement patterns. The bar has a fixed width and the background
  * fades out over time, creating trailing effects.
+ * On a matrix (MatrixLayout) a round spot moves with the noise along both axes.
  */
 class NoiseMoverEffect : public Effect {
 public:
@@ -22,6 +23,11 @@ public:
     uint8_t getModeId() const override;
 
 private:
+    /**
+     * @brief Draw the spot at the noise position on the matrix
+     */
+    void render2D(WS2812FX* strip);
+
     uint32_t timebase = 0;      ///< Time reference for noise calculations
     uint16_t noiseDist = 1234;  ///< Distance parameter for noise function
     bool initialized = false;   ///< Initialization flag to ensure proper setup
@@ -30,6 +36,7 @@ private:
     static const uint16_t NOISE_Y_SCALE = 30;  ///< Y-axis scale for noise
     static const uint16_t BAR_WIDTH = 6;       ///< Width of the moving bar
     static const uint8_t FADE_AMOUNT = 48;     ///< Amount to fade background
+    static const uint8_t SPOT_RADIUS = 2;      ///< Radius of the spot on a matrix (pixels)
 };
 
 #endif // NOISE_MOVER_EFFECT_H
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "PlasmaEffect.h"
 #include "../WS2812FX_FastLed.h"
 #include "../EffectHelper.h"
+#include "../MatrixLayout.h"
 
 uint16_t PlasmaEffect::update(WS2812FX* strip) {
     // Check if effect needs initialization
@@ -24,13 +25,18 @@ uint16_t PlasmaEffect::update(WS2812FX* strip) {
     
     // Calculate phase values for the two wave components
     // Primary phase - standard beat-based oscillation
-    uint8_t primaryPhase = beatsin88(seg->beat88, 0, 255, millis());
+    uint8_t primaryPhase = beatsin88(seg->beat88, 0, 255, strip->getEffectTimebase());
     
     // Secondary phase - slightly faster oscillation (11/10 * beat88) for complex interaction
-    uint8_t secondaryPhase = beatsin88((seg->beat88 * 11) / 10, 0, 255, millis());
+    uint8_t secondaryPhase = beatsin88((seg->beat88 * 11) / 10, 0, 255, strip->getEffectTimebase());
     
     // Additional phase for brightness modulation - even faster (12/10 * beat88)
-    uint8_t brightnessModulator = beatsin88((seg->beat88 * 12) / 10, 0, 128);
+    uint8_t brightnessModulator = beatsin88((seg->beat88 * 12) / 10, 0, 128, strip->getEffectTimebase());
+    
+    if (MatrixLayout::within(runtime->start, runtime->length)) {
+        render2D(strip, primaryPhase, secondaryPhase, brightnessModulator);
+        return strip->getStripMinDelay();
+    }
     
     // Process each LED in the segment
     for (int k = runtime->start; k < runtime->stop; k++) {
@@ -68,6 +74,27 @@ uint16_t PlasmaEffect::update(WS2812FX* strip) {
     return strip->getStripMinDelay();
 }
 
+void PlasmaEffect::render2D(WS2812FX* strip, uint8_t primaryPhase, uint8_t secondaryPhase, uint8_t brightnessModulator) {
+    auto seg = strip->getSegment();
+    auto runtime = strip->getSegmentRuntime();
+    const CRGBPalette16& pal = *strip->getCurrentPalette();
+    const uint16_t* index = MatrixLayout::map();
+    
+    for (uint8_t y = 0; y < MatrixLayout::height(); y++) {
+        // Each wave runs along one axis and is shifted by half its frequency along the other
+        uint8_t cubicPhase = primaryPhase + y * (CUBIC_WAVE_FREQUENCY / 2);
+        uint8_t cosPhase = secondaryPhase + y * COS_WAVE_FREQUENCY;
+        for (uint8_t x = 0; x < MatrixLayout::width(); x++) {
+            uint8_t colorIndex = cubicwave8(cubicPhase) / 2 + cos8(cosPhase) / 2 + runtime->baseHue;
+            uint8_t brightness = qsuba(colorIndex, brightnessModulator);
+            CRGB& led = strip->leds[*index++];
+            led = nblend(led, strip->ColorFromPaletteWithDistribution(pal, colorIndex, brightness, seg->blendType), BLEND_AMOUNT);
+            cubicPhase += CUBIC_WAVE_FREQUENCY;
+            cosPhase += COS_WAVE_FREQUENCY / 2;
+        }
+    }
+}
+
 const __FlashStringHelper* PlasmaEffect::getName() const {
     return F("Plasma");
 }
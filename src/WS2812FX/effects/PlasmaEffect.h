@@ -10,6 +10,7 @@
  * mathematical waves (cubic wave and cosine wave) with different phases.
  * The result is a smooth, organic-looking flow of colors that continuously
  * moves and morphs across the LED strip.
+ * On a matrix (MatrixLayout) the waves run diagonally across both axes.
  */
 class PlasmaEffect : public Effect {
 public:
@@ -21,6 +22,11 @@ public:
     uint8_t getModeId() const override;
 
 private:    
+    /**
+     * @brief Render the plasma on the matrix (the pixels taken from the XY table)
+     */
+    void render2D(WS2812FX* strip, uint8_t primaryPhase, uint8_t secondaryPhase, uint8_t brightnessModulator);
+
     // Constants for wave calculations
     static const uint8_t CUBIC_WAVE_FREQUENCY = 15;  ///< Frequency multiplier for cubic wave
     static const uint8_t COS_WAVE_FREQUENCY = 8;     ///< Frequency multiplier for cosine wave
@@ -2,6 +2,7 @@
 #define POPCORN_EFFECT_H
 
 #include "../Effect.h"
+#include "../ParticleSystem.h"
 
 /**
  * @brief Popcorn effect - simulates popcorn kernels popping with realistic physics
@@ -15,102 +16,64 @@
  * - Using palette colors for varied kernel colors
  * - Automatically re-igniting kernels after they lose momentum
  * 
- * The effect maintains its own state for:
- * - Individual kernel physics (position, velocity, time base)
- * - Color indices for palette-based coloring
- * - Damping factors for realistic bouncing behavior
- * - Previous positions for motion blur effects
- * 
- * Physics simulation includes:
+ * The kernels are particles of the shared ParticleSystem:
+ * - numBars kernels per PARTICLE_LEDS_PER_BAR LEDs (limited by the pool)
  * - Gravitational acceleration (configurable via beat88 parameter)
  * - Initial velocity calculations to reach strip ends
- * - Realistic ballistic motion with parabolic trajectories
- * - Energy loss on bouncing for natural behavior
- * 
- * This implementation uses minimal external shared resources by managing
- * all kernel state internally rather than using global runtime unions.
+ * - Energy loss on bouncing (damping) with a random variation per bounce
+ * - The kernels are drawn over the distance moved in the last frame (motion blur)
  */
 class PopcornEffect : public Effect {
 public:
     PopcornEffect() = default;
-    virtual ~PopcornEffect() = default;
+    virtual ~PopcornEffect() { cleanup(); }
 
     bool init(WS2812FX* strip) override;
     uint16_t update(WS2812FX* strip) override;
     const __FlashStringHelper* getName() const override;
     uint8_t getModeId() const override;
+    void cleanup() override;
+    void suspend() override;
 
 private:
     /**
-     * @brief Structure to hold physics state for each popcorn kernel
-     * Contains all the physics and visual data needed to simulate one kernel
+     * @brief Particle group holding the kernels
      */
-    struct KernelData {
-        uint32_t timebase;      ///< Time reference for physics calculations (milliseconds)
-        double v0;              ///< Initial velocity (mm/ms)
-        uint8_t color_index;    ///< Index into current palette for kernel color
-        uint8_t damp;           ///< Damping factor for bouncing (percentage, 0-100)
-        uint16_t prev_pos;      ///< Previous LED position for motion effects
-    };
-    
-    /**
-     * @brief Array storing physics data for each active kernel
-     * Each element manages the complete state of one popping kernel
-     */
-    KernelData kernels[32];  // Using reasonable limit based on MAX_NUM_BARS
-    
+    uint8_t group = ParticleSystem::NO_GROUP;
+
     /**
-     * @brief Number of active kernels currently being simulated
-     * Determined by strip configuration (SEG.numBars)
+     * @brief Number of kernels to be simulated
+     * Determined by strip configuration (SEG.numBars) and length
      */
-    uint8_t numKernels;
-    
+    uint16_t numKernels = 0;
+
     /**
-     * @brief Flag to track initialization state
-     * Ensures kernel arrays are properly initialized on first activation
+     * @brief Time of the last physics step
      */
-    bool initialized;
-    
-    /**
-     * @brief Calculate maximum velocity needed to reach strip end
-     * @param strip Pointer to WS2812FX instance for accessing strip parameters
-     * @param gravity Gravitational acceleration in mm/ms²
-     * @return Maximum initial velocity in mm/ms
-     */
-    double calculateMaxVelocity(WS2812FX* strip, double gravity) const;
-    
+    uint32_t lastStep = 0;
+
     /**
      * @brief Get gravitational acceleration based on effect parameters
      * @param strip Pointer to WS2812FX instance for accessing beat88 parameter
-     * @return Gravity value in mm/ms² (negative for downward acceleration)
+     * @return Gravity in particle units (negative for downward acceleration)
      */
-    double getGravity(WS2812FX* strip) const;
-    
+    int32_t getGravity(WS2812FX* strip) const;
+
     /**
-     * @brief Calculate current position using physics simulation
-     * @param kernel Reference to kernel data containing velocity and time
-     * @param gravity Current gravitational acceleration
-     * @param deltaTime Time elapsed since kernel time base
-     * @return Current position in millimeters from strip start
+     * @brief Calculate maximum velocity needed to reach strip end
+     * @param strip Pointer to WS2812FX instance for accessing strip parameters
+     * @param gravity Gravitational acceleration in particle units
+     * @return Maximum initial velocity in particle units
      */
-    double calculatePosition(const KernelData& kernel, double gravity, double deltaTime) const;
-    
+    int32_t calculateMaxVelocity(WS2812FX* strip, int32_t gravity) const;
+
     /**
-     * @brief Handle kernel bouncing and re-ignition logic
-     * @param kernelIndex Index of kernel to update
+     * @brief Handle a kernel which bounced on the ground (damping variation and re-ignition)
+     * @param i Particle index of the kernel
      * @param strip Pointer to WS2812FX instance for accessing parameters
      * @param maxVelocity Maximum velocity for re-ignition
      */
-    void updateKernelState(uint8_t kernelIndex, WS2812FX* strip, double maxVelocity);
-    
-    /**
-     * @brief Render a kernel at its current position with motion blur
-     * @param position Current position in millimeters
-     * @param prevPosition Previous position for calculating motion width
-     * @param kernel Kernel data containing color information
-     * @param strip Pointer to WS2812FX instance for rendering functions
-     */
-    void renderKernel(double position, KernelData& kernel, WS2812FX* strip);
+    void handleBounce(uint16_t i, WS2812FX* strip, int32_t maxVelocity);
 };
 
 #endif // POPCORN_EFFECT_H
\ No newline at end of file
@@ -10,7 +10,7 @@ bool PrideEffect::init(WS2812FX* strip) {
     
     // Initialize all internal state variables to clean defaults
     sPseudotime = 0;      // Reset accumulated pseudo-time
-    sLastMillis = 0;      // Will be set properly on first update
+    sLastMillis = strip->getEffectTimebase();  // the time runs from the start of the effect
     sHue16 = 0;           // Start with red hue position
     
     return true;
@@ -34,22 +34,24 @@ uint16_t PrideEffect::update(WS2812FX* strip) {
     CRGB* leds = strip->leds;
     
     // Calculate dynamic parameters based on strip speed (beat88)
-    uint8_t brightdepth = calculateBrightDepth(seg->beat88);
-    uint16_t brightnessthetainc16 = calculateBrightnessInc(seg->beat88);
-    uint8_t msmultiplier = calculateTimeMultiplier(seg->beat88);
-    uint16_t hueinc16 = calculateHueInc(seg->beat88);
+    const uint32_t timebase = strip->getEffectTimebase();
+    uint8_t brightdepth = calculateBrightDepth(seg->beat88, timebase);
+    uint16_t brightnessthetainc16 = calculateBrightnessInc(seg->beat88, timebase);
+    uint8_t msmultiplier = calculateTimeMultiplier(seg->beat88, timebase);
+    uint16_t hueinc16 = calculateHueInc(seg->beat88, timebase);
     
     // Initialize hue starting position for this frame
     uint16_t hue16 = sHue16;
     
     // Update timing - calculate milliseconds elapsed since last frame
-    uint16_t ms = millis();
+    // (the clock of the strip - strips in sync run the same deltas)
+    uint16_t ms = GET_MILLIS();
     uint16_t deltams = ms - sLastMillis;
     sLastMillis = ms;
     
     // Update internal state based on elapsed time
     sPseudotime += deltams * msmultiplier;
-    sHue16 += deltams * beatsin88((seg->beat88 / 5) * 2 + 1, 5, 9);
+    sHue16 += deltams * beatsin88((seg->beat88 / 5) * 2 + 1, 5, 9, timebase);
     
     // Initialize brightness wave position for this frame
     uint16_t brightnesstheta16 = sPseudotime;
@@ -94,28 +96,28 @@ uint8_t PrideEffect::getModeId() const {
 }
 
 // Helper method implementations
-uint8_t PrideEffect::calculateBrightDepth(uint16_t beat88) const {
+uint8_t PrideEffect::calculateBrightDepth(uint16_t beat88, uint32_t timebase) const {
     // Brightness depth controls how deep the brightness waves go
     // Higher beat88 = faster, more dramatic brightness variations
-    return beatsin88(beat88 / 3 + 1, 96, 224);
+    return beatsin88(beat88 / 3 + 1, 96, 224, timebase);
 }
 
-uint16_t PrideEffect::calculateBrightnessInc(uint16_t beat88) const {
+uint16_t PrideEffect::calculateBrightnessInc(uint16_t beat88, uint32_t timebase) const {
     // Controls the frequency of brightness waves across the strip
     // Higher values = more waves, more detailed brightness patterns
-    return beatsin88(beat88 / 5 + 1, (25 * 256), (40 * 256));
+    return beatsin88(beat88 / 5 + 1, (25 * 256), (40 * 256), timebase);
 }
 
-uint8_t PrideEffect::calculateTimeMultiplier(uint16_t beat88) const {
+uint8_t PrideEffect::calculateTimeMultiplier(uint16_t beat88, uint32_t timebase) const {
     // Controls how fast the waves move over time
     // Higher values = faster wave movement
-    return beatsin88(beat88 / 7 + 1, 23, 60);
+    return beatsin88(beat88 / 7 + 1, 23, 60, timebase);
 }
 
-uint16_t PrideEffect::calculateHueInc(uint16_t beat88) const {
+uint16_t PrideEffect::calculateHueInc(uint16_t beat88, uint32_t timebase) const {
     // Controls color transition speed across the strip
     // Higher values = more rainbow colors visible simultaneously
-    return beatsin88(beat88 / 9 + 1, 1, 3000);
+    return beatsin88(beat88 / 9 + 1, 1, 3000, timebase);
 }
 
 // Register this effect with the factory so it can be created by mode ID
@@ -35,30 +35,34 @@ private:
     /**
      * @brief Calculate brightness depth modulation
      * @param beat88 Current beat value from strip speed setting
+     * @param timebase Effect timebase of the strip
      * @return Brightness depth value (96-224 range)
      */
-    uint8_t calculateBrightDepth(uint16_t beat88) const;
+    uint8_t calculateBrightDepth(uint16_t beat88, uint32_t timebase) const;
     
     /**
      * @brief Calculate brightness theta increment for wave effect
      * @param beat88 Current beat value from strip speed setting
+     * @param timebase Effect timebase of the strip
      * @return Theta increment value for brightness waves
      */
-    uint16_t calculateBrightnessInc(uint16_t beat88) const;
+    uint16_t calculateBrightnessInc(uint16_t beat88, uint32_t timebase) const;
     
     /**
      * @brief Calculate time multiplier for effect speed
      * @param beat88 Current beat value from strip speed setting
+     * @param timebase Effect timebase of the strip
      * @return Multiplier for time-based calculations
      */
-    uint8_t calculateTimeMultiplier(uint16_t beat88) const;
+    uint8_t calculateTimeMultiplier(uint16_t beat88, uint32_t timebase) const;
     
     /**
      * @brief Calculate hue increment for color progression
      * @param beat88 Current beat value from strip speed setting
+     * @param timebase Effect timebase of the strip
      * @return Hue increment value
      */
-    uint16_t calculateHueInc(uint16_t beat88) const;
+    uint16_t calculateHueInc(uint16_t beat88, uint32_t timebase) const;
 };
 
 #endif // PRIDE_EFFECT_H
\ No newline at end of file
@@ -20,8 +20,8 @@ uint16_t RainbowCycleEffect::update(WS2812FX* strip) {
     auto runtime = strip->getSegmentRuntime();
     
     // Calculate current position in rainbow cycle using helper
-    // Use millis() for consistent timing (same as old standardInit)
-    uint16_t beatValue = EffectHelper::calculateBeatPosition(strip, millis());
+    // the timebase of the strip - in phase with other strips (see led_sync.h)
+    uint16_t beatValue = EffectHelper::calculateBeatPosition(strip, strip->getEffectTimebase());
     uint8_t startingPaletteIndex = EffectHelper::safeMapuint16_t(beatValue, 0, 65535, 0, 255);
     
     // Calculate color spacing (delta) based on segment length and palette distribution
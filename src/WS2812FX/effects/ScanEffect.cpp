@@ -26,7 +26,7 @@ uint16_t ScanEffect::update(WS2812FX* strip) {
     }
     
     // Calculate the current position of the scanning bar using helper
-    uint16_t trianglePosition = EffectHelper::calculateTrianglePosition(strip, millis());
+    uint16_t trianglePosition = EffectHelper::calculateTrianglePosition(strip, strip->getEffectTimebase());
     uint16_t ledOffset = calculateBarPosition(trianglePosition, runtime);
     
     // Clear the entire segment to black using helper
@@ -1,6 +1,7 @@
 #include "ShootingStarEffect.h"
 #include "../WS2812FX_FastLed.h"
 #include "../EffectHelper.h"
+#include "../FastRandom.h"
 
 bool ShootingStarEffect::init(WS2812FX* strip) {
     // Call base class standard initialization first
@@ -8,19 +9,39 @@ bool ShootingStarEffect::init(WS2812FX* strip) {
         return false;
     }
     
+    // (Re-)initialization starts with an empty group
+    if (!ParticleSystem::acquire(group)) {
+        return false;
+    }
+    
     auto seg = strip->getSegment();
+    auto runtime = strip->getSegmentRuntime();
     
-    // Store current number of bars (shooting stars)
-    numBars = seg->numBars;
-    if (numBars > MAX_NUM_BARS) {
-        numBars = MAX_NUM_BARS;
-    }
-    if (numBars == 0) {
-        numBars = 1; // Ensure at least one shooting star
-    }
+    // Number of shooting stars - numBars per PARTICLE_LEDS_PER_BAR LEDs (at least one)
+    const uint16_t metres = max((runtime->length + PARTICLE_LEDS_PER_BAR / 2) / PARTICLE_LEDS_PER_BAR, 1);
+    const uint16_t numStars = max(seg->numBars, (uint8_t)1) * metres;
     
-    // Initialize timing and color parameters
-    initializeStars(strip);
+    // Store base beat for change detection
+    basebeat = seg->beat88;
+    lastStep = millis();
+    lastColor = RandomPool::random8();
+    
+    // Spread the stars evenly across the cycle: a star at phase p of the cycle
+    // is at p² of the segment (constant acceleration from the start)
+    const float accel = (float)calculateAcceleration(strip);
+    const float length = (float)(runtime->length - 1) * 256.0f;
+    for (uint16_t k = 0; k < numStars; k++) {
+        const uint16_t i = ParticleSystem::spawn(group);
+        if (i == ParticleSystem::NONE) {
+            break; // pool exhausted - less stars
+        }
+        const float phase = (float)k / numStars;
+        ParticleSystem::pos[i] = (int32_t)(length * phase * phase);
+        ParticleSystem::vel[i] = (int32_t)(sqrtf(2.0f * accel * length) * phase);
+        ParticleSystem::size[i] = 2 * 256;
+        ParticleSystem::bright[i] = 255;
+        generateNewColor(i);
+    }
     
     setInitialized(true);
     return true;
@@ -44,17 +65,37 @@ uint16_t ShootingStarEffect::update(WS2812FX* strip) {
     
     // Check if we need to reinitialize (e.g., speed changed)
     if (runtime->modeinit || basebeat != seg->beat88) {
-        return init(strip) ? strip->getStripMinDelay() : strip->getStripMinDelay();
+        setInitialized(false);
+        init(strip);
+        return strip->getStripMinDelay();
     }
     
     // Apply fade and blur effects to create trailing stars using helper
     applyTrailEffects(strip);
     
-    // Update each shooting star
-    for (uint8_t i = 0; i < numBars; i++) {
-        updateStar(strip, i);
+    // Accelerate the stars towards the end of the segment
+    ParticleSystem::Physics physics;
+    physics.gravity = calculateAcceleration(strip);
+    physics.drag = 0;
+    physics.bounce = 0;
+    physics.lower = 0;
+    physics.upper = (int32_t)runtime->length * 256;
+    const uint32_t now = millis();
+    const uint16_t dt = min(now - lastStep, (uint32_t)64);
+    lastStep = now;
+    ParticleSystem::step(group, dt, physics);
+    
+    // Stars near the end sparkle and start over
+    const int32_t end = (int32_t)(runtime->length > 5 ? runtime->length - 5 : 0) * 256;
+    for (uint16_t i = ParticleSystem::first(group); i != ParticleSystem::NONE; i = ParticleSystem::next(i)) {
+        if (ParticleSystem::pos[i] >= end) {
+            handleStarEnd(strip, i);
+        }
     }
     
+    // Draw the shooting stars with fractional (sub-pixel) edges
+    ParticleSystem::render(group, strip, *strip->getCurrentPalette());
+    
     return strip->getStripMinDelay();
 }
 
@@ -66,86 +107,26 @@ uint8_t ShootingStarEffect::getModeId() const {
     return FX_MODE_SHOOTING_STAR;
 }
 
-void ShootingStarEffect::initializeStars(WS2812FX* strip) {
-    auto seg = strip->getSegment();
-    
-    // Store base beat for change detection
-    basebeat = seg->beat88;
-    
-    // Initialize timing offsets for each shooting star
-    // This spreads them out across the animation cycle
-    for (uint8_t i = 0; i < numBars; i++) {
-        // Distribute stars evenly across the timing cycle
-        delta_b[i] = (65535 / numBars) * i;
-        
-        // Initialize colors with variation between stars
-        if (i > 0) {
-            // Generate color related to previous star but with variation
-            cind[i] = EffectHelper::get_random_wheel_index(cind[i - 1], 32);
-        } else {
-            // First star gets a color related to the last star for smooth cycling
-            cind[i] = EffectHelper::get_random_wheel_index(cind[numBars - 1], 32);
-        }
-        
-        // Mark that star doesn't need immediate new color
-        new_cind[i] = false;
-    }
+void ShootingStarEffect::cleanup() {
+    ParticleSystem::release(group);
 }
 
-void ShootingStarEffect::updateStar(WS2812FX* strip, uint8_t starIndex) {
-    auto seg = strip->getSegment();
-    auto runtime = strip->getSegmentRuntime();
-    
-    // Calculate current beat for this star (base + offset)
-    uint16_t beat = beat88(seg->beat88) + delta_b[starIndex];
-    
-    // Calculate position using quadratic acceleration for realistic motion
-    uint16_t pos = calculateStarPosition(beat, strip);
-    
-    // Draw the shooting star using fractional bar for smooth movement
-    // Width of 2 creates a nice star appearance, color index provides variation
-    strip->drawFractionalBar(pos, 2, *strip->getCurrentPalette(), 
-                            cind[starIndex], 255, true, 1);
-    
-    // Check if star has reached near the end of the strip
-    if (pos / 16 > (runtime->stop - 4)) {
-        handleStarEnd(strip, starIndex, pos);
-    } else {
-        // Star is still moving - check if it needs a new color
-        if (new_cind[starIndex]) {
-            generateNewColor(strip, starIndex);
-        }
-        new_cind[starIndex] = false;
-    }
+// pooled and switched away from: the stars go, the group stays
+void ShootingStarEffect::suspend() {
+    ParticleSystem::killAll(group);
 }
 
-uint16_t ShootingStarEffect::calculateStarPosition(uint16_t beat, WS2812FX* strip) const {
-    auto runtime = strip->getSegmentRuntime();
-    
-    // Use quadratic function for acceleration: position = (beat/100)^2
-    // This creates realistic shooting star motion that starts slow and accelerates
-    double_t q_beat = static_cast<double_t>(beat / 100) * (beat / 100);
-    
-    // Map the quadratic result to the strip boundaries
-    // Using 16-bit fixed point for smooth sub-pixel positioning
-    uint16_t pos = map(static_cast<uint32_t>(q_beat + 0.5), 
-                      static_cast<uint32_t>(0), 
-                      static_cast<uint32_t>(429484),  // Maximum value for mapping
-                      static_cast<uint32_t>(runtime->start * 16), 
-                      static_cast<uint32_t>(runtime->stop * 16));
-    
-    return pos;
+int32_t ShootingStarEffect::calculateAcceleration(WS2812FX* strip) const {
+    // One beat88 cycle takes 60000 * 256 / beat88 ms - s = a/2 * t² over the segment
+    const float cycle = (60000.0f * 256.0f / max(strip->getSegment()->beat88, (uint16_t)1)) / 1024.0f;
+    const float length = (float)(strip->getSegmentRuntime()->length - 1) * 256.0f;
+    return (int32_t)(2.0f * length / (cycle * cycle)) + 1;
 }
 
-void ShootingStarEffect::generateNewColor(WS2812FX* strip, uint8_t starIndex) {
-    // Generate new color based on neighboring stars for smooth color transitions
-    if (starIndex > 0) {
-        // Base new color on previous star with some variation
-        cind[starIndex] = EffectHelper::get_random_wheel_index(cind[starIndex - 1], 32);
-    } else {
-        // First star bases color on last star for continuous cycling
-        cind[starIndex] = EffectHelper::get_random_wheel_index(cind[numBars - 1], 32);
-    }
+void ShootingStarEffect::generateNewColor(uint16_t starIndex) {
+    // Base new color on the previous star with some variation for smooth color transitions
+    lastColor = EffectHelper::get_random_wheel_index(lastColor, 32);
+    ParticleSystem::color[starIndex] = lastColor;
 }
 
 void ShootingStarEffect::applyTrailEffects(WS2812FX* strip) {
@@ -163,23 +144,28 @@ void ShootingStarEffect::applyTrailEffects(WS2812FX* strip) {
     }
 }
 
-void ShootingStarEffect::handleStarEnd(WS2812FX* strip, uint8_t starIndex, uint16_t position) {
+void ShootingStarEffect::handleStarEnd(WS2812FX* strip, uint16_t starIndex) {
     auto seg = strip->getSegment();
+    auto runtime = strip->getSegmentRuntime();
     
     // Add sparkle effect when star reaches the end
     CRGB led = strip->ColorFromPaletteWithDistribution(
-        *strip->getCurrentPalette(), cind[starIndex], seg->brightness, seg->blendType
+        *strip->getCurrentPalette(), ParticleSystem::color[starIndex], seg->brightness, seg->blendType
     );
     
-    if (led) {
+    const uint16_t position = ParticleSystem::pos[starIndex] >> 8;
+    if (led && position < runtime->length) {
         // Create sparkle by adding brightness to the end LED
         uint8_t sparkle_brightness = led.r | led.g | led.b;
-        strip->leds[position / 16].addToRGB(sparkle_brightness % 128);
+        strip->leds[runtime->start + position].addToRGB(sparkle_brightness % 128);
     }
     
-    // Mark this star for color change on next cycle
-    new_cind[starIndex] = true;
+    // Start over from the beginning of the segment with a new color
+    ParticleSystem::pos[starIndex] = 0;
+    ParticleSystem::vel[starIndex] = 0;
+    ParticleSystem::trail[starIndex] = 0;
+    generateNewColor(starIndex);
 }
 
 // Register this effect with the factory
-REGISTER_EFFECT(FX_MODE_SHOOTING_STAR, ShootingStarEffect)
\ No newline at end of file
+REGISTER_EFFECT(FX_MODE_SHOOTING_STAR, ShootingStarEffect)
@@ -2,11 +2,7 @@
 #define SHOOTING_STAR_EFFECT_H
 
 #include "../Effect.h"
-
-// Maximum number of shooting stars that can be active simultaneously
-#ifndef MAX_NUM_BARS
-#define MAX_NUM_BARS 8
-#endif
+#include "../ParticleSystem.h"
 
 /**
  * @brief Shooting Star Effect - Creates multiple shooting star animations across the LED strip
@@ -16,7 +12,8 @@
  * different colors, speeds, and trajectories.
  * 
  * Key features:
- * - Multiple independent shooting stars (configurable via numBars setting)
+ * - Multiple independent shooting stars (numBars per PARTICLE_LEDS_PER_BAR LEDs,
+ *   particles of the shared ParticleSystem)
  * - Quadratic acceleration for realistic motion physics
  * - Automatic color cycling with controlled randomization
  * - Trailing fade effects for realistic star trails
@@ -24,8 +21,8 @@
  * - Self-contained state management without external dependencies
  * 
  * Algorithm details:
- * 1. Each shooting star has its own beat offset for independent timing
- * 2. Position calculation uses quadratic function for acceleration
+ * 1. The stars start staggered over one beat88 cycle for independent timing
+ * 2. Constant acceleration - a star crosses the segment within one beat88 cycle
  * 3. Colors are distributed across the color wheel with controlled variation
  * 4. Trail effect is created using fade and blur operations
  * 5. Stars restart with new colors when they reach the end
@@ -36,48 +33,34 @@
 class ShootingStarEffect : public Effect {
 public:
     ShootingStarEffect() = default;
-    virtual ~ShootingStarEffect() = default;
+    virtual ~ShootingStarEffect() { cleanup(); }
 
     bool init(WS2812FX* strip) override;
     uint16_t update(WS2812FX* strip) override;
     const __FlashStringHelper* getName() const override;
     uint8_t getModeId() const override;
+    void cleanup() override;
+    void suspend() override;
 
 private:
     // Effect state variables - fully encapsulated within the class
+    uint8_t group = ParticleSystem::NO_GROUP;   ///< Particle group holding the stars
     uint16_t basebeat;              ///< Base beat value for timing calculations
-    uint16_t delta_b[MAX_NUM_BARS]; ///< Beat offset for each shooting star
-    uint8_t cind[MAX_NUM_BARS];     ///< Color index for each shooting star
-    bool new_cind[MAX_NUM_BARS];    ///< Flag indicating if star needs new color
-    uint8_t numBars;                ///< Number of active shooting stars
+    uint8_t lastColor;              ///< Color index of the last (re)started star
+    uint32_t lastStep;              ///< Timestamp of the last physics step
 
     /**
-     * @brief Initialize shooting star parameters
-     * @param strip Pointer to WS2812FX instance for accessing settings
-     */
-    void initializeStars(WS2812FX* strip);
-
-    /**
-     * @brief Update individual shooting star position and appearance
-     * @param strip Pointer to WS2812FX instance
-     * @param starIndex Index of the star to update (0 to numBars-1)
+     * @brief Acceleration to cross the segment within one beat88 cycle
+     * @param strip Pointer to WS2812FX instance for the speed and the segment length
+     * @return Acceleration in particle units
      */
-    void updateStar(WS2812FX* strip, uint8_t starIndex);
-
-    /**
-     * @brief Calculate shooting star position using quadratic acceleration
-     * @param beat Current beat value for the star
-     * @param strip Pointer to WS2812FX instance for strip boundaries
-     * @return Position in 16-bit fixed point format (position * 16)
-     */
-    uint16_t calculateStarPosition(uint16_t beat, WS2812FX* strip) const;
+    int32_t calculateAcceleration(WS2812FX* strip) const;
 
     /**
      * @brief Generate new color for a shooting star
-     * @param strip Pointer to WS2812FX instance
-     * @param starIndex Index of the star to recolor
+     * @param starIndex Particle index of the star to recolor
      */
-    void generateNewColor(WS2812FX* strip, uint8_t starIndex);
+    void generateNewColor(uint16_t starIndex);
 
     /**
      * @brief Apply fade and blur effects to create star trails
@@ -86,12 +69,11 @@ private:
     void applyTrailEffects(WS2812FX* strip);
 
     /**
-     * @brief Handle star reaching the end of the strip
+     * @brief Handle star reaching the end of the strip (sparkle and restart with a new color)
      * @param strip Pointer to WS2812FX instance
-     * @param starIndex Index of the star that reached the end
-     * @param position Current position of the star
+     * @param starIndex Particle index of the star that reached the end
      */
-    void handleStarEnd(WS2812FX* strip, uint8_t starIndex, uint16_t position);
+    void handleStarEnd(WS2812FX* strip, uint16_t starIndex);
 };
 
 #endif // SHOOTING_STAR_EFFECT_H
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "TwinkleFadeEffect.h"
 #include "../WS2812FX_FastLed.h"
 #include "../EffectHelper.h"
+#include "../FastRandom.h"
 
 bool TwinkleFadeEffect::init(WS2812FX* strip) {
     // Call base class standard initialization first
@@ -65,17 +66,17 @@ uint16_t TwinkleFadeEffect::update(WS2812FX* strip) {
         // Below target density - add a new twinkle
         
         // Select a random LED position within the segment
-        uint16_t ledIndex = random16(runtime->length);
+        uint16_t ledIndex = RandomPool::random16(runtime->length);
         uint16_t absoluteIndex = runtime->start + ledIndex;
         
         if (!strip->leds[absoluteIndex]) {
             // LED is currently off - light it up with a new twinkle
             
             // Generate random color from current palette
-            uint8_t randomColorIndex = random8();
+            uint8_t randomColorIndex = RandomPool::random8();
             
             // Generate random brightness (128-255 for good visibility)
-            uint8_t randomBrightness = random8(128, 255);
+            uint8_t randomBrightness = RandomPool::random8(128, 255);
             
             // Set the LED color using palette with distribution
             strip->leds[absoluteIndex] = strip->ColorFromPaletteWithDistribution(
@@ -77,8 +77,8 @@ uint16_t TwinkleFoxEffect::update(WS2812FX* strip) {
      */
     uint16_t prng16 = 11337;  // Fixed seed for deterministic behavior
     
-    // Get current time as the base for all animations
-    uint32_t currentTime = millis();
+    // Get current time as the base for all animations (the clock of the strips in sync)
+    uint32_t currentTime = GET_MILLIS();
     
     /**
      * Set up background color. In this implementation, we use black background
@@ -1,6 +1,7 @@
 #include "TwinkleMapEffect.h"
 #include "../WS2812FX_FastLed.h"
 #include "../EffectHelper.h"
+#include "../FastRandom.h"
 #include <new>  // For std::nothrow
 
 bool TwinkleMapEffect::init(WS2812FX* strip) {
@@ -19,10 +20,14 @@ bool TwinkleMapEffect::init(WS2812FX* strip) {
     // Initialize all pixel states to 0 (base color, not twinkling)
     memset(_pixelStates, 0, runtime->length * sizeof(uint8_t));
     
+    // Without the cache the colors get calculated per LED
+    const bool cached = ensureColorCache(strip);
+    const uint8_t hueOffset = runtime->baseHue + runtime->baseHue;
+
     // Set all LEDs to their base colors using palette mapping
     for (uint16_t i = 0; i < runtime->length; i++) {
-        CRGB baseColor = calculateBaseColor(strip, i);
-        strip->leds[runtime->start + i] = baseColor;
+        strip->leds[runtime->start + i] = cached ? *cachedColors(strip, _pixelIndex[i] + hueOffset)
+                                                 : calculateBaseColor(strip, i);
     }
     
     return true;
@@ -54,20 +59,32 @@ uint16_t TwinkleMapEffect::update(WS2812FX* strip) {
     uint8_t speedUp = EffectHelper::safeMapuint16_t(beat88_val, BEAT88_MIN, BEAT88_MAX, 4, 64);
     uint8_t speedDown = speedUp / 2; // Dimming is slower than brightening
     
+    // The colors only get calculated when the palette, the blend type,
+    // the distribution or the length changed (or per LED without the cache)
+    const bool cached = ensureColorCache(strip);
+    const uint8_t hueOffset = runtime->baseHue + runtime->baseHue;
+
     // Process each LED in the segment
     for (uint16_t i = 0; i < runtime->length; i++) {
         uint16_t absoluteIndex = runtime->start + i;
         uint8_t& pixelState = _pixelStates[i];
         
-        // Calculate colors for this LED position
-        CRGB baseColor = calculateBaseColor(strip, i);
-        CRGB peakColor = calculatePeakColor(strip, i);
+        // Colors for this LED position
+        CRGB baseColor, peakColor;
+        if (cached) {
+            const CRGB* colors = cachedColors(strip, _pixelIndex[i] + hueOffset);
+            baseColor = colors[0];
+            peakColor = colors[256];
+        } else {
+            baseColor = calculateBaseColor(strip, i);
+            peakColor = calculatePeakColor(strip, i);
+        }
         
         // State machine for each LED:
         if (pixelState == 0) {
             // LED is at base color - randomly decide whether to start twinkling
             uint8_t twinkleThreshold = (seg->twinkleDensity < 3) ? 1 : (seg->twinkleDensity - 2);
-            if (random8() < twinkleThreshold) {
+            if (RandomPool::random8() < twinkleThreshold) {
                 pixelState = 1; // Start brightening phase
             }
             // LED stays at base color if no twinkle started
@@ -127,6 +144,71 @@ void TwinkleMapEffect::cleanup() {
     size_t allocatedSize = _allocatedLength;
     EffectHelper::safeFreeArray((void*&)_pixelStates, allocatedSize);
     _allocatedLength = 0;
+    freeColorCache();
+}
+
+bool TwinkleMapEffect::ensureColorCache(WS2812FX* strip) {
+    auto seg = strip->getSegment();
+    auto runtime = strip->getSegmentRuntime();
+
+    if (_colorTable == nullptr) {
+        _colorTable = (CRGB*)malloc(512 * sizeof(CRGB));
+        if (_colorTable == nullptr) {
+            return false;
+        }
+        memset(_colorValid, 0, sizeof(_colorValid));
+    }
+
+    // Palette index per position - changes with the length only
+    if (_pixelIndex == nullptr || _indexLength != runtime->length) {
+        size_t indexLength = _indexLength;
+        _pixelIndex = (uint8_t*)EffectHelper::safeAllocateArray(_pixelIndex, indexLength, runtime->length, sizeof(uint8_t));
+        if (_pixelIndex == nullptr) {
+            _indexLength = 0;
+            return false;
+        }
+        _indexLength = indexLength;
+        for (uint16_t i = 0; i < runtime->length; i++) {
+            // calculateColorIndex without the offsets (the hue gets added per frame)
+            _pixelIndex[i] = EffectHelper::calculateColorIndex(strip, i, 0) - runtime->baseHue;
+        }
+    }
+
+    // Colors - change with the palette (blending), the blend type and the distribution
+    if (_tablePaletteVersion != strip->getPaletteVersion() ||
+        _tableBlendType != seg->blendType ||
+        _tableDistribution != seg->paletteDistribution) {
+        _tablePaletteVersion = strip->getPaletteVersion();
+        _tableBlendType = seg->blendType;
+        _tableDistribution = seg->paletteDistribution;
+        memset(_colorValid, 0, sizeof(_colorValid));
+    }
+    return true;
+}
+
+void TwinkleMapEffect::fillColorEntry(WS2812FX* strip, uint8_t paletteIndex) {
+    auto seg = strip->getSegment();
+
+    CRGB color = strip->ColorFromPaletteWithDistribution(
+        *(strip->getCurrentPalette()),
+        paletteIndex,
+        255,                              // Full saturation
+        seg->blendType                    // Segment blend type setting
+    );
+
+    // Same scaling as calculateBaseColor / calculatePeakColor
+    _colorTable[paletteIndex] = color;
+    _colorTable[paletteIndex].nscale8_video(32);
+    _colorTable[256 + paletteIndex] = color.addToRGB(4);
+    _colorValid[paletteIndex >> 3] |= 1 << (paletteIndex & 7);
+}
+
+void TwinkleMapEffect::freeColorCache() {
+    EffectHelper::safeFreeArray((void*&)_pixelIndex, _indexLength);
+    if (_colorTable != nullptr) {
+        free(_colorTable);
+        _colorTable = nullptr;
+    }
 }
 
 bool TwinkleMapEffect::ensureStateArrayAllocated(WS2812FX* strip) {
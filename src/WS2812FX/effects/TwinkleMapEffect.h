@@ -32,6 +32,14 @@
  * - Twinkle density controlled by segment twinkleDensity parameter
  * - Respects palette blend types and hue rotation
  * - Smooth, eye-pleasing transitions without abrupt changes
+ *
+ * Color Cache:
+ * - The base and peak colors only depend on the palette index of a LED. They are
+ *   kept in a table of 256 entries each (1536 bytes), computed on first use and
+ *   invalidated when the palette (version), the blend type or the distribution changes
+ * - The palette index of each position is kept per LED (1 byte) and rebuilt with the length
+ * - The hue rotation only offsets the index - it does not invalidate anything
+ * - Without the table (allocation failed) the colors get calculated per LED as before
  */
 class TwinkleMapEffect : public Effect {
 private:
@@ -56,11 +64,40 @@ private:
      */
     uint16_t _allocatedLength;
 
+    /**
+     * @brief Palette index of each LED position (without the hue offset)
+     */
+    uint8_t* _pixelIndex;
+
+    /**
+     * @brief Number of LEDs the palette indices were computed for
+     */
+    size_t _indexLength;
+
+    /**
+     * @brief Base colors (entries 0-255) and peak colors (entries 256-511) per palette index
+     */
+    CRGB* _colorTable;
+
+    /**
+     * @brief One bit per palette index - set once the table entry got computed
+     */
+    uint8_t _colorValid[256 / 8];
+
+    /**
+     * @brief Palette version, blend type and distribution the table was computed for
+     */
+    uint16_t _tablePaletteVersion;
+    uint8_t  _tableBlendType;
+    uint8_t  _tableDistribution;
+
 public:
     /**
      * @brief Constructor - Initialize with no allocated state
      */
-    TwinkleMapEffect() : _pixelStates(nullptr), _allocatedLength(0) {}
+    TwinkleMapEffect() : _pixelStates(nullptr), _allocatedLength(0),
+                         _pixelIndex(nullptr), _indexLength(0), _colorTable(nullptr),
+                         _tablePaletteVersion(0), _tableBlendType(0), _tableDistribution(0) {}
     
     /**
      * @brief Destructor - Clean up allocated memory
@@ -142,6 +179,43 @@ private:
      */
     bool ensureStateArrayAllocated(WS2812FX* strip);
 
+    /**
+     * @brief Allocate the color cache and drop outdated entries
+     *
+     * Rebuilds the palette index per LED when the length changed and invalidates the
+     * color table when the palette, the blend type or the palette distribution changed.
+     *
+     * @param strip Pointer to WS2812FX instance for palette and configuration access
+     * @return true if the cache can be used, false to calculate the colors per LED
+     */
+    bool ensureColorCache(WS2812FX* strip);
+
+    /**
+     * @brief Table entry (base color, peak color at +256) for a palette index
+     *
+     * Computes the entry on first use after an invalidation.
+     *
+     * @param strip Pointer to WS2812FX instance for palette and configuration access
+     * @param paletteIndex Palette index including the hue offset
+     * @return Pointer to the base color of the entry
+     */
+    inline const CRGB* cachedColors(WS2812FX* strip, uint8_t paletteIndex) {
+        if (!(_colorValid[paletteIndex >> 3] & (1 << (paletteIndex & 7)))) {
+            fillColorEntry(strip, paletteIndex);
+        }
+        return &_colorTable[paletteIndex];
+    }
+
+    /**
+     * @brief Compute the base and peak color of one table entry
+     */
+    void fillColorEntry(WS2812FX* strip, uint8_t paletteIndex);
+
+    /**
+     * @brief Free the color cache
+     */
+    void freeColorCache();
+
     /**
      * @brief Calculate the base color for a given LED position
      * 
@@ -85,6 +85,16 @@ extern "C"
 
 // new approach starts here:
 #include "LED_strip/led_strip.h"
+#include "LED_strip/led_commands.h"
+#include "LED_strip/led_preview.h"
+#include "LED_strip/led_realtime.h"
+#include "LED_strip/led_sync.h"
+#include "LED_strip/led_settings.h"
+#include "LED_strip/led_presets.h"
+#include "LED_strip/led_playlist.h"
+#include "WS2812FX/FastRandom.h"
+#include "WS2812FX/AudioInput.h"
+#include "profiler.h"
 
 #ifdef HAS_KNOB_CONTROL
   // the roating knob controller as input device
@@ -157,6 +167,57 @@ const char * AP_SSID PROGMEM = LED_NAME;
 AsyncWebServer server(80);
 // The Websocket part of the web handling
 AsyncWebSocket *webSocketsServer;
+// Server-Sent Events (/events): field changes and periodic stats for polling based integrations
+// (the clients are the ones of the event source - it removes them when they disconnect)
+AsyncEventSource *eventSource;
+struct eventStatistics {
+  uint32_t connects;
+  uint32_t rejected;
+  uint32_t dropped;
+  uint32_t events;
+} eventStats = {0, 0, 0, 0};
+// events were dropped - the clients get the complete state again with the next event
+bool eventsBehind = false;
+
+// State version: bumped whenever a (broadcasted) value changes.
+// Used as ETag (together with a random boot id) and for the long-poll on /status and /allvalues
+uint32_t stateVersion = 1;
+uint32_t stateBootId  = 0;
+// counts the field broadcasts to detect changes within checkSegmentChanges
+uint32_t fieldBroadcasts = 0;
+// while set (e.g. after a preset recall) changed fields are only counted
+// and sent as a whole by broadcastAllValues
+bool batchFieldBroadcasts = false;
+// counters exposed via /metrics
+struct metricCounters {
+  uint32_t requests;            // web requests received by the handlers (see counted - not the files served)
+  uint32_t requestsDone;        // web requests answered (connection closed)
+  uint32_t requestMillis;       // sum of the time from request to connection close
+  uint32_t requestMaxMillis;
+  uint32_t allocFailures;       // buffers which could not be allocated
+  uint32_t wifiDisconnects;     // station disconnected (event)
+  uint32_t wifiErrors;          // WiFi checks (every WIFI_TIMEOUT) finding no connection
+} metrics = {0, 0, 0, 0, 0, 0, 0};
+// names of the input sources (ledInputSources) for the latency stats
+const char * const latencySourceNames[LED_SRC_COUNT] = {"http", "ws", "knob", "udp"};
+
+// the handlers of the web server counting their requests (see countRequest)
+static ArRequestHandlerFunction counted(ArRequestHandlerFunction handler);
+
+// requests parked by the long-poll
+struct pendingPoll {
+  AsyncWebServerRequest * request;
+  void (*send)(AsyncWebServerRequest *request);
+  uint32_t since;
+  uint32_t timeout;
+} pendingPolls[LONGPOLL_MAX_REQUESTS];
+// /set requests waiting for their changes being shown (?latency)
+struct pendingSet {
+  AsyncWebServerRequest * request;
+  AsyncJsonResponse * response;
+  uint32_t arrival;
+  uint32_t timeout;
+} pendingSets[SET_LATENCY_REQUESTS];
 
 // we do not want anything to distrub the OTA
 // therefore there is a flag which could be used to prevent from that...
@@ -170,9 +231,26 @@ struct pingPong {
   uint32_t iD = 0;
   uint8_t pong = 0;
   uint8_t ping = 0;
+  // live preview (opt-in by sending {"preview":<fps>})
+  uint16_t previewInterval = 0; // ms between two frames, 0 = off
+  uint32_t previewNext = 0;     // time (millis) the next frame is due
+  uint16_t previewSeq = 0;      // sequence of the last full resolution frame received (0 = none)
+  uint8_t  previewShift = 0;    // current downsampling (log2)
+  uint8_t  previewGood = 0;     // frames sent without back pressure
   // Array holding the clients PingPongs
 }my_pingPongs[DEFAULT_MAX_WS_CLIENTS+1]; // as Array
 
+// live preview: the last full resolution frame being sent (base for the delta frames)
+// and the buffer to encode the frames. Both only exist while a client subscribed.
+CRGB    * previewPrev = NULL;
+uint8_t * previewBuf  = NULL;
+uint16_t  previewSeq  = 0;
+struct previewStatistics {
+  uint32_t frames;
+  uint32_t bytes;
+  uint32_t skipped;
+} previewStats = {0, 0, 0};
+
 
 /* END Network Definitions */
 
@@ -200,8 +278,6 @@ String lStrReason = "";
 //flag for saving data 
 bool shouldSaveRuntime = false;
 
-bool newSolidColor = false;
-
 // check if we need to Reset
 // We had to use a flag as the Async Responce caused
 // Watchdog reset.
@@ -212,6 +288,23 @@ enum doResets {
   LED_CTRL_RESET_FACTORY
 } ledCtrlDoResets;
 
+// boot sequence: the settings get restored and the strip renders right away,
+// WiFi, the web server, mDNS and OTA come up step by step (see bootService)
+enum bootStates {
+  BOOT_WIFI_START,
+  BOOT_WIFI_WAIT,
+  BOOT_SERVICES,
+  BOOT_DONE
+} bootState = BOOT_WIFI_START;
+// boot time breakdown (millis since the reset) exposed via /status
+struct bootTimes {
+  uint32_t setup;         // setup() entered
+  uint32_t settings;      // settings restored
+  uint32_t firstFrame;    // first frame shown
+  uint32_t wifi;          // WiFi connected (or given up)
+  uint32_t services;      // web server, mDNS and OTA running
+} bootTime = {0, 0, 0, 0, 0};
+
 // "local" copy of the segment data (to be saved)
 // used for comparison with the actual segment data
 WS2812FX::segment seg;
@@ -235,9 +328,18 @@ void initOverTheAirUpdate  (void);
 void setupWiFi             (uint16_t timeout);
 // initialises the Web sever with the callback / handler functions
 void setupWebServer        (void);
+// one step of the boot sequence (WiFi, web server, mDNS, OTA) - called from the loop
+// while the strip is already rendering. Returns true once everything is up.
+bool bootService           (uint32_t now);
 // handler for http://..../set calls (usually needs parameter and value)
 // will return the parameter and values being set as json
 void handleSet             (AsyncWebServerRequest *request);
+// handler for POST http://..../set with a JSON object (or binary TLV with content type
+// application/octet-stream) as body holding several field / value pairs.
+// All values are applied within the same frame, the answer holds all of them at once.
+void handleSetPost         (AsyncWebServerRequest *request);
+// collects the body of a POST /set request
+void handleSetBody         (AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
 // not found handler - called when the uri is not managed
 void handleNotFound        (AsyncWebServerRequest *request);
 // will return all available modes (effects) in an json array
@@ -247,48 +349,112 @@ void handleGetPals         (AsyncWebServerRequest *request);
 // will return the current status, listing all neccessary parameters 
 // as well as meta information
 void handleStatus          (AsyncWebServerRequest *request);
+// builds and sends the status (JSON) - called by handleStatus or the long-poll
+void sendStatus            (AsyncWebServerRequest *request);
+// builds and sends all field values (JSON)  - called by /allvalues or the long-poll
+void sendAllValues         (AsyncWebServerRequest *request);
+// answers conditional requests (If-None-Match with the current ETag -> 304)
+// and parks long-poll requests (?since=<version>&wait=<ms>) until the state changed.
+// returns true if the request was handled (or parked) and "send" must not be called
+bool handleStateRequest    (AsyncWebServerRequest *request, void (*send)(AsyncWebServerRequest *request));
+// answers the parked long-poll requests once the state version changed or they timed out
+void servicePendingPolls   (uint32_t now);
+// sends the answer of /set. With the parameter "latency" the answer waits till the changes
+// were shown and contains the measured latency (in us) from the request till FastLED.show()
+void sendSetResponse       (AsyncWebServerRequest *request, AsyncJsonResponse *response, bool queued);
+// answers the /set requests waiting for their latency
+void servicePendingSets    (uint32_t now);
+// the ETag representing the current stateVersion
+String getStateETag        (void);
+// device health in the prometheus text format (streamed, no JSON)
+void handleMetrics         (AsyncWebServerRequest *request);
+#ifdef HAS_PROFILER
+// dumps the profiler ring as Chrome trace_event JSON (chrome://tracing, Perfetto)
+void handleTrace           (AsyncWebServerRequest *request);
+#endif
 // when called with the right parameter, it will reset 
 // either to default values or perform a factory reset.
 // Parameter rst=
 //    "FactoryReset" --> Factory Reset
 //    "Defaults"     --> Reset to default values (without WiFi settings)
 void handleResetRequest    (AsyncWebServerRequest *request);
+// handler for http://..../preset
+//    id=<n>               --> recalls the preset n (applied within one frame)
+//    id=<n>&save=<name>   --> stores the current values as preset n (written from the loop - 202)
+//    id=<n>&delete        --> deletes the preset n (written from the loop - 202)
+void handlePreset          (AsyncWebServerRequest *request);
+// will return the stored presets (id and name) in an json array
+void handleGetPresets      (AsyncWebServerRequest *request);
+// handler for http://..../playlist
+//    id=<n>               --> starts playing the playlist n (1..PLAYLIST_MAX)
+//    stop                 --> stops playing
+//    id=<n>&save=<list>   --> stores the playlist n - "<preset>:<mode>:<palette>:<speed>:<seconds>,..."
+//                             (see playlistParse - e.g. "3::::60,0:12:-:1200:30")
+//    id=<n>&delete        --> deletes the playlist n
+void handlePlaylist        (AsyncWebServerRequest *request);
+// will return the stored playlists (id and entries) and the one playing in json
+void handleGetPlaylists    (AsyncWebServerRequest *request);
 // broadcasts the name and value to all websocket clients
 // name : the Parameter as pointer in Flash (const __FlashStringHelper* )
 // value: the parameter value as uint16_t
 void broadcastInt          (const __FlashStringHelper* name, uint16_t value);
+// broadcasts all field values at once - {"values":[{"name":..,"value":..},...]} to the
+// websocket clients and a "state" event to the /events clients
+void broadcastAllValues    (void);
+// registers a new /events client (or rejects it if there are already SSE_MAX_CLIENTS)
+// and sends the current values of all fields as "state" event
+void handleEventConnect    (AsyncEventSourceClient * client);
+// sends the event to all /events clients.
+// While the clients have SSE_MAX_QUEUED pending messages on average the events get dropped
+// (the complete state follows with the first event sent again)
+void sendEvent             (const char * data, const char * event);
+// sends the name / value pair as "field" event to all /events clients
+void sendFieldEvent        (const __FlashStringHelper* name, uint32_t value);
+// sends the compact stats as "stats" event to all /events clients
+void sendStatsEvent        (void);
 // handles requests received via web sockets.
 // this is currently only used to (de)register new clients
 // and to manage the "ping/pong" mechanism checking if WS is alive
 void webSocketEvent        (AsyncWebSocket * server, AsyncWebSocketClient * client, AwsEventType type, void * arg, uint8_t *data, size_t len);
-// will delete the CRC stored in EEPROM 
+// handles a control message received via web socket. Supported are
+//  text:   {"name":"brightness","value":120} or {"brightness":120,"speed":1000}
+//  binary: [field index (uint8)][value (1..4 bytes, little endian)]
+// the values are queued like the /set parameters and acknowledged
+// through the regular broadcast of changed values (checkSegmentChanges)
+void handleWebSocketControl(AsyncWebSocketClient * client, uint8_t *data, size_t len, bool isText);
+// will delete the stored settings (and the CRC stored in EEPROM)
 // used in case of e.g. WD reset
 void clearCRC              (void);
-// will delete the complete EEPROM 
+// will delete the stored settings and the complete EEPROM 
 // used in case of e.g. factory reset
 void clearEEPROM           (void);
 // deletes the EEPRORM as wel as WiFi settings
 // and restarts fresh
 void checkFactoryReset          (void);
-// reads the runtime data from EEPROM
+// reads the runtime data from LittleFS (or from EEPROM after an update of an older version)
 // and checks for validity (CRC)
 // if CRC does not match it will reset to default values
-void readRuntimeDataEEPROM (void);
+void readRuntimeData       (void);
 // shows status information during boot / OTA
 // not used when using "Knob control with display"
 void showInitColor         (CRGB Color);
 // cyclic check for changes to parameters.
 // when something is changed, it will enable the
-// "saveRuntimeData"-flag in order to store to EEPROM
-// at the next EEPROM update time
+// "shouldSaveRuntime"-flag in order to store the settings
+// (see settingsService)
 // it will also broadcast the change to connected WS-Clients
 void checkSegmentChanges   (void);
-// will write the current data to EEPROM (in case the "saveRuntimeData"-flag is true)
-void saveEEPROMData        (void);
+// will write the current data right away (e.g. before a restart)
+void saveRuntimeData       (void);
 // removes the Websocket Client from the list of 
 // connected clients
 void removeClient          (uint32_t iD);
 
+// sets the rate of the live preview frames sent to the WS client with iD (0 = off)
+void setPreviewRate           (uint32_t iD, uint8_t fps);
+// sends the live preview frames to the subscribed WS clients (when due)
+void servicePreview           (uint32_t now);
+
 // will delete the configFile (which gets recreated once /all is called)
 void deleteConfigFile      (void);
 
@@ -331,6 +497,9 @@ void addEntropy(void);
 
 void broadcastInt(const __FlashStringHelper* name, uint16_t value)
 {
+  fieldBroadcasts++;
+  if(batchFieldBroadcasts) return;
+  sendFieldEvent(name, value);
   // if we do have Knob control, we check if WiFi is supposed to be enabled or not.
   // the check if there is a WS server is always done
   #ifdef HAS_KNOB_CONTROL
@@ -353,11 +522,16 @@ void broadcastInt(const __FlashStringHelper* name, uint16_t value)
   if (buffer) {
       serializeJson(jsonDoc, (char *)buffer->get(), len + 1);
       webSocketsServer->textAll(buffer);
+  } else {
+    metrics.allocFailures++;
   }
 }
 
 void broadcastColor(const __FlashStringHelper* name, CRGB Col)
 {
+  fieldBroadcasts++;
+  if(batchFieldBroadcasts) return;
+  sendFieldEvent(name, ((Col.r << 16) | (Col.g << 8) | (Col.b << 0)) & 0xffffff);
   // if we do have Knob control, we check if WiFi is supposed to be enabled or not.
   // the check if there is a WS server is always done
   #ifdef HAS_KNOB_CONTROL
@@ -380,11 +554,118 @@ void broadcastColor(const __FlashStringHelper* name, CRGB Col)
   if (buffer) {
       serializeJson(jsonDoc, (char *)buffer->get(), len + 1);
       webSocketsServer->textAll(buffer);
+  } else {
+    metrics.allocFailures++;
+  }
+}
+
+void broadcastAllValues(void)
+{
+  PROFILE_ZONE("broadcastAllValues");
+  #ifdef HAS_KNOB_CONTROL
+  if(strip->getWiFiDisabled() || !WiFiConnected) return;
+  #endif
+  DynamicJsonDocument doc(2048);
+  if(eventSource != NULL)
+  {
+    getAllValuesJSON(doc.to<JsonObject>());
+    String state;
+    serializeJson(doc, state);
+    sendEvent(state.c_str(), "state");
+  }
+  if(webSocketsServer != NULL)
+  {
+    getAllValuesJSONArray(doc.to<JsonObject>().createNestedArray(F("values")));
+    size_t len = measureJson(doc);
+    AsyncWebSocketMessageBuffer * buffer = webSocketsServer->makeBuffer(len);
+    if (buffer) {
+      serializeJson(doc, (char *)buffer->get(), len + 1);
+      webSocketsServer->textAll(buffer);
+    } else {
+      metrics.allocFailures++;
+    }
+  }
+}
+
+// the current values of all fields as "state" event - to "client" or to all clients (NULL)
+static void sendStateEvent(AsyncEventSourceClient * client)
+{
+  DynamicJsonDocument doc(2048);
+  getAllValuesJSON(doc.to<JsonObject>());
+  String state;
+  serializeJson(doc, state);
+  if(client)
+  {
+    client->send(state.c_str(), "state", 0, SSE_RECONNECT);
+  }
+  else
+  {
+    eventSource->send(state.c_str(), "state");
+  }
+}
+
+void handleEventConnect(AsyncEventSourceClient * client)
+{
+  // the event source has added the client already
+  if(eventSource->count() > SSE_MAX_CLIENTS)
+  {
+    eventStats.rejected++;
+    client->close();
+    return;
+  }
+  eventStats.connects++;
+  // start with the complete state - changes will follow as "field" events
+  sendStateEvent(client);
+}
+
+void sendEvent(const char * data, const char * event)
+{
+  const size_t clients = eventSource->count();
+  if(!clients) return;
+  if(eventSource->avgPacketsWaiting() >= SSE_MAX_QUEUED)
+  {
+    // the clients do not keep up - they get the complete state once they did
+    eventStats.dropped++;
+    eventsBehind = true;
+    return;
+  }
+  if(eventsBehind && strcmp(event, "state"))
+  {
+    sendStateEvent(NULL);
+    eventStats.events += clients;
+  }
+  eventsBehind = false;
+  eventSource->send(data, event);
+  eventStats.events += clients;
+}
+
+void sendFieldEvent(const __FlashStringHelper* name, uint32_t value)
+{
+  #ifdef HAS_KNOB_CONTROL
+  if(eventSource == NULL || strip->getWiFiDisabled() || !WiFiConnected)
+  #else
+  if(eventSource == NULL)
+  #endif
+  {
+    return;
   }
+  char data[64];
+  snprintf_P(data, sizeof(data), PSTR("{\"name\":\"%S\",\"value\":%u}"), (PGM_P)name, value);
+  sendEvent(data, "field");
+}
+
+void sendStatsEvent(void)
+{
+  if(eventSource == NULL) return;
+  char data[160];
+  snprintf_P(data, sizeof(data), PSTR("{\"fps\":%u,\"heap\":%u,\"rssi\":%d,\"uptime\":%u,\"cmdQ\":%u,\"udp\":%u}"),
+             strip->getFPS(), ESP.getFreeHeap(), WiFi.RSSI(), (uint32_t)(millis() / 1000), getCommandQueueDepth(), realtimeIsActive());
+  sendEvent(data, "stats");
 }
 
 void checkSegmentChanges(void) 
 {
+  PROFILE_ZONE("checkSegmentChanges");
   // check the segment changes
   // broadcast the change and 
   // set the shouldSaveRuntime = true where applicable
@@ -392,6 +673,17 @@ void checkSegmentChanges(void)
   #ifdef DEBUG
   bool save = shouldSaveRuntime;
   #endif
+  const uint32_t broadcastsBefore = fieldBroadcasts;
+  static bool realtimeActive = false;
+  // a preset changes most of the fields at once - send them in one message
+  batchFieldBroadcasts = getPresetApplied();
+
+  if(realtimeActive != realtimeIsActive())
+  {
+    // not a field - but the effect shown is a different one
+    realtimeActive = realtimeIsActive();
+    stateVersion++;
+  }
 
   if(seg.power != strip->getPower()) {
     seg.power = strip->getPower();
@@ -500,9 +792,8 @@ void checkSegmentChanges(void)
       and to "set" this including palette creation...
       ...and the palette creation depends on the current palette number?
   */
-  if(newSolidColor)
+  if(getSolidColorChanged())
   {
-    newSolidColor = false;
     broadcastColor(F("solidColor"), ColorFromPalette(*(strip->getTargetPalette()), 0, 255, NOBLEND));
   }
 
@@ -608,6 +899,44 @@ void checkSegmentChanges(void)
     broadcastInt(F("backgroundBri"), seg.backgroundBri);
     shouldSaveRuntime = true;
   }
+  for(uint8_t l = 0; l < LAYER_COUNT; l++)
+  {
+    // names of the layer fields (see the fields table)
+    static const char layerFields[2][3][14] PROGMEM = {
+      {"layer1Effect", "layer1Opacity", "layer1Blend"},
+      {"layer2Effect", "layer2Opacity", "layer2Blend"}
+    };
+    if(seg.layerMode[l] != strip->getLayerMode(l))
+    {
+      seg.layerMode[l] = strip->getLayerMode(l);
+      broadcastInt(FPSTR(layerFields[l][0]), seg.layerMode[l]);
+      shouldSaveRuntime = true;
+    }
+    if(seg.layerOpacity[l] != strip->getLayerOpacity(l))
+    {
+      seg.layerOpacity[l] = strip->getLayerOpacity(l);
+      broadcastInt(FPSTR(layerFields[l][1]), seg.layerOpacity[l]);
+      shouldSaveRuntime = true;
+    }
+    if(seg.layerBlend[l] != strip->getLayerBlend(l))
+    {
+      seg.layerBlend[l] = strip->getLayerBlend(l);
+      broadcastInt(FPSTR(layerFields[l][2]), seg.layerBlend[l]);
+      shouldSaveRuntime = true;
+    }
+  }
+  if(seg.syncRole != strip->getSyncRole())
+  {
+    seg.syncRole = strip->getSyncRole();
+    broadcastInt(F("syncRole"), seg.syncRole);
+    shouldSaveRuntime = true;
+  }
+  if(seg.syncGroup != strip->getSyncGroup())
+  {
+    seg.syncGroup = strip->getSyncGroup();
+    broadcastInt(F("syncGroup"), seg.syncGroup);
+    shouldSaveRuntime = true;
+  }
 
   #ifdef HAS_KNOB_CONTROL
   if(seg.wifiDisabled != strip->getWiFiDisabled())
@@ -617,45 +946,57 @@ void checkSegmentChanges(void)
     shouldSaveRuntime = true;
   }
   #endif
+
+  if(fieldBroadcasts != broadcastsBefore)
+  {
+    stateVersion++;
+    if(batchFieldBroadcasts) broadcastAllValues();
+  }
+  batchFieldBroadcasts = false;
 }
 
-void saveEEPROMData(void)
+void saveRuntimeData(void)
 {
-  // write runtime data to EEPROM (when required by "shouldSave Runtime")
-
-  // nothing to do if flag is not set
-  if (!shouldSaveRuntime) {
-    return;
-  }
-  
+  PROFILE_ZONE("saveRuntimeData");
+  // write the runtime data immediately - the regular (debounced) writes are done by settingsService
   shouldSaveRuntime = false;
-
-  // update the CRC according to current segment data
-  seg.CRC = (uint16_t)WS2812FX::calc_CRC16(0x5a5a,(unsigned char *)&seg + 2, sizeof(seg) - 2);
-  strip->setCRC(seg.CRC);
-
-  // write the data to the EEPROM
-  EEPROM.put(0, seg);
-  // as we work on ESP, we also need to commit the written data.
-  EEPROM.commit();
+  settingsFlush(&seg);
 }
 
-void readRuntimeDataEEPROM(void)
+void readRuntimeData(void)
 {
 
-  // reads the stored runtime data from EEPROM
+  // reads the stored runtime data from LittleFS
   // must be called after everything else is already setup to be working
   // otherwise this may terribly fail and could override what was read already
 
-  //read the configuration from EEPROM into RAM (copy segment)
-  EEPROM.get(0, seg);
-
-  // calculate the CRC over the data being stored in the EEPROM (except the CRC itself)
-  uint16_t mCRC = (uint16_t)WS2812FX::calc_CRC16(0x5a5a, (unsigned char *)&seg + 2, sizeof(seg) - 2);
+  //read the configuration into RAM (copy segment)
+  // values not being stored (e.g. new ones after an update) keep their default
+  strip->resetDefaults();
+  seg = *strip->getSegment();
+  const settingsLoadResult stored = settingsLoad(&seg);
 
+  // nothing stored on LittleFS yet: the settings of an older version are still in the EEPROM
+  const bool fromEEPROM = (stored == SETTINGS_NONE);
+  bool valid = (stored == SETTINGS_LOADED);
+  if (fromEEPROM)
+  {
+    // stored in the layout of those versions - decoded field by field onto the defaults
+    const size_t size = settingsLegacySize();
+    uint8_t * blob = (uint8_t *)malloc(size);
+    if (blob)
+    {
+      for (size_t i = 0; i < size; i++)
+      {
+        blob[i] = EEPROM.read(i);
+      }
+      valid = settingsDecodeLegacy(blob, size, &seg);
+      free(blob);
+    }
+  }
   
-  // we have a matching CRC, so we update the runtime data.
-  if (seg.CRC == mCRC)
+  // we have valid settings, so we update the runtime data.
+  if (valid)
   {
     (*strip->getSegment()) = seg;
     
@@ -694,7 +1035,8 @@ void readRuntimeDataEEPROM(void)
   checkSegmentChanges();
 
   // no need to save right now. next save should be after /set?....
-  shouldSaveRuntime = false;
+  // (unless the settings were taken over from the EEPROM)
+  shouldSaveRuntime = fromEEPROM && valid;
   // init with transition (and effect reset)...
   // this ensures that the LEDs will be black first
   strip->setTransition();
@@ -1002,6 +1344,10 @@ void setupWiFi(uint16_t timeout = 240)
   WiFi.hostname(LED_NAME);
   // set the mode to station
   WiFi.mode(WIFI_STA);
+  // counts the disconnects when they happen (registered once - see handleMetrics)
+  static WiFiEventHandler wifiDisconnected = WiFi.onStationModeDisconnected([](const WiFiEventStationModeDisconnected &) {
+    metrics.wifiDisconnects++;
+  });
   // set the sleep mode to none
   WiFi.setSleepMode(WIFI_NONE_SLEEP);
 
@@ -1091,6 +1437,7 @@ uint8_t changebypercentage(uint8_t value, uint8_t percentage)
 
 void handleSet(AsyncWebServerRequest *request)
 {
+  PROFILE_ZONE("handleSet");
   // if /set was called
   #ifdef HAS_KNOB_CONTROL
   if(strip->getWiFiDisabled() || !WiFiConnected) return;
@@ -1126,12 +1473,19 @@ void handleSet(AsyncWebServerRequest *request)
   // create the answer object
   JsonObject answerObj = response->getRoot();
   JsonObject answer = answerObj.createNestedObject(F("currentState"));
+  // nothing is applied here. All changes are queued and become active with the next frame
+  // (see led_commands). The answer contains the values as they will be applied.
   uint32_t color = CRGB::Black;
+  bool hasColor = false;
+  ledCommand cmd = { LED_CMD_SET_FIELD, 0, 0, 0, 0, 0, 0 };
+  // all parameters of one request are applied within the same frame
+  beginCommandBatch();
   for(uint8_t i=0; i<request->params(); i++)
   {
-    if(isField(request->getParam(i)->name().c_str()))
+    const uint8_t idx = getFieldIndex(request->getParam(i)->name().c_str());
+    if(idx < getFieldCount())
     {
-      Field f = getField(request->getParam(i)->name().c_str());
+      const Field &f = getFields()[idx];
       if(f.type == ColorFieldType)
       {
         // comes from the web-Page currently as rgb
@@ -1148,25 +1502,32 @@ void handleSet(AsyncWebServerRequest *request)
         {
           color = constrain((uint32_t)strtoul(request->getParam(i)->value().c_str(), NULL, 16), 0, 0xffffff);
         }    
-        strip->setSolidColor(color);
-        strip->setColor(color);
-        answer[f.name] = color;
-        newSolidColor = true;
+        cmd.type  = LED_CMD_SOLID_COLOR;
+        cmd.value = color;
+        if(queueCommand(cmd))
+        {
+          answer[f.name] = color;
+        }
+        hasColor = true;
       }
       else
       {
         // normal parameter...
-        setFieldValue(request->getParam(i)->name().c_str(),(uint16_t)(request->getParam(i)->value().toInt()));
-        answer[request->getParam(i)->name()] = getFieldValue(request->getParam(i)->name().c_str());
+        const uint32_t value = limitFieldValue(f, (uint16_t)(request->getParam(i)->value().toInt()));
+        if(queueFieldValue(idx, value))
+        {
+          answer[f.name] = getFieldValue(f, value);
+        }
       }
       
     }
   }
   // a single pixel...
-  if(!newSolidColor)
+  if(!hasColor)
   {
     color = CRGB::Red; 
   }
+  cmd.value = color;
   
   #if LED_OFFSET > 0
   uint32_t fColor = 0x000000;
@@ -1181,53 +1542,50 @@ void handleSet(AsyncWebServerRequest *request)
   if (request->hasParam(F("pi")))
   {
     uint16_t pixel = constrain((uint16_t)strtoul(request->getParam(F("pi"))->value().c_str(), NULL, 10), 0, LED_COUNT_TOT - 1);
-    // set the VOID directly avoiding the call to "setTransition"
-    // which would clear the (currently written data first
-    strip->getSegment()->mode = FX_MODE_VOID;
-    strip->setPower(true);
-    pLeds[pixel] = CRGB(color);
-    // a range of pixels from start rnS to end rnE
-    answer[F("pixel")] = pixel;
-    char col[10];
-    sprintf(col, "%06X", color);    
-    answer[F("color")] = col;
-    answer[F("effect")] = strip->getModeName(FX_MODE_VOID);
-    answer[F("power")] = strip->getPower() ? F("on") : F("off");
-  }
-  //FIXME: Does not yet work. Lets simplyfy all of this!
+    cmd.type  = LED_CMD_PIXELS;
+    cmd.start = pixel;
+    cmd.end   = pixel;
+    if(queueCommand(cmd))
+    {
+      answer[F("pixel")] = pixel;
+      char col[10];
+      sprintf(col, "%06X", color);    
+      answer[F("color")] = col;
+      answer[F("effect")] = strip->getModeName(FX_MODE_VOID);
+      answer[F("power")] = F("on");
+    }
+  }
+  // a range of pixels from start rnS to end rnE
   else if (request->hasParam(F("rnS")) && request->hasParam(F("rnE")))
   {
     uint16_t start = constrain((uint16_t)strtoul(request->getParam(F("rnS"))->value().c_str(), NULL, 10), 0, LED_COUNT_TOT - 1);
     uint16_t end = constrain((uint16_t)strtoul(request->getParam(F("rnE"))->value().c_str(), NULL, 10), start, LED_COUNT_TOT - 1);
-
-    // set the VOID directly avoiding the call to "setTransition"
-    // which would clear the (currently written data first
-    strip->getSegment()->mode = FX_MODE_VOID;
-    strip->setPower(true);
-    for (uint16_t i = start; i <= end; i++)
+    cmd.type  = LED_CMD_PIXELS;
+    cmd.start = start;
+    cmd.end   = end;
+    if(queueCommand(cmd))
     {
-      pLeds[i] = CRGB(color);
+      answer[F("rnS")] = start;
+      answer[F("rnE")] = end;
+      char col[10];
+      sprintf(col, "%06X", color);    
+      answer[F("color")] = col;
+      answer[F("effect")] = strip->getModeName(FX_MODE_VOID);
+      answer[F("power")] = F("on");
     }
-    answer[F("rnS")] = start;
-    answer[F("rnE")] = end;
-    char col[10];
-    sprintf(col, "%06X", color);    
-    answer[F("color")] = col;
-    answer[F("effect")] = strip->getModeName(FX_MODE_VOID);
-    answer[F("power")] = strip->getPower() ? F("on") : F("off");
-    // one color for the complete strip
   }
+  // one color for the complete strip
   else if (request->hasParam(F("rgb")))
   {
-    strip->setColor(color);
-    strip->setPower(true);
-    strip->setMode(FX_MODE_STATIC);
-    // finally set a new color
-    char col[10];
-    sprintf(col, "%06X", color);    
-    answer[F("color")] = col;
-    answer[F("effect")] = strip->getModeName(FX_MODE_STATIC);
-    answer[F("power")] = strip->getPower() ? F("on") : F("off");
+    cmd.type = LED_CMD_RGB;
+    if(queueCommand(cmd))
+    {
+      char col[10];
+      sprintf(col, "%06X", color);    
+      answer[F("color")] = col;
+      answer[F("effect")] = strip->getModeName(FX_MODE_STATIC);
+      answer[F("power")] = F("on");
+    }
   }
   // if we work with offset (i.e. dead pixel at the beginning), we can use this for setting pixels without affecting the effects at all
   // this is the first try for that.
@@ -1236,33 +1594,124 @@ void handleSet(AsyncWebServerRequest *request)
   else if (request->hasParam(F("fpi")))
   {
     uint16_t pixel = constrain((uint16_t)strtoul(request->getParam(F("fpi"))->value().c_str(), NULL, 10), 0, LED_OFFSET - 1);
-    pLeds[pixel] = CRGB(fColor);
-    // a single pixel at fpi
-    answer[F("fpi")] = pixel;
-    char col[10];
-    sprintf(col, "%06X", fColor);    
-    answer[F("fColor")] = col;
-    answer[F("power")] = strip->getPower() ? F("on") : F("off");
+    cmd.type  = LED_CMD_FREE_PIXELS;
+    cmd.start = pixel;
+    cmd.end   = pixel;
+    cmd.value = fColor;
+    if(queueCommand(cmd))
+    {
+      // a single pixel at fpi
+      answer[F("fpi")] = pixel;
+      char col[10];
+      sprintf(col, "%06X", fColor);    
+      answer[F("fColor")] = col;
+      answer[F("power")] = strip->getPower() ? F("on") : F("off");
+    }
   }
   else if (request->hasParam(F("fS")) && request->hasParam(F("fE")))
   {
     uint16_t start = constrain((uint16_t)strtoul(request->getParam(F("fS"))->value().c_str(), NULL, 10), 0, LED_OFFSET - 1);
     uint16_t end = constrain((uint16_t)strtoul(request->getParam(F("fE"))->value().c_str(), NULL, 10), start, LED_OFFSET - 1);
-    for (uint16_t i = start; i <= end; i++)
+    cmd.type  = LED_CMD_FREE_PIXELS;
+    cmd.start = start;
+    cmd.end   = end;
+    cmd.value = fColor;
+    if(queueCommand(cmd))
     {
-      pLeds[i] = CRGB(fColor);
+      answer[F("fS")] = start;
+      answer[F("fE")] = end;
+      char col[10];
+      sprintf(col, "%06X", fColor);    
+      answer[F("color")] = col;
+      answer[F("power")] = strip->getPower() ? F("on") : F("off");
     }
-    answer[F("fS")] = start;
-    answer[F("fE")] = end;
-    char col[10];
-    sprintf(col, "%06X", fColor);    
-    answer[F("color")] = col;
-    answer[F("power")] = strip->getPower() ? F("on") : F("off");
-    // one color for the complete strip
   }
   #endif
-  response->setLength();
-  request->send(response);
+  const bool queued = commitCommandBatch();
+  if(!queued)
+  {
+    answer.clear();
+    answerObj[F("error")] = F("Command queue full - nothing was applied");
+    response->setCode(503);
+  }
+  sendSetResponse(request, response, queued);
+}
+
+void handleSetBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+{
+  // the body may arrive in several chunks. It is collected into one buffer
+  // which gets freed together with the request.
+  if(total > SET_BODY_MAX_SIZE) return;
+  if(index == 0 && !request->_tempObject)
+  {
+    request->_tempObject = malloc(total);
+    if(!request->_tempObject) metrics.allocFailures++;
+  }
+  if(request->_tempObject && (index + len) <= total)
+  {
+    memcpy((uint8_t *)request->_tempObject + index, data, len);
+  }
+}
+
+void handleSetPost(AsyncWebServerRequest *request)
+{
+  PROFILE_ZONE("handleSetPost");
+  #ifdef HAS_KNOB_CONTROL
+  if(strip->getWiFiDisabled() || !WiFiConnected) return;
+  #endif
+
+  const uint8_t * body = (const uint8_t *)request->_tempObject;
+  const size_t len = request->contentLength();
+  if(!body)
+  {
+    if(request->params())
+    {
+      // form encoded parameters - same as GET
+      handleSet(request);
+    }
+    else
+    {
+      request->send(400, F("text/plain"), F("Body missing or too large"));
+    }
+    return;
+  }
+
+  AsyncJsonResponse * response = new AsyncJsonResponse(false, 1024);
+  JsonObject answerObj = response->getRoot();
+  JsonObject answer = answerObj.createNestedObject(F("currentState"));
+
+  bool valid = true;
+  bool queued = false;
+  beginCommandBatch();
+  if(request->contentType().startsWith(F("application/octet-stream")))
+  {
+    valid = (queueFieldsTLV(body, len, answer) >= 0);
+  }
+  else
+  {
+    // static: no stack or heap being used for parsing. The async callbacks do not run concurrently.
+    static StaticJsonDocument<SET_JSON_DOC_SIZE> doc;
+    valid = !deserializeJson(doc, (const char *)body, len) && doc.is<JsonObject>();
+    if(valid)
+    {
+      queueFieldsJSON(doc.as<JsonObjectConst>(), answer);
+    }
+  }
+
+  if(!valid)
+  {
+    cancelCommandBatch();
+    answer.clear();
+    answerObj[F("error")] = F("Malformed body");
+    response->setCode(400);
+  }
+  else if(!(queued = commitCommandBatch()))
+  {
+    answer.clear();
+    answerObj[F("error")] = F("Command queue full - nothing was applied");
+    response->setCode(503);
+  }
+  sendSetResponse(request, response, queued);
 }
 
 void handleNotFound(AsyncWebServerRequest * request)
@@ -1313,13 +1762,374 @@ void handleGetPals(AsyncWebServerRequest *request)
   request->send(response);
 }
 
+String getStateETag(void)
+{
+  char etag[24];
+  snprintf_P(etag, sizeof(etag), PSTR("\"%08x-%u\""), stateBootId, stateVersion);
+  return String(etag);
+}
+
+// removes the request from the long-poll and /set?latency lists (e.g. when the client went away)
+void removePendingPoll(AsyncWebServerRequest *request)
+{
+  for(uint8_t i=0; i<LONGPOLL_MAX_REQUESTS; i++)
+  {
+    if(pendingPolls[i].request == request) pendingPolls[i].request = NULL;
+  }
+  for(uint8_t i=0; i<SET_LATENCY_REQUESTS; i++)
+  {
+    if(pendingSets[i].request == request)
+    {
+      // the response was never handed over to the request
+      delete pendingSets[i].response;
+      pendingSets[i].request  = NULL;
+      pendingSets[i].response = NULL;
+    }
+  }
+}
+
+void sendSetResponse(AsyncWebServerRequest *request, AsyncJsonResponse *response, bool queued)
+{
+  if(queued && request->hasParam(F("latency")))
+  {
+    for(uint8_t i=0; i<SET_LATENCY_REQUESTS; i++)
+    {
+      if(pendingSets[i].request == NULL)
+      {
+        pendingSets[i].request  = request;
+        pendingSets[i].response = response;
+        pendingSets[i].arrival  = getCommandBatchArrival();
+        pendingSets[i].timeout  = millis() + SET_LATENCY_MAX_WAIT;
+        return;
+      }
+    }
+    // no slot left - answer without latency
+  }
+  response->setLength();
+  request->send(response);
+}
+
+void servicePendingSets(uint32_t now)
+{
+  for(uint8_t i=0; i<SET_LATENCY_REQUESTS; i++)
+  {
+    pendingSet &p = pendingSets[i];
+    if(p.request == NULL) continue;
+    uint32_t latency = 0;
+    const bool shown = getInputShown(LED_SRC_HTTP, p.arrival, latency);
+    if(!shown && (int32_t)(now - p.timeout) < 0) continue;
+
+    JsonObject root = p.response->getRoot();
+    if(shown)
+    {
+      root[F("latency_us")] = latency;
+    }
+    else
+    {
+      root[F("latency_us")] = (char *)NULL; // not shown within SET_LATENCY_MAX_WAIT
+    }
+    AsyncWebServerRequest * request = p.request;
+    AsyncJsonResponse * response = p.response;
+    p.request  = NULL;
+    p.response = NULL;
+    response->setLength();
+    request->send(response);
+  }
+}
+
+bool handleStateRequest(AsyncWebServerRequest *request, void (*send)(AsyncWebServerRequest *request))
+{
+  if(request->hasHeader(F("If-None-Match")) && request->getHeader(F("If-None-Match"))->value() == getStateETag())
+  {
+    AsyncWebServerResponse * response = request->beginResponse(304);
+    response->addHeader(F("ETag"), getStateETag());
+    request->send(response);
+    return true;
+  }
+  if(!request->hasParam(F("since")) || (uint32_t)request->getParam(F("since"))->value().toInt() != stateVersion)
+  {
+    // nothing to wait for
+    return false;
+  }
+  uint32_t wait = LONGPOLL_DEFAULT_WAIT;
+  if(request->hasParam(F("wait")))
+  {
+    wait = constrain(request->getParam(F("wait"))->value().toInt(), 0, LONGPOLL_MAX_WAIT);
+  }
+  for(uint8_t i=0; i<LONGPOLL_MAX_REQUESTS; i++)
+  {
+    if(pendingPolls[i].request == NULL)
+    {
+      pendingPolls[i].request = request;
+      pendingPolls[i].send    = send;
+      pendingPolls[i].since   = stateVersion;
+      pendingPolls[i].timeout = millis() + wait;
+      // the request object gets deleted when the client goes away (see countRequest)
+      return true;
+    }
+  }
+  // all slots in use - answer right away
+  return false;
+}
+
+void servicePendingPolls(uint32_t now)
+{
+  for(uint8_t i=0; i<LONGPOLL_MAX_REQUESTS; i++)
+  {
+    pendingPoll &p = pendingPolls[i];
+    if(p.request == NULL) continue;
+    AsyncWebServerRequest * request = p.request;
+    if(p.since != stateVersion)
+    {
+      p.request = NULL;
+      p.send(request);
+    }
+    else if((int32_t)(now - p.timeout) >= 0)
+    {
+      // nothing changed
+      p.request = NULL;
+      AsyncWebServerResponse * response = request->beginResponse(304);
+      response->addHeader(F("ETag"), getStateETag());
+      request->send(response);
+    }
+  }
+}
+
+// counts the request and measures the time until its connection gets closed
+static void countRequest(AsyncWebServerRequest *request)
+{
+  metrics.requests++;
+  const uint32_t start = millis();
+  request->onDisconnect([request, start]() {
+    const uint32_t duration = millis() - start;
+    metrics.requestsDone++;
+    metrics.requestMillis += duration;
+    if(duration > metrics.requestMaxMillis) metrics.requestMaxMillis = duration;
+    // a parked long-poll request is gone with the connection
+    removePendingPoll(request);
+  });
+}
+
+static ArRequestHandlerFunction counted(ArRequestHandlerFunction handler)
+{
+  return [handler](AsyncWebServerRequest *request) {
+    countRequest(request);
+    handler(request);
+  };
+}
+
+// writes one metric with its type
+static void printMetric(AsyncResponseStream *response, const __FlashStringHelper * name, const __FlashStringHelper * type, uint32_t value)
+{
+  response->printf_P(PSTR("# TYPE %S %S\n%S %u\n"), (PGM_P)name, (PGM_P)type, (PGM_P)name, value);
+}
+
+void handleMetrics(AsyncWebServerRequest *request)
+{
+  AsyncResponseStream *response = request->beginResponseStream(F("text/plain; version=0.0.4"));
+  const __FlashStringHelper * gauge   = F("gauge");
+  const __FlashStringHelper * counter = F("counter");
+
+  uint32_t free;
+  uint16_t max;
+  uint8_t frag;
+  ESP.getHeapStats(&free, &max, &frag);
+  printMetric(response, F("led_heap_free_bytes"), gauge, free);
+  printMetric(response, F("led_heap_max_block_bytes"), gauge, max);
+  printMetric(response, F("led_heap_fragmentation_percent"), gauge, frag);
+  printMetric(response, F("led_alloc_failures_total"), counter, metrics.allocFailures);
+  printMetric(response, F("led_uptime_seconds"), counter, millis() / 1000);
+  response->printf_P(PSTR("# TYPE led_wifi_rssi_dbm gauge\nled_wifi_rssi_dbm %d\n"), WiFi.RSSI());
+  printMetric(response, F("led_wifi_disconnects_total"), counter, metrics.wifiDisconnects);
+  printMetric(response, F("led_wifi_errors_total"), counter, metrics.wifiErrors);
+
+  const WS2812FX::frame_stats * frames = strip->getFrameStats();
+  printMetric(response, F("led_fps"), gauge, strip->getFPS());
+  printMetric(response, F("led_fastled_fps"), gauge, FastLED.getFPS());
+  printMetric(response, F("led_frames_total"), counter, frames->frames);
+  printMetric(response, F("led_frames_missed_total"), counter, frames->missed);
+  printMetric(response, F("led_render_total"), counter, frames->renders);
+  printMetric(response, F("led_render_microseconds_total"), counter, frames->renderMicros);
+  printMetric(response, F("led_render_microseconds_max"), gauge, frames->renderMaxMicros);
+  printMetric(response, F("led_render_microseconds_last"), gauge, frames->lastRenderMicros);
+  printMetric(response, F("led_render_microseconds_avg"), gauge, frames->avgRenderMicros);
+  // time left of a frame at STRIP_MAX_FPS after the calculation of the effect running (negative: too slow)
+  const int32_t headroom = (int32_t)(1000000 / STRIP_MAX_FPS) - (int32_t)frames->avgRenderMicros;
+  response->printf_P(PSTR("# TYPE led_render_headroom_microseconds gauge\nled_render_headroom_microseconds %d\n"), headroom);
+  printMetric(response, F("led_random_refills_total"), counter, RandomPool::getRefills());
+  uint32_t layerRenders = 0, layerThrottled = 0;
+  for(uint8_t l = 0; l < LAYER_COUNT; l++)
+  {
+    layerRenders   += LayerStack::getStats(l).renders;
+    layerThrottled += LayerStack::getStats(l).throttled;
+  }
+  printMetric(response, F("led_layer_renders_total"), counter, layerRenders);
+  printMetric(response, F("led_layer_throttled_total"), counter, layerThrottled);
+  #ifdef HAS_AUDIO_INPUT
+  printMetric(response, F("led_audio_samples_total"), counter, AudioInput::getSamples());
+  printMetric(response, F("led_audio_samples_held_total"), counter, AudioInput::getHeld());
+  printMetric(response, F("led_audio_overruns_total"), counter, AudioInput::getOverruns());
+  printMetric(response, F("led_audio_beats_total"), counter, AudioInput::getBeats());
+  printMetric(response, F("led_audio_bpm"), gauge, AudioInput::frame().bpm);
+  #endif
+
+  printMetric(response, F("led_http_requests_total"), counter, metrics.requests);
+  printMetric(response, F("led_http_requests_done_total"), counter, metrics.requestsDone);
+  printMetric(response, F("led_http_request_milliseconds_total"), counter, metrics.requestMillis);
+  printMetric(response, F("led_http_request_milliseconds_max"), gauge, metrics.requestMaxMillis);
+
+  uint32_t wsClients = 0, wsFull = 0;
+  if(webSocketsServer)
+  {
+    for(const auto& c: webSocketsServer->getClients())
+    {
+      if(c->status() != WS_CONNECTED) continue;
+      wsClients++;
+      if(c->queueIsFull()) wsFull++;
+    }
+  }
+  printMetric(response, F("led_ws_clients"), gauge, wsClients);
+  printMetric(response, F("led_ws_clients_queue_full"), gauge, wsFull);
+  printMetric(response, F("led_cmd_queue_depth"), gauge, getCommandQueueDepth());
+  printMetric(response, F("led_cmd_queue_dropped_total"), counter, getCommandStats()->dropped);
+
+  response->print(F("# TYPE led_input_latency_microseconds summary\n"));
+  for(uint8_t s=0; s<LED_SRC_COUNT; s++)
+  {
+    const ledLatencyStats * l = getLatencyStats((ledInputSources)s);
+    if(!l->count) continue;
+    response->printf_P(PSTR("led_input_latency_microseconds{source=\"%s\",quantile=\"0.5\"} %u\n"), latencySourceNames[s], getLatencyPercentile((ledInputSources)s, 50));
+    response->printf_P(PSTR("led_input_latency_microseconds{source=\"%s\",quantile=\"0.9\"} %u\n"), latencySourceNames[s], getLatencyPercentile((ledInputSources)s, 90));
+    response->printf_P(PSTR("led_input_latency_microseconds{source=\"%s\",quantile=\"0.99\"} %u\n"), latencySourceNames[s], getLatencyPercentile((ledInputSources)s, 99));
+    response->printf_P(PSTR("led_input_latency_microseconds_count{source=\"%s\"} %u\n"), latencySourceNames[s], l->count);
+  }
+
+  const settingsStats * settings = getSettingsStats();
+  printMetric(response, F("led_settings_writes_total"), counter, settings->writes);
+  printMetric(response, F("led_settings_compactions_total"), counter, settings->compactions);
+  printMetric(response, F("led_settings_write_failures_total"), counter, settings->failures);
+  printMetric(response, F("led_settings_changed_bytes_total"), counter, settings->bytesChanged);
+  printMetric(response, F("led_settings_written_bytes_total"), counter, settings->bytesWritten);
+  printMetric(response, F("led_settings_journal_bytes"), gauge, settings->logBytes);
+  printMetric(response, F("led_settings_stall_microseconds_total"), counter, settings->stallMicros);
+  printMetric(response, F("led_settings_stall_microseconds_max"), gauge, settings->stallMaxMicros);
+  printMetric(response, F("led_settings_stall_microseconds_last"), gauge, settings->lastStallMicros);
+  printMetric(response, F("led_settings_load_microseconds"), gauge, settings->loadMicros);
+
+  request->send(response);
+}
+
+#ifdef HAS_PROFILER
+// the trace being sent - a new request starts over (the one before stops)
+static uint32_t traceGeneration = 0;
+
+// releases the ring when it goes away - sent completely or the client aborted
+// (chunked or, for HTTP/1.0 clients, until closed - as beginChunkedResponse does)
+template <class Base>
+class TraceResponse : public Base {
+  public:
+    template <typename... Args>
+    TraceResponse(uint32_t generation, Args... args) : Base(args...), _generation(generation) {}
+    ~TraceResponse()
+    {
+      if(_generation == traceGeneration) getProfilerRing().frozen = false;
+    }
+  private:
+    const uint32_t _generation;
+};
+
+void handleTrace(AsyncWebServerRequest *request)
+{
+  // The ring is frozen while it is being sent in chunks (released with the last chunk or
+  // when the response gets deleted - e.g. the client aborted, see TraceResponse).
+  static uint16_t first, total, sent;
+  static bool closed;
+  profilerRing & ring = getProfilerRing();
+  ring.frozen = true;
+  total  = min((uint32_t)PROFILER_EVENTS, ring.count);
+  first  = (ring.head + PROFILER_EVENTS - total) % PROFILER_EVENTS;
+  sent   = 0;
+  closed = false;
+  const uint32_t generation = ++traceGeneration;
+
+  AwsResponseFiller filler = [generation](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+    if(closed || generation != traceGeneration) return 0;
+    profilerRing & ring = getProfilerRing();
+    const uint32_t mhz = ESP.getCpuFreqMHz();
+    size_t len = 0;
+    if(index == 0)
+    {
+      len += snprintf_P((char *)buffer, maxLen, PSTR("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    }
+    while(sent < total)
+    {
+      const profilerEvent & e = ring.events[(first + sent) % PROFILER_EVENTS];
+      const uint32_t us   = e.cycles / mhz;
+      const uint32_t frac = (e.cycles % mhz) * 100 / mhz;
+      char line[96];
+      const int n = snprintf_P(line, sizeof(line), PSTR("%s{\"name\":\"%S\",\"ph\":\"X\",\"ts\":%u,\"dur\":%u.%02u,\"pid\":1,\"tid\":1}"),
+                               sent ? "," : "", e.name, e.start, us, frac);
+      if(len + n > maxLen) break;
+      memcpy(buffer + len, line, n);
+      len += n;
+      sent++;
+    }
+    if(sent == total && len + 2 <= maxLen)
+    {
+      memcpy(buffer + len, "]}", 2);
+      len += 2;
+      closed = true;
+      ring.frozen = false;
+    }
+    return len ? len : RESPONSE_TRY_AGAIN;
+  };
+  const String type(F("application/json"));
+  AsyncWebServerResponse *response;
+  if(request->version())
+    response = new TraceResponse<AsyncChunkedResponse>(generation, type, filler);
+  else
+    response = new TraceResponse<AsyncCallbackResponse>(generation, type, (size_t)0, filler);
+  request->send(response);
+}
+#endif
+
 void handleStatus(AsyncWebServerRequest *request)
 {
-  // collects the current status and returns that
+  if(!handleStateRequest(request, sendStatus))
+  {
+    sendStatus(request);
+  }
+}
+
+void sendAllValues(AsyncWebServerRequest *request)
+{
+  PROFILE_ZONE("sendAllValues");
+  // Buffer size: 2048 bytes works great
   AsyncJsonResponse * response = new AsyncJsonResponse(false, 2048);
 
+  JsonObject root = response->getRoot();
+  root[F("stateVersion")] = stateVersion;
+  JsonArray arr = root.createNestedArray(F("values"));
+  if(!getAllValuesJSONArray(arr))
+  {
+    JsonObject obj = arr.createNestedObject();
+    obj[F("ValueError")] = F("Did not read any values!");
+  }
+  response->addHeader(F("ETag"), getStateETag());
+  response->setLength();
+  request->send(response);
+}
+
+void sendStatus(AsyncWebServerRequest *request)
+{
+  PROFILE_ZONE("sendStatus");
+  // collects the current status and returns that
+  AsyncJsonResponse * response = new AsyncJsonResponse(false, 4096);
+
 
   JsonObject answerObj = response->getRoot();
+  // the ETag only reflects this version - the statistics below may have changed nevertheless
+  answerObj[F("stateVersion")] = stateVersion;
   JsonObject currentStateAnswer = answerObj.createNestedObject(F("currentState"));
   JsonObject sunriseAnswer = answerObj.createNestedObject(F("sunRiseState"));
   JsonObject statsAnswer = answerObj.createNestedObject(F("Stats"));
@@ -1405,7 +2215,65 @@ void handleStatus(AsyncWebServerRequest *request)
   statsAnswer[F("esp_Runtime_Hours")]       = mESPrunTime.hours;
   statsAnswer[F("esp_Runtime_Minutes")]     = mESPrunTime.minutes;
   statsAnswer[F("esp_Runtime_Seconds")]     = mESPrunTime.seconds;
+  const ledCommandStats * cmdStats = getCommandStats();
+  statsAnswer[F("cmdQ_Depth")]              = getCommandQueueDepth();
+  statsAnswer[F("cmdQ_MaxDepth")]           = cmdStats->maxDepth;
+  statsAnswer[F("cmdQ_Queued")]             = cmdStats->queued;
+  statsAnswer[F("cmdQ_Applied")]            = cmdStats->applied;
+  statsAnswer[F("cmdQ_Coalesced")]          = cmdStats->coalesced;
+  statsAnswer[F("cmdQ_Dropped")]            = cmdStats->dropped;
+  statsAnswer[F("preview_Frames")]          = previewStats.frames;
+  statsAnswer[F("preview_Bytes")]           = previewStats.bytes;
+  statsAnswer[F("preview_Skipped")]         = previewStats.skipped;
+  const realtimeStats * rtStats = getRealtimeStats();
+  statsAnswer[F("udp_Active")]              = realtimeIsActive();
+  statsAnswer[F("udp_Packets")]             = rtStats->packets;
+  statsAnswer[F("udp_Frames")]              = rtStats->frames;
+  statsAnswer[F("udp_OutOfSequence")]       = rtStats->outOfSequence;
+  statsAnswer[F("udp_Invalid")]             = rtStats->invalid;
+  statsAnswer[F("udp_Ignored")]             = rtStats->ignored;
+  const syncStats * sync = getSyncStats();
+  statsAnswer[F("sync_Following")]          = syncIsFollowing();
+  statsAnswer[F("sync_Leader")]             = sync->leader;
+  statsAnswer[F("sync_Sent")]               = sync->sent;
+  statsAnswer[F("sync_Received")]           = sync->received;
+  statsAnswer[F("sync_Ignored")]            = sync->ignored;
+  statsAnswer[F("sync_Invalid")]            = sync->invalid;
+  statsAnswer[F("sync_Steps")]              = sync->steps;
+  statsAnswer[F("sync_Offset")]             = sync->offset;
+  statsAnswer[F("sync_Error")]              = sync->error;
+  statsAnswer[F("sse_Connects")]            = eventStats.connects;
+  statsAnswer[F("sse_Rejected")]            = eventStats.rejected;
+  statsAnswer[F("sse_Dropped")]             = eventStats.dropped;
+  statsAnswer[F("sse_Events")]              = eventStats.events;
+  const settingsStats * settings = getSettingsStats();
+  statsAnswer[F("settings_Writes")]         = settings->writes;
+  statsAnswer[F("settings_Compactions")]    = settings->compactions;
+  statsAnswer[F("settings_BytesChanged")]   = settings->bytesChanged;
+  statsAnswer[F("settings_BytesWritten")]   = settings->bytesWritten;
+  statsAnswer[F("settings_JournalBytes")]   = settings->logBytes;
+  statsAnswer[F("settings_StallMax")]       = settings->stallMaxMicros;
+  statsAnswer[F("settings_LoadMicros")]     = settings->loadMicros;
+  // boot time breakdown in ms since the reset
+  statsAnswer[F("boot_Setup")]              = bootTime.setup;
+  statsAnswer[F("boot_Settings")]           = bootTime.settings;
+  statsAnswer[F("boot_FirstFrame")]         = bootTime.firstFrame;
+  statsAnswer[F("boot_WiFi")]               = bootTime.wifi;
+  statsAnswer[F("boot_Services")]           = bootTime.services;
+  // input latency till the first FastLED.show() (us) - percentiles of the last LED_LATENCY_SAMPLES inputs
+  for(uint8_t s=0; s<LED_SRC_COUNT; s++)
+  {
+    if(!getLatencyStats((ledInputSources)s)->count) continue;
+    char key[24];
+    snprintf_P(key, sizeof(key), PSTR("lat_%s_P50"), latencySourceNames[s]);
+    statsAnswer[key] = getLatencyPercentile((ledInputSources)s, 50);
+    snprintf_P(key, sizeof(key), PSTR("lat_%s_P99"), latencySourceNames[s]);
+    statsAnswer[key] = getLatencyPercentile((ledInputSources)s, 99);
+    snprintf_P(key, sizeof(key), PSTR("lat_%s_Max"), latencySourceNames[s]);
+    statsAnswer[key] = getLatencyStats((ledInputSources)s)->max;
+  }
 
+  response->addHeader(F("ETag"), getStateETag());
   response->setLength();
   request->send(response);
 }
@@ -1418,8 +2286,7 @@ void checkFactoryReset()
       break;
     case LED_CTRL_SAVE_RESTART:
     {
-      shouldSaveRuntime = true;
-      saveEEPROMData();
+      saveRuntimeData();
       EEPROM.end();
       ESP.restart();
       break;
@@ -1436,9 +2303,7 @@ void checkFactoryReset()
       delay(INITDELAY);
       checkSegmentChanges();
       delay(INITDELAY);
-      shouldSaveRuntime = true;
-      delay(INITDELAY);
-      saveEEPROMData();
+      saveRuntimeData();
       delay(INITDELAY);
       writeLastResetReason(F("Reset Default Values"));
       ESP.restart();
@@ -1503,45 +2368,257 @@ const __FlashStringHelper * getResetReasonStr(uint8_t resetReason)
     return(F("External Trigger"));
     break;
 
-  default:
-    return(F("Unknown Cause"));
-    break;
+  default:
+    return(F("Unknown Cause"));
+    break;
+  }
+  return(F("Unknown Cause"));
+}
+
+void clearCRC(void)
+{  
+/*
+ * Clear the CRC to startup Fresh....
+ * Used in case we end up in a WDT reset (either SW or HW)
+ */
+  // we will reset anyway... so lets stop the server
+  server.end();
+  if(webSocketsServer)
+  {
+    webSocketsServer->enable(false);
+  }
+  deleteConfigFile();
+  settingsClear();
+// invalidating the CRC - in case somthing goes terribly wrong...
+  EEPROM.begin(strip->getCRCsize());
+  EEPROM.put(0,(uint16_t)0);
+  EEPROM.commit();
+  EEPROM.end();
+  delay(100);
+}
+
+void clearEEPROM(void)
+{
+  deleteConfigFile();
+  settingsClear();
+  //Clearing EEPROM
+  EEPROM.begin(strip->getSegmentSize());
+  for (uint32_t i = 0; i < EEPROM.length(); i++)
+  {
+    EEPROM.write(i, 0);
+  }
+  EEPROM.commit();
+  EEPROM.end();
+}
+
+void handlePreset(AsyncWebServerRequest *request)
+{
+  PROFILE_ZONE("handlePreset");
+  AsyncJsonResponse * response = new AsyncJsonResponse(false, 256);
+  JsonObject answerObj = response->getRoot();
+
+  const long id = request->hasParam(F("id")) ? request->getParam(F("id"))->value().toInt() : 0;
+  if(id < 1 || id > 255)
+  {
+    answerObj[F("error")] = F("Parameter id (1..255) missing");
+    response->setCode(400);
+    sendSetResponse(request, response, false);
+    return;
+  }
+  answerObj[F("preset")] = id;
+
+  bool queued = false;
+  if(request->hasParam(F("save")))
+  {
+    // written from the loop (see presetService) - the values of the frame shown then
+    const String &name = request->getParam(F("save"))->value();
+    uint8_t count = 0;
+    getPresets(&count);
+    if(getPreset(id) == NULL && count >= PRESET_MAX)
+    {
+      answerObj[F("error")] = F("All presets in use");
+      response->setCode(507);
+    }
+    else if(!queuePresetSave(id, name.c_str()))
+    {
+      answerObj[F("error")] = F("A save is pending");
+      response->setCode(503);
+    }
+    else
+    {
+      answerObj[F("saving")] = name;
+      response->setCode(202);
+    }
+  }
+  else if(request->hasParam(F("delete")))
+  {
+    if(getPreset(id) == NULL)
+    {
+      answerObj[F("error")] = F("No such preset");
+      response->setCode(404);
+    }
+    else if(!queuePresetDelete(id))
+    {
+      answerObj[F("error")] = F("A save is pending");
+      response->setCode(503);
+    }
+    else
+    {
+      answerObj[F("deleting")] = true;
+      response->setCode(202);
+    }
+  }
+  else if(getPreset(id) == NULL)
+  {
+    answerObj[F("error")] = F("No such preset");
+    response->setCode(404);
+  }
+  else
+  {
+    beginCommandBatch();
+    queuePresetRecall(id);
+    if(!(queued = commitCommandBatch()))
+    {
+      answerObj[F("error")] = F("Command queue full - nothing was applied");
+      response->setCode(503);
+    }
+    else
+    {
+      answerObj[F("name")] = getPreset(id)->name;
+    }
+  }
+  // with "latency" the answer of a recall waits till the preset was shown
+  sendSetResponse(request, response, queued);
+}
+
+void handleGetPresets(AsyncWebServerRequest *request)
+{
+  // will return all stored presets in JSON as id, name
+  AsyncJsonResponse * response = new AsyncJsonResponse(false, 1024);
+
+  JsonObject root = response->getRoot();
+  root[F("max")] = PRESET_MAX;
+  JsonArray arr = root.createNestedArray(F("presets"));
+  uint8_t count = 0;
+  const presetEntry * presets = getPresets(&count);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    JsonObject obj = arr.createNestedObject();
+    obj[F("id")] = presets[i].id;
+    obj[F("name")] = (const char *)presets[i].name;
+  }
+  response->setLength();
+  request->send(response);
+}
+
+void handlePlaylist(AsyncWebServerRequest *request)
+{
+  PROFILE_ZONE("handlePlaylist");
+  AsyncJsonResponse * response = new AsyncJsonResponse(false, 256);
+  JsonObject answerObj = response->getRoot();
+
+  bool queued = false;
+  if(request->hasParam(F("stop")))
+  {
+    beginCommandBatch();
+    queuePlaylist(0);
+    if(!(queued = commitCommandBatch()))
+    {
+      answerObj[F("error")] = F("Command queue full - nothing was applied");
+      response->setCode(503);
+    }
+    else
+    {
+      answerObj[F("stopped")] = true;
+    }
+    sendSetResponse(request, response, queued);
+    return;
+  }
+
+  const long id = request->hasParam(F("id")) ? request->getParam(F("id"))->value().toInt() : 0;
+  if(id < 1 || id > PLAYLIST_MAX)
+  {
+    answerObj[F("error")] = F("Parameter id (1..PLAYLIST_MAX) missing");
+    response->setCode(400);
+    sendSetResponse(request, response, false);
+    return;
   }
-  return(F("Unknown Cause"));
-}
+  answerObj[F("playlist")] = id;
 
-void clearCRC(void)
-{  
-/*
- * Clear the CRC to startup Fresh....
- * Used in case we end up in a WDT reset (either SW or HW)
- */
-  // we will reset anyway... so lets stop the server
-  server.end();
-  if(webSocketsServer)
+  if(request->hasParam(F("save")))
   {
-    webSocketsServer->enable(false);
+    playlistEntry entries[PLAYLIST_MAX_ENTRIES];
+    const uint8_t count = playlistParse(request->getParam(F("save"))->value().c_str(), entries, PLAYLIST_MAX_ENTRIES);
+    if(!count)
+    {
+      answerObj[F("error")] = F("Malformed playlist");
+      response->setCode(400);
+    }
+    else if(!playlistSave(id, entries, count))
+    {
+      answerObj[F("error")] = F("Playlist could not be stored");
+      response->setCode(507);
+    }
+    else
+    {
+      answerObj[F("saved")] = count;
+    }
   }
-  deleteConfigFile();
-// invalidating the CRC - in case somthing goes terribly wrong...
-  EEPROM.begin(strip->getCRCsize());
-  EEPROM.put(0,(uint16_t)0);
-  EEPROM.commit();
-  EEPROM.end();
-  delay(100);
+  else if(request->hasParam(F("delete")))
+  {
+    if(!playlistDelete(id))
+    {
+      answerObj[F("error")] = F("No such playlist");
+      response->setCode(404);
+    }
+    else
+    {
+      answerObj[F("deleted")] = true;
+    }
+  }
+  else
+  {
+    beginCommandBatch();
+    if(!queuePlaylist(id))
+    {
+      cancelCommandBatch();
+      answerObj[F("error")] = F("No such playlist");
+      response->setCode(404);
+    }
+    else if(!(queued = commitCommandBatch()))
+    {
+      answerObj[F("error")] = F("Command queue full - nothing was applied");
+      response->setCode(503);
+    }
+  }
+  sendSetResponse(request, response, queued);
 }
 
-void clearEEPROM(void)
+void handleGetPlaylists(AsyncWebServerRequest *request)
 {
-  deleteConfigFile();
-  //Clearing EEPROM
-  EEPROM.begin(strip->getSegmentSize());
-  for (uint32_t i = 0; i < EEPROM.length(); i++)
+  // will return all stored playlists in JSON as id, entries
+  // (streamed - a JsonDocument for PLAYLIST_MAX full playlists would need more than 10 kB)
+  AsyncResponseStream *response = request->beginResponseStream(F("application/json"));
+  uint8_t entry = 0;
+  const uint8_t playing = getPlaylistPlaying(&entry);
+  response->printf_P(PSTR("{\"max\":%u,\"playing\":%u,\"entry\":%u,\"playlists\":["), PLAYLIST_MAX, playing, entry);
+  playlistEntry entries[PLAYLIST_MAX_ENTRIES];
+  bool first = true;
+  for (uint8_t id = 1; id <= PLAYLIST_MAX; id++)
   {
-    EEPROM.write(i, 0);
+    const uint8_t count = playlistRead(id, entries, PLAYLIST_MAX_ENTRIES);
+    if (!count) continue;
+    response->printf_P(PSTR("%s{\"id\":%u,\"entries\":["), first ? "" : ",", id);
+    first = false;
+    for (uint8_t i = 0; i < count; i++)
+    {
+      response->printf_P(PSTR("%s{\"preset\":%u,\"mode\":%u,\"palette\":%u,\"speed\":%u,\"duration\":%u}"),
+                         i ? "," : "", entries[i].preset, entries[i].mode, entries[i].palette, entries[i].speed, entries[i].duration);
+    }
+    response->print(F("]}"));
   }
-  EEPROM.commit();
-  EEPROM.end();
+  response->print(F("]}"));
+  request->send(response);
 }
 
 void handleResetRequest(AsyncWebServerRequest * request)
@@ -1599,61 +2676,63 @@ void updateConfigFile(void)
 
 void setupWebServer(void)
 {
-  showInitColor(CRGB::Blue);
-  delay(INITDELAY);
-  
+  // a new ETag base with every boot - the state version starts over
+  stateBootId = RANDOM_REG32;
 
-  server.on(("/all"), HTTP_GET, [](AsyncWebServerRequest *request) {
+  server.on(("/all"), HTTP_GET, counted([](AsyncWebServerRequest *request) {
     if(!LittleFS.exists(F("/config_all.json")))
     {
       updateConfigFile();
     }
     request->send(LittleFS, F("/config_all.json"), F("application/json"));
-  });
+  }));
 
 
-  server.on("/allvalues", HTTP_GET, [](AsyncWebServerRequest *request) {
-    // Buffer size: 2048 bytes works great
-    AsyncJsonResponse * response = new AsyncJsonResponse(false, 2048);
-
-    JsonObject root = response->getRoot();
-    JsonArray arr = root.createNestedArray(F("values"));
-    if(!getAllValuesJSONArray(arr))
+  server.on("/allvalues", HTTP_GET, counted([](AsyncWebServerRequest *request) {
+    if(!handleStateRequest(request, sendAllValues))
     {
-      JsonObject obj = arr.createNestedObject();
-      obj[F("ValueError")] = F("Did not read any values!");
+      sendAllValues(request);
     }
-    response->setLength();
-    request->send(response);
-  });
+  }));
 
-  server.on("/fieldValue", HTTP_GET, [](AsyncWebServerRequest *request) {
+  server.on("/fieldValue", HTTP_GET, counted([](AsyncWebServerRequest *request) {
     String name = request->getParam(F("name"))->value();
     String response = getFieldValue(name.c_str());
     request->send(200, F("text/plain"), response);
-  });
+  }));
 
   
   // keepAlive
-  server.on("/ping", HTTP_GET, [](AsyncWebServerRequest *request) {
+  server.on("/ping", HTTP_GET, counted([](AsyncWebServerRequest *request) {
     request->send(200, F("text/plain"), F("Pong"));
-  });
+  }));
+
+  // POST with JSON / TLV body needs to be registered ahead of the generic /set handler
+  server.on("/set", HTTP_POST, counted(handleSetPost), nullptr, handleSetBody);
+  server.on("/set", counted(handleSet));
+  server.on("/getmodes", counted(handleGetModes));
+  server.on("/getpals", counted(handleGetPals));
+  server.on("/status", counted(handleStatus));
+  server.on("/metrics", HTTP_GET, counted(handleMetrics));
+  #ifdef HAS_PROFILER
+  server.on("/trace", HTTP_GET, counted(handleTrace));
+  #endif
+  server.on("/reset", counted(handleResetRequest));
 
-  server.on("/set", handleSet);
-  server.on("/getmodes", handleGetModes);
-  server.on("/getpals", handleGetPals);
-  server.on("/status", handleStatus);
-  server.on("/reset", handleResetRequest);
+  server.on("/preset", HTTP_GET, counted(handlePreset));
+  server.on("/presets", HTTP_GET, counted(handleGetPresets));
+  server.on("/playlist", HTTP_GET, counted(handlePlaylist));
+  server.on("/playlists", HTTP_GET, counted(handleGetPlaylists));
   
   // Serve index.htm as the main page
-  server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
+  server.on("/", HTTP_GET, counted([](AsyncWebServerRequest *request) {
     request->send(LittleFS, F("/index.htm"), F("text/html"));
-  });
+  }));
   
   //server.onNotFound(handleNotFound);
-  server.onNotFound([](AsyncWebServerRequest *request) {
+  server.onNotFound(counted([](AsyncWebServerRequest *request) {
     request->redirect("/");
-  });
+  }));
 
   /* should work without as we serve static below
   server.on("/", HTTP_OPTIONS, [](AsyncWebServerRequest *request) {
@@ -1682,16 +2761,20 @@ void setupWebServer(void)
     server.addHandler(webSocketsServer);
   }
 
+  if(eventSource == NULL) eventSource = new AsyncEventSource("/events");
+  if(eventSource)
+  {
+    eventSource->onConnect(handleEventConnect);
+    server.addHandler(eventSource);
+  }
+
   server.begin();
 
-  showInitColor(CRGB::Yellow);
-  delay(INITDELAY);
+  // realtime pixel data (DDP, E1.31, Art-Net)
+  realtimeBegin();
+  // synchronization with other strips
+  syncBegin();
 
-  
-  
- 
- 
- 
   if (!MDNS.begin(LED_NAME)) {
 
   }
@@ -1699,11 +2782,61 @@ void setupWebServer(void)
   {
     MDNS.addService("http", "tcp", 80);
   }
+}
 
-  showInitColor(CRGB::Green);
-  delay(INITDELAY);
-  showInitColor(CRGB::Black);
-  delay(INITDELAY);
+bool bootService(uint32_t now)
+{
+  static uint32_t wifiStart = 0;
+
+  switch (bootState)
+  {
+  case BOOT_WIFI_START:
+    WiFi.hostname(LED_NAME);
+    WiFi.mode(WIFI_STA);
+    WiFi.setSleepMode(WIFI_NONE_SLEEP);
+    WiFi.persistent(true);
+    if(WiFi.SSID().length() == 0)
+    {
+      // nothing stored to connect to - only the captive portal (blocking) helps
+      setupWiFi();
+      bootTime.wifi = millis();
+      bootState = BOOT_SERVICES;
+      break;
+    }
+    // connects with the stored credentials in the background
+    WiFi.begin();
+    wifiStart = now;
+    bootState = BOOT_WIFI_WAIT;
+    break;
+  case BOOT_WIFI_WAIT:
+    if(WiFi.status() == WL_CONNECTED)
+    {
+      WiFi.setAutoReconnect(true);
+      wifi_disconnect_counter = 0;
+      gateway_ip = WiFi.gatewayIP();
+    }
+    else if(now - wifiStart > BOOT_WIFI_TIMEOUT)
+    {
+      // the WiFiManager retries and opens the captive portal (or restarts)
+      setupWiFi();
+    }
+    else
+    {
+      break;
+    }
+    bootTime.wifi = millis();
+    bootState = BOOT_SERVICES;
+    break;
+  case BOOT_SERVICES:
+    setupWebServer();
+    initOverTheAirUpdate();
+    bootTime.services = millis();
+    bootState = BOOT_DONE;
+    break;
+  default:
+    break;
+  }
+  return bootState == BOOT_DONE;
 }
 
 uint8_t addClient(uint32_t iD)
@@ -1729,6 +2862,7 @@ uint8_t addClient(uint32_t iD)
           my_pingPongs[i].iD = iD;
           my_pingPongs[i].ping = 0;
           my_pingPongs[i].pong = 0;
+          my_pingPongs[i].previewInterval = 0;
           return i;
         }
     }
@@ -1759,7 +2893,133 @@ void removeClient(uint32_t iD)
       my_pingPongs[i].iD = 0;
       my_pingPongs[i].ping = 0;
       my_pingPongs[i].pong = 0;
+      my_pingPongs[i].previewInterval = 0;
+    }
+  }
+}
+
+void setPreviewRate(uint32_t iD, uint8_t fps)
+{
+  uint8_t i = getClient(iD);
+  if(i >= DEFAULT_MAX_WS_CLIENTS) return;
+  fps = min(fps, (uint8_t)PREVIEW_MAX_FPS);
+  my_pingPongs[i].previewInterval = fps ? (1000 / fps) : 0;
+  my_pingPongs[i].previewNext  = 0;
+  my_pingPongs[i].previewSeq   = 0; // starts with a key frame
+  my_pingPongs[i].previewShift = 0;
+  my_pingPongs[i].previewGood  = 0;
+}
+
+void servicePreview(uint32_t now)
+{
+  PROFILE_ZONE("servicePreview");
+  const size_t bufSize = PREVIEW_MAX_FRAME_SIZE(LED_COUNT);
+  bool subscribed = false;
+  bool due = false;
+  for(uint8_t i=0; i<DEFAULT_MAX_WS_CLIENTS; i++)
+  {
+    if(my_pingPongs[i].iD && my_pingPongs[i].previewInterval)
+    {
+      subscribed = true;
+      if((int32_t)(now - my_pingPongs[i].previewNext) >= 0) due = true;
+    }
+  }
+  if(!webSocketsServer || !subscribed)
+  {
+    // nobody is watching - release the buffers
+    if(previewPrev) { free(previewPrev); previewPrev = NULL; }
+    if(previewBuf)  { free(previewBuf);  previewBuf  = NULL; }
+    return;
+  }
+  if(!due) return;
+
+  if(!previewPrev || !previewBuf)
+  {
+    if(!previewPrev) previewPrev = (CRGB *)malloc(LED_COUNT * sizeof(CRGB));
+    if(!previewBuf)  previewBuf  = (uint8_t *)malloc(bufSize);
+    previewSeq = 0;
+    if(!previewPrev || !previewBuf)
+    {
+      metrics.allocFailures++;
+      previewStats.skipped++;
+      return;
+    }
+  }
+  // we do not want to exhaust the heap for "just" a preview
+  if(ESP.getMaxFreeBlockSize() < PREVIEW_MIN_FREE_BLOCK)
+  {
+    previewStats.skipped++;
+    return;
+  }
+
+  const CRGB * leds = strip->_bleds;
+  uint16_t newSeq = previewSeq + 1;
+  if(!newSeq) newSeq = 1; // 0 means "no frame received"
+  // the delta frame is the same for all clients being in sync - so it is encoded once
+  AsyncWebSocketMessageBuffer * deltaBuffer = NULL;
+  bool fullFrameSent = false;
+
+  for(uint8_t i=0; i<DEFAULT_MAX_WS_CLIENTS; i++)
+  {
+    pingPong &p = my_pingPongs[i];
+    if(!p.iD || !p.previewInterval || (int32_t)(now - p.previewNext) < 0) continue;
+    AsyncWebSocketClient * c = webSocketsServer->client(p.iD);
+    if(!c || c->status() != WS_CONNECTED) continue;
+
+    p.previewNext = now + p.previewInterval;
+    if(c->queueIsFull())
+    {
+      // back pressure: skip this frame and send less data from now on
+      if(p.previewShift < PREVIEW_MAX_DS_SHIFT) p.previewShift++;
+      p.previewGood = 0;
+      p.previewSeq  = 0;
+      previewStats.skipped++;
+      continue;
+    }
+
+    AsyncWebSocketMessageBuffer * buffer = NULL;
+    if(!p.previewShift && previewSeq && p.previewSeq == previewSeq)
+    {
+      if(!deltaBuffer)
+      {
+        size_t len = encodePreviewDeltaFrame(leds, previewPrev, LED_COUNT, newSeq, previewBuf, bufSize);
+        deltaBuffer = len ? webSocketsServer->makeBuffer(len) : NULL;
+        if(deltaBuffer) memcpy(deltaBuffer->get(), previewBuf, len);
+      }
+      buffer = deltaBuffer;
+    }
+    else
+    {
+      size_t len = encodePreviewKeyFrame(leds, LED_COUNT, p.previewShift, newSeq, previewBuf, bufSize);
+      buffer = len ? webSocketsServer->makeBuffer(len) : NULL;
+      if(buffer) memcpy(buffer->get(), previewBuf, len);
+    }
+    if(!buffer)
+    {
+      metrics.allocFailures++;
+      previewStats.skipped++;
+      continue;
+    }
+    c->binary(buffer);
+    previewStats.frames++;
+    previewStats.bytes += buffer->length();
+
+    if(!p.previewShift)
+    {
+      p.previewSeq = newSeq;
+      fullFrameSent = true;
     }
+    else if(++p.previewGood >= PREVIEW_RECOVER_FRAMES)
+    {
+      p.previewShift--;
+      p.previewGood = 0;
+    }
+  }
+
+  if(fullFrameSent)
+  {
+    memcpy(previewPrev, leds, LED_COUNT * sizeof(CRGB));
+    previewSeq = newSeq;
   }
 }
 
@@ -1823,12 +3083,7 @@ void webSocketEvent(AsyncWebSocket * server, AsyncWebSocketClient * client, AwsE
         Serial.printf("\n");
         #endif
       }
-      #ifdef DEBUG
-      if(info->opcode == WS_TEXT)
-       client->text("{\"message\":\"I got your text message\"}");
-      else
-        client->binary("{\"message\":\"I got your binary message\"}");
-      #endif
+      handleWebSocketControl(client, data, len, info->opcode == WS_TEXT);
     } else {
       //message is comprised of multiple frames or the frame is split into multiple packets
       if(info->index == 0){
@@ -1876,6 +3131,71 @@ void webSocketEvent(AsyncWebSocket * server, AsyncWebSocketClient * client, AwsE
   }
 }
 
+void handleWebSocketControl(AsyncWebSocketClient * client, uint8_t *data, size_t len, bool isText)
+{
+  PROFILE_ZONE("handleWebSocketControl");
+  // no answer needed - the changes get broadcasted to all clients by checkSegmentChanges
+  JsonObject noAnswer;
+
+  bool valid = false;
+  beginCommandBatch(LED_SRC_WS);
+  if(isText)
+  {
+    // static: no stack or heap being used for parsing. The async callbacks do not run concurrently.
+    static StaticJsonDocument<SET_JSON_DOC_SIZE> doc;
+    if(!deserializeJson(doc, (const char *)data, len) && doc.is<JsonObject>())
+    {
+      JsonObjectConst obj = doc.as<JsonObjectConst>();
+      if(obj.containsKey(F("preview")))
+      {
+        // {"preview": <fps>} subscribes to the live preview (0 = unsubscribe)
+        setPreviewRate(client->id(), constrain(obj[F("preview")] | 0, 0, PREVIEW_MAX_FPS));
+        cancelCommandBatch();
+        return;
+      }
+      if(obj.containsKey(F("preset")))
+      {
+        // {"preset": <id>} recalls the preset
+        valid = queuePresetRecall(constrain(obj[F("preset")] | 0, 0, 255));
+      }
+      else if(obj.containsKey(F("playlist")))
+      {
+        // {"playlist": <id>} starts the playlist (0 stops)
+        valid = queuePlaylist(constrain(obj[F("playlist")] | 0, 0, PLAYLIST_MAX));
+      }
+      else if(obj.containsKey(F("name")))
+      {
+        // {"name": <field>, "value": <value>}
+        valid = queueFieldJSON(getFieldIndex(obj[F("name")] | ""), obj[F("value")], noAnswer);
+      }
+      else
+      {
+        // {<field>: <value>, ...}
+        valid = (queueFieldsJSON(obj, noAnswer) > 0);
+      }
+    }
+  }
+  else if(len >= 2 && len <= 5)
+  {
+    // [field index][value] -> same as a single TLV entry
+    uint8_t tlv[6];
+    tlv[0] = data[0];
+    tlv[1] = len - 1;
+    memcpy(&tlv[2], &data[1], len - 1);
+    valid = (queueFieldsTLV(tlv, len + 1, noAnswer) > 0);
+  }
+
+  if(!valid)
+  {
+    cancelCommandBatch();
+    client->text(F("{\"error\":\"Invalid control message\"}"));
+  }
+  else if(!commitCommandBatch())
+  {
+    client->text(F("{\"error\":\"Command queue full\"}"));
+  }
+}
+
 #ifdef HAS_KNOB_CONTROL
 void setupKnobControl(void)
 { 
@@ -2262,6 +3582,7 @@ void showDisplay(uint8_t curr_field)
 
 void knob_service(uint32_t now)
 {
+  PROFILE_ZONE("knob_service");
   // ToDo: Use a unique and better name. 
   // Maybe make this local within the functions?
   const uint8_t fieldCount  = getFieldCount();
@@ -2279,6 +3600,7 @@ void knob_service(uint32_t now)
   static bool in_submenu = false;
   static bool newfield_selected = false;
   static bool setnewValue = false;
+  static uint32_t knobArrival = 0; // when the value started to change (for the latency)
  
   if (digitalRead(KNOB_C_BTN) == LOW && now > last_btn_press + KNOB_BTN_DEBOUNCE)
   {
@@ -2360,6 +3682,7 @@ void knob_service(uint32_t now)
           old_val = setEncoderValues(curr_field, &knb_maxVal, &knb_minVal, &knb_curVal, &knb_steps);
           newfield_selected = false;
         }
+        if(!setnewValue) knobArrival = micros();
         setnewValue = true;
         
       }
@@ -2374,6 +3697,7 @@ void knob_service(uint32_t now)
         if(fields[curr_field].setValue)
         {
           fields[curr_field].setValue(val);
+          noteInputApplied(LED_SRC_KNOB, knobArrival);
         }
       }
     }
@@ -2442,7 +3766,12 @@ void addEntropy(void)
   random16_add_entropy(esp_get_cycle_count());
   random16_add_entropy(ESP.getFreeHeap());
   random16_add_entropy(WiFi.RSSI());
+  #ifdef HAS_AUDIO_INPUT
+  // A0 belongs to the audio sampling
+  random16_add_entropy(AudioInput::lastSample());
+  #else
   random16_add_entropy(analogRead(PIN_A0));
+  #endif
 }
 
 void writeLastResetReason(const String reason)
@@ -2456,13 +3785,16 @@ void writeLastResetReason(const String reason)
 
 void setup()
 {
+  bootTime.setup = millis();
   // setup network and output pins
 
   // Sanity delay to get everything settled....
   delay(INITDELAY);
 
   // only used to add entropy to the random numbers
+  // (and for the audio reactive effects with HAS_AUDIO_INPUT)
   pinMode(A0, INPUT);
+  AudioInput::begin();
 
   addEntropy();
 
@@ -2539,20 +3871,26 @@ void setup()
 
   stripe_setup(pLeds, eLeds);
 
-  readRuntimeDataEEPROM();
+  readRuntimeData();
+  presetsBegin();
+  bootTime.settings = millis();
 
   if(!seg.wifiDisabled)
   {
     cursor = drawtxtline10(cursor, font_height, F("WiFi-Setup"));
     display.display();
     setupWiFi();
+    bootTime.wifi = millis();
     cursor = drawtxtline10(cursor, font_height, F("WebServer Setup"));
     display.display();
     setupWebServer();
     cursor = drawtxtline10(cursor, font_height, F("OTA Setup"));
     display.display();
     initOverTheAirUpdate();
+    bootTime.services = millis();
   }  
+  // the knob control shows the boot on the display - everything is up at this point
+  bootState = BOOT_DONE;
 
   delay(KNOB_BOOT_DELAY);
   display.clear();
@@ -2601,100 +3939,20 @@ void setup()
       
       break;
   }
-  delay(10);
-  
+
   FastLED.addLeds<WS2812, LED_PIN, GRB>(pLeds, LED_COUNT_TOT);
   FastLED.setBrightness(255);
  
   stripe_setup(pLeds, eLeds);
 
-
   // internal LED can be light up when current is limited by FastLED
-  
   pinMode(2, OUTPUT);
 
-
-  delay(10);
-  
-  setupWiFi();
-
-  setupWebServer();
-
-  if (!MDNS.begin(LED_NAME)) {
-
-  }
-  else
-  {
-    MDNS.addService("http", "tcp", 80);
-  }
-
-  initOverTheAirUpdate();
-
-  // if we got that far, we show by a nice little animation
-  // as setup finished signal....
-  const uint16_t mindelay = map(NUM_INFORMATION_LEDS, LED_COUNT>300?LED_COUNT:300, 0, 1, 100);
-  for (uint8_t a = 0; a < 1; a++)
-  {
-    for (uint16_t c = 0; c < 32; c += 3)
-    {
-      for (uint16_t i = 0; i < NUM_INFORMATION_LEDS; i++)
-      {
-        strip->leds[i].green = c;
-      }
-      strip->show();
-      
-      delay(mindelay);
-    }
-    delay(20);
-    for (int16_t c = strip->leds[0].green; c > 0; c -= 3)
-    {
-      for (uint16_t i = 0; i < NUM_INFORMATION_LEDS; i++)
-      {
-        strip->leds[i].subtractFromRGB(4);
-      }
-      strip->show();
-      delay(mindelay);
-    }
-  }
-  //strip->stop();
-  delay(INITDELAY);
-
-  // Show the IP Address at the beginning
-  // so one can take a picture. 
-  // one needs to know the structure of the leds...
-
-  if(LED_COUNT >= 40)
-  {
-    // can show the complete IP Address on the first 40 LEDs
-    for(uint8_t j=0; j<4; j++)
-    {
-      for(uint8_t i=0; i<8; i++)
-      {
-        if((WiFi.localIP()[j] >> i) & 0x01)
-        {
-          strip->_bleds[j * 10 + 7 - i] = CRGB::Red;
-        }
-        else
-        {
-          strip->_bleds[j * 10 + 7 - i] = CRGB(16,16,16);
-        }
-      }
-    }
-  }
-  else if(LED_COUNT >= 8)
-  {
-    // can show the last ocet i.e. 192.168.2.XXX where XXX will be shown
-  }
-  else
-  {
-    // will show the IP as a "hue" on the first LED.
-  }
-  FastLED.show();
-
-  delay(2000);
-
-  readRuntimeDataEEPROM();
-
+  // restore the last scene right away - the strip starts rendering with the first loop.
+  // WiFi, the web server, mDNS and OTA follow step by step (bootService)
+  readRuntimeData();
+  presetsBegin();
+  bootTime.settings = millis();
 
 #endif // HAS_KNOB_CONTROL
 }
@@ -2708,16 +3966,30 @@ void loop()
   if (OTAisRunning)
     return;
 
+  // cheap unless a sample slot is due - as often as possible
+  AudioInput::poll();
+
   #ifndef HAS_KNOB_CONTROL
+  if(bootState != BOOT_DONE)
+  {
+    // the restored scene is shown while the network comes up
+    strip->service();
+    if(!bootTime.firstFrame && strip->getFrameStats()->frames) bootTime.firstFrame = millis();
+    bootService(now);
+    return;
+  }
+
   // Checking WiFi state every WIFI_TIMEOUT
   // Reset on disconnection
   if (now > wifi_check_time)
   {
+    PROFILE_ZONE("wifiCheck");
     if (!WLAN_Connected)
     {
       server.end();
       if(webSocketsServer) webSocketsServer->enable(false);
       wifi_err_counter+=2;
+      metrics.wifiErrors++;
       wifi_disconnect_counter+=50; 
     }
     else
@@ -2792,8 +4064,7 @@ void loop()
     if(!wifiDisabled)
     {
       checkSegmentChanges();
-      shouldSaveRuntime = true;
-      saveEEPROMData();
+      saveRuntimeData();
       writeLastResetReason(F("WiFi disabled toggle"));
       ESP.restart();
     }
@@ -2822,6 +4093,7 @@ void loop()
       if(webSocketsServer) webSocketsServer->enable(false);
       if(WiFiConnected) last_control_operation = now;    // Will switch the display on. Only needed when we had connection and now lose it...
       wifi_err_counter+=1;
+      metrics.wifiErrors++;
       wifi_disconnect_counter+=50;
       WiFiConnected = false;
     }
@@ -2848,6 +4120,7 @@ void loop()
 
   if(!WiFiIsDisabled && WiFiConnected)
   {
+    PROFILE_ZONE("wifiService");
     ArduinoOTA.handle(); // check and handle OTA updates of the code....
     MDNS.update();
 
@@ -2870,7 +4143,13 @@ void loop()
 
   #endif
 
+  // received pixel data goes to the LEDs with this frame
+  if(WLAN_Connected) realtimeService(now);
+  // the clock and the effect of the sync leader
+  if(WLAN_Connected) syncService(now);
+
   strip->service();
+  if(!bootTime.firstFrame && strip->getFrameStats()->frames) bootTime.firstFrame = millis();
 
   if(WLAN_Connected)
   {
@@ -2879,13 +4158,23 @@ void loop()
       checkSegmentChanges();
       checkFactoryReset();
     }
+    servicePreview(now);
+    servicePendingPolls(now);
+    servicePendingSets(now);
+    EVERY_N_MILLIS(SSE_STATS_INTERVAL)
+    {
+      sendStatsEvent();
+    }
   }
 
-  EVERY_N_MILLIS(EEPROM_SAVE_INTERVAL_MS)
+  // changed settings get written (debounced) directly after a frame was shown
+  if(shouldSaveRuntime)
   {
-    saveEEPROMData();
+    settingsChanged(now);
     shouldSaveRuntime = false;
   }
+  settingsService(&seg, now);
+  presetService();
   #ifdef HAS_KNOB_CONTROL
   knob_service(now);
   #endif
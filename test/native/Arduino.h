@@ -0,0 +1,68 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+/*
+ * The parts of the Arduino core (ESP8266) the sources under test use - for the
+ * host build of [env:native] only. The clock and A0 are driven by the tests
+ * (see native.h).
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+
+typedef bool     boolean;
+typedef uint8_t  byte;
+typedef uint8_t  uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+
+#define PROGMEM
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+
+#define pgm_read_byte(addr)  (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)  (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+#define strlen_P strlen
+#define strcmp_P strcmp
+
+class __FlashStringHelper;
+#define F(s)     (reinterpret_cast<const __FlashStringHelper *>(s))
+#define FPSTR(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+class String : public std::string {
+public:
+  String() {}
+  String(const char * s) : std::string(s) {}
+  String(const __FlashStringHelper * s) : std::string(reinterpret_cast<const char *>(s)) {}
+  String(int v) : std::string(std::to_string(v)) {}
+};
+
+using std::min;
+using std::max;
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+#define INPUT  0x00
+#define OUTPUT 0x01
+#define A0     17
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void yield(void) {}
+
+uint32_t millis(void);
+uint32_t micros(void);
+void     delay(uint32_t ms);
+uint16_t analogRead(uint8_t pin);
+
+#endif
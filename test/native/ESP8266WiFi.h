@@ -0,0 +1,34 @@
+#ifndef NATIVE_ESP8266WIFI_H
+#define NATIVE_ESP8266WIFI_H
+
+/*
+ * Several instances (processes) of a test form the "network" on loopback:
+ * instance i has the chip id 1000 + i (see WiFiUdp.h).
+ */
+#include <Arduino.h>
+
+extern uint8_t nativeInstance;   // this instance
+extern uint8_t nativeInstances;  // instances on the network
+
+class IPAddress {
+public:
+  IPAddress(uint32_t address = 0) : _address(address) {}
+  operator uint32_t() const { return _address; }
+private:
+  uint32_t _address;
+};
+
+class ESPClass {
+public:
+  uint32_t getChipId(void) { return 1000 + nativeInstance; }
+};
+extern ESPClass ESP;
+
+class WiFiClass {
+public:
+  IPAddress localIP(void)    { return IPAddress(0x0100007FUL); }  // 127.0.0.1
+  IPAddress subnetMask(void) { return IPAddress(0x000000FFUL); }  // 255.0.0.0
+};
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef NATIVE_FASTLED_H
+#define NATIVE_FASTLED_H
+
+/*
+ * The color and math parts of the bundled FastLED (lib8tion, pixel types,
+ * palettes, noise) for the host build - the controllers and the platform
+ * code are left out (lib_ignore = FastLED in [env:native], native.cpp
+ * compiles the sources needed).
+ *
+ * The guards of FastLED.h and led_sysdefs.h are taken here, so the includes
+ * of "FastLED.h" inside the library do not pull in the platform code.
+ */
+#define __INC_FASTSPI_LED2_H
+#define __INC_LED_SYSDEFS_H
+
+#include <Arduino.h>
+
+#define FASTLED_NAMESPACE_BEGIN
+#define FASTLED_NAMESPACE_END
+#define FASTLED_USING_NAMESPACE
+#define FASTLED_USE_PROGMEM 0
+#define F_CPU 80000000L
+// the beat generators use millis() - unless a test runs them on the synchronized clock
+#define FASTLED_HAS_MILLIS
+
+#include "fastled_config.h"
+#include "lib8tion.h"
+#include "pixeltypes.h"
+#include "hsv2rgb.h"
+#include "colorutils.h"
+#include "colorpalettes.h"
+#include "noise.h"
+
+#define DISABLE_DITHER 0x00
+#define BINARY_DITHER  0x01
+
+// the controller part - the host has no LEDs, show() just counts
+class CFastLED {
+public:
+  CFastLED() : _brightness(255), _shows(0) {}
+  void     setBrightness(uint8_t scale) { _brightness = scale; }
+  uint8_t  getBrightness(void) { return _brightness; }
+  void     setCorrection(const CRGB &) {}
+  void     setTemperature(const CRGB &) {}
+  void     setDither(uint8_t = BINARY_DITHER) {}
+  void     setMaxRefreshRate(uint16_t, bool = false) {}
+  void     setMaxPowerInVoltsAndMilliamps(uint8_t, uint32_t) {}
+  void     clear(bool = false) {}
+  void     show(void) { _shows++; }
+  void     show(uint8_t) { _shows++; }
+  uint32_t getShows(void) { return _shows; }
+private:
+  uint8_t  _brightness;
+  uint32_t _shows;
+};
+extern CFastLED FastLED;
+
+// power management - the full power is available on the host
+inline uint32_t calculate_unscaled_power_mW(const CRGB *, uint16_t) { return 0; }
+inline uint8_t  calculate_max_brightness_for_power_mW(uint8_t target_brightness, uint32_t) { return target_brightness; }
+inline uint8_t  get_gDark_mW(void) { return 0; }
+inline uint8_t  get_gMCU_mW(void) { return 0; }
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef NATIVE_LITTLEFS_H
+#define NATIVE_LITTLEFS_H
+
+/*
+ * LittleFS in memory: the files are byte vectors by name, a test can look at
+ * (and damage) them through LittleFS.files. Writes go to the file at once -
+ * what was written before a "power loss" is what the test left in the vector.
+ */
+#include <Arduino.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef std::map<std::string, std::vector<uint8_t> > nativeFiles;
+
+class File {
+public:
+  File(nativeFiles * files = NULL, const std::string & name = "") : _files(files), _name(name), _pos(0) {}
+
+  explicit operator bool() const { return _files != NULL; }
+
+  size_t write(const uint8_t * buf, size_t len)
+  {
+    if (!_files) return 0;
+    std::vector<uint8_t> & v = (*_files)[_name];
+    v.insert(v.end(), buf, buf + len);
+    return len;
+  }
+
+  size_t read(uint8_t * buf, size_t len)
+  {
+    if (!_files) return 0;
+    const std::vector<uint8_t> & v = (*_files)[_name];
+    const size_t n = _pos < v.size() ? std::min(len, v.size() - _pos) : 0;
+    if (n) memcpy(buf, v.data() + _pos, n);
+    _pos += n;
+    return n;
+  }
+
+  int available(void)
+  {
+    if (!_files) return 0;
+    const size_t size = (*_files)[_name].size();
+    return _pos < size ? (int)(size - _pos) : 0;
+  }
+
+  size_t size(void) { return _files ? (*_files)[_name].size() : 0; }
+
+  void close(void) { _files = NULL; }
+
+private:
+  nativeFiles * _files;
+  std::string   _name;
+  size_t        _pos;
+};
+
+class FS {
+public:
+  nativeFiles files;
+
+  File open(const char * path, const char * mode)
+  {
+    if (mode[0] == 'r' && !files.count(path)) return File();
+    if (mode[0] == 'w') files[path].clear();
+    return File(&files, path);
+  }
+
+  bool exists(const char * path) { return files.count(path) != 0; }
+
+  bool rename(const char * from, const char * to)
+  {
+    if (!files.count(from)) return false;
+    files[to] = files[from];
+    files.erase(from);
+    return true;
+  }
+
+  bool remove(const char * path) { return files.erase(path) != 0; }
+};
+extern FS LittleFS;
+
+#endif
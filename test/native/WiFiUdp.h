@@ -0,0 +1,91 @@
+#ifndef NATIVE_WIFIUDP_H
+#define NATIVE_WIFIUDP_H
+
+/*
+ * UDP on loopback: instance i binds port + i, a packet sent to any address is
+ * delivered to port + 0 .. port + nativeInstances - 1 (the "broadcast" - the
+ * sender gets its own packet like on the device).
+ */
+#include "ESP8266WiFi.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+class WiFiUDP {
+public:
+  WiFiUDP() : _fd(-1), _port(0), _len(0), _pos(0), _outLen(0) {}
+  ~WiFiUDP() { if (_fd >= 0) close(_fd); }
+
+  uint8_t begin(uint16_t port)
+  {
+    _port = port;
+    _fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in a = address(port + nativeInstance);
+    if (_fd < 0 || bind(_fd, (sockaddr *)&a, sizeof(a)) < 0) return 0;
+    fcntl(_fd, F_SETFL, O_NONBLOCK);
+    return 1;
+  }
+
+  int parsePacket(void)
+  {
+    const ssize_t n = _fd < 0 ? -1 : recv(_fd, _in, sizeof(_in), 0);
+    _len = n > 0 ? n : 0;
+    _pos = 0;
+    return _len;
+  }
+
+  int read(uint8_t * data, size_t size)
+  {
+    if (size > _len - _pos) size = _len - _pos;
+    memcpy(data, &_in[_pos], size);
+    _pos += size;
+    return size;
+  }
+
+  int beginPacket(IPAddress, uint16_t)
+  {
+    _outLen = 0;
+    return 1;
+  }
+
+  size_t write(const uint8_t * data, size_t size)
+  {
+    if (size > sizeof(_out) - _outLen) size = sizeof(_out) - _outLen;
+    memcpy(&_out[_outLen], data, size);
+    _outLen += size;
+    return size;
+  }
+
+  int endPacket(void)
+  {
+    for (uint8_t i = 0; i < nativeInstances; i++)
+    {
+      sockaddr_in a = address(_port + i);
+      sendto(_fd, _out, _outLen, 0, (sockaddr *)&a, sizeof(a));
+    }
+    return 1;
+  }
+
+private:
+  static sockaddr_in address(uint16_t port)
+  {
+    sockaddr_in a;
+    memset(&a, 0, sizeof(a));
+    a.sin_family      = AF_INET;
+    a.sin_port        = htons(port);
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return a;
+  }
+
+  int     _fd;
+  uint16_t _port;
+  uint8_t _in[1472];    // a full E1.31 / Art-Net universe
+  size_t  _len;
+  size_t  _pos;
+  uint8_t _out[512];
+  size_t  _outLen;
+};
+
+#endif
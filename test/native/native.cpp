@@ -0,0 +1,74 @@
+/*
+ * The host stand-ins of [env:native] - included once by every test (the
+ * sources under test are included by the tests themselves, the library
+ * sources of the bundled FastLED they need are compiled here).
+ */
+#include "native.h"
+#include <FastLED.h>
+#include <ESP8266WiFi.h>
+#include <LittleFS.h>
+#include <time.h>
+
+#include "lib8tion.cpp"
+#include "hsv2rgb.cpp"
+#include "colorutils.cpp"
+// (the palettes are skipped behind the guard of colorpalettes.h otherwise)
+#undef __INC_COLORPALETTES_H
+#include "colorpalettes.cpp"
+#include "noise.cpp"
+
+uint32_t nativeMicros = 0;
+static nativeAnalogSource _analogSource = NULL;
+static nativeClockSource  _clockSource  = NULL;
+
+CFastLED FastLED;
+
+uint8_t   nativeInstance  = 0;
+uint8_t   nativeInstances = 1;
+ESPClass  ESP;
+WiFiClass WiFi;
+FS        LittleFS;
+
+// the matrix mapping blur2d() of colorutils.cpp links against (not used by the tests)
+uint16_t XY(uint8_t x, uint8_t y)
+{
+  return (uint16_t)y * 256 + x;
+}
+
+void nativeSetClockSource(nativeClockSource source)
+{
+  _clockSource = source;
+}
+
+uint32_t micros(void)
+{
+  if (_clockSource) nativeMicros = _clockSource();
+  return nativeMicros;
+}
+
+uint32_t millis(void)
+{
+  return micros() / 1000;
+}
+
+uint64_t nativeHostNanos(void)
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+void delay(uint32_t ms)
+{
+  nativeMicros += ms * 1000;
+}
+
+void nativeSetAnalogSource(nativeAnalogSource source)
+{
+  _analogSource = source;
+}
+
+uint16_t analogRead(uint8_t)
+{
+  return _analogSource ? _analogSource() : 512;
+}
@@ -0,0 +1,24 @@
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include <Arduino.h>
+
+/*
+ * Controls of the host stand-ins (see native.cpp): the clock only moves when
+ * a test advances it (or follows the installed source - a real time clock),
+ * A0 returns what the installed source delivers.
+ */
+extern uint32_t nativeMicros;
+
+typedef uint32_t (*nativeClockSource)(void);
+void nativeSetClockSource(nativeClockSource source);
+
+typedef uint16_t (*nativeAnalogSource)(void);
+void nativeSetAnalogSource(nativeAnalogSource source);
+
+inline void nativeAdvance(uint32_t us) { nativeMicros += us; }
+
+// the time of the host (ns, monotonic) - for the timings the tests report
+uint64_t nativeHostNanos(void);
+
+#endif
@@ -0,0 +1,237 @@
+/*
+ * Feeds WAV files (16 bit PCM, mono) through the AudioAnalyzer and through
+ * AudioInput with the sampling gaps of show() - the beat and tempo detection
+ * has to follow synthetic kick drums. A recording can be fed in addition
+ * (AUDIO_WAV=file.wav AUDIO_BPM=120 pio test -e native -f test_audio).
+ */
+#include <unity.h>
+#include "../native/native.cpp"
+#include "WS2812FX/AudioAnalyzer.cpp"
+#include "WS2812FX/AudioInput.cpp"
+#include <vector>
+#include <stdio.h>
+
+struct wav {
+  uint32_t rate;
+  std::vector<int16_t> pcm;
+};
+
+static void put16(std::vector<uint8_t> &b, uint16_t v) { b.push_back(v & 0xff); b.push_back(v >> 8); }
+static void put32(std::vector<uint8_t> &b, uint32_t v) { put16(b, v & 0xffff); put16(b, v >> 16); }
+static uint16_t get16(const uint8_t * p) { return p[0] | (p[1] << 8); }
+static uint32_t get32(const uint8_t * p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+
+// kick drum (falling 115 -> 55 Hz), hi-hat noise and a 400 Hz tone as a 16 bit mono WAV
+static std::vector<uint8_t> synthesize(uint16_t bpm, uint8_t seconds)
+{
+  const uint32_t rate = 22050;
+  const uint32_t n = rate * seconds;
+  std::vector<uint8_t> b;
+  b.insert(b.end(), {'R', 'I', 'F', 'F'}); put32(b, 36 + n * 2);
+  b.insert(b.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '}); put32(b, 16);
+  put16(b, 1); put16(b, 1); put32(b, rate); put32(b, rate * 2); put16(b, 2); put16(b, 16);
+  b.insert(b.end(), {'d', 'a', 't', 'a'}); put32(b, n * 2);
+  srand(1);
+  for (uint32_t i = 0; i < n; i++)
+  {
+    const double t  = (double)i / rate;
+    const double tb = fmod(t, 60.0 / bpm);
+    const double kick = exp(-tb * 18) * sin(2 * M_PI * (55 + 60 * exp(-tb * 30)) * tb);
+    const double hat  = ((double)rand() / RAND_MAX * 2 - 1) * 0.05;
+    const double tone = 0.15 * sin(2 * M_PI * 400 * t);
+    const double v = std::max(-1.0, std::min(1.0, 0.6 * kick + hat + tone));
+    put16(b, (uint16_t)(int16_t)(v * 30000));
+  }
+  return b;
+}
+
+static bool parse(const std::vector<uint8_t> &b, wav &w)
+{
+  if (b.size() < 12 || memcmp(&b[0], "RIFF", 4) || memcmp(&b[8], "WAVE", 4)) return false;
+  bool fmt = false;
+  for (size_t p = 12; p + 8 <= b.size();)
+  {
+    const uint32_t len = get32(&b[p + 4]);
+    if (p + 8 + len > b.size()) return false;
+    if (!memcmp(&b[p], "fmt ", 4))
+    {
+      // PCM, mono, 16 bit
+      if (len < 16 || get16(&b[p + 8]) != 1 || get16(&b[p + 10]) != 1 || get16(&b[p + 22]) != 16) return false;
+      w.rate = get32(&b[p + 12]);
+      fmt = true;
+    }
+    else if (!memcmp(&b[p], "data", 4) && fmt)
+    {
+      w.pcm.resize(len / 2);
+      for (size_t i = 0; i < w.pcm.size(); i++) w.pcm[i] = (int16_t)get16(&b[p + 8 + i * 2]);
+      return true;
+    }
+    p += 8 + len + (len & 1);
+  }
+  return false;
+}
+
+static bool load(const char * file, wav &w)
+{
+  FILE * f = fopen(file, "rb");
+  if (!f) return false;
+  std::vector<uint8_t> b;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) b.insert(b.end(), chunk, chunk + n);
+  fclose(f);
+  return parse(b, w);
+}
+
+// the ADC reading (10 bit, about +-470 around the middle) of the WAV at "us"
+static const wav * _playing = NULL;
+static uint16_t adcAt(uint32_t us)
+{
+  const size_t i = (uint64_t)us * _playing->rate / 1000000UL;
+  const int16_t s = i < _playing->pcm.size() ? _playing->pcm[i] : 0;
+  return 512 + s / 64;
+}
+
+static uint16_t playing(void)
+{
+  return adcAt(nativeMicros);
+}
+
+struct result {
+  uint32_t beats;
+  uint16_t bpm;
+};
+
+// every sample at AUDIO_SAMPLE_RATE straight into the analyzer
+static result analyze(const wav &w)
+{
+  _playing = &w;
+  AudioAnalyzer a;
+  result r = {0, 0};
+  const uint32_t duration = (uint64_t)w.pcm.size() * 1000000UL / w.rate;
+  for (uint32_t us = 0; us < duration; us += 1000000UL / AUDIO_SAMPLE_RATE)
+  {
+    if (a.addSample(adcAt(us)) && a.takeBeat()) r.beats++;
+  }
+  r.bpm = a.result().bpm;
+  return r;
+}
+
+// like on the device: the loop polls every "spin" us, each frame blocks for "show" us
+static result stream(const wav &w, uint32_t frame, uint32_t show, uint32_t spin)
+{
+  _playing = &w;
+  nativeSetAnalogSource(playing);
+  nativeMicros = 0;
+  AudioInput::begin();
+  result r = {0, 0};
+  const uint32_t duration = (uint64_t)w.pcm.size() * 1000000UL / w.rate;
+  uint32_t nextFrame = frame;
+  while (nativeMicros < duration)
+  {
+    AudioInput::poll();
+    nativeAdvance(spin);
+    if (nativeMicros >= nextFrame)
+    {
+      nextFrame += frame;
+      AudioInput::update();
+      if (AudioInput::frame().beat) r.beats++;
+      nativeAdvance(show);
+    }
+  }
+  r.bpm = AudioInput::frame().bpm;
+  AudioInput::end();
+  nativeSetAnalogSource(NULL);
+  return r;
+}
+
+static void checkTempo(uint16_t bpm, const result &r, uint8_t seconds)
+{
+  char msg[64];
+  snprintf(msg, sizeof(msg), "%u bpm: %u beats, estimated %u bpm", bpm, r.beats, r.bpm);
+  TEST_MESSAGE(msg);
+  // the first beats may be missed while the gain settles
+  TEST_ASSERT_UINT_WITHIN(3, bpm * seconds / 60, r.beats);
+  TEST_ASSERT_UINT_WITHIN(bpm / 12, bpm, r.bpm);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_wav_parse(void)
+{
+  wav w;
+  TEST_ASSERT_TRUE(parse(synthesize(120, 1), w));
+  TEST_ASSERT_EQUAL_UINT32(22050, w.rate);
+  TEST_ASSERT_EQUAL_UINT32(22050, w.pcm.size());
+  std::vector<uint8_t> broken = synthesize(120, 1);
+  broken[20] = 3;  // float samples
+  TEST_ASSERT_FALSE(parse(broken, w));
+}
+
+void test_tempo_95(void)
+{
+  wav w;
+  TEST_ASSERT_TRUE(parse(synthesize(95, 20), w));
+  checkTempo(95, analyze(w), 20);
+}
+
+void test_tempo_120(void)
+{
+  wav w;
+  TEST_ASSERT_TRUE(parse(synthesize(120, 20), w));
+  checkTempo(120, analyze(w), 20);
+}
+
+void test_no_beats_in_noise(void)
+{
+  AudioAnalyzer a;
+  srand(3);
+  for (uint32_t i = 0; i < AUDIO_SAMPLE_RATE * 10UL; i++) a.addSample(512 + rand() % 5 - 2);
+  TEST_ASSERT_EQUAL_UINT32(0, a.getBeats());
+  TEST_ASSERT_EQUAL_UINT8(0, a.result().level);
+}
+
+void test_gaps_of_show(void)
+{
+  // 60 fps with 250 LEDs: show() blocks 7.5 ms of each 16.7 ms frame
+  wav w;
+  TEST_ASSERT_TRUE(parse(synthesize(120, 20), w));
+  const result r = stream(w, 16667, 7500, 150);
+  TEST_ASSERT_GREATER_THAN(0, AudioInput::getHeld());
+  TEST_ASSERT_EQUAL_UINT32(0, AudioInput::getOverruns());
+  checkTempo(120, r, 20);
+
+  // 40 fps with 300 LEDs
+  TEST_ASSERT_TRUE(parse(synthesize(95, 20), w));
+  checkTempo(95, stream(w, 25000, 9000, 150), 20);
+}
+
+void test_recording(void)
+{
+  const char * file = getenv("AUDIO_WAV");
+  if (!file)
+  {
+    TEST_MESSAGE("no AUDIO_WAV given");
+    return;
+  }
+  wav w;
+  TEST_ASSERT_TRUE_MESSAGE(load(file, w), "AUDIO_WAV is no 16 bit PCM mono WAV");
+  const result r = analyze(w);
+  const uint8_t seconds = w.pcm.size() / w.rate;
+  const char * bpm = getenv("AUDIO_BPM");
+  if (bpm) checkTempo(atoi(bpm), r, seconds);
+  else TEST_ASSERT_GREATER_THAN(0, r.beats);
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_wav_parse);
+  RUN_TEST(test_tempo_95);
+  RUN_TEST(test_tempo_120);
+  RUN_TEST(test_no_beats_in_noise);
+  RUN_TEST(test_gaps_of_show);
+  RUN_TEST(test_recording);
+  return UNITY_END();
+}
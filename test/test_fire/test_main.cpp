@@ -0,0 +1,89 @@
+/*
+ * Fire2012: the fast paths give the values of the original calculation, and
+ * the segment holds one flame unless the build asks for several
+ * (FIRE2012_FLAMES) - numBars and mirror leave existing lamps as they were.
+ */
+#include <unity.h>
+#include "../native/native.cpp"
+#include "WS2812FX/WS2812FX_FastLED.cpp"
+#include "WS2812FX/Effect.cpp"
+#include "WS2812FX/EffectHelper.cpp"
+#include "WS2812FX/LayerStack.cpp"
+#include "WS2812FX/MatrixLayout.cpp"
+#include "WS2812FX/FastRandom.cpp"
+#include "WS2812FX/PixelKernels.cpp"
+#include "WS2812FX/SpanRaster.cpp"
+#include "WS2812FX/AudioInput.cpp"
+#include "WS2812FX/AudioAnalyzer.cpp"
+#include "WS2812FX/effects/Fire2012Effect.cpp"
+
+static CRGB physicalLeds[LED_COUNT + LED_OFFSET];
+static CRGB effectLeds[LED_COUNT];
+static WS2812FX * strip = NULL;
+
+void setUp(void)
+{
+  strip = new WS2812FX(physicalLeds, effectLeds);
+  strip->init();
+  strip->start();
+}
+
+void tearDown(void)
+{
+  delete strip;
+  strip = NULL;
+}
+
+static void test_divide_by_three(void)
+{
+  for (uint32_t x = 0; x <= 3 * 255; x++)
+  {
+    TEST_ASSERT_EQUAL_UINT32(x / 3, (x * 683) >> 11);
+  }
+}
+
+static void test_cooling_bytes(void)
+{
+  // random8(0, limit) of lib8tion is (byte * limit) >> 8 - the batched bytes keep the range
+  for (uint16_t limit = 2; limit <= 256; limit++)
+  {
+    TEST_ASSERT_TRUE(((255 * limit) >> 8) < limit);
+  }
+}
+
+// the first frames burn at the base of the segment only - no flames start further up
+static void test_one_flame(void)
+{
+  strip->setNumBars(3);
+  strip->setMirror(true);
+  strip->setSparking(255);
+  RandomPool::seed(42);
+  Effect * fire = EffectFactory::createEffect(FX_MODE_FIRE2012);
+  TEST_ASSERT_NOT_NULL(fire);
+  fill_solid(strip->leds, LED_COUNT, CRGB::Black);
+  TEST_ASSERT_TRUE(fire->init(strip));
+
+  bool burning = false;
+  for (uint8_t frame = 0; frame < 5; frame++)
+  {
+    fire->update(strip);
+    for (uint16_t i = 0; i < 7; i++) burning |= (bool)strip->leds[i];
+    // 7 cells of sparks plus two cells diffusion per frame
+    for (uint16_t i = 7 + 2 * 5; i < LED_COUNT; i++)
+    {
+      TEST_ASSERT_FALSE(strip->leds[i]);
+    }
+  }
+  TEST_ASSERT_TRUE(burning);
+  fire->cleanup();
+  delete fire;
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_divide_by_three);
+  RUN_TEST(test_cooling_bytes);
+  RUN_TEST(test_one_flame);
+  return UNITY_END();
+}
@@ -0,0 +1,151 @@
+/*
+ * The layers: which modes can run as a layer, the blend modes staying in
+ * range, and each layer rendering on its own timer - independent of the
+ * effect of the strip and of the calls coming late.
+ */
+#include <unity.h>
+#include "../native/native.cpp"
+#include "WS2812FX/WS2812FX_FastLED.cpp"
+#include "WS2812FX/Effect.cpp"
+#include "WS2812FX/EffectHelper.cpp"
+#include "WS2812FX/LayerStack.cpp"
+#include "WS2812FX/MatrixLayout.cpp"
+#include "WS2812FX/FastRandom.cpp"
+#include "WS2812FX/PixelKernels.cpp"
+#include "WS2812FX/SpanRaster.cpp"
+#include "WS2812FX/AudioInput.cpp"
+#include "WS2812FX/AudioAnalyzer.cpp"
+
+#define LAYER_INTERVAL 25     // ms the layer effect asks for
+#define BASE_INTERVAL  1000   // ms the effect of the strip asks for
+
+// counts its frames and asks for a fixed interval
+template <uint8_t MODE, uint16_t INTERVAL>
+class PacedEffect : public Effect {
+public:
+    static uint32_t frames;
+    uint16_t update(WS2812FX*) override { frames++; return INTERVAL; }
+    const __FlashStringHelper* getName() const override { return F("Paced"); }
+    uint8_t getModeId() const override { return MODE; }
+};
+template <uint8_t MODE, uint16_t INTERVAL> uint32_t PacedEffect<MODE, INTERVAL>::frames = 0;
+
+typedef PacedEffect<FX_MODE_STATIC, LAYER_INTERVAL> LayerEffect;
+typedef PacedEffect<FX_MODE_EASE, BASE_INTERVAL>    BaseEffect;
+REGISTER_EFFECT(FX_MODE_STATIC, LayerEffect)
+REGISTER_EFFECT(FX_MODE_EASE, BaseEffect)
+
+static CRGB physicalLeds[LED_COUNT + LED_OFFSET];
+static CRGB effectLeds[LED_COUNT];
+static WS2812FX * strip = NULL;
+
+// the clock moves on with every read (service() waits for the frame time)
+static uint32_t ticking(void)
+{
+  return nativeMicros + 1;
+}
+
+void setUp(void)
+{
+  nativeMicros = 1000000;
+  strip = new WS2812FX(physicalLeds, effectLeds);
+  strip->init();
+  strip->start();
+  LayerEffect::frames = 0;
+  BaseEffect::frames  = 0;
+}
+
+void tearDown(void)
+{
+  nativeSetClockSource(NULL);
+  delete strip;
+  strip = NULL;
+}
+
+static void test_layerable(void)
+{
+  TEST_ASSERT_FALSE(LayerStack::isLayerable(FX_MODE_VOID));
+  TEST_ASSERT_FALSE(LayerStack::isLayerable(FX_MODE_RING_RING));
+  TEST_ASSERT_FALSE(LayerStack::isLayerable(FX_MODE_SUNRISE));
+  TEST_ASSERT_FALSE(LayerStack::isLayerable(FX_MODE_SUNSET));
+  TEST_ASSERT_FALSE(LayerStack::isLayerable(MODE_COUNT));
+  for (uint8_t m = FX_MODE_STATIC; m < FX_MODE_VOID; m++)
+  {
+    TEST_ASSERT_TRUE(LayerStack::isLayerable(m));
+  }
+  // appended behind SUNSET - layerable where available
+  TEST_ASSERT_TRUE(LayerStack::isLayerable(FX_MODE_AUDIO_SPECTRUM));
+  TEST_ASSERT_TRUE(LayerStack::isLayerable(FX_MODE_AUDIO_VU));
+  TEST_ASSERT_TRUE(LayerStack::isLayerable(FX_MODE_AUDIO_BEAT));
+}
+
+static void test_blend_in_range(void)
+{
+  // SCREEN never wraps, MULTIPLY and every mode keep the base at opacity 0
+  for (uint16_t c = 0; c < 256; c++)
+  {
+    for (uint16_t l = 0; l < 256; l += 3)
+    {
+      for (uint16_t o = 0; o < 256; o += 5)
+      {
+        CRGB base((uint8_t)c, (uint8_t)c, (uint8_t)c);
+        const CRGB layer((uint8_t)l, (uint8_t)l, (uint8_t)l);
+        CRGB screen = base;
+        blendPixel(screen, layer, LayerStack::SCREEN, o);
+        TEST_ASSERT_TRUE(screen.r >= base.r);
+        CRGB multiply = base;
+        blendPixel(multiply, layer, LayerStack::MULTIPLY, o);
+        TEST_ASSERT_TRUE(multiply.r <= base.r);
+        if (o) continue;
+        for (uint8_t b = 0; b < LayerStack::BLEND_COUNT; b++)
+        {
+          CRGB same = base;
+          blendPixel(same, layer, b, 0);
+          TEST_ASSERT_TRUE(same == base);
+        }
+      }
+    }
+  }
+}
+
+// called every 7 ms - the layer keeps its 25 ms grid (80 frames in 2 s, not one per 28 ms)
+static void test_layer_grid(void)
+{
+  strip->setLayerMode(0, FX_MODE_STATIC);
+  strip->setLayerOpacity(0, 255);
+  const uint32_t start = millis();
+  for (uint32_t t = 0; t < 2000; t += 7)
+  {
+    LayerStack::render(strip, start + t);
+  }
+  TEST_ASSERT_UINT32_WITHIN(1, 2000 / LAYER_INTERVAL, LayerEffect::frames);
+  TEST_ASSERT_EQUAL_UINT32(LayerEffect::frames, LayerStack::getStats(0).renders);
+  LayerStack::end();
+}
+
+// the effect of the strip is due once a second - the layer renders at its own rate
+static void test_layer_own_timer(void)
+{
+  nativeSetClockSource(ticking);
+  strip->setMode(FX_MODE_EASE);
+  strip->setLayerMode(0, FX_MODE_STATIC);
+  strip->setLayerOpacity(0, 255);
+  const uint32_t start = millis();
+  while (millis() - start < 2000)
+  {
+    strip->service();
+  }
+  TEST_ASSERT_UINT32_WITHIN(1, 2000 / BASE_INTERVAL, BaseEffect::frames);
+  TEST_ASSERT_UINT32_WITHIN(2, 2000 / LAYER_INTERVAL, LayerEffect::frames);
+  LayerStack::end();
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_layerable);
+  RUN_TEST(test_blend_in_range);
+  RUN_TEST(test_layer_grid);
+  RUN_TEST(test_layer_own_timer);
+  return UNITY_END();
+}
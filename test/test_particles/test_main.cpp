@@ -0,0 +1,201 @@
+/*
+ * The particle pool: the groups share one free-list - whatever gets spawned
+ * and killed, every particle is in exactly one list and an exhausted pool
+ * spawns none. step() bounces at the lower bound (flagging the landing) and
+ * the block of the pool gets freed with the last group only.
+ */
+#include <unity.h>
+#include "../native/native.cpp"
+#include "WS2812FX/WS2812FX_FastLED.cpp"
+#include "WS2812FX/Effect.cpp"
+#include "WS2812FX/EffectHelper.cpp"
+#include "WS2812FX/LayerStack.cpp"
+#include "WS2812FX/MatrixLayout.cpp"
+#include "WS2812FX/FastRandom.cpp"
+#include "WS2812FX/PixelKernels.cpp"
+#include "WS2812FX/SpanRaster.cpp"
+#include "WS2812FX/AudioInput.cpp"
+#include "WS2812FX/AudioAnalyzer.cpp"
+#include "WS2812FX/ParticleSystem.cpp"
+
+#define GROUPS 3
+
+static uint8_t groups[GROUPS];
+
+// each particle once - in the list of one group or free - and the counts agree
+static void checkLists(void)
+{
+  static uint8_t owner[PARTICLE_POOL_SIZE];
+  memset(owner, 0xFF, sizeof(owner));
+  uint16_t listed = 0;
+  for (uint8_t g = 0; g < GROUPS; g++)
+  {
+    uint16_t n = 0;
+    for (uint16_t i = ParticleSystem::first(groups[g]); i != ParticleSystem::NONE; i = ParticleSystem::next(i))
+    {
+      TEST_ASSERT_LESS_THAN(PARTICLE_POOL_SIZE, i);
+      TEST_ASSERT_EQUAL_UINT8(0xFF, owner[i]);
+      owner[i] = g;
+      n++;
+    }
+    TEST_ASSERT_EQUAL_UINT16(ParticleSystem::count(groups[g]), n);
+    listed += n;
+  }
+  TEST_ASSERT_EQUAL_UINT16(PARTICLE_POOL_SIZE, listed + ParticleSystem::available());
+}
+
+void setUp(void)
+{
+  srand(1);
+  for (uint8_t g = 0; g < GROUPS; g++)
+  {
+    groups[g] = ParticleSystem::NO_GROUP;
+    TEST_ASSERT_TRUE(ParticleSystem::acquire(groups[g]));
+  }
+}
+
+void tearDown(void)
+{
+  for (uint8_t g = 0; g < GROUPS; g++)
+  {
+    ParticleSystem::release(groups[g]);
+  }
+}
+
+static void test_free_list(void)
+{
+  for (uint8_t g = 0; g < GROUPS; g++)
+  {
+    for (uint8_t h = 0; h < g; h++) TEST_ASSERT_NOT_EQUAL(groups[h], groups[g]);
+  }
+  // spawned and killed at random, across the groups
+  for (uint16_t k = 0; k < 20000; k++)
+  {
+    const uint8_t g = rand() % GROUPS;
+    if (rand() % 3)
+    {
+      ParticleSystem::spawn(groups[g]);
+    }
+    else if (ParticleSystem::count(groups[g]))
+    {
+      // a particle from within the list
+      uint16_t i = ParticleSystem::first(groups[g]);
+      for (uint16_t skip = rand() % ParticleSystem::count(groups[g]); skip; skip--) i = ParticleSystem::next(i);
+      ParticleSystem::kill(groups[g], i);
+    }
+    if (!(k % 97)) checkLists();
+  }
+  checkLists();
+
+  // exhausted: none spawned, no group changed
+  while (ParticleSystem::spawn(groups[rand() % GROUPS]) != ParticleSystem::NONE) {}
+  TEST_ASSERT_EQUAL_UINT16(0, ParticleSystem::available());
+  const uint16_t counts[GROUPS] = { ParticleSystem::count(groups[0]), ParticleSystem::count(groups[1]), ParticleSystem::count(groups[2]) };
+  for (uint8_t g = 0; g < GROUPS; g++)
+  {
+    TEST_ASSERT_EQUAL_UINT16(ParticleSystem::NONE, ParticleSystem::spawn(groups[g]));
+    TEST_ASSERT_EQUAL_UINT16(counts[g], ParticleSystem::count(groups[g]));
+  }
+  checkLists();
+
+  // the particles of one group back to the others
+  ParticleSystem::killAll(groups[1]);
+  TEST_ASSERT_EQUAL_UINT16(0, ParticleSystem::count(groups[1]));
+  TEST_ASSERT_EQUAL_UINT16(ParticleSystem::NONE, ParticleSystem::first(groups[1]));
+  TEST_ASSERT_EQUAL_UINT16(counts[1], ParticleSystem::available());
+  checkLists();
+  for (uint16_t k = 0; k < counts[1]; k++)
+  {
+    TEST_ASSERT_NOT_EQUAL(ParticleSystem::NONE, ParticleSystem::spawn(groups[2]));
+  }
+  TEST_ASSERT_EQUAL_UINT16(ParticleSystem::NONE, ParticleSystem::spawn(groups[0]));
+  checkLists();
+
+  // acquired again: the group is emptied
+  const uint8_t g0 = groups[0];
+  TEST_ASSERT_TRUE(ParticleSystem::acquire(groups[0]));
+  TEST_ASSERT_EQUAL_UINT8(g0, groups[0]);
+  TEST_ASSERT_EQUAL_UINT16(0, ParticleSystem::count(groups[0]));
+  checkLists();
+}
+
+static void test_step(void)
+{
+  const ParticleSystem::Physics physics = { -256 * 40, 0, 128, 256, 50 * 256 };
+  const uint16_t ball = ParticleSystem::spawn(groups[0]);
+  ParticleSystem::pos[ball]   = 300;
+  ParticleSystem::vel[ball]   = -256 * 20;
+  ParticleSystem::flags[ball] = ParticleSystem::FLAG_BOUNCE;
+  const uint16_t stone = ParticleSystem::spawn(groups[0]);
+  ParticleSystem::pos[stone]  = 300;
+  ParticleSystem::vel[stone]  = -256 * 20;
+
+  // 20 ms at 20 LED/s: 100 below the bound - the ball lands there, the stone dies
+  ParticleSystem::step(groups[0], 20, physics);
+  TEST_ASSERT_EQUAL_UINT16(1, ParticleSystem::count(groups[0]));
+  TEST_ASSERT_EQUAL_UINT16(ball, ParticleSystem::first(groups[0]));
+  TEST_ASSERT_EQUAL_INT32(physics.lower, ParticleSystem::pos[ball]);
+  TEST_ASSERT_TRUE(ParticleSystem::flags[ball] & ParticleSystem::FLAG_LANDED);
+  TEST_ASSERT_TRUE(ParticleSystem::flags[ball] & ParticleSystem::FLAG_BOUNCE);
+  // on its way up with half the speed (the gravity of the step included)
+  const int32_t impact = -256 * 20 + ((physics.gravity * 20) >> 10);
+  TEST_ASSERT_EQUAL_INT32((-impact * physics.bounce) >> 8, ParticleSystem::vel[ball]);
+
+  // flying: the landing is cleared with the next step
+  ParticleSystem::step(groups[0], 20, physics);
+  TEST_ASSERT_GREATER_THAN(physics.lower, ParticleSystem::pos[ball]);
+  TEST_ASSERT_FALSE(ParticleSystem::flags[ball] & ParticleSystem::FLAG_LANDED);
+
+  // at rest on the bound it stays there
+  for (uint16_t k = 0; k < 500; k++) ParticleSystem::step(groups[0], 20, physics);
+  TEST_ASSERT_EQUAL_INT32(physics.lower, ParticleSystem::pos[ball]);
+
+  // the life counts down - the particle dies with the step it runs out
+  ParticleSystem::life[ball] = 30;
+  ParticleSystem::step(groups[0], 20, physics);
+  TEST_ASSERT_EQUAL_UINT16(10, ParticleSystem::life[ball]);
+  ParticleSystem::step(groups[0], 20, physics);
+  TEST_ASSERT_EQUAL_UINT16(0, ParticleSystem::count(groups[0]));
+  checkLists();
+}
+
+static void test_release(void)
+{
+  for (uint8_t g = 0; g < GROUPS; g++)
+  {
+    for (uint8_t k = 0; k < 10; k++) ParticleSystem::spawn(groups[g]);
+  }
+  int32_t * const block = ParticleSystem::pos;
+  TEST_ASSERT_NOT_NULL(block);
+
+  // the others keep the pool and their particles
+  ParticleSystem::release(groups[0]);
+  TEST_ASSERT_EQUAL_UINT8(ParticleSystem::NO_GROUP, groups[0]);
+  TEST_ASSERT_TRUE(block == ParticleSystem::pos);
+  TEST_ASSERT_EQUAL_UINT16(PARTICLE_POOL_SIZE - 20, ParticleSystem::available());
+  TEST_ASSERT_EQUAL_UINT16(10, ParticleSystem::count(groups[1]));
+  checkLists();
+  ParticleSystem::release(groups[1]);
+  TEST_ASSERT_TRUE(block == ParticleSystem::pos);
+  TEST_ASSERT_EQUAL_UINT16(10, ParticleSystem::count(groups[2]));
+
+  // the last one frees it
+  ParticleSystem::release(groups[2]);
+  TEST_ASSERT_NULL(ParticleSystem::pos);
+  TEST_ASSERT_EQUAL_UINT16(0, ParticleSystem::available());
+  TEST_ASSERT_EQUAL_UINT16(ParticleSystem::NONE, ParticleSystem::spawn(0));
+
+  // and the next group allocates a fresh one
+  TEST_ASSERT_TRUE(ParticleSystem::acquire(groups[0]));
+  TEST_ASSERT_NOT_NULL(ParticleSystem::pos);
+  TEST_ASSERT_EQUAL_UINT16(PARTICLE_POOL_SIZE, ParticleSystem::available());
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_free_list);
+  RUN_TEST(test_step);
+  RUN_TEST(test_release);
+  return UNITY_END();
+}
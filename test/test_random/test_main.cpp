@@ -0,0 +1,162 @@
+/*
+ * The random numbers of the effects: the generator is xorshift32 (seeded it
+ * repeats its sequence), the pool hands out its bytes in order and costs one
+ * refill per RANDOM_POOL_SIZE bytes, and the ranged functions stay in their
+ * range with the bytes being evenly distributed. The time for a frame of 300
+ * LEDs gets reported against random8() of lib8tion.
+ */
+#include <unity.h>
+#include "../native/native.cpp"
+#include "WS2812FX/FastRandom.cpp"
+
+void setUp(void)
+{
+  RandomPool::seed(1);
+}
+
+void tearDown(void) {}
+
+static void test_xorshift(void)
+{
+  // Marsaglia, "Xorshift RNGs" (13, 17, 5)
+  FastRandom r(1);
+  TEST_ASSERT_EQUAL_UINT32(270369UL, r.next());
+  TEST_ASSERT_EQUAL_UINT32(67634689UL, r.next());
+  TEST_ASSERT_EQUAL_UINT32(2647435461UL, r.next());
+  // zero would stay zero
+  FastRandom z(0);
+  TEST_ASSERT_NOT_EQUAL(0, z.next());
+}
+
+static void test_fill(void)
+{
+  FastRandom a(7), b(7);
+  uint8_t buf[11];
+  a.fill(buf, sizeof(buf));
+  for (uint8_t i = 0; i < sizeof(buf); i += 4)
+  {
+    const uint32_t r = b.next();
+    for (uint8_t j = 0; j < 4 && i + j < sizeof(buf); j++)
+    {
+      TEST_ASSERT_EQUAL_UINT8((uint8_t)(r >> (8 * j)), buf[i + j]);
+    }
+  }
+  // the tail took a step of its own
+  TEST_ASSERT_EQUAL_UINT32(b.next(), a.next());
+}
+
+static void test_pool(void)
+{
+  FastRandom reference(1234);
+  uint8_t expected[3 * RANDOM_POOL_SIZE];
+  reference.fill(expected, sizeof(expected));
+
+  RandomPool::seed(1234);
+  const uint32_t refills = RandomPool::getRefills();
+  for (uint16_t i = 0; i < sizeof(expected); i++)
+  {
+    TEST_ASSERT_EQUAL_UINT8(expected[i], RandomPool::random8());
+  }
+  TEST_ASSERT_EQUAL_UINT32(refills + 3, RandomPool::getRefills());
+
+  // reseeding starts the sequence again (with a new block)
+  RandomPool::seed(1234);
+  TEST_ASSERT_EQUAL_UINT8(expected[0], RandomPool::random8());
+  TEST_ASSERT_EQUAL_UINT16(((uint16_t)expected[1] << 8) | expected[2], RandomPool::random16());
+}
+
+static void test_ranges(void)
+{
+  for (uint32_t i = 0; i < 100000; i++)
+  {
+    const uint8_t lim = 1 + i % 255;
+    TEST_ASSERT_LESS_THAN(lim, RandomPool::random8(lim));
+    const uint8_t v = RandomPool::random8(lim / 2, lim);
+    TEST_ASSERT_TRUE(v >= lim / 2 && v < lim);
+    const uint16_t lim16 = 1 + (i * 7919) % 65535;
+    TEST_ASSERT_LESS_THAN(lim16, RandomPool::random16(lim16));
+    const uint16_t w = RandomPool::random16(lim16 / 3, lim16);
+    TEST_ASSERT_TRUE(w >= lim16 / 3 && w < lim16);
+  }
+  TEST_ASSERT_EQUAL_UINT8(0, RandomPool::random8(0));
+  // the full range of lib8tion: random8(lim) reaches lim - 1
+  bool top = false;
+  for (uint16_t i = 0; i < 2000 && !top; i++) top = RandomPool::random8(10) == 9;
+  TEST_ASSERT_TRUE(top);
+}
+
+static void test_distribution(void)
+{
+  static uint32_t histogram[256];
+  const uint32_t draws = 256UL * 4000;
+  memset(histogram, 0, sizeof(histogram));
+  for (uint32_t i = 0; i < draws; i++)
+  {
+    histogram[RandomPool::random8()]++;
+  }
+  // chi-square of 255 degrees of freedom - 350 is beyond p = 0.0001
+  double chi = 0;
+  for (uint16_t v = 0; v < 256; v++)
+  {
+    const double d = (double)histogram[v] - draws / 256;
+    chi += d * d / (draws / 256);
+  }
+  TEST_ASSERT_LESS_THAN(350, (uint32_t)chi);
+}
+
+static void test_effect_seeds(void)
+{
+  RandomPool::seed(99);
+  const uint32_t a = RandomPool::effectSeed(0);
+  RandomPool::seed(99);
+  const uint32_t b = RandomPool::effectSeed(1);
+  TEST_ASSERT_NOT_EQUAL(a, b);
+  RandomPool::seed(99);
+  TEST_ASSERT_EQUAL_UINT32(a, RandomPool::effectSeed(0));
+}
+
+// a random byte for each pixel of 300 LEDs: lib8tion, the pool, a frame filled at once
+static void test_timing(void)
+{
+  const uint16_t count = 300;
+  const uint16_t frames = 5000;
+  static uint8_t frame[count];
+  volatile uint8_t sink = 0;
+  uint64_t t = nativeHostNanos();
+  for (uint16_t f = 0; f < frames; f++)
+  {
+    for (uint16_t i = 0; i < count; i++) sink += ::random8();
+  }
+  const uint64_t lib8tion = nativeHostNanos() - t;
+  t = nativeHostNanos();
+  for (uint16_t f = 0; f < frames; f++)
+  {
+    for (uint16_t i = 0; i < count; i++) sink += RandomPool::random8();
+  }
+  const uint64_t pool = nativeHostNanos() - t;
+  FastRandom generator(1);
+  t = nativeHostNanos();
+  for (uint16_t f = 0; f < frames; f++)
+  {
+    generator.fill(frame, count);
+    sink += frame[f % count];
+  }
+  const uint64_t filled = nativeHostNanos() - t;
+  char msg[112];
+  snprintf(msg, sizeof(msg), "%u LEDs: %.2f us random8(), %.2f us RandomPool, %.2f us filled per frame",
+           count, lib8tion / 1000.0 / frames, pool / 1000.0 / frames, filled / 1000.0 / frames);
+  TEST_MESSAGE(msg);
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_xorshift);
+  RUN_TEST(test_fill);
+  RUN_TEST(test_pool);
+  RUN_TEST(test_ranges);
+  RUN_TEST(test_distribution);
+  RUN_TEST(test_effect_seeds);
+  RUN_TEST(test_timing);
+  return UNITY_END();
+}
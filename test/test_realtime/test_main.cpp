@@ -0,0 +1,270 @@
+/*
+ * The realtime UDP decoders (DDP, E1.31, Art-Net): packets sent on loopback to
+ * the ports of the receiver have to end up in the LEDs, frames complete when
+ * pushed / all universes arrived / synced, and stale or malformed packets are
+ * dropped without touching the LEDs.
+ */
+#include <unity.h>
+#include "../native/native.cpp"
+#include "WS2812FX/WS2812FX_FastLED.cpp"
+#include "WS2812FX/Effect.cpp"
+#include "WS2812FX/EffectHelper.cpp"
+#include "WS2812FX/LayerStack.cpp"
+#include "WS2812FX/MatrixLayout.cpp"
+#include "WS2812FX/FastRandom.cpp"
+#include "WS2812FX/PixelKernels.cpp"
+#include "WS2812FX/SpanRaster.cpp"
+#include "WS2812FX/AudioInput.cpp"
+#include "WS2812FX/AudioAnalyzer.cpp"
+#include "LED_strip/led_realtime.cpp"
+
+WS2812FX * strip = NULL;
+static CRGB physicalLeds[LED_COUNT + LED_OFFSET];
+static CRGB effectLeds[LED_COUNT];
+static uint32_t now = 1000;
+static uint32_t inputsApplied = 0;
+
+// the latency is measured by led_commands.cpp
+void noteInputApplied(ledInputSources, uint32_t) { inputsApplied++; }
+
+static void sendTo(uint16_t port, const uint8_t * data, size_t len)
+{
+  const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in a;
+  memset(&a, 0, sizeof(a));
+  a.sin_family      = AF_INET;
+  a.sin_port        = htons(port);
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  TEST_ASSERT_EQUAL((int)len, (int)sendto(fd, data, len, 0, (sockaddr *)&a, sizeof(a)));
+  close(fd);
+}
+
+// the channel value of the test pattern
+static inline uint8_t pattern(uint16_t channel, uint8_t frame)
+{
+  return (uint8_t)(channel * 7 + frame * 31 + 1);
+}
+
+static bool ledsShow(uint8_t frame, uint16_t from, uint16_t to)
+{
+  const uint8_t * p = (const uint8_t *)&physicalLeds[LED_OFFSET];
+  for (uint16_t c = from; c < to; c++)
+  {
+    if (p[c] != pattern(c, frame)) return false;
+  }
+  return true;
+}
+
+static void sendDDP(uint8_t flags, uint8_t seq, uint32_t offset, uint16_t len, uint8_t frame, bool timecode = false)
+{
+  uint8_t p[DDP_HEADER_SIZE + DDP_TIMECODE_SIZE + RT_CHANNELS];
+  const uint8_t h = timecode ? DDP_HEADER_SIZE + DDP_TIMECODE_SIZE : DDP_HEADER_SIZE;
+  memset(p, 0, sizeof(p));
+  p[0] = flags | (timecode ? DDP_FLAG_TIMECODE : 0);
+  p[1] = seq;
+  p[2] = DDP_TYPE_RGB8;
+  p[3] = DDP_ID_DISPLAY;
+  p[4] = offset >> 24; p[5] = offset >> 16; p[6] = offset >> 8; p[7] = offset;
+  p[8] = len >> 8;     p[9] = len;
+  for (uint16_t i = 0; i < len && h + i < sizeof(p); i++) p[h + i] = pattern(offset + i, frame);
+  sendTo(UDP_RT_DDP_PORT, p, h + len);
+}
+
+static void sendE131(uint16_t universe, uint8_t seq, uint8_t options, uint16_t syncAddr, uint8_t frame)
+{
+  uint8_t p[E131_DATA_HEADER_SIZE + RT_CHANNELS];
+  memset(p, 0, sizeof(p));
+  p[1] = 0x10;
+  memcpy(&p[4], E131_ACN_ID, sizeof(E131_ACN_ID));
+  p[21]  = E131_VECTOR_ROOT_DATA;
+  p[43]  = E131_VECTOR_DATA_PACKET;
+  p[108] = 100;
+  p[109] = syncAddr >> 8; p[110] = syncAddr;
+  p[111] = seq;
+  p[112] = options;
+  p[113] = universe >> 8; p[114] = universe;
+  p[117] = E131_VECTOR_DMP_SET;
+  p[118] = 0xa1;
+  p[122] = 1;
+  p[123] = (RT_CHANNELS + 1) >> 8; p[124] = RT_CHANNELS + 1;
+  for (uint16_t i = 0; i < RT_CHANNELS; i++) p[E131_DATA_HEADER_SIZE + i] = pattern(i, frame);
+  sendTo(UDP_RT_E131_PORT, p, sizeof(p));
+}
+
+static void sendE131Sync(uint16_t syncAddr)
+{
+  uint8_t p[E131_SYNC_PACKET_SIZE];
+  memset(p, 0, sizeof(p));
+  p[1] = 0x10;
+  memcpy(&p[4], E131_ACN_ID, sizeof(E131_ACN_ID));
+  p[21] = E131_VECTOR_ROOT_EXT;
+  p[43] = E131_VECTOR_EXT_SYNC;
+  p[45] = syncAddr >> 8; p[46] = syncAddr;
+  sendTo(UDP_RT_E131_PORT, p, sizeof(p));
+}
+
+static void sendArtnet(uint16_t opCode, uint16_t universe, uint8_t seq, uint8_t frame)
+{
+  uint8_t p[ARTNET_HEADER_SIZE + RT_CHANNELS];
+  memset(p, 0, sizeof(p));
+  memcpy(p, ARTNET_ID, sizeof(ARTNET_ID));
+  p[8]  = opCode; p[9] = opCode >> 8;
+  p[11] = 14;
+  p[12] = seq;
+  p[14] = universe; p[15] = universe >> 8;
+  p[16] = RT_CHANNELS >> 8; p[17] = RT_CHANNELS;
+  for (uint16_t i = 0; i < RT_CHANNELS; i++) p[ARTNET_HEADER_SIZE + i] = pattern(i, frame);
+  sendTo(UDP_RT_ARTNET_PORT, p, opCode == ARTNET_OP_DMX ? sizeof(p) : 14);
+}
+
+static void service(void)
+{
+  now += 10;
+  realtimeService(now);
+}
+
+void setUp(void)
+{
+  // the previous test is over - the receiver times out and ArtSync mode ends
+  now += ARTNET_SYNC_TIMEOUT + UDP_RT_TIMEOUT;
+  realtimeService(now);
+  memset(physicalLeds, 0, sizeof(physicalLeds));
+  strip->setMode(FX_MODE_STATIC);
+  _rtStats = {0, 0, 0, 0, 0};
+  inputsApplied = 0;
+}
+
+void tearDown(void) {}
+
+static void test_ddp_frame(void)
+{
+  // two packets - held until the push flag
+  sendDDP(DDP_FLAG_VERSION_1, 1, 0, 90, 1);
+  service();
+  TEST_ASSERT_TRUE(realtimeIsActive());
+  TEST_ASSERT_EQUAL_UINT8(FX_MODE_VOID, strip->getMode());
+  TEST_ASSERT_EQUAL_UINT32(0, getRealtimeStats()->frames);
+  TEST_ASSERT_TRUE(ledsShow(1, 0, 90));
+  sendDDP(DDP_FLAG_VERSION_1 | DDP_FLAG_PUSH, 1, 90, RT_CHANNELS - 90, 1, true);
+  service();
+  TEST_ASSERT_EQUAL_UINT32(1, getRealtimeStats()->frames);
+  TEST_ASSERT_EQUAL_UINT32(2, getRealtimeStats()->packets);
+  TEST_ASSERT_EQUAL_UINT32(2, inputsApplied);
+  TEST_ASSERT_TRUE(ledsShow(1, 0, RT_CHANNELS));
+
+  // the previous effect is back after the timeout
+  now += UDP_RT_TIMEOUT + 1;
+  realtimeService(now);
+  TEST_ASSERT_FALSE(realtimeIsActive());
+  TEST_ASSERT_EQUAL_UINT8(FX_MODE_STATIC, strip->getMode());
+}
+
+static void test_ddp_rejects(void)
+{
+  sendDDP(DDP_FLAG_VERSION_1 | DDP_FLAG_PUSH, 5, 0, RT_CHANNELS, 1);
+  service();
+  TEST_ASSERT_TRUE(ledsShow(1, 0, RT_CHANNELS));
+  // older sequence, other version, query
+  sendDDP(DDP_FLAG_VERSION_1 | DDP_FLAG_PUSH, 3, 0, RT_CHANNELS, 2);
+  sendDDP(0x80 | DDP_FLAG_PUSH, 6, 0, RT_CHANNELS, 2);
+  sendDDP(DDP_FLAG_VERSION_1 | DDP_FLAG_QUERY, 6, 0, RT_CHANNELS, 2);
+  service();
+  TEST_ASSERT_EQUAL_UINT32(1, getRealtimeStats()->outOfSequence);
+  TEST_ASSERT_EQUAL_UINT32(1, getRealtimeStats()->invalid);
+  TEST_ASSERT_EQUAL_UINT32(1, getRealtimeStats()->ignored);
+  TEST_ASSERT_TRUE(ledsShow(1, 0, RT_CHANNELS));
+  // beyond the LEDs - cut at their end
+  sendDDP(DDP_FLAG_VERSION_1 | DDP_FLAG_PUSH, 7, RT_CHANNELS - 3, 9, 3);
+  service();
+  TEST_ASSERT_TRUE(ledsShow(1, 0, RT_CHANNELS - 3));
+  TEST_ASSERT_TRUE(ledsShow(3, RT_CHANNELS - 3, RT_CHANNELS));
+}
+
+static void test_e131(void)
+{
+  // a single universe holds all LEDs - each packet completes the frame
+  sendE131(UDP_RT_E131_UNIVERSE, 10, 0, 0, 1);
+  service();
+  TEST_ASSERT_EQUAL_UINT32(1, getRealtimeStats()->frames);
+  TEST_ASSERT_TRUE(ledsShow(1, 0, RT_CHANNELS));
+  // stale sequence, preview data, another universe
+  sendE131(UDP_RT_E131_UNIVERSE, 9, 0, 0, 2);
+  sendE131(UDP_RT_E131_UNIVERSE, 11, E131_OPT_PREVIEW, 0, 2);
+  sendE131(UDP_RT_E131_UNIVERSE + RT_UNIVERSES, 11, 0, 0, 2);
+  service();
+  TEST_ASSERT_EQUAL_UINT32(1, getRealtimeStats()->outOfSequence);
+  TEST_ASSERT_EQUAL_UINT32(2, getRealtimeStats()->ignored);
+  TEST_ASSERT_TRUE(ledsShow(1, 0, RT_CHANNELS));
+
+  // synchronized: held until the sync packet of its address
+  sendE131(UDP_RT_E131_UNIVERSE, 12, 0, 7, 3);
+  service();
+  TEST_ASSERT_EQUAL_UINT32(1, getRealtimeStats()->frames);
+  sendE131Sync(8);
+  service();
+  TEST_ASSERT_EQUAL_UINT32(1, getRealtimeStats()->frames);
+  sendE131Sync(7);
+  service();
+  TEST_ASSERT_EQUAL_UINT32(2, getRealtimeStats()->frames);
+  TEST_ASSERT_TRUE(ledsShow(3, 0, RT_CHANNELS));
+
+  // the sender terminates the stream - the previous effect is back at once
+  sendE131(UDP_RT_E131_UNIVERSE, 13, E131_OPT_TERMINATED, 0, 4);
+  service();
+  TEST_ASSERT_FALSE(realtimeIsActive());
+  TEST_ASSERT_EQUAL_UINT8(FX_MODE_STATIC, strip->getMode());
+}
+
+static void test_artnet(void)
+{
+  sendArtnet(ARTNET_OP_DMX, UDP_RT_ARTNET_UNIVERSE, 1, 1);
+  service();
+  TEST_ASSERT_EQUAL_UINT32(1, getRealtimeStats()->frames);
+  TEST_ASSERT_TRUE(ledsShow(1, 0, RT_CHANNELS));
+  // ArtPoll is not supported
+  sendArtnet(0x2000, 0, 0, 0);
+  service();
+  TEST_ASSERT_EQUAL_UINT32(1, getRealtimeStats()->ignored);
+
+  // with ArtSync the data waits for the next ArtSync
+  sendArtnet(ARTNET_OP_SYNC, 0, 0, 0);
+  service();
+  const uint32_t frames = getRealtimeStats()->frames;
+  sendArtnet(ARTNET_OP_DMX, UDP_RT_ARTNET_UNIVERSE, 2, 2);
+  service();
+  TEST_ASSERT_EQUAL_UINT32(frames, getRealtimeStats()->frames);
+  TEST_ASSERT_TRUE(ledsShow(2, 0, RT_CHANNELS));
+  sendArtnet(ARTNET_OP_SYNC, 0, 0, 0);
+  service();
+  TEST_ASSERT_EQUAL_UINT32(frames + 1, getRealtimeStats()->frames);
+}
+
+// an effect chosen while receiving wins - the data is ignored until the sender stopped
+static void test_overridden(void)
+{
+  sendDDP(DDP_FLAG_VERSION_1 | DDP_FLAG_PUSH, 0, 0, RT_CHANNELS, 1);
+  service();
+  strip->setMode(FX_MODE_STATIC);
+  service();
+  TEST_ASSERT_FALSE(realtimeIsActive());
+  sendDDP(DDP_FLAG_VERSION_1 | DDP_FLAG_PUSH, 0, 0, RT_CHANNELS, 2);
+  service();
+  TEST_ASSERT_EQUAL_UINT8(FX_MODE_STATIC, strip->getMode());
+  TEST_ASSERT_EQUAL_UINT32(1, getRealtimeStats()->ignored);
+  TEST_ASSERT_TRUE(ledsShow(1, 0, RT_CHANNELS));
+}
+
+int main(void)
+{
+  strip = new WS2812FX(physicalLeds, effectLeds);
+  strip->init();
+  strip->start();
+  realtimeBegin();
+  UNITY_BEGIN();
+  RUN_TEST(test_ddp_frame);
+  RUN_TEST(test_ddp_rejects);
+  RUN_TEST(test_e131);
+  RUN_TEST(test_artnet);
+  RUN_TEST(test_overridden);
+  return UNITY_END();
+}
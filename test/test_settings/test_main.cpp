@@ -0,0 +1,253 @@
+/*
+ * The settings on LittleFS: snapshot and journal give back the segment after
+ * many debounced changes, a torn journal record is dropped, unknown values are
+ * skipped, and the EEPROM settings of the versions before are taken over.
+ * The time a load takes (both ways) gets reported.
+ */
+#include <unity.h>
+#include "../native/native.cpp"
+#include "WS2812FX/WS2812FX_FastLED.cpp"
+#include "WS2812FX/Effect.cpp"
+#include "WS2812FX/EffectHelper.cpp"
+#include "WS2812FX/LayerStack.cpp"
+#include "WS2812FX/MatrixLayout.cpp"
+#include "WS2812FX/FastRandom.cpp"
+#include "WS2812FX/PixelKernels.cpp"
+#include "WS2812FX/SpanRaster.cpp"
+#include "WS2812FX/AudioInput.cpp"
+#include "WS2812FX/AudioAnalyzer.cpp"
+#include "LED_strip/led_settings.cpp"
+
+WS2812FX * strip = NULL;
+static CRGB physicalLeds[LED_COUNT + LED_OFFSET];
+static CRGB effectLeds[LED_COUNT];
+static WS2812FX::segment defaults;
+
+// a segment holding the defaults (bytes - the padding compares equal as well)
+static void reset(WS2812FX::segment * s)
+{
+  memcpy(s, &defaults, sizeof(defaults));
+}
+
+static bool same(const WS2812FX::segment * a, const WS2812FX::segment * b)
+{
+  return !memcmp(a, b, sizeof(WS2812FX::segment));
+}
+
+void setUp(void)
+{
+  settingsClear();
+  LittleFS.files.clear();
+  strip = new WS2812FX(physicalLeds, effectLeds);
+  strip->init();
+  memcpy(&defaults, strip->getSegment(), sizeof(defaults));
+}
+
+void tearDown(void)
+{
+  delete strip;
+  strip = NULL;
+}
+
+static void test_round_trip(void)
+{
+  WS2812FX::segment s, r;
+  reset(&s);
+  TEST_ASSERT_EQUAL(SETTINGS_NONE, settingsLoad(&s));
+  s.mode            = FX_MODE_EASE;
+  s.effectSpeeds[3] = 42;
+  s.solidColor      = CRGB(1, 2, 3);
+  s.power           = !s.power;
+  settingsFlush(&s);
+  reset(&r);
+  TEST_ASSERT_EQUAL(SETTINGS_LOADED, settingsLoad(&r));
+  TEST_ASSERT_TRUE(same(&s, &r));
+}
+
+// a slider dragged for minutes: the journal stays bounded and gets compacted
+static void test_journal(void)
+{
+  WS2812FX::segment s, r;
+  reset(&s);
+  settingsLoad(&s);
+  settingsFlush(&s);
+  uint32_t now = 0;
+  for (uint16_t k = 0; k < 400; k++)
+  {
+    s.effectSpeeds[k % MODE_COUNT] = k;
+    s.brightness = k;
+    settingsChanged(now);
+    now += SETTINGS_QUIET_MS + SETTINGS_FRAME_WAIT_MS;
+    settingsService(&s, now);
+    // idle now and then - time to compact
+    if (k % 50 == 49)
+    {
+      now += SETTINGS_COMPACT_IDLE_MS + 1;
+      settingsService(&s, now);
+      settingsService(&s, now + SETTINGS_MIN_INTERVAL_MS);
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(SETTINGS_LOG_MAX, LittleFS.files[SETTINGS_LOG_FILE].size());
+  }
+  const settingsStats * stats = getSettingsStats();
+  TEST_ASSERT_EQUAL_UINT32(0, stats->failures);
+  TEST_ASSERT_GREATER_THAN(0, stats->compactions);
+  // only the changed bytes get appended
+  TEST_ASSERT_LESS_THAN(stats->writes * 2 * sizeof(WS2812FX::segment), stats->bytesWritten);
+
+  reset(&r);
+  TEST_ASSERT_EQUAL(SETTINGS_LOADED, settingsLoad(&r));
+  TEST_ASSERT_TRUE(same(&s, &r));
+}
+
+// power lost while appending: the records before stay, the journal is started again
+static void test_torn_record(void)
+{
+  WS2812FX::segment s, r;
+  reset(&s);
+  settingsLoad(&s);
+  settingsFlush(&s);
+  s.cooling = 5;
+  settingsFlush(&s);
+  std::vector<uint8_t> & log = LittleFS.files[SETTINGS_LOG_FILE];
+  TEST_ASSERT_GREATER_THAN(8, log.size());
+  log.push_back(SETTINGS_RECORD_MAGIC);
+  log.push_back(9);
+
+  reset(&r);
+  TEST_ASSERT_EQUAL(SETTINGS_LOADED, settingsLoad(&r));
+  TEST_ASSERT_TRUE(same(&s, &r));
+  r.sparking = 8;
+  settingsFlush(&r);
+  reset(&s);
+  TEST_ASSERT_EQUAL(SETTINGS_LOADED, settingsLoad(&s));
+  TEST_ASSERT_EQUAL_UINT8(5, s.cooling);
+  TEST_ASSERT_EQUAL_UINT8(8, s.sparking);
+
+  // a damaged snapshot keeps the defaults
+  LittleFS.files[SETTINGS_SNAPSHOT_FILE][20] ^= 0x01;
+  reset(&r);
+  TEST_ASSERT_EQUAL(SETTINGS_INVALID, settingsLoad(&r));
+  TEST_ASSERT_TRUE(same(&defaults, &r));
+}
+
+static void test_unknown_values(void)
+{
+  WS2812FX::segment s, r;
+  reset(&s);
+  s.numBars  = 3;
+  s.fps      = 77;
+  static uint8_t tlv[2048];
+  const size_t len = settingsEncode(&s, 0, tlv, sizeof(tlv) - 4);
+  TEST_ASSERT_GREATER_THAN(0, len);
+  TEST_ASSERT_LESS_OR_EQUAL(settingsEncodedSize(0), len);
+  TEST_ASSERT_EQUAL(0, settingsEncode(&s, 0, tlv, len - 1));
+
+  // written by a later version
+  tlv[len]     = 0xEE;
+  tlv[len + 1] = 2;
+  tlv[len + 2] = 0x12;
+  tlv[len + 3] = 0x34;
+  reset(&r);
+  TEST_ASSERT_TRUE(settingsDecode(tlv, len + 4, &r));
+  TEST_ASSERT_TRUE(same(&s, &r));
+  // the length runs beyond the data
+  TEST_ASSERT_FALSE(settingsDecode(tlv, len + 3, &r));
+}
+
+static void test_legacy(void)
+{
+  TEST_ASSERT_EQUAL(176, settingsLegacySize());
+  uint8_t blob[176];
+  memset(blob, 0, sizeof(blob));
+  const uint16_t beat88 = 1234;
+  memcpy(&blob[2], &beat88, 2);
+  for (uint8_t m = 0; m < 54; m++)
+  {
+    const uint16_t speed = 100 + m;
+    memcpy(&blob[4 + 2 * m], &speed, 2);
+  }
+  blob[112] = 9;            // solidColor
+  blob[113] = 8;
+  blob[114] = 7;
+  const uint32_t colorTemp = 0xFF0000;
+  memcpy(&blob[116], &colorTemp, 4);
+  blob[134] = FX_MODE_EASE; // mode
+  const uint16_t crc = WS2812FX::calc_CRC16(0x5a5a, &blob[2], sizeof(blob) - 2);
+  memcpy(blob, &crc, 2);
+
+  WS2812FX::segment r;
+  reset(&r);
+  TEST_ASSERT_TRUE(settingsDecodeLegacy(blob, sizeof(blob), &r));
+  TEST_ASSERT_EQUAL_UINT16(1234, r.beat88);
+  TEST_ASSERT_EQUAL_UINT16(153, r.effectSpeeds[53]);
+  // modes added later keep their default
+  TEST_ASSERT_EQUAL_UINT16(defaults.effectSpeeds[54], r.effectSpeeds[54]);
+  TEST_ASSERT_TRUE(r.solidColor == CRGB(9, 8, 7));
+  TEST_ASSERT_EQUAL_UINT32(0xFF0000, r.colorTemp);
+  TEST_ASSERT_EQUAL_UINT8(FX_MODE_EASE, r.mode);
+
+  blob[50] ^= 0x01;
+  TEST_ASSERT_FALSE(settingsDecodeLegacy(blob, sizeof(blob), &r));
+  TEST_ASSERT_FALSE(settingsDecodeLegacy(blob, sizeof(blob) - 1, &r));
+}
+
+// what a boot costs: the snapshot with a journal of changes, and the EEPROM blob taken over
+static void test_timing(void)
+{
+  WS2812FX::segment s, r;
+  reset(&s);
+  settingsLoad(&s);
+  settingsFlush(&s);
+  uint32_t now = 0;
+  for (uint16_t k = 0; k < 60; k++)
+  {
+    s.effectSpeeds[k % MODE_COUNT] = 1000 + k;
+    s.hueTime = k;
+    settingsChanged(now);
+    now += SETTINGS_QUIET_MS + SETTINGS_FRAME_WAIT_MS;
+    settingsService(&s, now);
+  }
+  const size_t journal = LittleFS.files[SETTINGS_LOG_FILE].size();
+  TEST_ASSERT_GREATER_THAN(0, journal);
+
+  const uint16_t loads = 2000;
+  uint64_t t = nativeHostNanos();
+  for (uint16_t i = 0; i < loads; i++)
+  {
+    reset(&r);
+    settingsLoad(&r);
+  }
+  t = nativeHostNanos() - t;
+  TEST_ASSERT_TRUE(same(&s, &r));
+  char msg[96];
+  snprintf(msg, sizeof(msg), "snapshot %u bytes + journal %u bytes: %.1f us per load",
+           (unsigned)LittleFS.files[SETTINGS_SNAPSHOT_FILE].size(), (unsigned)journal, t / 1000.0 / loads);
+  TEST_MESSAGE(msg);
+
+  uint8_t blob[176];
+  memset(blob, 0, sizeof(blob));
+  blob[134] = FX_MODE_EASE;
+  const uint16_t crc = WS2812FX::calc_CRC16(0x5a5a, &blob[2], sizeof(blob) - 2);
+  memcpy(blob, &crc, 2);
+  t = nativeHostNanos();
+  for (uint16_t i = 0; i < loads; i++)
+  {
+    reset(&r);
+    TEST_ASSERT_TRUE(settingsDecodeLegacy(blob, sizeof(blob), &r));
+  }
+  t = nativeHostNanos() - t;
+  snprintf(msg, sizeof(msg), "legacy EEPROM %u bytes: %.2f us per load", (unsigned)sizeof(blob), t / 1000.0 / loads);
+  TEST_MESSAGE(msg);
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_journal);
+  RUN_TEST(test_torn_record);
+  RUN_TEST(test_unknown_values);
+  RUN_TEST(test_legacy);
+  RUN_TEST(test_timing);
+  return UNITY_END();
+}
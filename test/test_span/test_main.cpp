@@ -0,0 +1,162 @@
+/*
+ * The spans: the pixels get lit by their coverage (1/256 pixel) - within one
+ * LSB of the bars drawn in 1/16 pixel before (drawFractionalBar as it was),
+ * with the light of a span being its length and the gradient kept in place
+ * when clipped. The time per bar gets reported for both.
+ */
+#include <unity.h>
+#include "../native/native.cpp"
+#include "WS2812FX/SpanRaster.cpp"
+
+#define BENCH_LEDS  300
+#define BENCH_BARS  200000
+
+// drawFractionalBar as it was (a palette distribution of 100, the segment being the buffer)
+static void fractionalBar(CRGB * leds, int count, int pos16, int width, const CRGBPalette16 &pal, uint8_t cindex, uint8_t max_bright, bool mixColors, uint8_t incIndex)
+{
+  int i = pos16 / 16;
+  const uint8_t frac = pos16 & 0x0F;
+  const uint8_t firstpixelbrightness = scale8((255 - (frac * 16)), max_bright);
+  const uint8_t lastpixelbrightness  = scale8((255 - firstpixelbrightness), max_bright);
+  bool mix = true;
+  for (int n = 0; n <= width; n++, i++)
+  {
+    uint8_t bright = max_bright;
+    if (n == 0)          bright = firstpixelbrightness;
+    else if (n == width) bright = lastpixelbrightness;
+    else                 mix = false;
+    CRGB newColor = ColorFromPalette(pal, cindex + (uint8_t)(n * incIndex), bright, LINEARBLEND);
+    if (n && n < width && incIndex)
+    {
+      CRGB prev_col = ColorFromPalette(pal, cindex + (uint8_t)((n - 1) * incIndex), bright, LINEARBLEND);
+      CRGB next_col = ColorFromPalette(pal, cindex + (uint8_t)((n + 1) * incIndex), bright, LINEARBLEND);
+      newColor = nblend(newColor, nblend(prev_col, next_col, firstpixelbrightness), 128);
+    }
+    if (i < 0 || i >= count) continue;
+    if (mixColors || mix) leds[i] |= newColor;
+    else                  leds[i] = newColor;
+  }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// a bar of one color at every 1/16 pixel, as drawn before
+static void test_fractional_bar(void)
+{
+  const CRGBPalette16 pal = RainbowColors_p;
+  static CRGB expected[LED_COUNT], actual[LED_COUNT];
+  for (uint16_t cindex = 0; cindex < 256; cindex += 37)
+  {
+    for (int pos16 = 0; pos16 < LED_COUNT * 16; pos16++)
+    {
+      for (int width = 1; width < 6; width++)
+      {
+        memset(expected, 0, sizeof(expected));
+        memset(actual, 0, sizeof(actual));
+        fractionalBar(expected, LED_COUNT, pos16, width, pal, cindex, 255, true, 0);
+        SpanRaster::fillPalette(actual, LED_COUNT, pos16 * 16, (pos16 + width * 16) * 16, pal, cindex, 0, 255, LINEARBLEND, SpanRaster::MAX);
+        for (uint16_t i = 0; i < LED_COUNT; i++)
+        {
+          for (uint8_t c = 0; c < 3; c++)
+          {
+            TEST_ASSERT_UINT_WITHIN(1, expected[i][c], actual[i][c]);
+          }
+        }
+      }
+    }
+  }
+}
+
+static void test_edges(void)
+{
+  // a quarter of a pixel within pixel 1
+  CRGB s[4];
+  memset(s, 0, sizeof(s));
+  SpanRaster::fillSolid(s, 4, 256 + 64, 256 + 128, CRGB(255, 255, 255), SpanRaster::ADD);
+  TEST_ASSERT_FALSE(s[0]);
+  TEST_ASSERT_UINT_WITHIN(1, 64, s[1].r);
+  TEST_ASSERT_FALSE(s[2]);
+
+  // half of pixel 0, pixels 1 and 2, a quarter of pixel 3
+  SpanRaster::fillSolid(s, 4, 128, 3 * 256 + 64, CRGB(200, 0, 0), SpanRaster::REPLACE);
+  TEST_ASSERT_UINT_WITHIN(1, 100, s[0].r);
+  TEST_ASSERT_EQUAL_UINT8(200, s[1].r);
+  TEST_ASSERT_EQUAL_UINT8(200, s[2].r);
+  TEST_ASSERT_UINT_WITHIN(1, 50, s[3].r);
+}
+
+// the light of a span is its length - wherever it lies, also when clipped
+static void test_coverage(void)
+{
+  static CRGB leds[50];
+  srand(3);
+  for (uint16_t k = 0; k < 5000; k++)
+  {
+    const int32_t from = (int32_t)(rand() % (60 * 256)) - 5 * 256;
+    const int32_t to   = from + rand() % (8 * 256);
+    memset(leds, 0, sizeof(leds));
+    SpanRaster::fillSolid(leds, 50, from, to, CRGB(255, 255, 255), SpanRaster::MAX);
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < 50; i++) sum += leds[i].g;
+    const int32_t clippedFrom = from < 0 ? 0 : from;
+    const int32_t clippedTo   = to > 50 * 256 ? 50 * 256 : to;
+    const int32_t expected    = clippedTo > clippedFrom ? (clippedTo - clippedFrom) * 255 / 256 : 0;
+    TEST_ASSERT_INT_WITHIN(2, expected, sum);
+  }
+}
+
+static void test_clipped_gradient(void)
+{
+  CRGBPalette16 pal = RainbowColors_p;
+  CRGB clipped[20], full[40];
+  memset(clipped, 0, sizeof(clipped));
+  memset(full, 0, sizeof(full));
+  SpanRaster::fillPalette(clipped, 20, -10 * 256, 10 * 256, pal, 0, 5 * 256, 255, LINEARBLEND, SpanRaster::REPLACE);
+  SpanRaster::fillPalette(full, 40, 0, 20 * 256, pal, 0, 5 * 256, 255, LINEARBLEND, SpanRaster::REPLACE);
+  TEST_ASSERT_EQUAL_MEMORY(&full[10], clipped, 10 * sizeof(CRGB));
+  for (uint16_t i = 10; i < 20; i++)
+  {
+    TEST_ASSERT_FALSE(clipped[i]);
+  }
+  // completely outside
+  SpanRaster::fillPalette(clipped, 20, 20 * 256, 30 * 256, pal, 0, 256, 255, LINEARBLEND, SpanRaster::REPLACE);
+  SpanRaster::fillPalette(clipped, 20, -30 * 256, -20 * 256, pal, 0, 256, 255, LINEARBLEND, SpanRaster::REPLACE);
+  TEST_ASSERT_EQUAL_MEMORY(&full[10], clipped, 10 * sizeof(CRGB));
+}
+
+// a gradient bar of 8 pixels (as the bar effects draw them) all over a strip of BENCH_LEDS
+static void test_timing(void)
+{
+  const CRGBPalette16 pal = RainbowColors_p;
+  static CRGB leds[BENCH_LEDS];
+  uint64_t t = nativeHostNanos();
+  for (uint32_t k = 0; k < BENCH_BARS; k++)
+  {
+    fractionalBar(leds, BENCH_LEDS, (k * 7) % (BENCH_LEDS * 16), 8, pal, k, 255, true, 1);
+  }
+  const uint64_t before = nativeHostNanos() - t;
+  t = nativeHostNanos();
+  for (uint32_t k = 0; k < BENCH_BARS; k++)
+  {
+    const int32_t from = ((k * 7) % (BENCH_LEDS * 16)) * 16;
+    SpanRaster::fillPalette(leds, BENCH_LEDS, from, from + 8 * 256, pal, k, 256, 255, LINEARBLEND, SpanRaster::MAX);
+  }
+  const uint64_t span = nativeHostNanos() - t;
+  char msg[96];
+  snprintf(msg, sizeof(msg), "8 pixel gradient bar: %.1f ns in 1/16 pixel, %.1f ns as span",
+           (double)before / BENCH_BARS, (double)span / BENCH_BARS);
+  TEST_MESSAGE(msg);
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_fractional_bar);
+  RUN_TEST(test_edges);
+  RUN_TEST(test_coverage);
+  RUN_TEST(test_clipped_gradient);
+  RUN_TEST(test_timing);
+  return UNITY_END();
+}
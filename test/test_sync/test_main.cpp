@@ -0,0 +1,350 @@
+/*
+ * Strips in sync: the beat based effects have to render from the effect timebase
+ * (the same time since the timebase - the same frame, whatever the clock says),
+ * an effect prepared ahead has to start with the switch it was prepared for
+ * (a pooled one being the same instance with each switch), and three strips on loopback (one leader, two followers with clocks of their
+ * own rate and start) have to run the effect of the leader in phase with it.
+ */
+#define USE_GET_MILLISECOND_TIMER
+#include <unity.h>
+#include "../native/native.cpp"
+#include "WS2812FX/WS2812FX_FastLED.cpp"
+#include "WS2812FX/Effect.cpp"
+#include "WS2812FX/EffectHelper.cpp"
+#include "WS2812FX/LayerStack.cpp"
+#include "WS2812FX/MatrixLayout.cpp"
+#include "WS2812FX/FastRandom.cpp"
+#include "WS2812FX/PixelKernels.cpp"
+#include "WS2812FX/SpanRaster.cpp"
+#include "WS2812FX/AudioInput.cpp"
+#include "WS2812FX/AudioAnalyzer.cpp"
+#include "WS2812FX/effects/PlasmaEffect.cpp"
+#include "WS2812FX/effects/RainbowCycleEffect.cpp"
+#include "WS2812FX/effects/FillWaveEffect.cpp"
+#include "WS2812FX/effects/LarsonScannerEffect.cpp"
+#include "WS2812FX/effects/ScanEffect.cpp"
+#include "WS2812FX/effects/MoveBarSinEffect.cpp"
+#include "WS2812FX/effects/MoveBarQuadEffect.cpp"
+#include "WS2812FX/effects/MoveBarSawtoothEffect.cpp"
+#include "WS2812FX/effects/TheaterChaseEffect.cpp"
+#include "WS2812FX/effects/PixelStackEffect.cpp"
+#include "WS2812FX/effects/FillBeatEffect.cpp"
+#include "WS2812FX/effects/FillBrightEffect.cpp"
+#include "WS2812FX/effects/PrideEffect.cpp"
+#include "WS2812FX/effects/JugglePalEffect.cpp"
+#include "WS2812FX/effects/DotBeatEffect.cpp"
+#include "WS2812FX/effects/MultiDynamicEffect.cpp"
+#include "LED_strip/led_sync.cpp"
+#include <sys/wait.h>
+#include <time.h>
+#include <vector>
+
+#define SYNC_INSTANCES  3
+#define SYNC_RUN_MS     4000    // each instance runs that long
+#define SYNC_CHANGE_MS  2000    // the leader changes effect and speed
+#define SYNC_SETTLED_MS 1000    // after a change the followers are in phase again
+#define SYNC_SAMPLE_MS  20
+#define SYNC_TOLERANCE  15      // ms the phases may differ (loopback delay and sampling included)
+
+WS2812FX * strip = NULL;
+static CRGB physicalLeds[LED_COUNT + LED_OFFSET];
+static CRGB effectLeds[LED_COUNT];
+
+// there is no playlist in the tests
+uint8_t getPlaylistPlaying(uint8_t *) { return 0; }
+void playlistStop(void) {}
+
+static const uint8_t beatModes[] = {
+  FX_MODE_PLASMA, FX_MODE_RAINBOW_CYCLE, FX_MODE_FILL_WAVE, FX_MODE_LARSON_SCANNER, FX_MODE_SCAN,
+  FX_MODE_MOVE_BAR_SIN, FX_MODE_MOVE_BAR_QUAD, FX_MODE_MOVE_BAR_SAWTOOTH, FX_MODE_THEATER_CHASE,
+  FX_MODE_PIXEL_STACK, FX_MODE_FILL_BEAT, FX_MODE_FILL_BRIGHT, FX_MODE_PRIDE, FX_MODE_JUGGLE_PAL,
+  FX_MODE_DOT_BEAT, FX_MODE_MULTI_DYNAMIC,
+};
+
+static void stripSetup(void)
+{
+  strip = new WS2812FX(physicalLeds, effectLeds);
+  strip->init();
+  strip->start();
+  // full brightness at once (service() ramps it up otherwise)
+  strip->setTargetBrightness(255);
+  strip->getSegment()->brightness = 255;
+}
+
+// a fresh effect started with the timebase, rendered every 20 ms up to the clock
+static void render(uint8_t mode, uint32_t timebase, uint32_t clock, CRGB * frame)
+{
+  Effect * effect = EffectFactory::createEffect(mode);
+  TEST_ASSERT_NOT_NULL(effect);
+  nativeMicros = timebase * 1000;
+  strip->setEffectTimebase(timebase);
+  random16_set_seed(1234);
+  RandomPool::seed(1234);
+  fill_solid(strip->leds, LED_COUNT, CRGB::Black);
+  effect->init(strip);
+  for (uint32_t t = timebase; t < clock; t += 20)
+  {
+    nativeMicros = t * 1000;
+    effect->update(strip);
+  }
+  nativeMicros = clock * 1000;
+  effect->update(strip);
+  memcpy(frame, strip->leds, sizeof(effectLeds));
+  effect->cleanup();
+  delete effect;
+}
+
+static void test_effects_follow_timebase(void)
+{
+  CRGB a[LED_COUNT], b[LED_COUNT], c[LED_COUNT];
+  stripSetup();
+  for (uint8_t i = 0; i < sizeof(beatModes); i++)
+  {
+    char name[24];
+    snprintf(name, sizeof(name), "mode %u", beatModes[i]);
+    // the same time since the timebase - the same frame
+    render(beatModes[i], 10000, 11234, a);
+    render(beatModes[i], 73000, 74234, b);
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(a, b, sizeof(a), name);
+    // later - another frame (a millis() timebase kept the beat generators still)
+    bool moved = false;
+    for (uint16_t later = 250; later < 4000 && !moved; later += 450)
+    {
+      render(beatModes[i], 73000, 74234 + later, c);
+      moved = memcmp(b, c, sizeof(b)) != 0;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(moved, name);
+  }
+  delete strip;
+  strip = NULL;
+}
+
+static uint32_t ticking(void)
+{
+  return nativeMicros + 1;
+}
+
+// an effect prepared ahead (playlists) starts its phase with the switch it was prepared for
+static void test_prepared_timebase(void)
+{
+  nativeSetClockSource(ticking);
+  nativeMicros = 50000 * 1000;
+  stripSetup();
+  strip->setMode(FX_MODE_PLASMA);
+  strip->service();
+  for (uint8_t early = 0; early < 2; early++)
+  {
+    WS2812FX::segment scene = *strip->getSegment();
+    scene.mode = early ? FX_MODE_SCAN : FX_MODE_LARSON_SCANNER;
+    const uint32_t activation = millis() + 1000;
+    TEST_ASSERT_TRUE(strip->prepareEffect(scene, physicalLeds, activation));
+    TEST_ASSERT_TRUE(strip->hasPreparedEffect(scene.mode));
+    nativeMicros += (early ? 500 : 1003) * 1000;
+    strip->setMode(scene.mode);
+    const uint32_t now = millis();
+    strip->service();
+    TEST_ASSERT_FALSE(strip->hasPreparedEffect(scene.mode));
+    // on time: the one prepared / too early: constructed anew with the time of the switch
+    TEST_ASSERT_EQUAL_UINT32(early ? now : activation, strip->getEffectTimebase());
+  }
+  nativeSetClockSource(NULL);
+  delete strip;
+  strip = NULL;
+}
+
+// the effects of a playlist get constructed once - a switch takes the pooled instance
+static void test_pooled_effects(void)
+{
+  stripSetup();
+  strip->setMode(FX_MODE_PLASMA);
+  strip->service();
+  static const uint8_t modes[] = { FX_MODE_PLASMA, FX_MODE_DOT_BEAT, FX_MODE_LARSON_SCANNER, FX_MODE_DOT_BEAT };
+  TEST_ASSERT_EQUAL_UINT8(3, strip->poolEffects(modes, sizeof(modes), physicalLeds));
+  Effect * instances[3] = { strip->getCurrentEffect(), NULL, NULL };
+  for (uint8_t k = 1; k < 10; k++)
+  {
+    const uint8_t i = k % 3;
+    WS2812FX::segment scene = *strip->getSegment();
+    scene.mode = modes[i];
+    // every other switch prepared ahead - a setMode within the same pass keeps its modeinit
+    if (k & 1)
+    {
+      strip->setMode(strip->getMode());
+      TEST_ASSERT_TRUE(strip->prepareEffect(scene, physicalLeds, millis()));
+      TEST_ASSERT_TRUE(strip->getSegmentRuntime()->modeinit);
+    }
+    strip->setMode(scene.mode);
+    nativeMicros += 100 * 1000;
+    strip->service();
+    if (!instances[i]) instances[i] = strip->getCurrentEffect();
+    TEST_ASSERT_TRUE(instances[i] == strip->getCurrentEffect());
+    TEST_ASSERT_EQUAL_UINT8(scene.mode, strip->getCurrentEffect()->getModeId());
+  }
+  // the one running stays with the strip
+  strip->releaseEffectPool();
+  nativeMicros += 100 * 1000;
+  strip->service();
+  strip->setMode(FX_MODE_PLASMA);
+  nativeMicros += 100 * 1000;
+  strip->service();
+  delete strip;
+  strip = NULL;
+}
+
+struct syncSample {
+  uint32_t real;    // ms since the start of the test
+  uint32_t phase;   // syncMillis() - effect timebase
+  uint8_t  mode;
+  uint16_t beat88;
+  uint8_t  backwards;
+};
+
+static uint64_t realMicros(void)
+{
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+static uint64_t instanceStart;
+static double   instanceSkew;
+static uint32_t instanceClock;
+
+// the clock of a strip - off by its skew and started at its own time
+static uint32_t instanceMicros(void)
+{
+  return instanceClock + (uint32_t)((realMicros() - instanceStart) * (1.0 + instanceSkew));
+}
+
+// one strip (the leader or a follower) - sends its samples to fd
+static void instance(uint8_t i, int fd, uint64_t t0, double skew, uint32_t start)
+{
+  nativeInstance  = i;
+  nativeInstances = SYNC_INSTANCES;
+  instanceStart   = t0;
+  instanceSkew    = skew;
+  instanceClock   = start * 1000;
+  nativeSetClockSource(instanceMicros);
+  stripSetup();
+  strip->setSyncGroup(7);
+  strip->setSyncRole(i ? SYNC_ROLE_FOLLOWER : SYNC_ROLE_LEADER);
+  strip->setMode(i ? FX_MODE_RAINBOW_CYCLE : FX_MODE_PLASMA);
+  strip->setBeat88(1000 + i * 300);
+  syncBegin();
+
+  uint32_t last = 0, slot = 0;
+  uint8_t  backwards = 0;
+  for (uint64_t r = 0; r < SYNC_RUN_MS * 1000ULL; r = realMicros() - t0)
+  {
+    if (!i && r >= SYNC_CHANGE_MS * 1000ULL && strip->getMode() != FX_MODE_LARSON_SCANNER)
+    {
+      strip->setMode(FX_MODE_LARSON_SCANNER);
+      strip->setBeat88(2222);
+    }
+    const uint32_t steps = getSyncStats()->steps;
+    syncService(millis());
+    strip->service();
+
+    // the clock is set at once only when a leader is found - slewed otherwise
+    const uint32_t now = syncMillis();
+    if ((int32_t)(now - last) < 0 && getSyncStats()->steps == steps) backwards = 1;
+    last = now;
+    if (r / 1000 / SYNC_SAMPLE_MS != slot)
+    {
+      slot = r / 1000 / SYNC_SAMPLE_MS;
+      const syncSample s = { (uint32_t)(r / 1000), now - strip->getEffectTimebase(), strip->getMode(), strip->getBeat88(), backwards };
+      if (write(fd, &s, sizeof(s)) != sizeof(s)) break;
+    }
+    usleep(1000);
+  }
+  close(fd);
+  _exit(0);
+}
+
+static std::vector<syncSample> samples[SYNC_INSTANCES];
+
+static void runInstances(void)
+{
+  static const double   skew[SYNC_INSTANCES]  = { 0.0, 0.002, -0.003 };
+  static const uint32_t start[SYNC_INSTANCES] = { 5000, 123456, 987 };
+  int   fd[SYNC_INSTANCES];
+  pid_t pid[SYNC_INSTANCES];
+
+  const uint64_t t0 = realMicros() + 100000;  // all start together
+  for (uint8_t i = 0; i < SYNC_INSTANCES; i++)
+  {
+    int p[2];
+    TEST_ASSERT_EQUAL(0, pipe(p));
+    pid[i] = fork();
+    TEST_ASSERT_TRUE(pid[i] >= 0);
+    if (!pid[i])
+    {
+      close(p[0]);
+      while (realMicros() < t0) usleep(100);
+      instance(i, p[1], t0, skew[i], start[i]);
+    }
+    close(p[1]);
+    fd[i] = p[0];
+  }
+  for (uint8_t i = 0; i < SYNC_INSTANCES; i++)
+  {
+    syncSample s;
+    while (read(fd[i], &s, sizeof(s)) == sizeof(s)) samples[i].push_back(s);
+    close(fd[i]);
+    int status;
+    waitpid(pid[i], &status, 0);
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+  }
+}
+
+// the phase of the leader at the real time of the sample (from its sample before)
+static bool leaderPhase(const syncSample &f, uint32_t &phase)
+{
+  const std::vector<syncSample> &l = samples[0];
+  for (size_t k = l.size(); k-- > 0;)
+  {
+    if (l[k].real > f.real) continue;
+    if (f.real - l[k].real > 2 * SYNC_SAMPLE_MS || l[k].mode != f.mode) return false;
+    phase = l[k].phase + (f.real - l[k].real);
+    return true;
+  }
+  return false;
+}
+
+static void test_followers_in_phase(void)
+{
+  runInstances();
+  TEST_ASSERT_TRUE(samples[0].size() > SYNC_RUN_MS / SYNC_SAMPLE_MS / 2);
+  for (uint8_t i = 1; i < SYNC_INSTANCES; i++)
+  {
+    uint16_t compared = 0;
+    for (size_t k = 0; k < samples[i].size(); k++)
+    {
+      const syncSample &f = samples[i][k];
+      TEST_ASSERT_EQUAL_UINT8_MESSAGE(0, f.backwards, "the clock went backwards");
+      const bool settled = (f.real >= SYNC_SETTLED_MS && f.real < SYNC_CHANGE_MS) ||
+                           f.real >= SYNC_CHANGE_MS + SYNC_SETTLED_MS;
+      if (!settled) continue;
+      TEST_ASSERT_EQUAL_UINT8(f.real < SYNC_CHANGE_MS ? FX_MODE_PLASMA : FX_MODE_LARSON_SCANNER, f.mode);
+      TEST_ASSERT_EQUAL_UINT16(f.real < SYNC_CHANGE_MS ? 1000 : 2222, f.beat88);
+      uint32_t phase;
+      if (!leaderPhase(f, phase)) continue;
+      TEST_ASSERT_INT32_WITHIN(SYNC_TOLERANCE, (int32_t)phase, (int32_t)f.phase);
+      compared++;
+    }
+    TEST_ASSERT_TRUE(compared > (SYNC_RUN_MS - 2 * SYNC_SETTLED_MS) / SYNC_SAMPLE_MS / 2);
+  }
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_effects_follow_timebase);
+  RUN_TEST(test_prepared_timebase);
+  RUN_TEST(test_pooled_effects);
+  RUN_TEST(test_followers_in_phase);
+  return UNITY_END();
+}
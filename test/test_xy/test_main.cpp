@@ -0,0 +1,129 @@
+/*
+ * The 2D mapping: the table of every rotation is the wiring maths of the panel
+ * (each LED of the matrix exactly once), and the coordinates outside are none.
+ * The time per frame of the table gets reported against the maths.
+ */
+#include <unity.h>
+#include "../native/native.cpp"
+#include "WS2812FX/MatrixLayout.cpp"
+
+// the index of the logical pixel (x, y) as wired - the panel turned by "rotation" quarter turns
+static uint16_t wired(uint8_t x, uint8_t y, uint8_t w, uint8_t h, bool serpentine, uint8_t rotation, uint16_t offset)
+{
+  uint8_t px, py;
+  switch (rotation)
+  {
+    case 0:  px = x;         py = y;         break;
+    case 1:  px = y;         py = h - 1 - x; break;
+    case 2:  px = w - 1 - x; py = h - 1 - y; break;
+    default: px = w - 1 - y; py = x;         break;
+  }
+  if (serpentine && (py & 1)) px = w - 1 - px;
+  return offset + py * w + px;
+}
+
+void setUp(void) {}
+
+void tearDown(void)
+{
+  MatrixLayout::end();
+}
+
+static void test_rotations(void)
+{
+  static const uint8_t sizes[][2] = { {4, 3}, {1, 5}, {16, 16}, {32, 8} };
+  for (uint8_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+  {
+    const uint8_t w = sizes[s][0];
+    const uint8_t h = sizes[s][1];
+    for (uint8_t serpentine = 0; serpentine < 2; serpentine++)
+    {
+      for (uint8_t rotation = 0; rotation < 4; rotation++)
+      {
+        TEST_ASSERT_TRUE(MatrixLayout::begin(w, h, serpentine, rotation, 10));
+        TEST_ASSERT_TRUE(MatrixLayout::is2D());
+        TEST_ASSERT_EQUAL_UINT8(rotation & 1 ? h : w, MatrixLayout::width());
+        TEST_ASSERT_EQUAL_UINT8(rotation & 1 ? w : h, MatrixLayout::height());
+
+        static bool seen[32 * 16];
+        memset(seen, 0, sizeof(seen));
+        for (uint8_t y = 0; y < MatrixLayout::height(); y++)
+        {
+          for (uint8_t x = 0; x < MatrixLayout::width(); x++)
+          {
+            const uint16_t i = MatrixLayout::XY(x, y);
+            TEST_ASSERT_EQUAL_UINT16(wired(x, y, w, h, serpentine, rotation, 10), i);
+            TEST_ASSERT_EQUAL_UINT16(i, MatrixLayout::map()[y * MatrixLayout::width() + x]);
+            TEST_ASSERT_FALSE(seen[i - 10]);
+            seen[i - 10] = true;
+          }
+        }
+        MatrixLayout::end();
+      }
+    }
+  }
+}
+
+static void test_bounds(void)
+{
+  TEST_ASSERT_FALSE(MatrixLayout::is2D());
+  TEST_ASSERT_EQUAL_UINT16(MatrixLayout::NONE, MatrixLayout::XYsafe(0, 0));
+  MatrixLayout::begin(4, 3, true, 1, 10);
+  TEST_ASSERT_EQUAL_UINT16(wired(2, 3, 4, 3, true, 1, 10), MatrixLayout::XYsafe(2, 3));
+  TEST_ASSERT_EQUAL_UINT16(MatrixLayout::NONE, MatrixLayout::XYsafe(-1, 0));
+  TEST_ASSERT_EQUAL_UINT16(MatrixLayout::NONE, MatrixLayout::XYsafe(3, 0));
+  TEST_ASSERT_EQUAL_UINT16(MatrixLayout::NONE, MatrixLayout::XYsafe(0, 4));
+  TEST_ASSERT_TRUE(MatrixLayout::within(10, 12));
+  TEST_ASSERT_TRUE(MatrixLayout::within(0, 30));
+  TEST_ASSERT_FALSE(MatrixLayout::within(11, 20));
+  TEST_ASSERT_FALSE(MatrixLayout::within(0, 21));
+}
+
+// the index of each pixel of a frame: the wiring maths against the table
+static void test_timing(void)
+{
+  static const uint8_t panels[][3] = { {16, 16, 0}, {32, 8, 1} };
+  const uint16_t frames = 20000;
+  for (uint8_t p = 0; p < sizeof(panels) / sizeof(panels[0]); p++)
+  {
+    const uint8_t w = panels[p][0];
+    const uint8_t h = panels[p][1];
+    const uint8_t rotation = panels[p][2];
+    TEST_ASSERT_TRUE(MatrixLayout::begin(w, h, true, rotation, 0));
+    const uint8_t width  = MatrixLayout::width();
+    const uint8_t height = MatrixLayout::height();
+    volatile uint16_t sink = 0;
+    uint64_t t = nativeHostNanos();
+    for (uint16_t f = 0; f < frames; f++)
+    {
+      for (uint8_t y = 0; y < height; y++)
+      {
+        for (uint8_t x = 0; x < width; x++) sink += wired(x, y, w, h, true, rotation, 0);
+      }
+    }
+    const uint64_t maths = nativeHostNanos() - t;
+    t = nativeHostNanos();
+    for (uint16_t f = 0; f < frames; f++)
+    {
+      for (uint8_t y = 0; y < height; y++)
+      {
+        for (uint8_t x = 0; x < width; x++) sink += MatrixLayout::XY(x, y);
+      }
+    }
+    const uint64_t table = nativeHostNanos() - t;
+    char msg[96];
+    snprintf(msg, sizeof(msg), "%ux%u rotation %u: %.2f us maths, %.2f us table per frame (%u bytes)",
+             w, h, rotation, maths / 1000.0 / frames, table / 1000.0 / frames, (unsigned)(w * h * sizeof(uint16_t)));
+    TEST_MESSAGE(msg);
+    MatrixLayout::end();
+  }
+}
+
+int main(void)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_rotations);
+  RUN_TEST(test_bounds);
+  RUN_TEST(test_timing);
+  return UNITY_END();
+}